@@ -34,7 +34,7 @@ STREAM* cliprdr_packet_new(uint16 msgType, uint16 msgFlags, uint32 dataLen)
 {
 	STREAM* data_out;
 
-	data_out = stream_new(dataLen + 8);
+	data_out = stream_pool_get(dataLen + 8);
 	stream_write_uint16(data_out, msgType);
 	stream_write_uint16(data_out, msgFlags);
 	/* Write actual length after the entire packet has been constructed. */
@@ -139,7 +139,7 @@ static void cliprdr_process_receive(rdpSvcPlugin* plugin, STREAM* data_in)
 			break;
 	}
 
-	stream_free(data_in);
+	stream_pool_put(data_in);
 }
 
 static void cliprdr_process_event(rdpSvcPlugin* plugin, FRDP_EVENT* event)
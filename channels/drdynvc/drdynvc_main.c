@@ -83,7 +83,7 @@ int drdynvc_write_data(drdynvcPlugin* drdynvc, uint32 ChannelId, char* data, uin
 
 	DEBUG_DVC("ChannelId=%d size=%d", ChannelId, data_size);
 
-	data_out = stream_new(CHANNEL_CHUNK_LENGTH);
+	data_out = stream_pool_get(CHANNEL_CHUNK_LENGTH);
 	stream_set_pos(data_out, 1);
 	cbChId = drdynvc_write_variable_uint(data_out, ChannelId);
 
@@ -112,7 +112,7 @@ int drdynvc_write_data(drdynvcPlugin* drdynvc, uint32 ChannelId, char* data, uin
 
 		while (error == CHANNEL_RC_OK && data_size > 0)
 		{
-			data_out = stream_new(CHANNEL_CHUNK_LENGTH);
+			data_out = stream_pool_get(CHANNEL_CHUNK_LENGTH);
 			stream_set_pos(data_out, 1);
 			cbChId = drdynvc_write_variable_uint(data_out, ChannelId);
 
@@ -166,7 +166,7 @@ static int drdynvc_process_capability_request(drdynvcPlugin* drdynvc, int Sp, in
 		stream_read_uint16(data_in, drdynvc->PriorityCharge2);
 		stream_read_uint16(data_in, drdynvc->PriorityCharge3);
 	}
-	data_out = stream_new(4);
+	data_out = stream_pool_get(4);
 	stream_write_uint16(data_out, 0x0050); /* Cmd+Sp+cbChId+Pad. Note: MSTSC sends 0x005c */
 	stream_write_uint16(data_out, drdynvc->version);
 	error = svc_plugin_send((rdpSvcPlugin*)drdynvc, data_out);
@@ -210,7 +210,7 @@ static int drdynvc_process_create_request(drdynvcPlugin* drdynvc, int Sp, int cb
 
 	error = dvcman_create_channel(drdynvc->channel_mgr, ChannelId, (char*)stream_get_tail(data_in));
 
-	data_out = stream_new(pos + 4);
+	data_out = stream_pool_get(pos + 4);
 	stream_write_uint8(data_out, 0x10 | cbChId);
 	stream_set_pos(data_in, 1);
 	stream_copy(data_out, data_in, pos - 1);
@@ -319,7 +319,7 @@ static void drdynvc_process_receive(rdpSvcPlugin* plugin, STREAM* data_in)
 			break;
 	}
 
-	stream_free(data_in);
+	stream_pool_put(data_in);
 }
 
 static void drdynvc_process_connect(rdpSvcPlugin* plugin)
@@ -363,7 +363,7 @@ int dvcman_close_channel(IWTSVirtualChannelManager* pChannelMgr, uint32 ChannelI
 	}
 	if (channel->dvc_data)
 	{
-		stream_free(channel->dvc_data);
+		stream_pool_put(channel->dvc_data);
 		channel->dvc_data = NULL;
 	}
 	DEBUG_DVC("dvcman_close_channel: channel %d closed", ChannelId);
@@ -383,8 +383,8 @@ int dvcman_receive_channel_data_first(IWTSVirtualChannelManager* pChannelMgr, ui
 		return 1;
 	}
 	if (channel->dvc_data)
-		stream_free(channel->dvc_data);
-	channel->dvc_data = stream_new(length);
+		stream_pool_put(channel->dvc_data);
+	channel->dvc_data = stream_pool_get(length);
 
 	return 0;
 }
@@ -407,7 +407,7 @@ int dvcman_receive_channel_data(IWTSVirtualChannelManager* pChannelMgr, uint32 C
 		if (stream_get_length(channel->dvc_data) + data_size > stream_get_size(channel->dvc_data))
 		{
 			DEBUG_WARN("data exceeding declared length!");
-			stream_free(channel->dvc_data);
+			stream_pool_put(channel->dvc_data);
 			channel->dvc_data = NULL;
 			return 1;
 		}
@@ -416,7 +416,7 @@ int dvcman_receive_channel_data(IWTSVirtualChannelManager* pChannelMgr, uint32 C
 		{
 			error = channel->channel_callback->OnDataReceived(channel->channel_callback,
 				stream_get_size(channel->dvc_data), stream_get_data(channel->dvc_data));
-			stream_free(channel->dvc_data);
+			stream_pool_put(channel->dvc_data);
 			channel->dvc_data = NULL;
 		}
 	}
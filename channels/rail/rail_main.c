@@ -67,7 +67,7 @@ rail_plugin_send_vchannel_data(
 	railPlugin* plugin = (railPlugin*)rail_plugin_object;
 	STREAM* s = NULL;
 
-	s = stream_new(length);
+	s = stream_pool_get(length);
 	stream_write(s, data, length);
 	svc_plugin_send((rdpSvcPlugin*)plugin, s);
 }
@@ -83,7 +83,7 @@ rail_plugin_process_received_vchannel_data(
 	DEBUG_RAIL("rail_plugin_process_receive: size=%d", stream_get_size(data_in));
 
 	rail_vchannel_process_received_vchannel_data(rail_plugin->session, data_in);
-	stream_free(data_in);
+	stream_pool_put(data_in);
 }
 //------------------------------------------------------------------------------
 static void
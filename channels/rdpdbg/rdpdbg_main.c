@@ -42,9 +42,9 @@ static void rdpdbg_process_receive(rdpSvcPlugin* plugin, STREAM* data_in)
 	STREAM* data_out;
 
 	DEBUG_WARN("size %d", stream_get_size(data_in));
-	stream_free(data_in);
+	stream_pool_put(data_in);
 
-	data_out = stream_new(8);
+	data_out = stream_pool_get(8);
 	stream_write(data_out, "senddata", 8);
 	svc_plugin_send(plugin, data_out);
 }
@@ -18,6 +18,7 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <freerdp/utils/args.h>
 #include <freerdp/utils/memory.h>
@@ -43,25 +44,36 @@ void df_begin_paint(rdpUpdate* update)
 
 	gdi = GET_GDI(update);
 	gdi->primary->hdc->hwnd->invalid->null = 1;
+	gdi->primary->hdc->hwnd->ninvalid = 0;
 }
 
 void df_end_paint(rdpUpdate* update)
 {
+	int i;
 	GDI* gdi;
 	dfInfo* dfi;
+	HGDI_RGN cinvalid;
 
 	gdi = GET_GDI(update);
 	dfi = GET_DFI(update);
 
+	gdi_end_paint(update);
+
 	if (gdi->primary->hdc->hwnd->invalid->null)
 		return;
 
-	dfi->update_rect.x = gdi->primary->hdc->hwnd->invalid->x;
-	dfi->update_rect.y = gdi->primary->hdc->hwnd->invalid->y;
-	dfi->update_rect.w = gdi->primary->hdc->hwnd->invalid->w;
-	dfi->update_rect.h = gdi->primary->hdc->hwnd->invalid->h;
+	cinvalid = gdi->primary->hdc->hwnd->cinvalid;
 
-	dfi->primary->Blit(dfi->primary, dfi->surface, &(dfi->update_rect), dfi->update_rect.x, dfi->update_rect.y);
+	/* only present the damaged rectangles, not their bounding box */
+	for (i = 0; i < gdi->primary->hdc->hwnd->ninvalid; i++)
+	{
+		dfi->update_rect.x = cinvalid[i].x;
+		dfi->update_rect.y = cinvalid[i].y;
+		dfi->update_rect.w = cinvalid[i].w;
+		dfi->update_rect.h = cinvalid[i].h;
+
+		dfi->primary->Blit(dfi->primary, dfi->surface, &(dfi->update_rect), dfi->update_rect.x, dfi->update_rect.y);
+	}
 }
 
 boolean df_get_fds(freerdp* instance, void** rfds, int* rcount, void** wfds, int* wcount)
@@ -85,9 +97,14 @@ boolean df_check_fds(freerdp* instance, fd_set* set)
 	if (!FD_ISSET(dfi->read_fds, set))
 		return True;
 
-	if (read(dfi->read_fds, &(dfi->event), sizeof(dfi->event)) > 0)
+	/* send all the input events pending on the descriptor in a single PDU */
+	instance->input->BeginBatch(instance->input);
+
+	while (read(dfi->read_fds, &(dfi->event), sizeof(dfi->event)) > 0)
 		df_event_process(instance, &(dfi->event));
 
+	instance->input->FlushBatch(instance->input);
+
 	return True;
 }
 
@@ -107,11 +124,17 @@ boolean df_post_connect(freerdp* instance)
 {
 	GDI* gdi;
 	dfInfo* dfi;
+	uint32 flags;
 
 	dfi = GET_DFI(instance);
 	SET_DFI(instance->update, dfi);
 
-	gdi_init(instance, CLRCONV_ALPHA | CLRBUF_16BPP | CLRBUF_32BPP);
+	flags = CLRCONV_ALPHA | CLRBUF_16BPP | CLRBUF_32BPP;
+
+	if (instance->settings->parallel_orders)
+		flags |= GDI_PARALLEL_ORDERS;
+
+	gdi_init(instance, flags);
 	gdi = GET_GDI(instance->update);
 
 	dfi->err = DirectFBCreate(&(dfi->dfb));
@@ -123,6 +146,7 @@ boolean df_post_connect(freerdp* instance)
 	dfi->dfb->SetVideoMode(dfi->dfb, gdi->width, gdi->height, gdi->dstBpp);
 	dfi->dfb->CreateInputEventBuffer(dfi->dfb, DICAPS_ALL, DFB_TRUE, &(dfi->event_buffer));
 	dfi->event_buffer->CreateFileDescriptor(dfi->event_buffer, &(dfi->read_fds));
+	fcntl(dfi->read_fds, F_SETFL, fcntl(dfi->read_fds, F_GETFL) | O_NONBLOCK);
 
 	dfi->dfb->GetDisplayLayer(dfi->dfb, 0, &(dfi->layer));
 	dfi->layer->EnableCursor(dfi->layer, 1);
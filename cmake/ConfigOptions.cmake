@@ -9,3 +9,4 @@ option(WITH_DEBUG_NEGO "Print negotiation related debug messages." OFF)
 option(WITH_DEBUG_CERTIFICATE "Print certificate related debug messages." OFF)
 option(WITH_DEBUG_LICENSE "Print license debug messages." OFF)
 option(WITH_DEBUG_GDI "Print graphics debug messages." OFF)
+option(WITH_DEBUG_FASTPATH "Print fast-path debug messages." OFF)
@@ -0,0 +1,115 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Bitmap Decompression Benchmark
+ *
+ * Copyright 2026 FreeRDP Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <freerdp/freerdp.h>
+#include "libfreerdp-core/bitmap.h"
+
+#include "test_bitmap.h"
+
+static double bench_elapsed(struct timeval* start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+
+	return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/**
+ * Measure the decompression throughput of a corpus bitmap,
+ * with the reference per-pixel decoder and with the current one.
+ * @param iterations number of times the bitmap is decompressed
+ */
+
+static void bench_bitmap_corpus(BITMAP_CORPUS* corpus, int iterations)
+{
+	int i;
+	double pixels;
+	double elapsed;
+	double reference;
+	uint8* decompressed;
+	uint8* expected;
+	struct timeval start;
+
+	decompressed = (uint8*) malloc(corpus->width * corpus->height * 4);
+	expected = (uint8*) malloc(corpus->width * corpus->height * 4);
+	pixels = (double) corpus->width * corpus->height * iterations / 1000000.0;
+
+	/* planar 32bpp bitmaps have no reference decoder */
+	reference = 0;
+
+	if (bitmap_decompress_ref(corpus->data, expected, corpus->width, corpus->height, corpus->size, corpus->bpp))
+	{
+		gettimeofday(&start, NULL);
+
+		for (i = 0; i < iterations; i++)
+			bitmap_decompress_ref(corpus->data, expected, corpus->width, corpus->height, corpus->size, corpus->bpp);
+
+		reference = pixels / bench_elapsed(&start);
+	}
+
+	gettimeofday(&start, NULL);
+
+	for (i = 0; i < iterations; i++)
+	{
+		bitmap_decompress(corpus->data, decompressed, corpus->width, corpus->height,
+			corpus->size, corpus->bpp, corpus->bpp);
+	}
+
+	elapsed = bench_elapsed(&start);
+
+	if (reference > 0)
+	{
+		printf("%-16s %8.1f -> %8.1f Mpixels/s %6.2fx%s\n", corpus->name, reference, pixels / elapsed,
+			pixels / elapsed / reference, memcmp(decompressed, expected,
+			corpus->width * corpus->height * ((corpus->bpp + 7) / 8)) ? " (output differs)" : "");
+	}
+	else
+	{
+		printf("%-16s %8s -> %8.1f Mpixels/s\n", corpus->name, "-", pixels / elapsed);
+	}
+
+	free(decompressed);
+	free(expected);
+}
+
+int main(int argc, char* argv[])
+{
+	int iterations = 100000;
+	BITMAP_CORPUS* corpus;
+
+	if (argc > 1)
+		iterations = atoi(argv[1]);
+
+	if (iterations < 1)
+	{
+		printf("usage: %s [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	/* the same number of pixels for every corpus, a 32x32 bitmap per iteration */
+	for (corpus = bitmap_corpora; corpus->data != NULL; corpus++)
+		bench_bitmap_corpus(corpus, iterations * 1024 / (corpus->width * corpus->height));
+
+	return 0;
+}
@@ -0,0 +1,326 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Reference Bitmap Decompression
+ *
+ * Copyright 2011 Jay Sorg <jay.sorg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+   Copy of the interleaved RLE decoder as it was before runs and
+   foreground/background images were written with bulk primitives, one
+   pixel at a time through DESTWRITEPIXEL. bench_bitmap measures the
+   current decoder against it. Color conversion is left out.
+*/
+
+#include <freerdp/types.h>
+#include "libfreerdp-core/bitmap.h"
+
+#include "test_bitmap.h"
+
+/*
+   RLE Compressed Bitmap Stream (RLE_BITMAP_STREAM)
+   http://msdn.microsoft.com/en-us/library/cc240895%28v=prot.10%29.aspx
+   pseudo-code
+   http://msdn.microsoft.com/en-us/library/dd240593%28v=prot.10%29.aspx
+*/
+
+/*
+   Bitmasks
+*/
+static uint8 g_MaskBit0 = 0x01; /* Least significant bit */
+
+static uint8 g_MaskRegularRunLength = 0x1F;
+static uint8 g_MaskLiteRunLength = 0x0F;
+
+static uint8 g_MaskSpecialFgBg1 = 0x03;
+static uint8 g_MaskSpecialFgBg2 = 0x05;
+
+/**
+ * Reads the supplied order header and extracts the compression
+ * order code ID.
+ */
+static uint32 ExtractCodeId(uint8 bOrderHdr)
+{
+	int code;
+
+	switch (bOrderHdr)
+	{
+		case MEGA_MEGA_BG_RUN:
+		case MEGA_MEGA_FG_RUN:
+		case MEGA_MEGA_SET_FG_RUN:
+		case MEGA_MEGA_DITHERED_RUN:
+		case MEGA_MEGA_COLOR_RUN:
+		case MEGA_MEGA_FGBG_IMAGE:
+		case MEGA_MEGA_SET_FGBG_IMAGE:
+		case MEGA_MEGA_COLOR_IMAGE:
+		case SPECIAL_FGBG_1:
+		case SPECIAL_FGBG_2:
+		case SPECIAL_WHITE:
+		case SPECIAL_BLACK:
+			return bOrderHdr;
+	}
+	code = bOrderHdr >> 5;
+	switch (code)
+	{
+		case REGULAR_BG_RUN:
+		case REGULAR_FG_RUN:
+		case REGULAR_COLOR_RUN:
+		case REGULAR_FGBG_IMAGE:
+		case REGULAR_COLOR_IMAGE:
+			return code;
+	}
+	return bOrderHdr >> 4;
+}
+
+/**
+ * Extract the run length of a compression order.
+ */
+static uint32 ExtractRunLength(uint32 code, uint8* pbOrderHdr, uint32* advance)
+{
+	uint32 runLength;
+	uint32 ladvance;
+
+	ladvance = 1;
+	runLength = 0;
+	switch (code)
+	{
+		case REGULAR_FGBG_IMAGE:
+			runLength = (*pbOrderHdr) & g_MaskRegularRunLength;
+			if (runLength == 0)
+			{
+				runLength = (*(pbOrderHdr + 1)) + 1;
+				ladvance += 1;
+			}
+			else
+			{
+				runLength = runLength * 8;
+			}
+			break;
+		case LITE_SET_FG_FGBG_IMAGE:
+			runLength = (*pbOrderHdr) & g_MaskLiteRunLength;
+			if (runLength == 0)
+			{
+				runLength = (*(pbOrderHdr + 1)) + 1;
+				ladvance += 1;
+			}
+			else
+			{
+				runLength = runLength * 8;
+			}
+			break;
+		case REGULAR_BG_RUN:
+		case REGULAR_FG_RUN:
+		case REGULAR_COLOR_RUN:
+		case REGULAR_COLOR_IMAGE:
+			runLength = (*pbOrderHdr) & g_MaskRegularRunLength;
+			if (runLength == 0)
+			{
+				/* An extended (MEGA) run. */
+				runLength = (*(pbOrderHdr + 1)) + 32;
+				ladvance += 1;
+			}
+			break;
+		case LITE_SET_FG_FG_RUN:
+		case LITE_DITHERED_RUN:
+			runLength = (*pbOrderHdr) & g_MaskLiteRunLength;
+			if (runLength == 0)
+			{
+				/* An extended (MEGA) run. */
+				runLength = (*(pbOrderHdr + 1)) + 16;
+				ladvance += 1;
+			}
+			break;
+		case MEGA_MEGA_BG_RUN:
+		case MEGA_MEGA_FG_RUN:
+		case MEGA_MEGA_SET_FG_RUN:
+		case MEGA_MEGA_DITHERED_RUN:
+		case MEGA_MEGA_COLOR_RUN:
+		case MEGA_MEGA_FGBG_IMAGE:
+		case MEGA_MEGA_SET_FGBG_IMAGE:
+		case MEGA_MEGA_COLOR_IMAGE:
+			runLength = ((uint16) pbOrderHdr[1]) | ((uint16) (pbOrderHdr[2] << 8));
+			ladvance += 2;
+			break;
+	}
+	*advance = ladvance;
+	return runLength;
+}
+
+/*
+   Destination cursor
+
+   Scanlines are stored bottom-up in the compressed stream. The cursor starts
+   on the last scanline of the destination rectangle and moves up one stride
+   each time a scanline is completed, so the previous (already decoded)
+   scanline is always found at pos + stride.
+*/
+struct _RLE_DEST
+{
+	uint8* line;
+	uint8* pos;
+	uint8* end;
+	sint32 stride;
+	uint32 lineSize;
+	uint32 lines;
+	uint32 height;
+	uint32 pixelSize;
+};
+typedef struct _RLE_DEST RLE_DEST;
+
+static void rle_dest_init(RLE_DEST* dest, uint8* buffer, sint32 stride, uint32 width, uint32 height, uint32 pixelSize)
+{
+	dest->pixelSize = pixelSize;
+	dest->lineSize = width * pixelSize;
+	dest->lines = (width > 0) ? height : 0;
+	dest->height = height;
+	dest->stride = stride;
+	dest->line = buffer + ((sint32) height - 1) * stride;
+	dest->pos = dest->line;
+	dest->end = dest->line + dest->lineSize;
+}
+
+/**
+ * Get the number of pixels of a run that fit on the current scanline.
+ */
+static uint32 rle_dest_span(RLE_DEST* dest, uint32 runLength, uint32 pixelSize)
+{
+	uint32 count;
+
+	count = (uint32) (dest->end - dest->pos) / pixelSize;
+
+	return (runLength < count) ? runLength : count;
+}
+
+/**
+ * Store the updated write position, moving to the next scanline if needed.
+ */
+static void rle_dest_commit(RLE_DEST* dest, uint8* pos)
+{
+	dest->pos = pos;
+
+	if (pos == dest->end)
+	{
+		dest->lines--;
+		dest->line -= dest->stride;
+		dest->pos = dest->line;
+		dest->end = dest->line + dest->lineSize;
+	}
+}
+
+
+#define UNROLL_COUNT 4
+#define UNROLL(_exp) do { _exp _exp _exp _exp } while (0)
+
+#undef DESTWRITEPIXEL
+#undef DESTREADPIXEL
+#undef SRCREADPIXEL
+#undef DESTNEXTPIXEL
+#undef SRCNEXTPIXEL
+#undef DESTPIXELSIZE
+#undef WRITEFGBGIMAGE
+#undef WRITEFIRSTLINEFGBGIMAGE
+#undef RLEDECOMPRESS
+#undef RLEEXTRA
+#define DESTWRITEPIXEL(_buf, _pix) (_buf)[0] = (uint8)(_pix)
+#define DESTREADPIXEL(_pix, _buf) _pix = (_buf)[0]
+#define SRCREADPIXEL(_pix, _buf) _pix = (_buf)[0]
+#define DESTNEXTPIXEL(_buf) _buf += 1
+#define SRCNEXTPIXEL(_buf) _buf += 1
+#define DESTPIXELSIZE 1
+#define WRITEFGBGIMAGE RefWriteFgBgImage8to8
+#define WRITEFIRSTLINEFGBGIMAGE RefWriteFirstLineFgBgImage8to8
+#define RLEDECOMPRESS RefRleDecompress8
+#define RLEEXTRA
+#include "bench_bitmap_ref_inc.c"
+
+#undef DESTWRITEPIXEL
+#undef DESTREADPIXEL
+#undef SRCREADPIXEL
+#undef DESTNEXTPIXEL
+#undef SRCNEXTPIXEL
+#undef DESTPIXELSIZE
+#undef WRITEFGBGIMAGE
+#undef WRITEFIRSTLINEFGBGIMAGE
+#undef RLEDECOMPRESS
+#undef RLEEXTRA
+#define DESTWRITEPIXEL(_buf, _pix) ((uint16*)(_buf))[0] = (uint16)(_pix)
+#define DESTREADPIXEL(_pix, _buf) _pix = ((uint16*)(_buf))[0]
+#define SRCREADPIXEL(_pix, _buf) _pix = ((uint16*)(_buf))[0]
+#define DESTNEXTPIXEL(_buf) _buf += 2
+#define SRCNEXTPIXEL(_buf) _buf += 2
+#define DESTPIXELSIZE 2
+#define WRITEFGBGIMAGE RefWriteFgBgImage16to16
+#define WRITEFIRSTLINEFGBGIMAGE RefWriteFirstLineFgBgImage16to16
+#define RLEDECOMPRESS RefRleDecompress16
+#define RLEEXTRA
+#include "bench_bitmap_ref_inc.c"
+
+#undef DESTWRITEPIXEL
+#undef DESTREADPIXEL
+#undef SRCREADPIXEL
+#undef DESTNEXTPIXEL
+#undef SRCNEXTPIXEL
+#undef DESTPIXELSIZE
+#undef WRITEFGBGIMAGE
+#undef WRITEFIRSTLINEFGBGIMAGE
+#undef RLEDECOMPRESS
+#undef RLEEXTRA
+#define DESTWRITEPIXEL(_buf, _pix) do { (_buf)[0] = (uint8)(_pix);  \
+  (_buf)[1] = (uint8)((_pix) >> 8); (_buf)[2] = (uint8)((_pix) >> 16); } while (0)
+#define DESTREADPIXEL(_pix, _buf) _pix = (_buf)[0] | ((_buf)[1] << 8) | \
+  ((_buf)[2] << 16)
+#define SRCREADPIXEL(_pix, _buf) _pix = (_buf)[0] | ((_buf)[1] << 8) | \
+  ((_buf)[2] << 16)
+#define DESTNEXTPIXEL(_buf) _buf += 3
+#define SRCNEXTPIXEL(_buf) _buf += 3
+#define DESTPIXELSIZE 3
+#define WRITEFGBGIMAGE RefWriteFgBgImage24to24
+#define WRITEFIRSTLINEFGBGIMAGE RefWriteFirstLineFgBgImage24to24
+#define RLEDECOMPRESS RefRleDecompress24
+#define RLEEXTRA
+#include "bench_bitmap_ref_inc.c"
+
+/**
+ * Decompress an interleaved RLE bitmap with the reference decoder.
+ * @return True on success
+ */
+boolean bitmap_decompress_ref(uint8* srcData, uint8* dstData, int width, int height, int size, int bpp)
+{
+	RLE_DEST dest;
+
+	switch (bpp)
+	{
+		case 8:
+			rle_dest_init(&dest, dstData, width, width, height, 1);
+			RefRleDecompress8(srcData, size, &dest);
+			break;
+
+		case 15:
+		case 16:
+			rle_dest_init(&dest, dstData, width * 2, width, height, 2);
+			RefRleDecompress16(srcData, size, &dest);
+			break;
+
+		case 24:
+			rle_dest_init(&dest, dstData, width * 3, width, height, 3);
+			RefRleDecompress24(srcData, size, &dest);
+			break;
+
+		default:
+			return False;
+	}
+
+	return True;
+}
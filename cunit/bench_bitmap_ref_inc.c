@@ -0,0 +1,426 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Reference RLE Compressed Bitmap Stream
+ *
+ * Copyright 2011 Jay Sorg <jay.sorg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* do not compile the file directly, included by bench_bitmap_ref.c */
+
+/**
+ * Write a foreground/background image to a destination buffer.
+ */
+static void WRITEFGBGIMAGE(RLE_DEST* dest, uint8 bitmask, PIXEL fgPel, uint32 cBits)
+{
+	PIXEL xorPixel;
+	uint8* pbDest;
+
+	while (cBits > 0 && dest->lines > 0)
+	{
+		pbDest = dest->pos;
+		DESTREADPIXEL(xorPixel, pbDest + dest->stride);
+		if (bitmask & g_MaskBit0)
+		{
+			DESTWRITEPIXEL(pbDest, xorPixel ^ fgPel);
+		}
+		else
+		{
+			DESTWRITEPIXEL(pbDest, xorPixel);
+		}
+		DESTNEXTPIXEL(pbDest);
+		rle_dest_commit(dest, pbDest);
+		bitmask = bitmask >> 1;
+		cBits = cBits - 1;
+	}
+}
+
+/**
+ * Write a foreground/background image to a destination buffer
+ * for the first line of compressed data.
+ */
+static void WRITEFIRSTLINEFGBGIMAGE(RLE_DEST* dest, uint8 bitmask, PIXEL fgPel, uint32 cBits)
+{
+	uint8* pbDest;
+
+	while (cBits > 0 && dest->lines > 0)
+	{
+		pbDest = dest->pos;
+		if (bitmask & g_MaskBit0)
+		{
+			DESTWRITEPIXEL(pbDest, fgPel);
+		}
+		else
+		{
+			DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
+		}
+		DESTNEXTPIXEL(pbDest);
+		rle_dest_commit(dest, pbDest);
+		bitmask = bitmask >> 1;
+		cBits = cBits - 1;
+	}
+}
+
+/**
+ * Decompress an RLE compressed bitmap.\n
+ * Pixels are written through the destination cursor, which hands out one
+ * scanline at a time. Runs are split on scanline boundaries so that they
+ * never write outside of the destination rectangle.
+ * @param pbSrcBuffer compressed bitmap data
+ * @param cbSrcBuffer compressed bitmap data length
+ * @param dest destination cursor
+ */
+static void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, RLE_DEST* dest)
+{
+	uint8* pbSrc = pbSrcBuffer;
+	uint8* pbEnd = pbSrcBuffer + cbSrcBuffer;
+	uint8* pbDest;
+	sint32 rowDelta;
+
+	PIXEL temp;
+	PIXEL fgPel = WHITE_PIXEL;
+	boolean fInsertFgPel = False;
+	boolean fFirstLine = True;
+
+	uint8 bitmask;
+	PIXEL pixelA, pixelB;
+
+	uint32 runLength;
+	uint32 count;
+	uint32 code;
+
+	uint32 advance;
+
+	RLEEXTRA
+
+	while (pbSrc < pbEnd && dest->lines > 0)
+	{
+		/* Watch out for the end of the first scanline. */
+		if (fFirstLine)
+		{
+			if (dest->lines < dest->height)
+			{
+				fFirstLine = False;
+				fInsertFgPel = False;
+			}
+		}
+
+		/*
+		   Extract the compression order code ID from the compression
+		   order header.
+		*/
+		code = ExtractCodeId(*pbSrc);
+
+		/* Handle Background Run Orders. */
+		if (code == REGULAR_BG_RUN || code == MEGA_MEGA_BG_RUN)
+		{
+			runLength = ExtractRunLength(code, pbSrc, &advance);
+			pbSrc = pbSrc + advance;
+			if (fFirstLine)
+			{
+				if (fInsertFgPel)
+				{
+					pbDest = dest->pos;
+					DESTWRITEPIXEL(pbDest, fgPel);
+					DESTNEXTPIXEL(pbDest);
+					rle_dest_commit(dest, pbDest);
+					runLength = runLength - 1;
+				}
+				while (runLength > 0 && dest->lines > 0)
+				{
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					while (count >= UNROLL_COUNT)
+					{
+						UNROLL(
+							DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
+							DESTNEXTPIXEL(pbDest); );
+						count = count - UNROLL_COUNT;
+					}
+					while (count > 0)
+					{
+						DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
+						DESTNEXTPIXEL(pbDest);
+						count = count - 1;
+					}
+					rle_dest_commit(dest, pbDest);
+				}
+			}
+			else
+			{
+				if (fInsertFgPel)
+				{
+					pbDest = dest->pos;
+					rowDelta = dest->stride;
+					DESTREADPIXEL(temp, pbDest + rowDelta);
+					DESTWRITEPIXEL(pbDest, temp ^ fgPel);
+					DESTNEXTPIXEL(pbDest);
+					rle_dest_commit(dest, pbDest);
+					runLength = runLength - 1;
+				}
+				while (runLength > 0 && dest->lines > 0)
+				{
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					rowDelta = dest->stride;
+					while (count >= UNROLL_COUNT)
+					{
+						UNROLL(
+							DESTREADPIXEL(temp, pbDest + rowDelta);
+							DESTWRITEPIXEL(pbDest, temp);
+							DESTNEXTPIXEL(pbDest); );
+						count = count - UNROLL_COUNT;
+					}
+					while (count > 0)
+					{
+						DESTREADPIXEL(temp, pbDest + rowDelta);
+						DESTWRITEPIXEL(pbDest, temp);
+						DESTNEXTPIXEL(pbDest);
+						count = count - 1;
+					}
+					rle_dest_commit(dest, pbDest);
+				}
+			}
+			/* A follow-on background run order will need a foreground pel inserted. */
+			fInsertFgPel = True;
+			continue;
+		}
+
+		/* For any of the other run-types a follow-on background run
+			order does not need a foreground pel inserted. */
+		fInsertFgPel = False;
+
+		switch (code)
+		{
+			/* Handle Foreground Run Orders. */
+			case REGULAR_FG_RUN:
+			case MEGA_MEGA_FG_RUN:
+			case LITE_SET_FG_FG_RUN:
+			case MEGA_MEGA_SET_FG_RUN:
+				runLength = ExtractRunLength(code, pbSrc, &advance);
+				pbSrc = pbSrc + advance;
+				if (code == LITE_SET_FG_FG_RUN || code == MEGA_MEGA_SET_FG_RUN)
+				{
+					SRCREADPIXEL(fgPel, pbSrc);
+					SRCNEXTPIXEL(pbSrc);
+				}
+				while (runLength > 0 && dest->lines > 0)
+				{
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					rowDelta = dest->stride;
+					if (fFirstLine)
+					{
+						while (count >= UNROLL_COUNT)
+						{
+							UNROLL(
+								DESTWRITEPIXEL(pbDest, fgPel);
+								DESTNEXTPIXEL(pbDest); );
+							count = count - UNROLL_COUNT;
+						}
+						while (count > 0)
+						{
+							DESTWRITEPIXEL(pbDest, fgPel);
+							DESTNEXTPIXEL(pbDest);
+							count = count - 1;
+						}
+					}
+					else
+					{
+						while (count >= UNROLL_COUNT)
+						{
+							UNROLL(
+								DESTREADPIXEL(temp, pbDest + rowDelta);
+								DESTWRITEPIXEL(pbDest, temp ^ fgPel);
+								DESTNEXTPIXEL(pbDest); );
+							count = count - UNROLL_COUNT;
+						}
+						while (count > 0)
+						{
+							DESTREADPIXEL(temp, pbDest + rowDelta);
+							DESTWRITEPIXEL(pbDest, temp ^ fgPel);
+							DESTNEXTPIXEL(pbDest);
+							count = count - 1;
+						}
+					}
+					rle_dest_commit(dest, pbDest);
+				}
+				break;
+
+			/* Handle Dithered Run Orders. */
+			case LITE_DITHERED_RUN:
+			case MEGA_MEGA_DITHERED_RUN:
+				runLength = ExtractRunLength(code, pbSrc, &advance);
+				pbSrc = pbSrc + advance;
+				SRCREADPIXEL(pixelA, pbSrc);
+				SRCNEXTPIXEL(pbSrc);
+				SRCREADPIXEL(pixelB, pbSrc);
+				SRCNEXTPIXEL(pbSrc);
+				/* the run length is a count of pixel pairs, which may straddle two scanlines */
+				runLength = runLength * 2;
+				while (runLength > 0 && dest->lines > 0)
+				{
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					while (count >= 2)
+					{
+						DESTWRITEPIXEL(pbDest, pixelA);
+						DESTNEXTPIXEL(pbDest);
+						DESTWRITEPIXEL(pbDest, pixelB);
+						DESTNEXTPIXEL(pbDest);
+						count = count - 2;
+					}
+					if (count > 0)
+					{
+						DESTWRITEPIXEL(pbDest, pixelA);
+						DESTNEXTPIXEL(pbDest);
+						temp = pixelA;
+						pixelA = pixelB;
+						pixelB = temp;
+					}
+					rle_dest_commit(dest, pbDest);
+				}
+				break;
+
+			/* Handle Color Run Orders. */
+			case REGULAR_COLOR_RUN:
+			case MEGA_MEGA_COLOR_RUN:
+				runLength = ExtractRunLength(code, pbSrc, &advance);
+				pbSrc = pbSrc + advance;
+				SRCREADPIXEL(pixelA, pbSrc);
+				SRCNEXTPIXEL(pbSrc);
+				while (runLength > 0 && dest->lines > 0)
+				{
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					while (count >= UNROLL_COUNT)
+					{
+						UNROLL(
+							DESTWRITEPIXEL(pbDest, pixelA);
+							DESTNEXTPIXEL(pbDest); );
+						count = count - UNROLL_COUNT;
+					}
+					while (count > 0)
+					{
+						DESTWRITEPIXEL(pbDest, pixelA);
+						DESTNEXTPIXEL(pbDest);
+						count = count - 1;
+					}
+					rle_dest_commit(dest, pbDest);
+				}
+				break;
+
+			/* Handle Foreground/Background Image Orders. */
+			case REGULAR_FGBG_IMAGE:
+			case MEGA_MEGA_FGBG_IMAGE:
+			case LITE_SET_FG_FGBG_IMAGE:
+			case MEGA_MEGA_SET_FGBG_IMAGE:
+				runLength = ExtractRunLength(code, pbSrc, &advance);
+				pbSrc = pbSrc + advance;
+				if (code == LITE_SET_FG_FGBG_IMAGE || code == MEGA_MEGA_SET_FGBG_IMAGE)
+				{
+					SRCREADPIXEL(fgPel, pbSrc);
+					SRCNEXTPIXEL(pbSrc);
+				}
+				while (runLength > 0)
+				{
+					count = (runLength > 8) ? 8 : runLength;
+					bitmask = *pbSrc;
+					pbSrc = pbSrc + 1;
+					if (fFirstLine)
+						WRITEFIRSTLINEFGBGIMAGE(dest, bitmask, fgPel, count);
+					else
+						WRITEFGBGIMAGE(dest, bitmask, fgPel, count);
+					runLength = runLength - count;
+				}
+				break;
+
+			/* Handle Color Image Orders. */
+			case REGULAR_COLOR_IMAGE:
+			case MEGA_MEGA_COLOR_IMAGE:
+				runLength = ExtractRunLength(code, pbSrc, &advance);
+				pbSrc = pbSrc + advance;
+				while (runLength > 0 && dest->lines > 0)
+				{
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					while (count >= UNROLL_COUNT)
+					{
+						UNROLL(
+							SRCREADPIXEL(temp, pbSrc);
+							SRCNEXTPIXEL(pbSrc);
+							DESTWRITEPIXEL(pbDest, temp);
+							DESTNEXTPIXEL(pbDest); );
+						count = count - UNROLL_COUNT;
+					}
+					while (count > 0)
+					{
+						SRCREADPIXEL(temp, pbSrc);
+						SRCNEXTPIXEL(pbSrc);
+						DESTWRITEPIXEL(pbDest, temp);
+						DESTNEXTPIXEL(pbDest);
+						count = count - 1;
+					}
+					rle_dest_commit(dest, pbDest);
+				}
+				break;
+
+			/* Handle Special Order 1. */
+			case SPECIAL_FGBG_1:
+				pbSrc = pbSrc + 1;
+				if (fFirstLine)
+					WRITEFIRSTLINEFGBGIMAGE(dest, g_MaskSpecialFgBg1, fgPel, 8);
+				else
+					WRITEFGBGIMAGE(dest, g_MaskSpecialFgBg1, fgPel, 8);
+				break;
+
+			/* Handle Special Order 2. */
+			case SPECIAL_FGBG_2:
+				pbSrc = pbSrc + 1;
+				if (fFirstLine)
+					WRITEFIRSTLINEFGBGIMAGE(dest, g_MaskSpecialFgBg2, fgPel, 8);
+				else
+					WRITEFGBGIMAGE(dest, g_MaskSpecialFgBg2, fgPel, 8);
+				break;
+
+				/* Handle White Order. */
+			case SPECIAL_WHITE:
+				pbSrc = pbSrc + 1;
+				pbDest = dest->pos;
+				DESTWRITEPIXEL(pbDest, WHITE_PIXEL);
+				DESTNEXTPIXEL(pbDest);
+				rle_dest_commit(dest, pbDest);
+				break;
+
+			/* Handle Black Order. */
+			case SPECIAL_BLACK:
+				pbSrc = pbSrc + 1;
+				pbDest = dest->pos;
+				DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
+				DESTNEXTPIXEL(pbDest);
+				rle_dest_commit(dest, pbDest);
+				break;
+
+			/* Unknown order, the rest of the stream cannot be decoded. */
+			default:
+				return;
+		}
+	}
+}
@@ -17,10 +17,12 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
 #include <freerdp/freerdp.h>
 #include <freerdp/utils/hexdump.h>
 #include <freerdp/utils/stream.h>
 #include "libfreerdp-core/bitmap.h"
+#include "libfreerdp-gdi/color.h"
 
 #include "test_bitmap.h"
 
@@ -1126,6 +1128,22 @@ uint8 decompressed_32x32x32[] =
 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 
+#define BITMAP_CORPUS_ENTRY(_w, _h, _bpp) { #_w "x" #_h "x" #_bpp, \
+	compressed_ ## _w ## x ## _h ## x ## _bpp, sizeof(compressed_ ## _w ## x ## _h ## x ## _bpp), _w, _h, _bpp }
+
+BITMAP_CORPUS bitmap_corpora[] =
+{
+	BITMAP_CORPUS_ENTRY(16, 1, 8),
+	BITMAP_CORPUS_ENTRY(32, 32, 8),
+	BITMAP_CORPUS_ENTRY(16, 1, 16),
+	BITMAP_CORPUS_ENTRY(32, 32, 16),
+	BITMAP_CORPUS_ENTRY(16, 1, 24),
+	BITMAP_CORPUS_ENTRY(32, 32, 24),
+	BITMAP_CORPUS_ENTRY(16, 1, 32),
+	BITMAP_CORPUS_ENTRY(32, 32, 32),
+	{ NULL, NULL, 0, 0, 0, 0 }
+};
+
 int init_bitmap_suite(void)
 {
 	return 0;
@@ -1141,6 +1159,7 @@ int add_bitmap_suite(void)
 	add_test_suite(bitmap);
 
 	add_test_function(bitmap);
+	add_test_function(bitmap_convert);
 
 	return 0;
 }
@@ -1248,3 +1267,119 @@ void test_bitmap(void)
 
 	free(t);
 }
+
+/* extra bytes at the end of each destination scanline, left untouched by the decoder */
+#define CONVERT_PADDING		12
+#define CONVERT_FILL		0xA5
+
+/**
+ * Decompress a bitmap straight to another color depth into a destination wider than
+ * the bitmap, and compare it with a plain decompression followed by gdi_image_convert.
+ * @return number of mismatching scanlines and modified padding bytes
+ */
+
+static int test_bitmap_convert_case(uint8* compressed, int size, int width, int height,
+		int srcBpp, int dstBpp, HCLRCONV clrconv)
+{
+	int x, y;
+	int bad;
+	int stride;
+	int scanline;
+	uint8* decoded;
+	uint8* decoded32;
+	uint8* expected;
+	uint8* converted;
+
+	bad = 0;
+	scanline = width * ((dstBpp + 7) / 8);
+	stride = scanline + CONVERT_PADDING;
+
+	decoded = (uint8*) malloc(width * height * ((srcBpp + 7) / 8));
+	converted = (uint8*) malloc(stride * height);
+	memset(converted, CONVERT_FILL, stride * height);
+
+	if (bitmap_decompress(compressed, decoded, width, height, size, srcBpp, srcBpp) != True)
+		bad++;
+
+	if (bitmap_decompress_ex(compressed, converted, stride, width, height, size,
+			srcBpp, dstBpp, gdi_color_get_palette(clrconv, dstBpp)) != True)
+		bad++;
+
+	if (srcBpp == 24 && dstBpp == 16)
+	{
+		/* gdi_image_convert has no 24 to 16 bpp conversion, go through 32 bpp */
+		decoded32 = gdi_image_convert(decoded, NULL, width, height, 24, 32, clrconv);
+		expected = gdi_image_convert(decoded32, NULL, width, height, 32, 16, clrconv);
+		free(decoded32);
+	}
+	else
+	{
+		expected = gdi_image_convert(decoded, NULL, width, height, srcBpp, dstBpp, clrconv);
+	}
+
+	CU_ASSERT(expected != decoded);
+
+	for (y = 0; y < height; y++)
+	{
+		if (memcmp(&converted[y * stride], &expected[y * scanline], scanline) != 0)
+			bad++;
+
+		for (x = scanline; x < stride; x++)
+			bad += (converted[y * stride + x] != CONVERT_FILL);
+	}
+
+	if (expected != decoded)
+		free(expected);
+
+	free(converted);
+	free(decoded);
+
+	return bad;
+}
+
+#define test_bitmap_convert_corpus(_w, _h, _bpp, _srcBpp, _dstBpp, _clrconv) \
+	test_bitmap_convert_case(compressed_ ## _w ## x ## _h ## x ## _bpp, \
+		sizeof(compressed_ ## _w ## x ## _h ## x ## _bpp), _w, _h, _srcBpp, _dstBpp, _clrconv)
+
+void test_bitmap_convert(void)
+{
+	int i;
+	CLRCONV clrconv;
+	FRDP_PALETTE palette;
+	FRDP_PALETTEENTRY entries[256];
+
+	for (i = 0; i < 256; i++)
+	{
+		entries[i].red = i;
+		entries[i].green = i ^ 0x55;
+		entries[i].blue = i ^ 0xAA;
+	}
+
+	palette.count = 256;
+	palette.entries = entries;
+
+	/* the conversions done while decompressing, as chosen by gdi_decode_bitmap */
+	clrconv.alpha = 0;
+	clrconv.invert = 0;
+	clrconv.rgb555 = 0;
+	gdi_color_set_palette(&clrconv, &palette);
+
+	CU_ASSERT(test_bitmap_convert_corpus(16, 1, 8, 8, 16, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(32, 32, 8, 8, 16, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(16, 1, 8, 8, 32, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(32, 32, 8, 8, 32, &clrconv) == 0);
+
+	/* 15bpp bitmaps are compressed like 16bpp ones */
+	CU_ASSERT(test_bitmap_convert_corpus(16, 1, 16, 15, 16, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(32, 32, 16, 15, 16, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(16, 1, 16, 15, 32, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(32, 32, 16, 15, 32, &clrconv) == 0);
+
+	CU_ASSERT(test_bitmap_convert_corpus(16, 1, 16, 16, 32, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(32, 32, 16, 16, 32, &clrconv) == 0);
+
+	CU_ASSERT(test_bitmap_convert_corpus(16, 1, 24, 24, 16, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(32, 32, 24, 24, 16, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(16, 1, 24, 24, 32, &clrconv) == 0);
+	CU_ASSERT(test_bitmap_convert_corpus(32, 32, 24, 24, 32, &clrconv) == 0);
+}
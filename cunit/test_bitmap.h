@@ -24,3 +24,20 @@ int clean_bitmap_suite(void);
 int add_bitmap_suite(void);
 
 void test_bitmap(void);
+void test_bitmap_convert(void);
+
+/* compressed bitmaps of the test corpora, terminated by an entry without data */
+struct _BITMAP_CORPUS
+{
+	const char* name;
+	uint8* data;
+	int size;
+	int width;
+	int height;
+	int bpp;
+};
+typedef struct _BITMAP_CORPUS BITMAP_CORPUS;
+
+extern BITMAP_CORPUS bitmap_corpora[];
+
+boolean bitmap_decompress_ref(uint8* srcData, uint8* dstData, int width, int height, int size, int bpp);
@@ -19,7 +19,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <freerdp/freerdp.h>
+#include <freerdp/utils/cpu.h>
 #include "gdi.h"
 #include "color.h"
 #include "test_color.h"
@@ -44,6 +46,8 @@ int add_color_suite(void)
 	add_test_function(color_GetRGB16);
 	add_test_function(color_GetBGR_565);
 	add_test_function(color_GetBGR16);
+	add_test_function(color_image_convert);
+	add_test_function(color_set_palette);
 
 	return 0;
 }
@@ -150,3 +154,213 @@ void test_color_GetBGR16(void)
 	CU_ASSERT(b == 0xEF);
 }
 
+
+static void test_color_image_convert_kernels(void)
+{
+	int i;
+	int width = 37;
+	int height = 3;
+	int count = width * height;
+	int bad15, bad16, bad24, bad32, badex;
+	uint8 red, green, blue;
+	uint32 srcData[37 * 3];
+	uint32 dstData[37 * 3];
+	uint8* src = (uint8*) srcData;
+	uint8* dst = (uint8*) dstData;
+	uint16* src16 = (uint16*) src;
+	uint16* dst16 = (uint16*) dst;
+	uint32* src32 = (uint32*) src;
+	uint32* dst32 = (uint32*) dst;
+	uint32 pixel;
+	CLRCONV clrconv;
+
+	clrconv.alpha = 0;
+	clrconv.invert = 0;
+	clrconv.rgb555 = 0;
+	clrconv.palette = NULL;
+
+	srand(1);
+
+	for (i = 0; i < (int) sizeof(srcData); i++)
+		src[i] = rand();
+
+	bad15 = bad16 = bad24 = bad32 = badex = 0;
+
+	/* RGB565 to XRGB32 */
+	gdi_image_convert(src, dst, width, height, 16, 32, &clrconv);
+
+	for (i = 0; i < count; i++)
+	{
+		GetBGR16(red, green, blue, src16[i]);
+		pixel = BGR32(red, green, blue);
+		bad16 += (dst32[i] != pixel);
+	}
+
+	/* RGB555 to XRGB32 */
+	gdi_image_convert(src, dst, width, height, 15, 32, &clrconv);
+
+	for (i = 0; i < count; i++)
+	{
+		GetRGB15(red, green, blue, src16[i]);
+		pixel = RGB32(red, green, blue);
+		bad15 += (dst32[i] != pixel);
+	}
+
+	/* RGB24 to XRGB32 */
+	gdi_image_convert(src, dst, width, height, 24, 32, &clrconv);
+
+	for (i = 0; i < count; i++)
+	{
+		pixel = src[i * 3] | (src[i * 3 + 1] << 8) | (src[i * 3 + 2] << 16);
+		bad24 += (dst32[i] != pixel);
+	}
+
+	/* XRGB32 to RGB565 */
+	gdi_image_convert(src, dst, width, height, 32, 16, &clrconv);
+
+	for (i = 0; i < count; i++)
+	{
+		GetRGB32(red, green, blue, src32[i]);
+		pixel = RGB16(red, green, blue);
+		bad32 += (dst16[i] != pixel);
+	}
+
+	CU_ASSERT(bad15 == 0);
+	CU_ASSERT(bad16 == 0);
+	CU_ASSERT(bad24 == 0);
+	CU_ASSERT(bad32 == 0);
+
+	/* RGB565 to RGB555 and back */
+	clrconv.rgb555 = 1;
+	gdi_image_convert(src, dst, width, height, 16, 16, &clrconv);
+	bad16 = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		pixel = ((src16[i] >> 1) & 0x7FE0) | (src16[i] & 0x1F);
+		bad16 += (dst16[i] != pixel);
+	}
+
+	CU_ASSERT(bad16 == 0);
+
+	clrconv.rgb555 = 0;
+	memcpy(src, dst, count * 2);
+	gdi_image_convert(src, dst, width, height, 15, 16, &clrconv);
+	bad15 = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		GetRGB_555(red, green, blue, src16[i]);
+		RGB_555_565(red, green, blue);
+		pixel = RGB565(red, green, blue);
+		bad15 += (dst16[i] != pixel);
+	}
+
+	CU_ASSERT(bad15 == 0);
+
+	/* opaque alpha */
+	clrconv.alpha = 1;
+	gdi_image_convert(src, dst, width, height, 32, 32, &clrconv);
+	bad32 = 0;
+
+	for (i = 0; i < count; i++)
+		bad32 += (dst32[i] != (src32[i] | 0xFF000000));
+
+	CU_ASSERT(bad32 == 0);
+
+	/* bottom-up source converted into a wider destination */
+	memset(dst, 0, sizeof(dstData));
+	CU_ASSERT(gdi_image_convert_ex(&src[(height - 1) * width * 2], -width * 2, dst, width * 4,
+			width - 1, height, 16, 32, &clrconv) == True);
+
+	for (i = 0; i < count; i++)
+	{
+		pixel = 0;
+
+		if (i % width != width - 1)
+		{
+			GetBGR16(red, green, blue, src16[(height - 1 - i / width) * width + i % width]);
+			pixel = BGR32(red, green, blue);
+		}
+
+		badex += (dst32[i] != pixel);
+	}
+
+	CU_ASSERT(badex == 0);
+	CU_ASSERT(gdi_image_convert_ex(src, width, dst, width, width, height, 8, 8, &clrconv) == False);
+}
+
+void test_color_image_convert(void)
+{
+	/* the scalar kernels, then the vector ones where they are built */
+	gdi_color_init(0);
+	test_color_image_convert_kernels();
+
+	gdi_color_init(CPU_SSE2);
+	test_color_image_convert_kernels();
+
+	gdi_color_init(freerdp_cpu_features());
+}
+
+void test_color_set_palette(void)
+{
+	int i;
+	int bad;
+	uint8 src[256];
+	uint32 dst32[256];
+	uint16 dst16[256];
+	uint8 pattern[8];
+	uint32* brush;
+	CLRCONV clrconv;
+	FRDP_PALETTE palette;
+	FRDP_PALETTEENTRY entries[256];
+
+	for (i = 0; i < 256; i++)
+	{
+		src[i] = 255 - i;
+		entries[i].red = i;
+		entries[i].green = i ^ 0x55;
+		entries[i].blue = i ^ 0xAA;
+	}
+
+	palette.count = 256;
+	palette.entries = entries;
+
+	clrconv.alpha = 0;
+	clrconv.invert = 0;
+	clrconv.rgb555 = 0;
+	gdi_color_set_palette(&clrconv, &palette);
+
+	CU_ASSERT(gdi_color_get_palette(&clrconv, 32) == clrconv.palette32);
+	CU_ASSERT(gdi_color_get_palette(&clrconv, 24) == NULL);
+	CU_ASSERT(gdi_color_convert(0x12, 8, 32, &clrconv) == 0xFF1247B8);
+	CU_ASSERT(gdi_color_convert(0xFF, 8, 16, &clrconv) == 0xFD4A);
+	CU_ASSERT(gdi_color_convert(0xFF, 8, 15, &clrconv) == 0x7EAA);
+
+	gdi_image_convert(src, (uint8*) dst32, 16, 16, 8, 32, &clrconv);
+	gdi_image_convert(src, (uint8*) dst16, 16, 16, 8, 16, &clrconv);
+	bad = 0;
+
+	for (i = 0; i < 256; i++)
+	{
+		bad += (dst32[i] != clrconv.palette32[src[i]]);
+		bad += (dst16[i] != clrconv.palette16[src[i]]);
+	}
+
+	CU_ASSERT(bad == 0);
+
+	/* pattern brush colors are looked up as well */
+	memset(pattern, 0xF0, sizeof(pattern));
+	brush = (uint32*) gdi_mono_image_convert(pattern, NULL, 8, 8, 8, 32, 0x12, 0x34, &clrconv);
+	CU_ASSERT(brush[0] == clrconv.palette32[0x12]);
+	CU_ASSERT(brush[7] == clrconv.palette32[0x34]);
+	free(brush);
+
+	/* a new palette takes effect once the tables are rebuilt */
+	entries[0x12].red = 0;
+	gdi_color_set_palette(&clrconv, &palette);
+	CU_ASSERT(gdi_color_convert(0x12, 8, 32, &clrconv) == 0xFF0047B8);
+
+	gdi_color_set_palette(&clrconv, NULL);
+	CU_ASSERT(gdi_color_get_palette(&clrconv, 32) == NULL);
+}
@@ -29,3 +29,5 @@ void test_color_GetRGB_565(void);
 void test_color_GetRGB16(void);
 void test_color_GetBGR_565(void);
 void test_color_GetBGR16(void);
+void test_color_image_convert(void);
+void test_color_set_palette(void);
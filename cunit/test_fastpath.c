@@ -0,0 +1,226 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Fast-Path Unit Tests
+ *
+ * Copyright 2026 FreeRDP Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <freerdp/freerdp.h>
+#include <freerdp/utils/stream.h>
+
+#include "rdp.h"
+#include "fastpath.h"
+#include "test_fastpath.h"
+
+static rdpRdp* rdp;
+
+static int begin_paint_count;
+static int end_paint_count;
+static int synchronize_count;
+static int palette_count;
+static PALETTE_UPDATE last_palette;
+
+static void test_begin_paint(rdpUpdate* update)
+{
+	begin_paint_count++;
+}
+
+static void test_end_paint(rdpUpdate* update)
+{
+	end_paint_count++;
+}
+
+static void test_synchronize(rdpUpdate* update)
+{
+	synchronize_count++;
+}
+
+static void test_palette(rdpUpdate* update, PALETTE_UPDATE* palette)
+{
+	palette_count++;
+	memcpy(&last_palette, palette, sizeof(PALETTE_UPDATE));
+}
+
+int init_fastpath_suite(void)
+{
+	rdp = rdp_new(NULL);
+
+	rdp->update->BeginPaint = test_begin_paint;
+	rdp->update->EndPaint = test_end_paint;
+	rdp->update->Synchronize = test_synchronize;
+	rdp->update->Palette = test_palette;
+
+	return 0;
+}
+
+int clean_fastpath_suite(void)
+{
+	rdp_free(rdp);
+	return 0;
+}
+
+int add_fastpath_suite(void)
+{
+	add_test_suite(fastpath);
+
+	add_test_function(fastpath_read_header);
+	add_test_function(fastpath_update_codes);
+	add_test_function(fastpath_fragmentation);
+	add_test_function(fastpath_encrypted);
+
+	return 0;
+}
+
+static void reset_counts(void)
+{
+	begin_paint_count = 0;
+	end_paint_count = 0;
+	synchronize_count = 0;
+	palette_count = 0;
+	memset(&last_palette, 0, sizeof(PALETTE_UPDATE));
+}
+
+static void recv_fastpath_pdu(uint8* data, int length)
+{
+	STREAM* s;
+
+	s = stream_new(0);
+	s->data = s->p = data;
+	s->size = length;
+
+	fastpath_recv_updates(rdp->fastpath, s);
+
+	/* every update of the PDU is consumed */
+	CU_ASSERT(stream_get_length(s) == length);
+
+	s->data = NULL;
+	stream_free(s);
+}
+
+void test_fastpath_read_header(void)
+{
+	STREAM* s;
+	uint16 length;
+	uint8 encryptionFlags;
+
+	s = stream_new(0);
+
+	/* one byte length */
+	s->data = s->p = (uint8*) "\x00\x10";
+	s->size = 2;
+	length = fastpath_read_header(s, &encryptionFlags);
+	CU_ASSERT(length == 0x10);
+	CU_ASSERT(encryptionFlags == 0);
+	CU_ASSERT(stream_get_length(s) == 2);
+
+	/* two byte length, most significant bit of the first byte set */
+	s->data = s->p = (uint8*) "\x80\x81\x23";
+	s->size = 3;
+	length = fastpath_read_header(s, &encryptionFlags);
+	CU_ASSERT(length == 0x0123);
+	CU_ASSERT(encryptionFlags == FASTPATH_OUTPUT_ENCRYPTED);
+	CU_ASSERT(stream_get_length(s) == 3);
+
+	/* the encryption flags are optional */
+	s->data = s->p = (uint8*) "\x40\x7F";
+	s->size = 2;
+	length = fastpath_read_header(s, NULL);
+	CU_ASSERT(length == 0x7F);
+
+	s->data = NULL;
+	stream_free(s);
+}
+
+uint8 fastpath_update_codes_pdu[] =
+	"\x00\x13"
+	"\x05\x00\x00"			/* pointer hidden */
+	"\x06\x00\x00"			/* default pointer */
+	"\x03\x00\x00"			/* synchronize */
+	"\x0A\x02\x00\x01\x00"		/* cached pointer */
+	"\x03\x00\x00";			/* synchronize */
+
+void test_fastpath_update_codes(void)
+{
+	reset_counts();
+
+	/* updates without a callback are skipped over */
+	recv_fastpath_pdu(fastpath_update_codes_pdu, sizeof(fastpath_update_codes_pdu) - 1);
+
+	CU_ASSERT(begin_paint_count == 1);
+	CU_ASSERT(end_paint_count == 1);
+	CU_ASSERT(synchronize_count == 2);
+	CU_ASSERT(palette_count == 0);
+}
+
+uint8 fastpath_fragment_first_pdu[] =
+	"\x00\x13"
+	"\x22\x06\x00\x02\x00\x00\x00\x02\x00"	/* FASTPATH_FRAGMENT_FIRST palette */
+	"\x32\x05\x00\x00\x00\x11\x22\x33";	/* FASTPATH_FRAGMENT_NEXT palette */
+
+uint8 fastpath_fragment_last_pdu[] =
+	"\x00\x08"
+	"\x12\x03\x00\x44\x55\x66";		/* FASTPATH_FRAGMENT_LAST palette */
+
+void test_fastpath_fragmentation(void)
+{
+	reset_counts();
+
+	/* the update is dispatched once its last fragment is received */
+	recv_fastpath_pdu(fastpath_fragment_first_pdu, sizeof(fastpath_fragment_first_pdu) - 1);
+	CU_ASSERT(palette_count == 0);
+
+	recv_fastpath_pdu(fastpath_fragment_last_pdu, sizeof(fastpath_fragment_last_pdu) - 1);
+	CU_ASSERT(palette_count == 1);
+	CU_ASSERT(last_palette.number == 2);
+	CU_ASSERT(last_palette.entries[0] == 0x332211);
+	CU_ASSERT(last_palette.entries[1] == 0x665544);
+
+	CU_ASSERT(begin_paint_count == 2);
+	CU_ASSERT(end_paint_count == 2);
+
+	/* a new first fragment starts over */
+	reset_counts();
+	recv_fastpath_pdu(fastpath_fragment_first_pdu, sizeof(fastpath_fragment_first_pdu) - 1);
+	recv_fastpath_pdu(fastpath_fragment_first_pdu, sizeof(fastpath_fragment_first_pdu) - 1);
+	recv_fastpath_pdu(fastpath_fragment_last_pdu, sizeof(fastpath_fragment_last_pdu) - 1);
+	CU_ASSERT(palette_count == 1);
+	CU_ASSERT(last_palette.number == 2);
+	CU_ASSERT(last_palette.entries[1] == 0x665544);
+}
+
+void test_fastpath_encrypted(void)
+{
+	STREAM* s;
+	uint8 pdu[] = "\x80\x05\x03\x00\x00";
+
+	reset_counts();
+
+	/* encrypted PDUs are dropped */
+	s = stream_new(0);
+	s->data = s->p = pdu;
+	s->size = sizeof(pdu) - 1;
+
+	fastpath_recv_updates(rdp->fastpath, s);
+
+	CU_ASSERT(rdp->fastpath->encryptionFlags == FASTPATH_OUTPUT_ENCRYPTED);
+	CU_ASSERT(begin_paint_count == 0);
+	CU_ASSERT(synchronize_count == 0);
+
+	s->data = NULL;
+	stream_free(s);
+}
@@ -25,6 +25,7 @@
 #include "test_mcs.h"
 #include "test_color.h"
 #include "test_bitmap.h"
+#include "test_mppc.h"
 #include "test_libgdi.h"
 #include "test_list.h"
 #include "test_stream.h"
@@ -32,6 +33,11 @@
 #include "test_orders.h"
 #include "test_license.h"
 #include "test_transport.h"
+#include "test_input.h"
+#include "test_fastpath.h"
+#include "test_persistent.h"
+#include "test_pipeline.h"
+#include "test_planar.h"
 #include "test_chanman.h"
 #include "test_cliprdr.h"
 #include "test_drdynvc.h"
@@ -122,11 +128,17 @@ int main(int argc, char* argv[])
 		add_mcs_suite();
 		add_color_suite();
 		add_bitmap_suite();
+		add_mppc_suite();
 		add_libgdi_suite();
 		add_list_suite();
 		add_orders_suite();
 		add_license_suite();
 		add_stream_suite();
+		add_input_suite();
+		add_fastpath_suite();
+		add_persistent_suite();
+		add_pipeline_suite();
+		add_planar_suite();
 	}
 	else
 	{
@@ -144,6 +156,10 @@ int main(int argc, char* argv[])
 			{
 				add_bitmap_suite();
 			}
+			else if (strcmp("mppc", argv[*pindex]) == 0)
+			{
+				add_mppc_suite();
+			}
 			else if (strcmp("libgdi", argv[*pindex]) == 0)
 			{
 				add_libgdi_suite();
@@ -172,6 +188,26 @@ int main(int argc, char* argv[])
 			{
 				add_transport_suite();
 			}
+			else if (strcmp("input", argv[*pindex]) == 0)
+			{
+				add_input_suite();
+			}
+			else if (strcmp("fastpath", argv[*pindex]) == 0)
+			{
+				add_fastpath_suite();
+			}
+			else if (strcmp("persistent", argv[*pindex]) == 0)
+			{
+				add_persistent_suite();
+			}
+			else if (strcmp("pipeline", argv[*pindex]) == 0)
+			{
+				add_pipeline_suite();
+			}
+			else if (strcmp("planar", argv[*pindex]) == 0)
+			{
+				add_planar_suite();
+			}
 			else if (strcmp("chanman", argv[*pindex]) == 0)
 			{
 				add_chanman_suite();
@@ -0,0 +1,147 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Input Unit Tests
+ *
+ * Copyright 2026 FreeRDP Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <freerdp/freerdp.h>
+#include <freerdp/utils/stream.h>
+
+#include "rdp.h"
+#include "input.h"
+#include "test_input.h"
+
+static rdpRdp* rdp;
+static int sockets[2];
+
+int init_input_suite(void)
+{
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0)
+		return -1;
+
+	/* PDUs are sent on one end of the pair and read back from the other one */
+	rdp = rdp_new(NULL);
+	rdp->settings->fast_path_input = True;
+	rdp->transport->tcp->sockfd = sockets[0];
+
+	return 0;
+}
+
+int clean_input_suite(void)
+{
+	rdp_free(rdp);
+	close(sockets[0]);
+	close(sockets[1]);
+	return 0;
+}
+
+int add_input_suite(void)
+{
+	add_test_suite(input);
+
+	add_test_function(input_batch);
+	add_test_function(input_batch_num_events);
+
+	return 0;
+}
+
+static STREAM* recv_input_pdu(int length)
+{
+	int status;
+	STREAM* s;
+
+	s = stream_new(length);
+
+	while (stream_get_pos(s) < length)
+	{
+		status = recv(sockets[1], stream_get_tail(s), length - stream_get_pos(s), 0);
+
+		if (status <= 0)
+			break;
+
+		stream_seek(s, status);
+	}
+
+	return s;
+}
+
+uint8 input_batch_expected[] =
+	"\x10\x80\x11"
+	"\x00\x1E"
+	"\x80\xE9\x00"
+	"\x20\x00\x08\x02\x01\x04\x03"
+	"\x03\x1D";
+
+void test_input_batch(void)
+{
+	STREAM* s;
+	rdpInput* input = rdp->input;
+
+	input->BeginBatch(input);
+	input->KeyboardEvent(input, KBD_FLAGS_DOWN, 0x1E);
+	input->UnicodeKeyboardEvent(input, 0x00E9);
+	input->MouseEvent(input, PTR_FLAGS_MOVE, 0x0102, 0x0304);
+	input->KeyboardEvent(input, KBD_FLAGS_RELEASE | KBD_FLAGS_EXTENDED, 0x1D);
+
+	/* nothing is sent before the batch is flushed */
+	CU_ASSERT(input->numberEvents == 4);
+
+	input->FlushBatch(input);
+	CU_ASSERT(input->numberEvents == 0);
+	CU_ASSERT(input->batching == False);
+
+	s = recv_input_pdu(sizeof(input_batch_expected) - 1);
+	ASSERT_STREAM(s, input_batch_expected, sizeof(input_batch_expected) - 1);
+	stream_free(s);
+}
+
+void test_input_batch_num_events(void)
+{
+	int i;
+	STREAM* s;
+	uint8* p;
+	rdpInput* input = rdp->input;
+
+	/* from 16 events on, numEvents no longer fits in fpInputHeader */
+	input->BeginBatch(input);
+
+	for (i = 0; i < 16; i++)
+		input->MouseEvent(input, PTR_FLAGS_MOVE, i, i);
+
+	input->FlushBatch(input);
+
+	s = recv_input_pdu(4 + 16 * 7);
+	CU_ASSERT(stream_get_length(s) == 4 + 16 * 7);
+
+	p = s->data;
+	CU_ASSERT(p[0] == 0x00); /* fpInputHeader */
+	CU_ASSERT(p[1] == 0x80 && p[2] == 4 + 16 * 7); /* length */
+	CU_ASSERT(p[3] == 16); /* numEvents */
+
+	for (i = 0; i < 16; i++)
+	{
+		p = s->data + 4 + i * 7;
+		CU_ASSERT(p[0] == 0x20 && p[1] == 0x00 && p[2] == 0x08);
+		CU_ASSERT(p[3] == i && p[5] == i);
+	}
+
+	stream_free(s);
+}
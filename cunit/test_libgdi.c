@@ -21,6 +21,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <freerdp/freerdp.h>
+#include <freerdp/utils/cpu.h>
 
 #include "gdi.h"
 #include "gdi_dc.h"
@@ -28,12 +29,16 @@
 #include "gdi_line.h"
 #include "gdi_shape.h"
 #include "gdi_brush.h"
+#include "gdi_cache.h"
 #include "gdi_region.h"
+#include "gdi_render.h"
+#include "gdi_decoder.h"
 #include "gdi_bitmap.h"
 #include "gdi_palette.h"
 #include "gdi_drawing.h"
 #include "gdi_clipping.h"
 #include "gdi_32bpp.h"
+#include "gdi_rop.h"
 
 #include "test_libgdi.h"
 
@@ -57,6 +62,7 @@ int add_libgdi_suite(void)
 	add_test_function(gdi_CreateCompatibleBitmap);
 	add_test_function(gdi_CreatePen);
 	add_test_function(gdi_CreateSolidBrush);
+	add_test_function(gdi_SetDCBrushColor);
 	add_test_function(gdi_CreatePatternBrush);
 	add_test_function(gdi_CreateRectRgn);
 	add_test_function(gdi_CreateRect);
@@ -71,8 +77,16 @@ int add_libgdi_suite(void)
 	add_test_function(gdi_BitBlt_32bpp);
 	add_test_function(gdi_BitBlt_16bpp);
 	add_test_function(gdi_BitBlt_8bpp);
+	add_test_function(gdi_rop);
+	add_test_function(gdi_rop3);
 	add_test_function(gdi_ClipCoords);
 	add_test_function(gdi_InvalidateRegion);
+	add_test_function(gdi_InvalidateDamage);
+	add_test_function(gdi_SetClipRects);
+	add_test_function(gdi_GlyphBlt);
+	add_test_function(gdi_MemBlt);
+	add_test_function(gdi_decoder);
+	add_test_function(gdi_render);
 
 	return 0;
 }
@@ -1345,6 +1359,39 @@ void test_gdi_CreateSolidBrush(void)
 	gdi_DeleteObject((HGDIOBJECT) hBrush);
 }
 
+void test_gdi_SetDCBrushColor(void)
+{
+	HGDI_DC hdc;
+	HGDI_BRUSH hBrush;
+	HGDI_PEN hPen;
+
+	hdc = gdi_GetDC();
+
+	/* the DC brush and pen are created on first use */
+	CU_ASSERT(hdc->dcBrush == NULL);
+	CU_ASSERT(hdc->dcPen == NULL);
+	CU_ASSERT(hdc->dcPatternBrush == NULL);
+
+	CU_ASSERT(gdi_SetDCBrushColor(hdc, 0xAABBCCDD) == 0);
+	hBrush = hdc->dcBrush;
+	CU_ASSERT(hBrush != NULL);
+	CU_ASSERT(hBrush->objectType == GDIOBJECT_BRUSH);
+	CU_ASSERT(hBrush->style == GDI_BS_SOLID);
+	CU_ASSERT(gdi_SetDCBrushColor(hdc, 0x11223344) == 0xAABBCCDD);
+	CU_ASSERT(hdc->dcBrush == hBrush);
+	CU_ASSERT(hBrush->color == 0x11223344);
+
+	CU_ASSERT(gdi_SetDCPenColor(hdc, 0xAABBCCDD) == 0);
+	hPen = hdc->dcPen;
+	CU_ASSERT(hPen != NULL);
+	CU_ASSERT(hPen->objectType == GDIOBJECT_PEN);
+	CU_ASSERT(gdi_SetDCPenColor(hdc, 0x11223344) == 0xAABBCCDD);
+	CU_ASSERT(hdc->dcPen == hPen);
+	CU_ASSERT(hPen->color == 0x11223344);
+
+	gdi_DeleteDC(hdc);
+}
+
 void test_gdi_CreatePatternBrush(void)
 {
 	HGDI_BRUSH hBrush;
@@ -1530,7 +1577,8 @@ void test_gdi_LineTo(void)
 	clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
 	clrconv->alpha = 1;
 	clrconv->invert = 0;
-	clrconv->palette = hPalette;
+	clrconv->rgb555 = 0;
+	gdi_color_set_palette(clrconv, hPalette);
 
 	data = (uint8*) gdi_image_convert((uint8*) line_to_case_1, NULL, 16, 16, 8, bitsPerPixel, clrconv);
 	hBmp_LineTo_1 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
@@ -1848,7 +1896,8 @@ void test_gdi_Ellipse(void)
 	clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
 	clrconv->alpha = 1;
 	clrconv->invert = 0;
-	clrconv->palette = hPalette;
+	clrconv->rgb555 = 0;
+	gdi_color_set_palette(clrconv, hPalette);
 
 	data = (uint8*) gdi_image_convert((uint8*) ellipse_case_1, NULL, 16, 16, 8, bitsPerPixel, clrconv);
 	hBmp_Ellipse_1 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
@@ -2006,7 +2055,8 @@ void test_gdi_BitBlt_32bpp(void)
 	clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
 	clrconv->alpha = 1;
 	clrconv->invert = 0;
-	clrconv->palette = hPalette;
+	clrconv->rgb555 = 0;
+	gdi_color_set_palette(clrconv, hPalette);
 
 	data = (uint8*) gdi_image_convert((uint8*) bmp_SRC, NULL, 16, 16, 8, bitsPerPixel, clrconv);
 	hBmpSrc = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
@@ -2260,7 +2310,8 @@ void test_gdi_BitBlt_16bpp(void)
 	clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
 	clrconv->alpha = 1;
 	clrconv->invert = 0;
-	clrconv->palette = hPalette;
+	clrconv->rgb555 = 0;
+	gdi_color_set_palette(clrconv, hPalette);
 
 	data = (uint8*) gdi_image_convert((uint8*) bmp_SRC, NULL, 16, 16, 8, bitsPerPixel, clrconv);
 	hBmpSrc = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
@@ -2514,7 +2565,8 @@ void test_gdi_BitBlt_8bpp(void)
 	clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
 	clrconv->alpha = 1;
 	clrconv->invert = 0;
-	clrconv->palette = hPalette;
+	clrconv->rgb555 = 0;
+	gdi_color_set_palette(clrconv, hPalette);
 
 	data = (uint8*) gdi_image_convert((uint8*) bmp_SRC, NULL, 16, 16, 8, bitsPerPixel, clrconv);
 	hBmpSrc = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
@@ -2723,6 +2775,269 @@ void test_gdi_BitBlt_8bpp(void)
 	CU_ASSERT(CompareBitmaps(hBmpDst, hBmp_SPna) == 1)
 }
 
+static HGDI_BITMAP test_rop_random_bitmap(int width, int height, int bpp, boolean glyph)
+{
+	int i;
+	uint8* data;
+
+	data = (uint8*) malloc(width * height * bpp / 8);
+
+	/* glyph bitmaps only hold 0x00 and 0xFF */
+	for (i = 0; i < width * height * bpp / 8; i++)
+		data[i] = (glyph) ? ((rand() & 1) ? 0xFF : 0x00) : (rand() & 0xFF);
+
+	return gdi_CreateBitmap(width, height, bpp, data);
+}
+
+void test_gdi_rop(void)
+{
+	int i, k;
+	int bpp;
+	int size;
+	int failures;
+	int unchanged;
+	HGDI_DC hdcSrc;
+	HGDI_DC hdcDst;
+	HGDI_DC hdcGlyph;
+	HGDI_BITMAP hBmpSrc;
+	HGDI_BITMAP hBmpDst;
+	HGDI_BITMAP hBmpGlyph;
+	uint8 original[45 * 7 * 4];
+	uint8 scalar[45 * 7 * 4];
+	GDI_COLOR brushColor;
+	GDI_COLOR textColor;
+	int rops[] =
+	{
+		GDI_SRCINVERT, GDI_SRCAND, GDI_SRCPAINT, GDI_DSTINVERT,
+		GDI_PATCOPY, GDI_PATINVERT, GDI_DSPDxax
+	};
+	/* odd widths and offsets exercise both the vector bodies and the scalar tails */
+	int rects[][6] =
+	{
+		{ 0, 0, 45, 7, 0, 0 }, { 3, 1, 37, 5, 1, 2 }, { 1, 2, 17, 3, 20, 4 },
+		{ 2, 3, 16, 4, 9, 0 }, { 5, 0, 1, 7, 44, 0 }, { 7, 6, 33, 1, 2, 5 }
+	};
+
+	srand(1);
+	failures = 0;
+	unchanged = 0;
+
+	brushColor = (GDI_COLOR) ARGB32(0xFF, 0x12, 0xB4, 0x7E);
+	textColor = (GDI_COLOR) ARGB32(0xFF, 0xC9, 0x35, 0x6A);
+
+	for (bpp = 8; bpp <= 32; bpp *= 2)
+	{
+		hdcSrc = gdi_GetDC();
+		hdcSrc->bitsPerPixel = bpp;
+		hdcSrc->bytesPerPixel = bpp / 8;
+
+		hdcDst = gdi_GetDC();
+		hdcDst->bitsPerPixel = bpp;
+		hdcDst->bytesPerPixel = bpp / 8;
+
+		hdcGlyph = gdi_GetDC();
+		hdcGlyph->bitsPerPixel = 8;
+		hdcGlyph->bytesPerPixel = 1;
+
+		hBmpSrc = test_rop_random_bitmap(45, 7, bpp, False);
+		hBmpDst = test_rop_random_bitmap(45, 7, bpp, False);
+		hBmpGlyph = test_rop_random_bitmap(45, 7, 8, True);
+		size = 45 * 7 * bpp / 8;
+		memcpy(original, hBmpDst->data, size);
+
+		gdi_SelectObject(hdcSrc, (HGDIOBJECT) hBmpSrc);
+		gdi_SelectObject(hdcDst, (HGDIOBJECT) hBmpDst);
+		gdi_SelectObject(hdcGlyph, (HGDIOBJECT) hBmpGlyph);
+		hdcDst->brush = gdi_CreateSolidBrush(brushColor);
+		hdcDst->textColor = textColor;
+
+		for (k = 0; k < (int) (sizeof(rops) / sizeof(int)); k++)
+		{
+			/* glyphs are not drawn with the scanline kernels at 8bpp */
+			if (rops[k] == GDI_DSPDxax && bpp == 8)
+				continue;
+
+			for (i = 0; i < (int) (sizeof(rects) / sizeof(rects[0])); i++)
+			{
+				/* the same blit with the scalar kernels, then with the vector ones */
+				memcpy(hBmpDst->data, original, size);
+				gdi_rop_init(0);
+				gdi_BitBlt(hdcDst, rects[i][0], rects[i][1], rects[i][2], rects[i][3],
+					(rops[k] == GDI_DSPDxax) ? hdcGlyph : hdcSrc, rects[i][4], rects[i][5], rops[k]);
+				memcpy(scalar, hBmpDst->data, size);
+
+				memcpy(hBmpDst->data, original, size);
+				gdi_rop_init(CPU_SSE2);
+				gdi_BitBlt(hdcDst, rects[i][0], rects[i][1], rects[i][2], rects[i][3],
+					(rops[k] == GDI_DSPDxax) ? hdcGlyph : hdcSrc, rects[i][4], rects[i][5], rops[k]);
+
+				failures += (memcmp(hBmpDst->data, scalar, size) != 0);
+				unchanged += (memcmp(original, scalar, size) == 0);
+			}
+		}
+
+		gdi_DeleteObject((HGDIOBJECT) hdcDst->brush);
+		gdi_DeleteObject((HGDIOBJECT) hBmpSrc);
+		gdi_DeleteObject((HGDIOBJECT) hBmpDst);
+		gdi_DeleteObject((HGDIOBJECT) hBmpGlyph);
+		gdi_DeleteDC(hdcSrc);
+		gdi_DeleteDC(hdcDst);
+		gdi_DeleteDC(hdcGlyph);
+	}
+
+	gdi_rop_init(freerdp_cpu_features());
+
+	CU_ASSERT(failures == 0);
+	CU_ASSERT(unchanged == 0);
+}
+
+static uint8 test_rop3_reference(int index, uint8 d, uint8 s, uint8 p)
+{
+	int bit;
+	int term;
+	uint8 result = 0;
+
+	for (bit = 0; bit < 8; bit++)
+	{
+		term = (((p >> bit) & 1) << 2) | (((s >> bit) & 1) << 1) | ((d >> bit) & 1);
+		result |= ((index >> term) & 1) << bit;
+	}
+
+	return result;
+}
+
+static HGDI_BITMAP test_rop3_random_bitmap(int width, int height)
+{
+	int i;
+	uint8* data;
+
+	data = (uint8*) malloc(width * height * 4);
+
+	for (i = 0; i < width * height * 4; i++)
+		data[i] = rand() & 0xFF;
+
+	return gdi_CreateBitmap(width, height, 32, data);
+}
+
+void test_gdi_rop3(void)
+{
+	int i, k;
+	int x, y;
+	int index;
+	int failures;
+	uint8* patp;
+	HGDI_DC hdcSrc;
+	HGDI_DC hdcDst;
+	HGDI_BITMAP hBmpSrc;
+	HGDI_BITMAP hBmpDst;
+	HGDI_BITMAP hBmpRef;
+	HGDI_BITMAP hBmpPat;
+	uint8 original[16 * 16 * 4];
+	uint8 color[4] = { 0, 0, 0, 0 };
+	uint8 rgb[4] = { 0xFF, 0xFF, 0xFF, 0x00 };
+	int rops[] =
+	{
+		GDI_SRCCOPY, GDI_SRCPAINT, GDI_SRCAND, GDI_SRCINVERT, GDI_SRCERASE,
+		GDI_NOTSRCCOPY, GDI_NOTSRCERASE, GDI_MERGECOPY, GDI_MERGEPAINT,
+		GDI_PATCOPY, GDI_PATPAINT, GDI_PATINVERT, GDI_DSTINVERT,
+		GDI_BLACKNESS, GDI_WHITENESS, GDI_SPna, GDI_DSna
+	};
+
+	srand(1);
+
+	hdcSrc = gdi_GetDC();
+	hdcSrc->bytesPerPixel = 4;
+	hdcSrc->bitsPerPixel = 32;
+
+	hdcDst = gdi_GetDC();
+	hdcDst->bytesPerPixel = 4;
+	hdcDst->bitsPerPixel = 32;
+
+	hBmpSrc = test_rop3_random_bitmap(16, 16);
+	hBmpDst = test_rop3_random_bitmap(16, 16);
+	hBmpRef = test_rop3_random_bitmap(16, 16);
+	hBmpPat = test_rop3_random_bitmap(8, 8);
+	memcpy(original, hBmpDst->data, sizeof(original));
+
+	gdi_SelectObject(hdcSrc, (HGDIOBJECT) hBmpSrc);
+	gdi_SelectObject(hdcDst, (HGDIOBJECT) hBmpDst);
+	hdcDst->brush = gdi_CreatePatternBrush(hBmpPat);
+
+	/* all 256 ternary raster operations against a bit by bit evaluation */
+	failures = 0;
+
+	for (index = 0; index < 256; index++)
+	{
+		memcpy(hBmpDst->data, original, sizeof(original));
+		gdi_rop3_blt(hdcDst, 1, 2, 13, 11, hdcSrc, 2, 1, gdi_rop3_code(index), color, rgb);
+
+		for (y = 0; y < 16; y++)
+		{
+			for (x = 0; x < 16; x++)
+			{
+				for (k = 0; k < 4; k++)
+				{
+					i = (y * 16 + x) * 4 + k;
+
+					if (x < 1 || x >= 14 || y < 2 || y >= 13 || k == 3)
+					{
+						failures += (hBmpDst->data[i] != original[i]);
+						continue;
+					}
+
+					patp = gdi_get_brush_pointer(hdcDst, x - 1, y - 2);
+
+					failures += (hBmpDst->data[i] != test_rop3_reference(index, original[i],
+						hBmpSrc->data[((y - 1) * 16 + x + 1) * 4 + k], patp[k]));
+				}
+			}
+		}
+	}
+
+	CU_ASSERT(failures == 0);
+
+	/* raster operations with a dedicated routine */
+	failures = 0;
+
+	for (k = 0; k < (int) (sizeof(rops) / sizeof(int)); k++)
+	{
+		memcpy(hBmpDst->data, original, sizeof(original));
+		gdi_BitBlt(hdcDst, 0, 0, 16, 16, hdcSrc, 0, 0, rops[k]);
+		memcpy(hBmpRef->data, hBmpDst->data, sizeof(original));
+
+		memcpy(hBmpDst->data, original, sizeof(original));
+		gdi_rop3_blt(hdcDst, 0, 0, 16, 16, hdcSrc, 0, 0, rops[k], color, rgb);
+
+		/* the dedicated routines do not all preserve the alpha byte */
+		for (i = 0; i < 16 * 16 * 4; i++)
+		{
+			if ((i & 3) != 3)
+				failures += (hBmpDst->data[i] != hBmpRef->data[i]);
+		}
+	}
+
+	CU_ASSERT(failures == 0);
+
+	/* overlapping source and destination */
+	memcpy(hBmpDst->data, original, sizeof(original));
+	memcpy(hBmpRef->data, original, sizeof(original));
+	gdi_rop3_blt(hdcDst, 3, 4, 10, 10, hdcDst, 1, 2, GDI_SRCCOPY, color, NULL);
+
+	failures = 0;
+
+	for (y = 0; y < 10; y++)
+		failures += memcmp(&hBmpDst->data[((y + 4) * 16 + 3) * 4], &original[((y + 2) * 16 + 1) * 4], 40) != 0;
+
+	CU_ASSERT(failures == 0);
+
+	gdi_DeleteObject((HGDIOBJECT) hdcDst->brush);
+	gdi_DeleteObject((HGDIOBJECT) hBmpSrc);
+	gdi_DeleteObject((HGDIOBJECT) hBmpDst);
+	gdi_DeleteObject((HGDIOBJECT) hBmpRef);
+	gdi_DeleteDC(hdcSrc);
+	gdi_DeleteDC(hdcDst);
+}
+
 void test_gdi_ClipCoords(void)
 {
 	HGDI_DC hdc;
@@ -2866,6 +3181,9 @@ void test_gdi_InvalidateRegion(void)
 	hdc->hwnd = (HGDI_WND) malloc(sizeof(GDI_WND));
 	hdc->hwnd->invalid = gdi_CreateRectRgn(0, 0, 0, 0);
 	hdc->hwnd->invalid->null = 1;
+	hdc->hwnd->count = 0;
+	hdc->hwnd->ninvalid = 0;
+	hdc->hwnd->cinvalid = NULL;
 	invalid = hdc->hwnd->invalid;
 	
 	rgn1 = gdi_CreateRectRgn(0, 0, 0, 0);
@@ -2985,3 +3303,763 @@ void test_gdi_InvalidateRegion(void)
 	gdi_InvalidateRegion(hdc, rgn1->x, rgn1->y, rgn1->w, rgn1->h);
 	CU_ASSERT(gdi_EqualRgn(invalid, rgn2) == 1);
 }
+
+void test_gdi_InvalidateDamage(void)
+{
+	int i;
+	HGDI_DC hdc;
+	HGDI_WND hwnd;
+	HGDI_BITMAP bmp;
+	GDI_RGN expected;
+
+	hdc = gdi_GetDC();
+	hdc->bytesPerPixel = 4;
+	hdc->bitsPerPixel = 32;
+	bmp = gdi_CreateBitmap(1024, 768, 4, NULL);
+	gdi_SelectObject(hdc, (HGDIOBJECT) bmp);
+	gdi_SetNullClipRgn(hdc);
+
+	hdc->hwnd = hwnd = (HGDI_WND) malloc(sizeof(GDI_WND));
+	hwnd->invalid = gdi_CreateRectRgn(0, 0, 0, 0);
+	hwnd->invalid->null = 1;
+	hwnd->count = GDI_MAX_INVALID_RECTS;
+	hwnd->ninvalid = 0;
+	hwnd->cinvalid = (HGDI_RGN) malloc(sizeof(GDI_RGN) * hwnd->count);
+
+	/* opposite corners stay apart, in band order */
+	gdi_InvalidateRegion(hdc, 1000, 700, 24, 68);
+	gdi_InvalidateRegion(hdc, 0, 0, 10, 10);
+	CU_ASSERT(hwnd->ninvalid == 2);
+	gdi_SetRgn(&expected, 0, 0, 10, 10);
+	CU_ASSERT(gdi_EqualRgn(&hwnd->cinvalid[0], &expected) == 1);
+	gdi_SetRgn(&expected, 1000, 700, 24, 68);
+	CU_ASSERT(gdi_EqualRgn(&hwnd->cinvalid[1], &expected) == 1);
+
+	/* contained rectangles add nothing */
+	gdi_InvalidateRegion(hdc, 2, 2, 5, 5);
+	CU_ASSERT(hwnd->ninvalid == 2);
+
+	/* adjacent rectangles in a band merge */
+	gdi_InvalidateRegion(hdc, 10, 0, 10, 10);
+	CU_ASSERT(hwnd->ninvalid == 2);
+	gdi_SetRgn(&expected, 0, 0, 20, 10);
+	CU_ASSERT(gdi_EqualRgn(&hwnd->cinvalid[0], &expected) == 1);
+
+	/* clipped to the bitmap */
+	gdi_InvalidateRegion(hdc, 500, -10, 10, 20);
+	CU_ASSERT(hwnd->ninvalid == 3);
+	gdi_SetRgn(&expected, 500, 0, 10, 10);
+	CU_ASSERT(gdi_EqualRgn(&hwnd->cinvalid[1], &expected) == 1);
+
+	/* a full list merges instead of growing */
+	hwnd->ninvalid = 0;
+
+	for (i = 0; i < GDI_MAX_INVALID_RECTS * 2; i++)
+		gdi_InvalidateRegion(hdc, (i % 8) * 128, (i / 8) * 96, 4, 4);
+
+	CU_ASSERT(hwnd->ninvalid > 0 && hwnd->ninvalid <= GDI_MAX_INVALID_RECTS);
+
+	for (i = 1; i < hwnd->ninvalid; i++)
+	{
+		CU_ASSERT(hwnd->cinvalid[i - 1].y < hwnd->cinvalid[i].y ||
+			(hwnd->cinvalid[i - 1].y == hwnd->cinvalid[i].y && hwnd->cinvalid[i - 1].x <= hwnd->cinvalid[i].x));
+	}
+
+	gdi_DeleteObject((HGDIOBJECT) bmp);
+	gdi_DeleteDC(hdc);
+}
+
+void test_gdi_SetClipRects(void)
+{
+	int x, y;
+	int inside;
+	int badPixels;
+	HGDI_DC hdc;
+	GDI_RECT rect;
+	GDI_RGN expected;
+	GDI_RGN rects[2];
+	HGDI_BRUSH hBrush;
+	HGDI_BITMAP hBitmap;
+	uint32* data;
+	uint32 orig[32 * 32];
+	uint8 mask[32 * 32];
+	GDI_COLOR color;
+
+	hdc = gdi_GetDC();
+	hdc->bytesPerPixel = 4;
+	hdc->bitsPerPixel = 32;
+
+	hBitmap = gdi_CreateCompatibleBitmap(hdc, 32, 32);
+	gdi_SelectObject(hdc, (HGDIOBJECT) hBitmap);
+	data = (uint32*) hBitmap->data;
+
+	/* overlapping rectangles are split into bands */
+	gdi_SetRgn(&rects[0], 0, 0, 10, 10);
+	gdi_SetRgn(&rects[1], 5, 5, 10, 10);
+	gdi_SetClipRects(hdc, rects, 2);
+	CU_ASSERT(hdc->nclip == 3);
+	gdi_SetRgn(&expected, 0, 0, 10, 5);
+	CU_ASSERT(gdi_EqualRgn(&hdc->cclip[0], &expected) == 1);
+	gdi_SetRgn(&expected, 0, 5, 15, 5);
+	CU_ASSERT(gdi_EqualRgn(&hdc->cclip[1], &expected) == 1);
+	gdi_SetRgn(&expected, 5, 10, 10, 5);
+	CU_ASSERT(gdi_EqualRgn(&hdc->cclip[2], &expected) == 1);
+	gdi_SetRgn(&expected, 0, 0, 15, 15);
+	CU_ASSERT(gdi_EqualRgn(hdc->clip, &expected) == 1);
+
+	/* vertically adjacent bands with the same spans are coalesced */
+	gdi_SetRgn(&rects[0], 0, 0, 4, 4);
+	gdi_SetRgn(&rects[1], 0, 4, 4, 4);
+	gdi_SetClipRects(hdc, rects, 2);
+	CU_ASSERT(hdc->nclip == 1);
+	gdi_SetRgn(&expected, 0, 0, 4, 8);
+	CU_ASSERT(gdi_EqualRgn(&hdc->cclip[0], &expected) == 1);
+
+	/* filling through an L-shaped region */
+	gdi_SetRgn(&rects[0], 0, 0, 16, 8);
+	gdi_SetRgn(&rects[1], 0, 8, 8, 8);
+	gdi_SetClipRects(hdc, rects, 2);
+
+	memset(data, 0, 32 * 32 * 4);
+	color = (GDI_COLOR) ARGB32(0xFF, 0xAA, 0xBB, 0xCC);
+	hBrush = gdi_CreateSolidBrush(color);
+	gdi_SetRect(&rect, 4, 4, 31, 31);
+	gdi_FillRect(hdc, &rect, hBrush);
+	gdi_DeleteObject((HGDIOBJECT) hBrush);
+
+	badPixels = 0;
+
+	for (y = 0; y < 32; y++)
+	{
+		for (x = 0; x < 32; x++)
+		{
+			inside = (x >= 4 && y >= 4) && ((y < 8 && x < 16) || (y < 16 && x < 8));
+
+			if ((data[y * 32 + x] != 0) != inside)
+				badPixels++;
+		}
+	}
+
+	CU_ASSERT(badPixels == 0);
+
+	/* overlapping blit within the same bitmap reads every source pixel before writing it */
+	for (x = 0; x < 32 * 32; x++)
+		orig[x] = data[x] = x;
+
+	gdi_BitBlt(hdc, 2, 2, 20, 20, hdc, 0, 0, GDI_SRCCOPY);
+
+	badPixels = 0;
+
+	for (y = 0; y < 32; y++)
+	{
+		for (x = 0; x < 32; x++)
+		{
+			inside = (x >= 2 && y >= 2) && ((y < 8 && x < 16) || (y < 16 && x < 8));
+
+			if (data[y * 32 + x] != (inside ? orig[(y - 2) * 32 + (x - 2)] : orig[y * 32 + x]))
+				badPixels++;
+		}
+	}
+
+	CU_ASSERT(badPixels == 0);
+
+	/* glyphs are drawn through the region as well */
+	for (y = 0; y < 32; y++)
+	{
+		for (x = 0; x < 32; x++)
+			mask[y * 32 + x] = ((x + y) & 1) ? 0xFF : 0;
+	}
+
+	memset(data, 0, 32 * 32 * 4);
+	gdi_GlyphBlt(hdc, 4, 4, 28, 28, mask, 4, 4, 32, color);
+
+	badPixels = 0;
+
+	for (y = 0; y < 32; y++)
+	{
+		for (x = 0; x < 32; x++)
+		{
+			inside = (x >= 4 && y >= 4) && ((y < 8 && x < 16) || (y < 16 && x < 8));
+
+			if ((data[y * 32 + x] != 0) != (inside && mask[y * 32 + x]))
+				badPixels++;
+		}
+	}
+
+	CU_ASSERT(badPixels == 0);
+
+	gdi_SetNullClipRgn(hdc);
+	CU_ASSERT(hdc->nclip == 0);
+
+	gdi_DeleteObject((HGDIOBJECT) hBitmap);
+	gdi_DeleteDC(hdc);
+}
+
+void test_gdi_GlyphBlt(void)
+{
+	int x, y;
+	int bpp;
+	int inside;
+	int badPixels;
+	uint8* pixel;
+	uint8 mask[8 * 8];
+	HGDI_DC hdc;
+	HGDI_BITMAP hBitmap;
+	GDI_COLOR color;
+
+	for (y = 0; y < 8; y++)
+	{
+		for (x = 0; x < 8; x++)
+			mask[y * 8 + x] = ((x ^ y) & 2) ? 0xFF : 0;
+	}
+
+	color = (GDI_COLOR) ARGB32(0xFF, 0x12, 0x34, 0x56);
+
+	/* every color depth has a glyph routine */
+	for (bpp = 8; bpp <= 32; bpp *= 2)
+	{
+		hdc = gdi_GetDC();
+		hdc->bitsPerPixel = bpp;
+		hdc->bytesPerPixel = bpp / 8;
+
+		hBitmap = gdi_CreateCompatibleBitmap(hdc, 8, 8);
+		gdi_SelectObject(hdc, (HGDIOBJECT) hBitmap);
+		memset(hBitmap->data, 0, 8 * 8 * hdc->bytesPerPixel);
+
+		CU_ASSERT(gdi_GlyphBlt(hdc, 1, 1, 6, 6, mask, 1, 1, 8, color) == 1);
+
+		badPixels = 0;
+
+		for (y = 0; y < 8; y++)
+		{
+			for (x = 0; x < 8; x++)
+			{
+				inside = (x >= 1 && x < 7 && y >= 1 && y < 7 && mask[y * 8 + x]);
+				pixel = &hBitmap->data[(y * 8 + x) * hdc->bytesPerPixel];
+
+				if ((memcmp(pixel, "\0\0\0\0", hdc->bytesPerPixel) != 0) != inside)
+					badPixels++;
+			}
+		}
+
+		CU_ASSERT(badPixels == 0);
+
+		gdi_DeleteObject((HGDIOBJECT) hBitmap);
+		gdi_DeleteDC(hdc);
+	}
+}
+
+static int test_gdi_memblt_bad_pixels(GDI* gdi, int type, int left, int top, int width, int height, int xSrc, int ySrc)
+{
+	int x, y;
+	int sx, sy;
+	int badPixels;
+	uint32 pixel;
+	uint32* data;
+	MEMBLT_ORDER memblt;
+	MEM3BLT_ORDER mem3blt;
+
+	data = (uint32*) gdi->primary->bitmap->data;
+	memset(data, 0, gdi->width * gdi->height * 4);
+	gdi_SetNullClipRgn(gdi->primary->hdc);
+
+	if (type == GDI_RENDER_MEMBLT)
+	{
+		memset(&memblt, 0, sizeof(MEMBLT_ORDER));
+		memblt.cacheId = 0x0100;
+		memblt.cacheIndex = 1;
+		memblt.nLeftRect = left;
+		memblt.nTopRect = top;
+		memblt.nWidth = width;
+		memblt.nHeight = height;
+		memblt.nXSrc = xSrc;
+		memblt.nYSrc = ySrc;
+		memblt.bRop = 0xCC;
+		gdi_draw_order(gdi, gdi->primary->hdc, GDI_RENDER_MEMBLT, &memblt);
+	}
+	else
+	{
+		memset(&mem3blt, 0, sizeof(MEM3BLT_ORDER));
+		mem3blt.cacheId = 0;
+		mem3blt.cacheIndex = 1;
+		mem3blt.nLeftRect = left;
+		mem3blt.nTopRect = top;
+		mem3blt.nWidth = width;
+		mem3blt.nHeight = height;
+		mem3blt.nXSrc = xSrc;
+		mem3blt.nYSrc = ySrc;
+		mem3blt.bRop = 0xCC;
+		mem3blt.brushStyle = BS_SOLID;
+		mem3blt.foreColor = 0x00FF00;
+		gdi_draw_order(gdi, gdi->primary->hdc, GDI_RENDER_MEM3BLT, &mem3blt);
+	}
+
+	badPixels = 0;
+
+	/* the source is clipped to the 16x8 cached bitmap, the destination follows */
+	for (y = 0; y < gdi->height; y++)
+	{
+		for (x = 0; x < gdi->width; x++)
+		{
+			pixel = 0;
+			sx = xSrc + x - left;
+			sy = ySrc + y - top;
+
+			if (x >= left && x < left + width && y >= top && y < top + height &&
+					sx >= 0 && sx < 16 && sy >= 0 && sy < 8)
+				pixel = 0xFF000000 | (sy << 8) | (sx + 1);
+
+			if (data[y * gdi->width + x] != pixel)
+				badPixels++;
+		}
+	}
+
+	return badPixels;
+}
+
+void test_gdi_MemBlt(void)
+{
+	int x, y;
+	GDI* gdi;
+	uint32* data;
+	GDI_IMAGE* bitmap;
+	rdpSettings settings;
+
+	gdi = (GDI*) malloc(sizeof(GDI));
+	memset(gdi, 0, sizeof(GDI));
+	gdi->width = 64;
+	gdi->height = 48;
+	gdi->srcBpp = 32;
+	gdi->dstBpp = 32;
+	gdi->bytesPerPixel = 4;
+
+	gdi->hdc = gdi_GetDC();
+	gdi->hdc->bitsPerPixel = 32;
+	gdi->hdc->bytesPerPixel = 4;
+
+	gdi->clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
+	gdi->clrconv->alpha = 1;
+	gdi->clrconv->invert = 0;
+	gdi->clrconv->rgb555 = 0;
+
+	gdi->primary = gdi_bitmap_new(gdi, gdi->width, gdi->height, 32, NULL);
+	gdi->drawing = gdi->primary;
+
+	memset(&settings, 0, sizeof(rdpSettings));
+	gdi->bitmap_cache = gdi_bitmap_cache_new(&settings);
+
+	bitmap = gdi_bitmap_new(gdi, 16, 8, 32, NULL);
+	data = (uint32*) bitmap->bitmap->data;
+
+	for (y = 0; y < 8; y++)
+	{
+		for (x = 0; x < 16; x++)
+			data[y * 16 + x] = 0xFF000000 | (y << 8) | (x + 1);
+	}
+
+	gdi_bitmap_cache_put(gdi->bitmap_cache, 0, 1, bitmap);
+
+	/* source inside the cached bitmap */
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 10, 10, 16, 8, 0, 0) == 0);
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 10, 10, 4, 3, 5, 2) == 0);
+
+	/* source past the right and bottom edges */
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 10, 10, 20, 12, 8, 4) == 0);
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 0, 0, 64, 48, 0, 0) == 0);
+
+	/* source before the left and top edges moves the destination */
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 10, 10, 16, 8, -3, -2) == 0);
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 10, 10, 24, 12, -4, -4) == 0);
+
+	/* source past the edge while the destination runs off the screen */
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 56, 44, 16, 8, 4, 2) == 0);
+
+	/* source entirely outside, nothing is drawn */
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 10, 10, 8, 8, 16, 0) == 0);
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 10, 10, 8, 8, 0, 8) == 0);
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEMBLT, 10, 10, 8, 8, -8, 0) == 0);
+
+	/* Mem3Blt sources are clipped the same way */
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEM3BLT, 10, 10, 20, 12, 8, 4) == 0);
+	CU_ASSERT(test_gdi_memblt_bad_pixels(gdi, GDI_RENDER_MEM3BLT, 10, 10, 16, 8, -3, -2) == 0);
+
+	gdi_bitmap_cache_free(gdi->bitmap_cache);
+	gdi_bitmap_free(gdi->primary);
+	free(gdi->clrconv);
+	gdi_DeleteDC(gdi->hdc);
+	free(gdi);
+}
+
+static BITMAP_DATA* test_decoder_bitmaps;
+static int test_decoder_count[16];
+static GDI_DECODE_PROC test_decoder_decode;
+
+/* each rectangle is counted by the thread decoding it, the counts are read once the run is over */
+static void test_gdi_decoder_decode(GDI* gdi, BITMAP_DATA* bmp)
+{
+	test_decoder_count[bmp - test_decoder_bitmaps]++;
+
+	if (test_decoder_decode != NULL)
+		test_decoder_decode(gdi, bmp);
+}
+
+static int test_gdi_decoder_calls(void)
+{
+	int i;
+	int calls = 0;
+
+	for (i = 0; i < 16; i++)
+		calls += test_decoder_count[i];
+
+	return calls;
+}
+
+/* decode a bitmap update into a cleared primary surface, with or without the worker threads */
+static void test_gdi_decoder_update(GDI* gdi, rdpUpdate* update, BITMAP_UPDATE* bitmap, boolean serial, uint32* data)
+{
+	int i;
+	int threads;
+	uint32* primary;
+
+	primary = (uint32*) gdi->primary->bitmap->data;
+
+	for (i = 0; i < gdi->width * gdi->height; i++)
+		primary[i] = 0x5A5A5A5A;
+
+	memset(test_decoder_count, 0, sizeof(test_decoder_count));
+
+	threads = gdi->decoder->threads;
+
+	if (serial)
+		gdi->decoder->threads = 0;
+
+	IFCALL(update->Bitmap, update, bitmap);
+
+	gdi->decoder->threads = threads;
+
+	memcpy(data, primary, gdi->width * gdi->height * 4);
+}
+
+void test_gdi_decoder(void)
+{
+	int i, j;
+	int x, y;
+	int size;
+	GDI* gdi;
+	uint16* pixels;
+	uint32* serial;
+	uint32* parallel;
+	freerdp instance;
+	rdpSettings settings;
+	GDI_DECODER* decoder;
+	BITMAP_UPDATE bitmap;
+	BITMAP_DATA bitmaps[16];
+
+	/* every rectangle is decoded exactly once, whatever the number of rectangles */
+	test_decoder_bitmaps = bitmaps;
+	test_decoder_decode = NULL;
+	decoder = gdi_decoder_new(NULL, test_gdi_decoder_decode, 3);
+	CU_ASSERT(decoder->threads == 3);
+
+	for (i = 16; i >= 0; i--)
+	{
+		memset(test_decoder_count, 0, sizeof(test_decoder_count));
+		gdi_decoder_run(decoder, bitmaps, i);
+
+		for (j = 0; j < 16; j++)
+			CU_ASSERT(test_decoder_count[j] == ((j < i) ? 1 : 0));
+	}
+
+	gdi_decoder_free(decoder);
+
+	memset(&instance, 0, sizeof(freerdp));
+	memset(&settings, 0, sizeof(rdpSettings));
+	settings.width = 128;
+	settings.height = 96;
+	settings.color_depth = 16;
+	instance.settings = &settings;
+	instance.update = (rdpUpdate*) malloc(sizeof(rdpUpdate));
+	memset(instance.update, 0, sizeof(rdpUpdate));
+
+	gdi_init(&instance, CLRBUF_32BPP);
+	gdi = GET_GDI(instance.update);
+
+	/* same decoding function, on three worker threads whatever the number of processors */
+	test_decoder_decode = gdi->decoder->decode;
+	gdi_decoder_free(gdi->decoder);
+	gdi->decoder = gdi_decoder_new(gdi, test_gdi_decoder_decode, 3);
+
+	/* a 4x3 grid of 32x32 uncompressed 16bpp rectangles */
+	for (i = 0; i < 12; i++)
+	{
+		pixels = (uint16*) malloc(32 * 32 * 2);
+
+		for (j = 0; j < 32 * 32; j++)
+			pixels[j] = (uint16) ((i + 1) * 40503 + j * 7);
+
+		bitmaps[i].left = (i % 4) * 32;
+		bitmaps[i].top = (i / 4) * 32;
+		bitmaps[i].right = bitmaps[i].left + 31;
+		bitmaps[i].bottom = bitmaps[i].top + 31;
+		bitmaps[i].width = 32;
+		bitmaps[i].height = 32;
+		bitmaps[i].bpp = 16;
+		bitmaps[i].length = 32 * 32 * 2;
+		bitmaps[i].compressed = False;
+		bitmaps[i].data = (uint8*) pixels;
+	}
+
+	bitmap.number = 12;
+	bitmap.bitmaps = bitmaps;
+
+	size = gdi->width * gdi->height * 4;
+	serial = (uint32*) malloc(size);
+	parallel = (uint32*) malloc(size);
+
+	/* non-overlapping direct rectangles go through the worker pool */
+	test_gdi_decoder_update(gdi, instance.update, &bitmap, True, serial);
+	CU_ASSERT(test_gdi_decoder_calls() == 0);
+
+	test_gdi_decoder_update(gdi, instance.update, &bitmap, False, parallel);
+	CU_ASSERT(test_gdi_decoder_calls() == 12);
+	CU_ASSERT(memcmp(serial, parallel, size) == 0);
+
+	for (i = 0; i < gdi->width * gdi->height; i++)
+	{
+		if (parallel[i] == 0x5A5A5A5A)
+			break;
+	}
+
+	CU_ASSERT(i == gdi->width * gdi->height);
+
+	/* overlapping rectangles are decoded one after the other */
+	bitmaps[5].left -= 16;
+	bitmaps[5].right -= 16;
+
+	test_gdi_decoder_update(gdi, instance.update, &bitmap, True, serial);
+	test_gdi_decoder_update(gdi, instance.update, &bitmap, False, parallel);
+	CU_ASSERT(test_gdi_decoder_calls() == 0);
+	CU_ASSERT(memcmp(serial, parallel, size) == 0);
+
+	bitmaps[5].left += 16;
+	bitmaps[5].right += 16;
+
+	/* a rectangle clipped by the server is not decoded straight into the surface */
+	bitmaps[6].right = bitmaps[6].left + 15;
+
+	test_gdi_decoder_update(gdi, instance.update, &bitmap, True, serial);
+	test_gdi_decoder_update(gdi, instance.update, &bitmap, False, parallel);
+	CU_ASSERT(test_gdi_decoder_calls() == 0);
+	CU_ASSERT(memcmp(serial, parallel, size) == 0);
+
+	for (y = bitmaps[6].top; y <= bitmaps[6].bottom; y++)
+	{
+		for (x = bitmaps[6].left; x < bitmaps[6].left + 32; x++)
+		{
+			if ((parallel[y * gdi->width + x] == 0x5A5A5A5A) != (x > bitmaps[6].right))
+				break;
+		}
+
+		if (x < bitmaps[6].left + 32)
+			break;
+	}
+
+	CU_ASSERT(y > bitmaps[6].bottom);
+
+	for (i = 0; i < 12; i++)
+		free(bitmaps[i].data);
+
+	free(serial);
+	free(parallel);
+	gdi_free(&instance);
+	free(instance.update);
+}
+
+static void test_gdi_render_order(GDI* gdi, GDI_RENDERER* render, BOUNDS* bounds, int type, void* order)
+{
+	if (render != NULL)
+	{
+		gdi_render_set_bounds(render, bounds);
+		gdi_render_record(render, type, order);
+		return;
+	}
+
+	if (bounds != NULL)
+	{
+		gdi_SetClipRgn(gdi->drawing->hdc, bounds->left, bounds->top,
+				bounds->right - bounds->left + 1, bounds->bottom - bounds->top + 1);
+	}
+	else
+	{
+		gdi_SetNullClipRgn(gdi->drawing->hdc);
+	}
+
+	gdi_draw_order(gdi, gdi->drawing->hdc, type, order);
+}
+
+/* draw the same orders either one after the other or through the parallel rasterizer */
+static void test_gdi_render_orders(GDI* gdi, GDI_RENDERER* render)
+{
+	int i;
+	BOUNDS bounds;
+	uint32* data;
+	DSTBLT_ORDER dstblt;
+	PATBLT_ORDER patblt;
+	SCRBLT_ORDER scrblt;
+	LINE_TO_ORDER line_to;
+	OPAQUE_RECT_ORDER opaque_rect;
+
+	data = (uint32*) gdi->primary->bitmap->data;
+
+	for (i = 0; i < gdi->width * gdi->height; i++)
+		data[i] = i * 2654435761U;
+
+	memset(&opaque_rect, 0, sizeof(OPAQUE_RECT_ORDER));
+	opaque_rect.nLeftRect = 10;
+	opaque_rect.nTopRect = 10;
+	opaque_rect.nWidth = 150;
+	opaque_rect.nHeight = 100;
+	opaque_rect.color = 0x123456;
+	test_gdi_render_order(gdi, render, NULL, GDI_RENDER_OPAQUE_RECT, &opaque_rect);
+
+	memset(&line_to, 0, sizeof(LINE_TO_ORDER));
+	line_to.nXStart = 0;
+	line_to.nYStart = 0;
+	line_to.nXEnd = 299;
+	line_to.nYEnd = 199;
+	line_to.bRop2 = GDI_R2_XORPEN;
+	line_to.penColor = 0xFFFFFF;
+	line_to.penWidth = 1;
+	test_gdi_render_order(gdi, render, NULL, GDI_RENDER_LINE_TO, &line_to);
+
+	/* overlapping screen to screen copies across tiles, in both directions */
+	memset(&scrblt, 0, sizeof(SCRBLT_ORDER));
+	scrblt.nLeftRect = 40;
+	scrblt.nTopRect = 30;
+	scrblt.nWidth = 160;
+	scrblt.nHeight = 120;
+	scrblt.nXSrc = 0;
+	scrblt.nYSrc = 0;
+	scrblt.bRop = 0xCC;
+	test_gdi_render_order(gdi, render, NULL, GDI_RENDER_SCRBLT, &scrblt);
+
+	bounds.left = 50;
+	bounds.top = 50;
+	bounds.right = 250;
+	bounds.bottom = 180;
+
+	memset(&patblt, 0, sizeof(PATBLT_ORDER));
+	patblt.nLeftRect = 0;
+	patblt.nTopRect = 0;
+	patblt.nWidth = 300;
+	patblt.nHeight = 200;
+	patblt.bRop = 0x5A;
+	patblt.backColor = 0x00FF00;
+	patblt.foreColor = 0x0000FF;
+	patblt.brushStyle = BS_PATTERN;
+	patblt.brushHatch = 0xAA;
+	patblt.brushExtra[0] = 0x55;
+	patblt.brushExtra[3] = 0xF0;
+	test_gdi_render_order(gdi, render, &bounds, GDI_RENDER_PATBLT, &patblt);
+
+	memset(&dstblt, 0, sizeof(DSTBLT_ORDER));
+	dstblt.nLeftRect = 100;
+	dstblt.nTopRect = 20;
+	dstblt.nWidth = 150;
+	dstblt.nHeight = 150;
+	dstblt.bRop = 0x55;
+	test_gdi_render_order(gdi, render, &bounds, GDI_RENDER_DSTBLT, &dstblt);
+
+	scrblt.nLeftRect = 0;
+	scrblt.nTopRect = 0;
+	scrblt.nWidth = 200;
+	scrblt.nHeight = 150;
+	scrblt.nXSrc = 60;
+	scrblt.nYSrc = 40;
+	test_gdi_render_order(gdi, render, NULL, GDI_RENDER_SCRBLT, &scrblt);
+
+	opaque_rect.nLeftRect = 250;
+	opaque_rect.nTopRect = 120;
+	opaque_rect.nWidth = 100;
+	opaque_rect.nHeight = 100;
+	opaque_rect.color = 0xABCDEF;
+	test_gdi_render_order(gdi, render, NULL, GDI_RENDER_OPAQUE_RECT, &opaque_rect);
+
+	/* clipped away entirely */
+	bounds.left = 0;
+	bounds.top = 0;
+	bounds.right = 9;
+	bounds.bottom = 9;
+	test_gdi_render_order(gdi, render, &bounds, GDI_RENDER_OPAQUE_RECT, &opaque_rect);
+}
+
+void test_gdi_render(void)
+{
+	int i;
+	int size;
+	int badPixels;
+	GDI* gdi;
+	uint32* expected;
+	GDI_RENDERER* render;
+
+	gdi = (GDI*) malloc(sizeof(GDI));
+	memset(gdi, 0, sizeof(GDI));
+	gdi->width = 300;
+	gdi->height = 200;
+	gdi->srcBpp = 32;
+	gdi->dstBpp = 32;
+	gdi->bytesPerPixel = 4;
+
+	gdi->hdc = gdi_GetDC();
+	gdi->hdc->bitsPerPixel = 32;
+	gdi->hdc->bytesPerPixel = 4;
+
+	gdi->clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
+	gdi->clrconv->alpha = 1;
+	gdi->clrconv->invert = 0;
+	gdi->clrconv->rgb555 = 0;
+
+	gdi->primary = (GDI_IMAGE*) malloc(sizeof(GDI_IMAGE));
+	gdi->primary->hdc = gdi_CreateCompatibleDC(gdi->hdc);
+	gdi->primary->bitmap = gdi_CreateCompatibleBitmap(gdi->hdc, gdi->width, gdi->height);
+	gdi_SelectObject(gdi->primary->hdc, (HGDIOBJECT) gdi->primary->bitmap);
+	gdi->primary->hdc->brush = gdi->primary->hdc->dcBrush;
+	gdi->drawing = gdi->primary;
+
+	size = gdi->width * gdi->height * 4;
+	expected = (uint32*) malloc(size);
+
+	test_gdi_render_orders(gdi, NULL);
+	memcpy(expected, gdi->primary->bitmap->data, size);
+
+	render = gdi_render_new(gdi);
+	test_gdi_render_orders(gdi, render);
+
+	/* nothing is drawn before the command list is flushed */
+	CU_ASSERT(render->count == 7);
+	CU_ASSERT(render->commands[2].whole == True);
+	CU_ASSERT(render->commands[3].whole == True);
+	CU_ASSERT(render->commands[4].whole == False);
+
+	gdi_render_flush(render);
+	CU_ASSERT(render->count == 0);
+
+	badPixels = 0;
+
+	for (i = 0; i < gdi->width * gdi->height; i++)
+	{
+		if (((uint32*) gdi->primary->bitmap->data)[i] != expected[i])
+			badPixels++;
+	}
+
+	CU_ASSERT(badPixels == 0);
+
+	gdi_render_free(render);
+	free(expected);
+	gdi_DeleteObject((HGDIOBJECT) gdi->primary->bitmap);
+	gdi_DeleteDC(gdi->primary->hdc);
+	free(gdi->primary);
+	free(gdi->clrconv);
+	gdi_DeleteDC(gdi->hdc);
+	free(gdi);
+}
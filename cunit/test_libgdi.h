@@ -29,6 +29,7 @@ void test_gdi_CreateBitmap(void);
 void test_gdi_CreateCompatibleBitmap(void);
 void test_gdi_CreatePen(void);
 void test_gdi_CreateSolidBrush(void);
+void test_gdi_SetDCBrushColor(void);
 void test_gdi_CreatePatternBrush(void);
 void test_gdi_CreateRectRgn(void);
 void test_gdi_CreateRect(void);
@@ -43,5 +44,13 @@ void test_gdi_FillRect(void);
 void test_gdi_BitBlt_32bpp(void);
 void test_gdi_BitBlt_16bpp(void);
 void test_gdi_BitBlt_8bpp(void);
+void test_gdi_rop(void);
+void test_gdi_rop3(void);
 void test_gdi_ClipCoords(void);
 void test_gdi_InvalidateRegion(void);
+void test_gdi_InvalidateDamage(void);
+void test_gdi_SetClipRects(void);
+void test_gdi_GlyphBlt(void);
+void test_gdi_MemBlt(void);
+void test_gdi_decoder(void);
+void test_gdi_render(void);
@@ -0,0 +1,89 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * MPPC Bulk Data Decompression Unit Tests
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <freerdp/freerdp.h>
+
+#include "rdp.h"
+#include "mppc.h"
+
+#include "test_mppc.h"
+
+/* RDP 5.0: literals 'a', 'b', 0xE9, copy offset 3 length 9, literal '!' */
+static uint8 compressed_64k[] = "\x61\x62\xB4\xFC\x3C\x48\x40";
+static uint8 decompressed_64k[] = "ab\xE9" "ab\xE9" "ab\xE9" "ab\xE9" "!";
+
+/* RDP 4.0: literals 'x', 'y', copy offset 2 length 4, copy offset 4 length 3 */
+static uint8 compressed_8k[] = "\x78\x79\xF0\xA3\xC4\x00";
+static uint8 decompressed_8k[] = "xyxyxyxyx";
+
+int init_mppc_suite(void)
+{
+	return 0;
+}
+
+int clean_mppc_suite(void)
+{
+	return 0;
+}
+
+int add_mppc_suite(void)
+{
+	add_test_suite(mppc);
+
+	add_test_function(mppc);
+
+	return 0;
+}
+
+void test_mppc(void)
+{
+	int rlen;
+	uint8* rbuf;
+	rdpMppc* mppc;
+
+	mppc = mppc_new();
+
+	CU_ASSERT(mppc_decompress(mppc, compressed_64k, sizeof(compressed_64k) - 1,
+			PACKET_COMPRESSED | PACKET_FLUSHED | PACKET_COMPR_TYPE_64K, &rbuf, &rlen) == True);
+	CU_ASSERT(rlen == sizeof(decompressed_64k) - 1);
+	CU_ASSERT(memcmp(rbuf, decompressed_64k, sizeof(decompressed_64k) - 1) == 0);
+
+	/* the next packet continues in the history buffer */
+	CU_ASSERT(mppc_decompress(mppc, compressed_64k, sizeof(compressed_64k) - 1,
+			PACKET_COMPRESSED | PACKET_COMPR_TYPE_64K, &rbuf, &rlen) == True);
+	CU_ASSERT(rbuf == mppc->history_buf + sizeof(decompressed_64k) - 1);
+	CU_ASSERT(memcmp(rbuf, decompressed_64k, sizeof(decompressed_64k) - 1) == 0);
+
+	CU_ASSERT(mppc_decompress(mppc, compressed_8k, sizeof(compressed_8k) - 1,
+			PACKET_COMPRESSED | PACKET_AT_FRONT | PACKET_COMPR_TYPE_8K, &rbuf, &rlen) == True);
+	CU_ASSERT(rbuf == mppc->history_buf);
+	CU_ASSERT(rlen == sizeof(decompressed_8k) - 1);
+	CU_ASSERT(memcmp(rbuf, decompressed_8k, sizeof(decompressed_8k) - 1) == 0);
+
+	/* uncompressed data is passed through */
+	CU_ASSERT(mppc_decompress(mppc, compressed_8k, sizeof(compressed_8k) - 1,
+			PACKET_COMPR_TYPE_8K, &rbuf, &rlen) == True);
+	CU_ASSERT(rbuf == compressed_8k);
+	CU_ASSERT(rlen == sizeof(compressed_8k) - 1);
+
+	mppc_free(mppc);
+}
@@ -19,6 +19,7 @@
 
 #include <freerdp/freerdp.h>
 #include <freerdp/utils/hexdump.h>
+#include <freerdp/utils/arena.h>
 #include <freerdp/utils/stream.h>
 
 #include "test_orders.h"
@@ -28,7 +29,7 @@ ORDER_INFO* orderInfo;
 
 int init_orders_suite(void)
 {
-	orderInfo = (ORDER_INFO*) malloc(sizeof(orderInfo));
+	orderInfo = (ORDER_INFO*) malloc(sizeof(ORDER_INFO));
 	return 0;
 }
 
@@ -48,6 +49,7 @@ int add_orders_suite(void)
 	add_test_function(read_opaque_rect_order);
 	add_test_function(read_draw_nine_grid_order);
 	add_test_function(read_multi_opaque_rect_order);
+	add_test_function(read_multi_scrblt_order);
 	add_test_function(read_line_to_order);
 	add_test_function(read_polyline_order);
 	add_test_function(read_glyph_index_order);
@@ -58,6 +60,7 @@ int add_orders_suite(void)
 	add_test_function(read_cache_bitmap_order);
 	add_test_function(read_cache_bitmap_v2_order);
 	add_test_function(read_cache_bitmap_v3_order);
+	add_test_function(read_cache_glyph_v2_order);
 	add_test_function(read_cache_brush_order);
 
 	add_test_function(read_create_offscreen_bitmap_order);
@@ -257,6 +260,48 @@ void test_read_multi_opaque_rect_order(void)
 	CU_ASSERT(stream_get_length(s) == (sizeof(multi_opaque_rect_order) - 1));
 }
 
+uint8 multi_scrblt_order[] =
+	"\x0a\x00\x14\x00\x64\x00\x32\x00\xcc\xc8\x00\x2c\x01\x02\x07\x00"
+	"\x06\x0a\x14\x1e\x0a\x28\x14";
+
+void test_read_multi_scrblt_order(void)
+{
+	STREAM* s;
+	MULTI_SCRBLT_ORDER multi_scrblt;
+
+	s = stream_new(0);
+	s->p = s->data = multi_scrblt_order;
+
+	memset(orderInfo, 0, sizeof(ORDER_INFO));
+	orderInfo->fieldFlags = 0x01FF;
+	memset(&multi_scrblt, 0xFF, sizeof(MULTI_SCRBLT_ORDER));
+
+	update_read_multi_scrblt_order(s, orderInfo, &multi_scrblt);
+
+	CU_ASSERT(multi_scrblt.nLeftRect == 10);
+	CU_ASSERT(multi_scrblt.nTopRect == 20);
+	CU_ASSERT(multi_scrblt.nWidth == 100);
+	CU_ASSERT(multi_scrblt.nHeight == 50);
+	CU_ASSERT(multi_scrblt.bRop == 204);
+	CU_ASSERT(multi_scrblt.nXSrc == 200);
+	CU_ASSERT(multi_scrblt.nYSrc == 300);
+	CU_ASSERT(multi_scrblt.nDeltaEntries == 2);
+	CU_ASSERT(multi_scrblt.cbData == 7);
+
+	CU_ASSERT(multi_scrblt.rectangles[1].left == 10);
+	CU_ASSERT(multi_scrblt.rectangles[1].top == 20);
+	CU_ASSERT(multi_scrblt.rectangles[1].width == 30);
+	CU_ASSERT(multi_scrblt.rectangles[1].height == 10);
+
+	/* a zero top delta and a repeated width */
+	CU_ASSERT(multi_scrblt.rectangles[2].left == 50);
+	CU_ASSERT(multi_scrblt.rectangles[2].top == 20);
+	CU_ASSERT(multi_scrblt.rectangles[2].width == 30);
+	CU_ASSERT(multi_scrblt.rectangles[2].height == 20);
+
+	CU_ASSERT(stream_get_length(s) == (sizeof(multi_scrblt_order) - 1));
+}
+
 uint8 line_to_order[] = "\x03\xb1\x0e\xa6\x5b\xef\x00";
 
 void test_read_line_to_order(void)
@@ -467,6 +512,8 @@ void test_read_fast_index_order(void)
 	memset(orderInfo, 0, sizeof(ORDER_INFO));
 	orderInfo->fieldFlags = 0x70FF;
 
+	memset(&fast_index, 0, sizeof(FAST_INDEX_ORDER));
+
 	update_read_fast_index_order(s, orderInfo, &fast_index);
 
 	CU_ASSERT(fast_index.cacheId == 7);
@@ -525,7 +572,26 @@ void test_read_fast_glyph_order(void)
 	CU_ASSERT(fast_glyph.x == -32768);
 	CU_ASSERT(fast_glyph.y == 187);
 
+	CU_ASSERT(fast_glyph.cbData == 19);
+	CU_ASSERT(fast_glyph.glyph_data.cacheIndex == 0);
+	CU_ASSERT(fast_glyph.glyph_data.x == 1);
+	CU_ASSERT(fast_glyph.glyph_data.y == -10);
+	CU_ASSERT(fast_glyph.glyph_data.cx == 6);
+	CU_ASSERT(fast_glyph.glyph_data.cy == 10);
+	CU_ASSERT(fast_glyph.glyph_data.cb == 12);
+	CU_ASSERT(fast_glyph.glyph_data.aj == &fast_glyph.data[5]);
+
 	CU_ASSERT(stream_get_length(s) == (sizeof(fast_glyph_order) - 1));
+
+	/* a delta order without glyph data draws the same glyph without defining it again */
+	s->p = s->data = fast_glyph_order;
+	orderInfo->fieldFlags = 0x0001;
+
+	update_read_fast_glyph_order(s, orderInfo, &fast_glyph);
+
+	CU_ASSERT(fast_glyph.cbData == 19);
+	CU_ASSERT(fast_glyph.glyph_data.cacheIndex == 0);
+	CU_ASSERT(fast_glyph.glyph_data.aj == NULL);
 }
 
 uint8 polygon_cb_order[] =
@@ -639,6 +705,7 @@ uint8 cache_bitmap_v3_order[] =
 void test_read_cache_bitmap_v3_order(void)
 {
 	STREAM* s;
+	ARENA* arena;
 	uint16 extraFlags;
 	CACHE_BITMAP_V3_ORDER cache_bitmap_v3;
 
@@ -648,7 +715,8 @@ void test_read_cache_bitmap_v3_order(void)
 
 	memset(&cache_bitmap_v3, 0, sizeof(CACHE_BITMAP_V3_ORDER));
 
-	update_read_cache_bitmap_v3_order(s, &cache_bitmap_v3, True, extraFlags);
+	arena = freerdp_arena_new(0x1000);
+	update_read_cache_bitmap_v3_order(s, arena, &cache_bitmap_v3, True, extraFlags);
 
 	CU_ASSERT(cache_bitmap_v3.cacheIndex == 32767);
 	CU_ASSERT(cache_bitmap_v3.key1 == 0xBCEC5035);
@@ -662,6 +730,40 @@ void test_read_cache_bitmap_v3_order(void)
 	CU_ASSERT(cache_bitmap_v3.bitmapData.length == 40);
 
 	CU_ASSERT(stream_get_length(s) == (sizeof(cache_bitmap_v3_order) - 1));
+
+	freerdp_arena_free(arena);
+}
+
+uint8 cache_glyph_v2_order[] =
+	"\x0a\x00\x4a\x06\x0a\x80\x80\x80\xb8\xc4\x84\x84\x84\x84\x84\x00\x00";
+
+void test_read_cache_glyph_v2_order(void)
+{
+	STREAM* s;
+	ARENA* arena;
+	CACHE_GLYPH_V2_ORDER cache_glyph_v2;
+
+	s = stream_new(0);
+	s->p = s->data = cache_glyph_v2_order;
+
+	memset(&cache_glyph_v2, 0, sizeof(CACHE_GLYPH_V2_ORDER));
+
+	arena = freerdp_arena_new(0x1000);
+	update_read_cache_glyph_v2_order(s, arena, &cache_glyph_v2, 0x0107);
+
+	CU_ASSERT(cache_glyph_v2.cacheId == 7);
+	CU_ASSERT(cache_glyph_v2.cGlyphs == 1);
+	CU_ASSERT(cache_glyph_v2.glyphData[0].cacheIndex == 10);
+	CU_ASSERT(cache_glyph_v2.glyphData[0].x == 0);
+	CU_ASSERT(cache_glyph_v2.glyphData[0].y == -10);
+	CU_ASSERT(cache_glyph_v2.glyphData[0].cx == 6);
+	CU_ASSERT(cache_glyph_v2.glyphData[0].cy == 10);
+	CU_ASSERT(cache_glyph_v2.glyphData[0].cb == 12);
+	CU_ASSERT(cache_glyph_v2.glyphData[0].aj[3] == 0xb8);
+
+	CU_ASSERT(stream_get_length(s) == (sizeof(cache_glyph_v2_order) - 1));
+
+	freerdp_arena_free(arena);
 }
 
 uint8 cache_brush_order[] = "\x00\x01\x08\x08\x81\x08\xaa\x55\xaa\x55\xaa\x55\xaa\x55";
@@ -669,6 +771,7 @@ uint8 cache_brush_order[] = "\x00\x01\x08\x08\x81\x08\xaa\x55\xaa\x55\xaa\x55\xa
 void test_read_cache_brush_order(void)
 {
 	STREAM* s;
+	ARENA* arena;
 	CACHE_BRUSH_ORDER cache_brush;
 
 	s = stream_new(0);
@@ -676,7 +779,8 @@ void test_read_cache_brush_order(void)
 
 	memset(&cache_brush, 0, sizeof(CACHE_BRUSH_ORDER));
 
-	update_read_cache_brush_order(s, &cache_brush, 0);
+	arena = freerdp_arena_new(0x1000);
+	update_read_cache_brush_order(s, arena, &cache_brush, 0);
 
 	CU_ASSERT(cache_brush.cacheEntry == 0);
 	CU_ASSERT(cache_brush.bpp == 1);
@@ -686,6 +790,8 @@ void test_read_cache_brush_order(void)
 	CU_ASSERT(cache_brush.length == 8);
 
 	CU_ASSERT(stream_get_length(s) == (sizeof(cache_brush_order) - 1));
+
+	freerdp_arena_free(arena);
 }
 
 uint8 create_offscreen_bitmap_order[] = "\x00\x80\x60\x01\x10\x00\x01\x00\x02\x00";
@@ -29,6 +29,7 @@ void test_read_scrblt_order(void);
 void test_read_opaque_rect_order(void);
 void test_read_draw_nine_grid_order(void);
 void test_read_multi_opaque_rect_order(void);
+void test_read_multi_scrblt_order(void);
 void test_read_line_to_order(void);
 void test_read_polyline_order(void);
 void test_read_glyph_index_order(void);
@@ -39,6 +40,7 @@ void test_read_polygon_cb_order(void);
 void test_read_cache_bitmap_order(void);
 void test_read_cache_bitmap_v2_order(void);
 void test_read_cache_bitmap_v3_order(void);
+void test_read_cache_glyph_v2_order(void);
 void test_read_cache_brush_order(void);
 
 void test_read_create_offscreen_bitmap_order(void);
@@ -0,0 +1,253 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Persistent Bitmap Cache Unit Tests
+ *
+ * Copyright 2026 FreeRDP Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <freerdp/freerdp.h>
+#include <freerdp/utils/memory.h>
+
+#include "registry.h"
+#include "persistent.h"
+#include "test_persistent.h"
+
+static rdpSettings* settings;
+static rdpRegistry* registry;
+
+static int cache_bitmap_v2_count;
+static CACHE_BITMAP_V2_ORDER replayed[4];
+
+static void test_cache_bitmap_v2(rdpUpdate* update, CACHE_BITMAP_V2_ORDER* cache_bitmap_v2_order)
+{
+	if (cache_bitmap_v2_count < 4)
+		memcpy(&replayed[cache_bitmap_v2_count], cache_bitmap_v2_order, sizeof(CACHE_BITMAP_V2_ORDER));
+
+	cache_bitmap_v2_count++;
+}
+
+int init_persistent_suite(void)
+{
+	char path[] = "/tmp/test_persistent_XXXXXX";
+
+	if (mkdtemp(path) == NULL)
+		return -1;
+
+	/* the cache file is kept in a scratch directory instead of ~/.freerdp */
+	settings = settings_new();
+	settings->color_depth = 16;
+	settings->persistent_bitmap_cache = True;
+	settings->bitmap_cache_v2_num_cells = 3;
+	settings->bitmap_cache_v2_cell_info[0].numEntries = 8;
+	settings->bitmap_cache_v2_cell_info[0].persistent = False;
+	settings->bitmap_cache_v2_cell_info[1].numEntries = 8;
+	settings->bitmap_cache_v2_cell_info[1].persistent = True;
+	settings->bitmap_cache_v2_cell_info[2].numEntries = 4;
+	settings->bitmap_cache_v2_cell_info[2].persistent = True;
+
+	registry = (rdpRegistry*) xzalloc(sizeof(rdpRegistry));
+	registry->path = xstrdup(path);
+	registry->available = True;
+	registry->settings = settings;
+
+	return 0;
+}
+
+int clean_persistent_suite(void)
+{
+	char file[64];
+
+	snprintf(file, sizeof(file), "%s/bitmap_cache_v2_%d.bin", registry->path, settings->color_depth);
+	unlink(file);
+	rmdir(registry->path);
+
+	xfree(registry->path);
+	xfree(registry);
+	settings_free(settings);
+	return 0;
+}
+
+int add_persistent_suite(void)
+{
+	add_test_suite(persistent);
+
+	add_test_function(persistent_cache_round_trip);
+	add_test_function(persistent_cache_replay);
+	add_test_function(persistent_cache_reset);
+
+	return 0;
+}
+
+static void put_bitmap(rdpPersistentCache* cache, int id, int index, uint32 key, uint8* data, int length)
+{
+	CACHE_BITMAP_V2_ORDER cache_bitmap_v2_order;
+
+	memset(&cache_bitmap_v2_order, 0, sizeof(CACHE_BITMAP_V2_ORDER));
+	cache_bitmap_v2_order.cacheId = id;
+	cache_bitmap_v2_order.cacheIndex = index;
+	cache_bitmap_v2_order.flags = CBR2_PERSISTENT_KEY_PRESENT;
+	cache_bitmap_v2_order.key1 = key;
+	cache_bitmap_v2_order.key2 = ~key;
+	cache_bitmap_v2_order.bitmapBpp = 16;
+	cache_bitmap_v2_order.bitmapWidth = 4;
+	cache_bitmap_v2_order.bitmapHeight = 2;
+	cache_bitmap_v2_order.bitmapLength = length;
+	cache_bitmap_v2_order.compressed = (key & 1) ? True : False;
+	memcpy(cache_bitmap_v2_order.bitmapComprHdr, "\x00\x00\x08\x00\x08\x00\x04\x00", 8);
+	cache_bitmap_v2_order.bitmapDataStream = data;
+
+	persistent_cache_put(cache, &cache_bitmap_v2_order);
+}
+
+static boolean check_entry(PERSISTENT_CACHE_ENTRY* entry, uint32 key, uint8* data, int length)
+{
+	if (entry == NULL || !(entry->flags & PERSISTENT_ENTRY_VALID))
+		return False;
+
+	if (entry->key1 != key || entry->key2 != ~key)
+		return False;
+
+	if (((entry->flags & PERSISTENT_ENTRY_COMPRESSED) ? 1 : 0) != (key & 1))
+		return False;
+
+	if (entry->width != 4 || entry->height != 2 || entry->bpp != 16 || entry->length != length)
+		return False;
+
+	if (memcmp(entry->bitmapComprHdr, "\x00\x00\x08\x00\x08\x00\x04\x00", 8) != 0)
+		return False;
+
+	return (memcmp(&entry[1], data, length) == 0) ? True : False;
+}
+
+uint8 persistent_bitmap_a[16] =
+	"\x00\x11\x22\x33\x44\x55\x66\x77\x88\x99\xAA\xBB\xCC\xDD\xEE\xFF";
+
+uint8 persistent_bitmap_b[6] =
+	"\x0F\x1E\x2D\x3C\x4B\x5A";
+
+void test_persistent_cache_round_trip(void)
+{
+	rdpPersistentCache* cache;
+
+	cache = persistent_cache_new(settings, registry);
+	CU_ASSERT(persistent_cache_open(cache) == True);
+
+	put_bitmap(cache, 1, 5, 0x12345678, persistent_bitmap_a, sizeof(persistent_bitmap_a));
+	put_bitmap(cache, 2, 0, 0xCAFEBABF, persistent_bitmap_b, sizeof(persistent_bitmap_b));
+
+	/* waiting list entries, non-persistent cells and out of range indices are not stored */
+	put_bitmap(cache, 1, BITMAP_CACHE_WAITING_LIST_INDEX, 0x1111, persistent_bitmap_b, sizeof(persistent_bitmap_b));
+	put_bitmap(cache, 0, 0, 0x2222, persistent_bitmap_b, sizeof(persistent_bitmap_b));
+	put_bitmap(cache, 2, 4, 0x3333, persistent_bitmap_b, sizeof(persistent_bitmap_b));
+	CU_ASSERT(persistent_cache_get(cache, 0, 0) == NULL);
+	CU_ASSERT(persistent_cache_get(cache, 2, 4) == NULL);
+
+	persistent_cache_free(cache);
+
+	/* a new instance reads back what the previous one wrote */
+	cache = persistent_cache_new(settings, registry);
+	CU_ASSERT(persistent_cache_open(cache) == True);
+
+	CU_ASSERT(check_entry(persistent_cache_get(cache, 1, 5), 0x12345678,
+		persistent_bitmap_a, sizeof(persistent_bitmap_a)) == True);
+	CU_ASSERT(check_entry(persistent_cache_get(cache, 2, 0), 0xCAFEBABF,
+		persistent_bitmap_b, sizeof(persistent_bitmap_b)) == True);
+	CU_ASSERT(persistent_cache_get(cache, 1, 4)->flags == 0);
+	CU_ASSERT(persistent_cache_get(cache, 1, 6)->flags == 0);
+
+	persistent_cache_free(cache);
+}
+
+void test_persistent_cache_replay(void)
+{
+	rdpUpdate* update;
+	rdpPersistentCache* cache;
+
+	update = (rdpUpdate*) xzalloc(sizeof(rdpUpdate));
+	update->CacheBitmapV2 = test_cache_bitmap_v2;
+
+	cache = persistent_cache_new(settings, registry);
+	CU_ASSERT(persistent_cache_open(cache) == True);
+
+	/* the key list is sent from compacted cells, slot 5 moves to slot 0 */
+	CU_ASSERT(persistent_cache_compact(cache, 1) == 1);
+	CU_ASSERT(persistent_cache_compact(cache, 2) == 1);
+	CU_ASSERT(check_entry(persistent_cache_get(cache, 1, 0), 0x12345678,
+		persistent_bitmap_a, sizeof(persistent_bitmap_a)) == True);
+	CU_ASSERT(persistent_cache_get(cache, 1, 5)->flags == 0);
+
+	persistent_cache_free(cache);
+
+	cache = persistent_cache_new(settings, registry);
+	CU_ASSERT(persistent_cache_open(cache) == True);
+
+	/* nothing is replayed until the key list was sent */
+	cache_bitmap_v2_count = 0;
+	persistent_cache_replay(cache, update);
+	CU_ASSERT(cache_bitmap_v2_count == 0);
+
+	cache->replay = True;
+	persistent_cache_replay(cache, update);
+	CU_ASSERT(cache_bitmap_v2_count == 2);
+
+	CU_ASSERT(replayed[0].cacheId == 1);
+	CU_ASSERT(replayed[0].cacheIndex == 0);
+	CU_ASSERT(replayed[0].key1 == 0x12345678);
+	CU_ASSERT(replayed[0].compressed == False);
+	CU_ASSERT(replayed[0].bitmapLength == sizeof(persistent_bitmap_a));
+	CU_ASSERT(memcmp(replayed[0].bitmapDataStream, persistent_bitmap_a, sizeof(persistent_bitmap_a)) == 0);
+
+	CU_ASSERT(replayed[1].cacheId == 2);
+	CU_ASSERT(replayed[1].cacheIndex == 0);
+	CU_ASSERT(replayed[1].key1 == 0xCAFEBABF);
+	CU_ASSERT(replayed[1].compressed == True);
+	CU_ASSERT(memcmp(replayed[1].bitmapDataStream, persistent_bitmap_b, sizeof(persistent_bitmap_b)) == 0);
+
+	/* replay happens once per connection */
+	persistent_cache_replay(cache, update);
+	CU_ASSERT(cache_bitmap_v2_count == 2);
+
+	persistent_cache_free(cache);
+	xfree(update);
+}
+
+void test_persistent_cache_reset(void)
+{
+	rdpPersistentCache* cache;
+
+	/* a different cache layout discards the file contents */
+	settings->bitmap_cache_v2_cell_info[2].numEntries = 2;
+
+	cache = persistent_cache_new(settings, registry);
+	CU_ASSERT(persistent_cache_open(cache) == True);
+	CU_ASSERT(persistent_cache_get(cache, 1, 0)->flags == 0);
+	CU_ASSERT(persistent_cache_get(cache, 2, 0)->flags == 0);
+	CU_ASSERT(persistent_cache_get(cache, 2, 2) == NULL);
+	persistent_cache_free(cache);
+
+	settings->bitmap_cache_v2_cell_info[2].numEntries = 4;
+
+	/* the cache is unavailable without a registry directory */
+	registry->available = False;
+	cache = persistent_cache_new(settings, registry);
+	CU_ASSERT(persistent_cache_open(cache) == False);
+	CU_ASSERT(persistent_cache_get(cache, 1, 0) == NULL);
+	persistent_cache_free(cache);
+	registry->available = True;
+}
@@ -0,0 +1,333 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Update Pipeline Unit Tests
+ *
+ * Copyright 2026 FreeRDP Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <freerdp/freerdp.h>
+#include <freerdp/utils/thread.h>
+#include <freerdp/utils/semaphore.h>
+
+#include "rdp.h"
+#include "pipeline.h"
+#include "test_pipeline.h"
+
+#define TEST_PIPELINE_CAPACITY		4096
+#define TEST_PIPELINE_SYNCHRONIZE	-1
+#define TEST_PIPELINE_BITMAP		-2
+
+static rdpRdp* rdp;
+static pthread_t network_thread;
+
+/* callback log, written by the render thread and read once the pipeline is flushed */
+static int log_count;
+static int log_values[2048];
+static boolean log_inline[2048];
+
+static int delay;
+static boolean gate_armed;
+static freerdp_sem gate;
+
+static volatile int produced;
+static freerdp_sem produced_all;
+
+static void test_log(int value)
+{
+	log_inline[log_count] = pthread_equal(pthread_self(), network_thread) ? True : False;
+	log_values[log_count++] = value;
+}
+
+static void test_synchronize(rdpUpdate* update)
+{
+	test_log(TEST_PIPELINE_SYNCHRONIZE);
+}
+
+static void test_opaque_rect(rdpUpdate* update, OPAQUE_RECT_ORDER* opaque_rect)
+{
+	if (gate_armed)
+	{
+		gate_armed = False;
+		freerdp_sem_wait(gate);
+	}
+
+	if (delay > 0)
+		usleep(delay);
+
+	test_log(opaque_rect->nLeftRect);
+}
+
+static void test_bitmap(rdpUpdate* update, BITMAP_UPDATE* bitmap)
+{
+	int i;
+
+	/* the bitmap data is filled with its length */
+	for (i = 0; i < bitmap->bitmaps[0].length; i++)
+	{
+		if (bitmap->bitmaps[0].data[i] != (uint8) bitmap->bitmaps[0].length)
+			break;
+	}
+
+	test_log((i == bitmap->bitmaps[0].length) ? TEST_PIPELINE_BITMAP : 0);
+}
+
+int init_pipeline_suite(void)
+{
+	rdp = rdp_new(NULL);
+
+	rdp->update->Synchronize = test_synchronize;
+	rdp->update->OpaqueRect = test_opaque_rect;
+	rdp->update->Bitmap = test_bitmap;
+
+	gate = freerdp_sem_new(0);
+	produced_all = freerdp_sem_new(0);
+	network_thread = pthread_self();
+
+	return 0;
+}
+
+int clean_pipeline_suite(void)
+{
+	freerdp_sem_free(gate);
+	freerdp_sem_free(produced_all);
+	rdp_free(rdp);
+	return 0;
+}
+
+int add_pipeline_suite(void)
+{
+	add_test_suite(pipeline);
+
+	add_test_function(pipeline_wrap);
+	add_test_function(pipeline_back_pressure);
+	add_test_function(pipeline_flush);
+	add_test_function(pipeline_inline);
+	add_test_function(pipeline_free);
+
+	return 0;
+}
+
+static void test_pipeline_start(void)
+{
+	log_count = 0;
+	delay = 0;
+	gate_armed = False;
+	produced = 0;
+
+	/* a small ring wraps around and fills up after a few orders */
+	rdp->pipeline = pipeline_new(rdp->update, TEST_PIPELINE_CAPACITY);
+}
+
+static void test_pipeline_stop(void)
+{
+	pipeline_free(rdp->pipeline);
+	rdp->pipeline = NULL;
+}
+
+static void test_opaque_rects(int first, int count)
+{
+	int i;
+	OPAQUE_RECT_ORDER opaque_rect;
+
+	memset(&opaque_rect, 0, sizeof(OPAQUE_RECT_ORDER));
+
+	for (i = first; i < first + count; i++)
+	{
+		opaque_rect.nLeftRect = i;
+		IFCALL(rdp->update->OpaqueRect, rdp->update, &opaque_rect);
+		produced++;
+	}
+}
+
+static boolean test_log_sequence(int first, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (log_values[first + i] != i || log_inline[first + i])
+			return False;
+	}
+
+	return True;
+}
+
+void test_pipeline_wrap(void)
+{
+	int i;
+
+	test_pipeline_start();
+
+	for (i = 0; i < 10; i++)
+	{
+		test_opaque_rects(i * 100, 100);
+		IFCALL(rdp->update->Synchronize, rdp->update);
+	}
+
+	pipeline_flush(rdp->pipeline);
+
+	/* the records were written across the end of the ring several times */
+	CU_ASSERT(rdp->pipeline->head > 4 * TEST_PIPELINE_CAPACITY);
+	CU_ASSERT(log_count == 1010);
+
+	for (i = 0; i < 10; i++)
+	{
+		CU_ASSERT(log_values[i * 101 + 100] == TEST_PIPELINE_SYNCHRONIZE);
+		log_values[i * 101 + 100] = i * 100 + 100;
+	}
+
+	/* with the synchronize records replaced, the orders are all there in sequence */
+	for (i = 0; i < 1010; i++)
+	{
+		if (log_values[i] != i - (i / 101))
+			break;
+	}
+
+	CU_ASSERT(i == 1010);
+
+	test_pipeline_stop();
+}
+
+static void* test_pipeline_producer(void* arg)
+{
+	test_opaque_rects(0, 500);
+	freerdp_sem_signal(produced_all);
+	return NULL;
+}
+
+void test_pipeline_back_pressure(void)
+{
+	int i;
+	uint32 used;
+	rdpPipeline* pipeline;
+
+	test_pipeline_start();
+	pipeline = rdp->pipeline;
+
+	/* the render thread is held on the first order while the ring fills up */
+	gate_armed = True;
+	freerdp_thread_create(test_pipeline_producer, NULL);
+
+	for (i = 0; i < 2000; i++)
+	{
+		if (*((volatile uint32*) &pipeline->waiting) == 1)
+			break;
+
+		usleep(1000);
+	}
+
+	used = pipeline->head - pipeline->tail;
+
+	CU_ASSERT(pipeline->waiting == 1);
+	CU_ASSERT(produced > 0 && produced < 500);
+	CU_ASSERT(used <= TEST_PIPELINE_CAPACITY);
+	CU_ASSERT(used > TEST_PIPELINE_CAPACITY / 2);
+	CU_ASSERT(log_count == 0);
+
+	/* the producer goes on once the render thread makes room */
+	freerdp_sem_signal(gate);
+	freerdp_sem_wait(produced_all);
+
+	pipeline_flush(pipeline);
+
+	CU_ASSERT(produced == 500);
+	CU_ASSERT(log_count == 500);
+	CU_ASSERT(test_log_sequence(0, 500) == True);
+
+	test_pipeline_stop();
+}
+
+void test_pipeline_flush(void)
+{
+	test_pipeline_start();
+
+	delay = 2000;
+	test_opaque_rects(0, 20);
+
+	/* every record queued before the barrier has been processed */
+	pipeline_flush(rdp->pipeline);
+	CU_ASSERT(log_count == 20);
+	CU_ASSERT(test_log_sequence(0, 20) == True);
+
+	test_pipeline_stop();
+}
+
+static void test_pipeline_bitmap(int length)
+{
+	uint8* data;
+	BITMAP_DATA bitmap_data;
+	BITMAP_UPDATE bitmap;
+
+	data = (uint8*) malloc(length);
+	memset(data, (uint8) length, length);
+
+	memset(&bitmap_data, 0, sizeof(BITMAP_DATA));
+	bitmap_data.length = length;
+	bitmap_data.data = data;
+	bitmap.number = 1;
+	bitmap.bitmaps = &bitmap_data;
+
+	IFCALL(rdp->update->Bitmap, rdp->update, &bitmap);
+
+	/* the queued copy does not point to the parser buffers */
+	memset(data, 0, length);
+	free(data);
+}
+
+void test_pipeline_inline(void)
+{
+	test_pipeline_start();
+
+	delay = 2000;
+	test_opaque_rects(0, 5);
+	test_pipeline_bitmap(100);
+
+	/* too large to be queued, drawn on this thread after the earlier records */
+	test_pipeline_bitmap(PIPELINE_MAX_RECORD(TEST_PIPELINE_CAPACITY) * 2 + 1);
+	CU_ASSERT(log_count == 7);
+
+	test_opaque_rects(0, 5);
+	pipeline_flush(rdp->pipeline);
+
+	CU_ASSERT(log_count == 12);
+	CU_ASSERT(test_log_sequence(0, 5) == True);
+	CU_ASSERT(log_values[5] == TEST_PIPELINE_BITMAP);
+	CU_ASSERT(log_inline[5] == False);
+	CU_ASSERT(log_values[6] == TEST_PIPELINE_BITMAP);
+	CU_ASSERT(log_inline[6] == True);
+	CU_ASSERT(test_log_sequence(7, 5) == True);
+
+	test_pipeline_stop();
+}
+
+void test_pipeline_free(void)
+{
+	test_pipeline_start();
+
+	/* the queued records are processed before the callbacks are put back */
+	delay = 1000;
+	test_opaque_rects(0, 50);
+	test_pipeline_stop();
+
+	CU_ASSERT(log_count == 50);
+	CU_ASSERT(test_log_sequence(0, 50) == True);
+	CU_ASSERT(rdp->update->OpaqueRect == test_opaque_rect);
+	CU_ASSERT(rdp->update->Bitmap == test_bitmap);
+}
@@ -0,0 +1,429 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Planar Codec Unit Tests
+ *
+ * Copyright 2026 FreeRDP Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <freerdp/freerdp.h>
+#include <freerdp/utils/cpu.h>
+
+#include "planar.h"
+#include "test_planar.h"
+
+/* number of long runs (16 to 47 bytes in a single code) written by the encoder */
+static int long_runs;
+
+int init_planar_suite(void)
+{
+	srand(1);
+	return 0;
+}
+
+int clean_planar_suite(void)
+{
+	planar_init(freerdp_cpu_features());
+	return 0;
+}
+
+int add_planar_suite(void)
+{
+	add_test_suite(planar);
+
+	add_test_function(planar_raw);
+	add_test_function(planar_rle);
+	add_test_function(planar_color_loss);
+	add_test_function(planar_large);
+	add_test_function(planar_malformed);
+
+	return 0;
+}
+
+/**
+ * Fill a plane with a mix of random bytes, runs and scanlines repeating the previous one.
+ */
+static void test_planar_fill(uint8* plane, int width, int height)
+{
+	int x, y;
+	int length;
+	uint8 value;
+	uint8* row;
+
+	for (y = 0; y < height; y++)
+	{
+		row = plane + y * width;
+
+		if (y > 0 && (rand() % 3) == 0)
+		{
+			memcpy(row, row - width, width);
+
+			/* a few changed bytes leave runs of zero deltas around them */
+			row[rand() % width] ^= 0x55;
+			continue;
+		}
+
+		for (x = 0; x < width; x += length)
+		{
+			length = 1 + rand() % 40;
+
+			if (length > width - x)
+				length = width - x;
+
+			if (rand() % 2)
+			{
+				value = rand();
+				memset(&row[x], value, length);
+			}
+			else
+			{
+				for (value = 0; value < length; value++)
+					row[x + value] = rand();
+			}
+		}
+	}
+}
+
+/**
+ * Run-length encode one scanline of colors or deltas, a run repeating the last color written.
+ */
+static uint8* test_planar_encode_row(uint8* dst, uint8* values, int width)
+{
+	int x = 0;
+	int run;
+	int raw = 0;
+	uint8 color = 0;
+
+	while (x < width)
+	{
+		for (run = 0; x + run < width && values[x + run] == color; run++);
+
+		/* run lengths of 1 and 2 would be taken for long runs, short runs are written as raw bytes */
+		if (run >= 3)
+		{
+			if (raw == 0 && run >= 16)
+			{
+				/* long runs swap the nibbles, the high bits of the length standing in the low nibble */
+				run = (run > 47) ? 47 : run;
+				*dst++ = ((run & 0x0F) << 4) | (run >> 4);
+				long_runs++;
+			}
+			else
+			{
+				run = (run > 15) ? 15 : run;
+				*dst++ = (raw << 4) | run;
+				dst += raw;
+			}
+
+			x += run;
+			raw = 0;
+			continue;
+		}
+
+		dst[1 + raw++] = color = values[x];
+
+		if (raw == 15 || x + 1 == width)
+		{
+			*dst++ = raw << 4;
+			dst += raw;
+			raw = 0;
+		}
+
+		x++;
+	}
+
+	return dst;
+}
+
+/**
+ * Run-length encode a plane, scanlines after the first one holding sign and magnitude deltas.
+ */
+static uint8* test_planar_encode_plane(uint8* dst, uint8* plane, int width, int height)
+{
+	int x, y;
+	sint8 delta;
+	uint8* row;
+	uint8* values;
+
+	values = (uint8*) xmalloc(width);
+
+	for (y = 0; y < height; y++)
+	{
+		row = plane + y * width;
+
+		if (y == 0)
+		{
+			memcpy(values, row, width);
+		}
+		else
+		{
+			for (x = 0; x < width; x++)
+			{
+				delta = (sint8) (row[x] - row[x - width]);
+				values[x] = (delta < 0) ? (((~delta) << 1) | 1) : (delta << 1);
+			}
+		}
+
+		dst = test_planar_encode_row(dst, values, width);
+	}
+
+	xfree(values);
+
+	return dst;
+}
+
+/**
+ * Encode the planes of a bitmap, raw planes being followed by a pad byte.
+ * @return stream length
+ */
+static int test_planar_encode(uint8* stream, uint8 header, uint8** planes, int width, int height)
+{
+	int i;
+	int subsample;
+	int widths[4];
+	int heights[4];
+	uint8* dst = stream;
+
+	subsample = (header & PLANAR_FORMAT_HEADER_CS) ? 1 : 0;
+
+	widths[0] = widths[1] = width;
+	heights[0] = heights[1] = height;
+	widths[2] = widths[3] = (width + subsample) >> subsample;
+	heights[2] = heights[3] = (height + subsample) >> subsample;
+
+	*dst++ = header;
+
+	for (i = (header & PLANAR_FORMAT_HEADER_NA) ? 1 : 0; i < 4; i++)
+	{
+		if (header & PLANAR_FORMAT_HEADER_RLE)
+		{
+			dst = test_planar_encode_plane(dst, planes[i], widths[i], heights[i]);
+		}
+		else
+		{
+			memcpy(dst, planes[i], widths[i] * heights[i]);
+			dst += widths[i] * heights[i];
+		}
+	}
+
+	if (!(header & PLANAR_FORMAT_HEADER_RLE))
+		*dst++ = 0;
+
+	return (int) (dst - stream);
+}
+
+static uint8 test_planar_clamp(int value)
+{
+	return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+}
+
+/**
+ * Compute the top-down BGRA pixels the planes stand for.
+ */
+static void test_planar_expected(uint8* dst, uint8 header, uint8** planes, int width, int height)
+{
+	int x, y;
+	int i, c;
+	int shift;
+	int subsample;
+	int chromaWidth;
+	int luma, co, cg;
+	uint8* pixel;
+
+	shift = (header & PLANAR_FORMAT_HEADER_CLL_MASK) - 1;
+	subsample = (header & PLANAR_FORMAT_HEADER_CS) ? 1 : 0;
+	chromaWidth = (width + subsample) >> subsample;
+
+	for (y = 0; y < height; y++)
+	{
+		for (x = 0; x < width; x++)
+		{
+			/* planes are stored bottom-up */
+			i = y * width + x;
+			c = (y >> subsample) * chromaWidth + (x >> subsample);
+			pixel = &dst[((height - y - 1) * width + x) * 4];
+
+			if (shift < 0)
+			{
+				pixel[0] = planes[3][i];
+				pixel[1] = planes[2][i];
+				pixel[2] = planes[1][i];
+			}
+			else
+			{
+				luma = planes[1][i];
+				co = (sint8) (planes[2][c] << shift);
+				cg = (sint8) (planes[3][c] << shift);
+
+				pixel[0] = test_planar_clamp(luma - cg - co);
+				pixel[1] = test_planar_clamp(luma + cg);
+				pixel[2] = test_planar_clamp(luma - cg + co);
+			}
+
+			pixel[3] = (header & PLANAR_FORMAT_HEADER_NA) ? 0xFF : planes[0][i];
+		}
+	}
+}
+
+/**
+ * Encode random planes, then decode them with the scalar and with the vector kernels.
+ * @return number of decodes failing or giving pixels other than the expected ones
+ */
+static int test_planar_check(uint8 header, int width, int height)
+{
+	int i;
+	int size;
+	int bad = 0;
+	int length = width * height * 4;
+	uint8* planes[4];
+	uint8* stream;
+	uint8* expected;
+	uint8* scalar;
+	uint8* vector;
+
+	for (i = 0; i < 4; i++)
+	{
+		planes[i] = (uint8*) xmalloc(width * height);
+		test_planar_fill(planes[i], width, height);
+	}
+
+	/* each 15 raw bytes take a code byte, each scanline at most one more */
+	stream = (uint8*) xmalloc(2 + 4 * (width * height * 16 / 15 + 2 * height));
+	expected = (uint8*) xmalloc(length);
+	scalar = (uint8*) xmalloc(length);
+	vector = (uint8*) xmalloc(length);
+
+	size = test_planar_encode(stream, header, planes, width, height);
+	test_planar_expected(expected, header, planes, width, height);
+
+	planar_init(0);
+	bad += (planar_decompress(stream, scalar, width * 4, width, height, size) != True);
+
+	planar_init(CPU_SSE2);
+	bad += (planar_decompress(stream, vector, width * 4, width, height, size) != True);
+
+	bad += (memcmp(scalar, expected, length) != 0);
+	bad += (memcmp(vector, expected, length) != 0);
+
+	for (i = 0; i < 4; i++)
+		xfree(planes[i]);
+
+	xfree(stream);
+	xfree(expected);
+	xfree(scalar);
+	xfree(vector);
+
+	return bad;
+}
+
+void test_planar_raw(void)
+{
+	CU_ASSERT(test_planar_check(0, 37, 5) == 0);
+	CU_ASSERT(test_planar_check(PLANAR_FORMAT_HEADER_NA, 37, 5) == 0);
+	CU_ASSERT(test_planar_check(0, 1, 1) == 0);
+	CU_ASSERT(test_planar_check(PLANAR_FORMAT_HEADER_NA, 64, 64) == 0);
+}
+
+void test_planar_rle(void)
+{
+	long_runs = 0;
+
+	CU_ASSERT(test_planar_check(PLANAR_FORMAT_HEADER_RLE, 37, 5) == 0);
+	CU_ASSERT(test_planar_check(PLANAR_FORMAT_HEADER_RLE | PLANAR_FORMAT_HEADER_NA, 37, 5) == 0);
+	CU_ASSERT(test_planar_check(PLANAR_FORMAT_HEADER_RLE, 1, 1) == 0);
+	CU_ASSERT(test_planar_check(PLANAR_FORMAT_HEADER_RLE, 64, 64) == 0);
+	CU_ASSERT(test_planar_check(PLANAR_FORMAT_HEADER_RLE | PLANAR_FORMAT_HEADER_NA, 63, 17) == 0);
+
+	CU_ASSERT(long_runs > 0);
+}
+
+void test_planar_color_loss(void)
+{
+	uint8 cll;
+	uint8 header;
+
+	for (cll = 1; cll <= 7; cll++)
+	{
+		header = cll | ((cll & 1) ? PLANAR_FORMAT_HEADER_NA : 0);
+
+		CU_ASSERT(test_planar_check(header, 37, 5) == 0);
+		CU_ASSERT(test_planar_check(header | PLANAR_FORMAT_HEADER_RLE, 37, 5) == 0);
+
+		/* odd sizes leave a chroma sample covering a single column or scanline */
+		CU_ASSERT(test_planar_check(header | PLANAR_FORMAT_HEADER_CS, 37, 5) == 0);
+		CU_ASSERT(test_planar_check(header | PLANAR_FORMAT_HEADER_CS | PLANAR_FORMAT_HEADER_RLE, 37, 5) == 0);
+		CU_ASSERT(test_planar_check(header | PLANAR_FORMAT_HEADER_CS | PLANAR_FORMAT_HEADER_RLE, 1, 3) == 0);
+		CU_ASSERT(test_planar_check(header | PLANAR_FORMAT_HEADER_CS, 64, 63) == 0);
+	}
+}
+
+void test_planar_large(void)
+{
+	/* larger than the plane buffer on the stack */
+	CU_ASSERT(test_planar_check(PLANAR_FORMAT_HEADER_RLE, 80, 60) == 0);
+	CU_ASSERT(test_planar_check(3 | PLANAR_FORMAT_HEADER_CS | PLANAR_FORMAT_HEADER_RLE, 81, 61) == 0);
+	CU_ASSERT(test_planar_check(PLANAR_FORMAT_HEADER_NA, 100, 50) == 0);
+}
+
+void test_planar_malformed(void)
+{
+	int i;
+	int size;
+	int bad;
+	uint8* planes[4];
+	uint8 stream[4 * 64 * 2];
+	uint8 dst[8 * 8 * 4];
+	uint8 overrun[] = { PLANAR_FORMAT_HEADER_RLE | PLANAR_FORMAT_HEADER_NA, 0x0F };
+
+	for (i = 0; i < 4; i++)
+	{
+		planes[i] = (uint8*) xmalloc(8 * 8);
+		test_planar_fill(planes[i], 8, 8);
+	}
+
+	planar_init(CPU_SSE2);
+
+	/* chroma subsampling without color loss */
+	stream[0] = PLANAR_FORMAT_HEADER_CS | PLANAR_FORMAT_HEADER_NA;
+	memset(&stream[1], 0, 3 * 8 * 8);
+	CU_ASSERT(planar_decompress(stream, dst, 8 * 4, 8, 8, 1 + 3 * 8 * 8) == False);
+
+	/* a run going past the end of the scanline */
+	CU_ASSERT(planar_decompress(overrun, dst, 8 * 4, 8, 1, sizeof(overrun)) == False);
+
+	/* truncated RLE planes, and RLE planes followed by garbage */
+	size = test_planar_encode(stream, PLANAR_FORMAT_HEADER_RLE, planes, 8, 8);
+
+	for (i = 1, bad = 0; i < size; i++)
+		bad += (planar_decompress(stream, dst, 8 * 4, 8, 8, i) != False);
+
+	CU_ASSERT(bad == 0);
+	CU_ASSERT(planar_decompress(stream, dst, 8 * 4, 8, 8, size) == True);
+	CU_ASSERT(planar_decompress(stream, dst, 8 * 4, 8, 8, size + 1) == False);
+
+	/* truncated raw planes, the pad byte being optional */
+	size = test_planar_encode(stream, 0, planes, 8, 8);
+
+	for (i = 1, bad = 0; i < size - 1; i++)
+		bad += (planar_decompress(stream, dst, 8 * 4, 8, 8, i) != False);
+
+	CU_ASSERT(bad == 0);
+	CU_ASSERT(planar_decompress(stream, dst, 8 * 4, 8, 8, size - 1) == True);
+
+	for (i = 0; i < 4; i++)
+		xfree(planes[i]);
+}
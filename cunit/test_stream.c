@@ -41,6 +41,7 @@ int add_stream_suite(void)
 	add_test_suite(stream);
 
 	add_test_function(stream);
+	add_test_function(stream_pool);
 
 	return 0;
 }
@@ -74,3 +75,61 @@ void test_stream(void)
 
 	stream_free(stream);
 }
+
+void test_stream_pool(void)
+{
+	int i;
+	STREAM* s1;
+	STREAM* s2;
+	STREAM* stream;
+	STREAM_POOL_STATS stats1;
+	STREAM_POOL_STATS stats2;
+
+	s1 = stream_pool_get(300);
+	CU_ASSERT(stream_get_size(s1) == 300);
+	CU_ASSERT(stream_get_pos(s1) == 0);
+	CU_ASSERT(s1->capacity >= 300);
+
+	stream_write_uint32(s1, 0x01020304);
+	stream_pool_put(s1);
+
+	/* a stream of the same size class is recycled */
+	s2 = stream_pool_get(400);
+	CU_ASSERT(s2 == s1);
+	CU_ASSERT(stream_get_size(s2) == 400);
+	CU_ASSERT(stream_get_pos(s2) == 0);
+
+	/* extending a pooled stream within its capacity keeps the buffer */
+	stream_write_uint32(s2, 0x01020304);
+	stream_seal(s2);
+	stream_check_size(s2, 450);
+	CU_ASSERT(stream_get_size(s2) >= 450);
+	stream_pool_put(s2);
+
+	/* streams from stream_new can be returned to the pool */
+	stream = stream_new(1000);
+	stream_pool_put(stream);
+
+	/* steady state get/put does not allocate */
+	stream_pool_get_stats(&stats1);
+
+	for (i = 0; i < 1000; i++)
+	{
+		s1 = stream_pool_get(200 + i);
+		s2 = stream_pool_get(64);
+		stream_pool_put(s1);
+		stream_pool_put(s2);
+	}
+
+	stream_pool_get_stats(&stats2);
+
+	CU_ASSERT(stats2.gets - stats1.gets == 2000);
+	CU_ASSERT(stats2.puts - stats1.puts == 2000);
+	CU_ASSERT(stats2.allocs - stats1.allocs <= 4);
+	CU_ASSERT(stats2.frees - stats1.frees == 0);
+
+	/* sizes beyond the largest class bypass the pool */
+	stream = stream_pool_get(1024 * 1024);
+	CU_ASSERT(stream_get_size(stream) == 1024 * 1024);
+	stream_pool_put(stream);
+}
@@ -26,6 +26,7 @@
 #include <freerdp/utils/load_plugin.h>
 #include <freerdp/utils/wait_obj.h>
 #include <freerdp/utils/args.h>
+#include <freerdp/utils/arena.h>
 
 #include "test_utils.h"
 
@@ -48,6 +49,7 @@ int add_utils_suite(void)
 	add_test_function(load_plugin);
 	add_test_function(wait_obj);
 	add_test_function(args);
+	add_test_function(arena);
 
 	return 0;
 }
@@ -159,3 +161,41 @@ void test_args(void)
 	}
 	CU_ASSERT(i == 2);
 }
+
+void test_arena(void)
+{
+	int i;
+	ARENA* arena;
+	uint8* data[8];
+
+	arena = freerdp_arena_new(64);
+
+	/* allocations are aligned and do not overlap, the arena grows past its initial size */
+	for (i = 0; i < 8; i++)
+	{
+		data[i] = (uint8*) freerdp_arena_alloc(arena, 13);
+		CU_ASSERT(((long) data[i] & 7) == 0);
+		memset(data[i], i, 13);
+	}
+
+	for (i = 0; i < 8; i++)
+		CU_ASSERT(data[i][0] == i && data[i][12] == i);
+
+	CU_ASSERT(arena->block->next != NULL);
+
+	/* blocks are merged on reset, the same allocations then fit in a single block */
+	freerdp_arena_reset(arena);
+	CU_ASSERT(arena->block->next == NULL);
+
+	for (i = 0; i < 8; i++)
+		freerdp_arena_alloc(arena, 13);
+
+	CU_ASSERT(arena->block->next == NULL);
+
+	/* a single block is kept and reused from its start */
+	data[0] = (uint8*) freerdp_arena_alloc(arena, 0);
+	freerdp_arena_reset(arena);
+	CU_ASSERT(freerdp_arena_alloc(arena, 13) == (void*) (data[0] - 8 * 16));
+
+	freerdp_arena_free(arena);
+}
@@ -28,3 +28,4 @@ void test_semaphore(void);
 void test_load_plugin(void);
 void test_wait_obj(void);
 void test_args(void);
+void test_arena(void);
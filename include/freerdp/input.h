@@ -20,6 +20,9 @@
 #ifndef __INPUT_API_H
 #define __INPUT_API_H
 
+#include <freerdp/types.h>
+#include <freerdp/utils/stream.h>
+
 /* Input Events */
 #define INPUT_EVENT_SYNC		0x0000
 #define INPUT_EVENT_SCANCODE		0x0004
@@ -62,6 +65,8 @@ typedef void (*pcKeyboardEvent)(rdpInput* input, uint16 flags, uint16 code);
 typedef void (*pcUnicodeKeyboardEvent)(rdpInput* input, uint16 code);
 typedef void (*pcMouseEvent)(rdpInput* input, uint16 flags, uint16 x, uint16 y);
 typedef void (*pcExtendedMouseEvent)(rdpInput* input, uint16 flags, uint16 x, uint16 y);
+typedef void (*pcBeginBatch)(rdpInput* input);
+typedef void (*pcFlushBatch)(rdpInput* input);
 
 struct rdp_input
 {
@@ -71,6 +76,14 @@ struct rdp_input
 	pcUnicodeKeyboardEvent UnicodeKeyboardEvent;
 	pcMouseEvent MouseEvent;
 	pcExtendedMouseEvent ExtendedMouseEvent;
+
+	/* events between BeginBatch and FlushBatch are sent in a single PDU */
+	pcBeginBatch BeginBatch;
+	pcFlushBatch FlushBatch;
+
+	boolean batching;
+	uint16 numberEvents;
+	STREAM* events;
 };
 
 #endif /* __INPUT_API_H */
@@ -77,6 +77,20 @@ typedef struct
 	uint32 daylightBias;
 } TIME_ZONE_INFORMATION;
 
+/* BITMAP_CACHE_V2_CELL_INFO */
+typedef struct
+{
+	uint16 numEntries;
+	boolean persistent;
+} BITMAP_CACHE_V2_CELL_INFO;
+
+/* GLYPH_CACHE_DEFINITION */
+typedef struct
+{
+	uint16 numEntries;
+	uint16 maxCellSize;
+} GLYPH_CACHE_DEFINITION;
+
 /* ARC_CS_PRIVATE_PACKET */
 typedef struct
 {
@@ -153,6 +167,7 @@ struct rdp_settings
 	char client_product_id[32];
 
 	uint16 port;
+	uint32 tcp_timeout; /* milliseconds, 0 waits without a time limit */
 	char* hostname;
 	char* username;
 	char* password;
@@ -195,6 +210,9 @@ struct rdp_settings
 	boolean sound_beeps;
 
 	boolean fast_path_input;
+	boolean fast_path_output;
+	boolean update_pipeline;
+	boolean parallel_orders;
 
 	boolean offscreen_bitmap_cache;
 	uint16 offscreen_bitmap_cache_size;
@@ -202,6 +220,11 @@ struct rdp_settings
 
 	boolean bitmap_cache;
 	boolean persistent_bitmap_cache;
+	uint8 bitmap_cache_v2_num_cells;
+	BITMAP_CACHE_V2_CELL_INFO bitmap_cache_v2_cell_info[5];
+
+	GLYPH_CACHE_DEFINITION glyph_cache[10];
+	GLYPH_CACHE_DEFINITION fragment_cache;
 
 	uint32 vc_chunk_size;
 
@@ -46,6 +46,7 @@ struct _BITMAP_DATA
 	uint16 bpp;
 	uint16 flags;
 	uint16 length;
+	boolean compressed;
 	uint8* data;
 };
 typedef struct _BITMAP_DATA BITMAP_DATA;
@@ -145,6 +146,15 @@ struct _DRAW_NINE_GRID_ORDER
 };
 typedef struct _DRAW_NINE_GRID_ORDER DRAW_NINE_GRID_ORDER;
 
+struct _DELTA_RECT
+{
+	sint16 left;
+	sint16 top;
+	sint16 width;
+	sint16 height;
+};
+typedef struct _DELTA_RECT DELTA_RECT;
+
 struct _MULTI_DSTBLT_ORDER
 {
 	sint16 nLeftRect;
@@ -154,7 +164,7 @@ struct _MULTI_DSTBLT_ORDER
 	uint8 bRop;
 	uint8 nDeltaEntries;
 	uint16 cbData;
-	uint8* codeDeltaList;
+	DELTA_RECT rectangles[46];
 };
 typedef struct _MULTI_DSTBLT_ORDER MULTI_DSTBLT_ORDER;
 
@@ -174,7 +184,7 @@ struct _MULTI_PATBLT_ORDER
 	uint8 brushExtra[7];
 	uint8 nDeltaEntries;
 	uint16 cbData;
-	uint8* codeDeltaList;
+	DELTA_RECT rectangles[46];
 };
 typedef struct _MULTI_PATBLT_ORDER MULTI_PATBLT_ORDER;
 
@@ -189,19 +199,10 @@ struct _MULTI_SCRBLT_ORDER
 	sint16 nYSrc;
 	uint8 nDeltaEntries;
 	uint16 cbData;
-	uint8* codeDeltaList;
+	DELTA_RECT rectangles[46];
 };
 typedef struct _MULTI_SCRBLT_ORDER MULTI_SCRBLT_ORDER;
 
-struct _DELTA_RECT
-{
-	sint16 left;
-	sint16 top;
-	sint16 width;
-	sint16 height;
-};
-typedef struct _DELTA_RECT DELTA_RECT;
-
 struct _MULTI_OPAQUE_RECT_ORDER
 {
 	sint16 nLeftRect;
@@ -211,7 +212,7 @@ struct _MULTI_OPAQUE_RECT_ORDER
 	uint32 color;
 	uint8 numRectangles;
 	uint16 cbData;
-	DELTA_RECT rectangles[45];
+	DELTA_RECT rectangles[46];
 };
 typedef struct _MULTI_OPAQUE_RECT_ORDER MULTI_OPAQUE_RECT_ORDER;
 
@@ -332,7 +333,7 @@ struct _GLYPH_INDEX_ORDER
 	sint16 x;
 	sint16 y;
 	uint8 cbData;
-	uint8* data;
+	uint8 data[256];
 };
 typedef struct _GLYPH_INDEX_ORDER GLYPH_INDEX_ORDER;
 
@@ -354,10 +355,22 @@ struct _FAST_INDEX_ORDER
 	sint16 x;
 	sint16 y;
 	uint8 cbData;
-	uint8* data;
+	uint8 data[256];
 };
 typedef struct _FAST_INDEX_ORDER FAST_INDEX_ORDER;
 
+struct _GLYPH_DATA_V2
+{
+	uint8 cacheIndex;
+	sint16 x;
+	sint16 y;
+	uint16 cx;
+	uint16 cy;
+	uint16 cb;
+	uint8* aj;
+};
+typedef struct _GLYPH_DATA_V2 GLYPH_DATA_V2;
+
 struct _FAST_GLYPH_ORDER
 {
 	uint8 cacheId;
@@ -376,7 +389,8 @@ struct _FAST_GLYPH_ORDER
 	sint16 x;
 	sint16 y;
 	uint8 cbData;
-	uint8* data;
+	uint8 data[256];
+	GLYPH_DATA_V2 glyph_data;
 };
 typedef struct _FAST_GLYPH_ORDER FAST_GLYPH_ORDER;
 
@@ -452,6 +466,7 @@ struct _CACHE_BITMAP_ORDER
 	uint8 bitmapHeight;
 	uint16 bitmapLength;
 	uint16 cacheIndex;
+	boolean compressed;
 	uint8 bitmapComprHdr[8];
 	uint8* bitmapDataStream;
 };
@@ -468,6 +483,7 @@ struct _CACHE_BITMAP_V2_ORDER
 	uint16 bitmapHeight;
 	uint32 bitmapLength;
 	uint16 cacheIndex;
+	boolean compressed;
 	uint8 bitmapComprHdr[8];
 	uint8* bitmapDataStream;
 };
@@ -507,8 +523,8 @@ typedef struct _CACHE_COLOR_TABLE_ORDER CACHE_COLOR_TABLE_ORDER;
 struct _GLYPH_DATA
 {
 	uint16 cacheIndex;
-	uint16 x;
-	uint16 y;
+	sint16 x;
+	sint16 y;
 	uint16 cx;
 	uint16 cy;
 	uint16 cb;
@@ -525,18 +541,6 @@ struct _CACHE_GLYPH_ORDER
 };
 typedef struct _CACHE_GLYPH_ORDER CACHE_GLYPH_ORDER;
 
-struct _GLYPH_DATA_V2
-{
-	uint8 cacheIndex;
-	sint16 x;
-	sint16 y;
-	uint16 cx;
-	uint16 cy;
-	uint16 cb;
-	uint8* aj;
-};
-typedef struct _GLYPH_DATA_V2 GLYPH_DATA_V2;
-
 struct _CACHE_GLYPH_V2_ORDER
 {
 	uint8 cacheId;
@@ -711,6 +715,17 @@ typedef struct _DRAW_GDIPLUS_CACHE_END_ORDER DRAW_GDIPLUS_CACHE_END_ORDER;
 #define HS_CROSS	0x04
 #define HS_DIAGCROSS	0x05
 
+#define SO_FLAG_DEFAULT_PLACEMENT	0x01
+#define SO_HORIZONTAL			0x02
+#define SO_VERTICAL			0x04
+#define SO_REVERSED			0x08
+#define SO_ZERO_BEARINGS		0x10
+#define SO_CHAR_INC_EQUAL_BM_BASE	0x20
+#define SO_MAXEXT_EQUAL_BM_SIDE		0x40
+
+#define GLYPH_FRAGMENT_USE		0xFE
+#define GLYPH_FRAGMENT_ADD		0xFF
+
 #define DSDNG_STRETCH 		0x00000001
 #define DSDNG_TILE 		0x00000002
 #define DSDNG_PERPIXELALPHA 	0x00000004
@@ -787,6 +802,9 @@ struct rdp_update
 	void* param1;
 	void* param2;
 
+	/* parse-time allocations, released at the end of each update PDU */
+	struct rdp_arena* arena;
+
 	pcBeginPaint BeginPaint;
 	pcEndPaint EndPaint;
 	pcSetBounds SetBounds;
@@ -0,0 +1,45 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Arena Allocator Utils
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ARENA_UTILS_H
+#define __ARENA_UTILS_H
+
+#include <freerdp/types.h>
+
+struct rdp_arena_block
+{
+	struct rdp_arena_block* next;
+	uint32 size;
+	uint32 used;
+};
+
+struct rdp_arena
+{
+	/* block being filled, followed by the blocks filled before it */
+	struct rdp_arena_block* block;
+	uint32 size;
+};
+typedef struct rdp_arena ARENA;
+
+ARENA* freerdp_arena_new(uint32 size);
+void* freerdp_arena_alloc(ARENA* arena, uint32 length);
+void freerdp_arena_reset(ARENA* arena);
+void freerdp_arena_free(ARENA* arena);
+
+#endif /* __ARENA_UTILS_H */
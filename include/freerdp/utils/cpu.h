@@ -0,0 +1,40 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * CPU Feature Utils
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CPU_UTILS_H
+#define __CPU_UTILS_H
+
+#include <freerdp/types.h>
+
+/*
+ * SIMD kernels are only built when the compiler targets the instruction set,
+ * SSE2 being part of the x86-64 baseline. Modules keep a scalar version of each
+ * kernel and switch to the SIMD one at init time, if the processor has it.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WITH_SSE2
+#include <emmintrin.h>
+#endif
+
+/* CPU Features */
+#define CPU_SSE2		0x00000001
+
+uint32 freerdp_cpu_features(void);
+
+#endif /* __CPU_UTILS_H */
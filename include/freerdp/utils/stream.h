@@ -29,12 +29,26 @@ struct _STREAM
 	int size;
 	uint8* p;
 	uint8* data;
+	int capacity;
 };
 typedef struct _STREAM STREAM;
 
 STREAM* stream_new(int size);
 void stream_free(STREAM* stream);
 
+struct _STREAM_POOL_STATS
+{
+	uint32 gets;
+	uint32 puts;
+	uint32 allocs;
+	uint32 frees;
+};
+typedef struct _STREAM_POOL_STATS STREAM_POOL_STATS;
+
+STREAM* stream_pool_get(int size);
+void stream_pool_put(STREAM* stream);
+void stream_pool_get_stats(STREAM_POOL_STATS* stats);
+
 void stream_extend(STREAM* stream);
 #define stream_check_size(_s,_n) \
 	while (_s->p - _s->data + (_n) > _s->size) \
@@ -90,7 +90,9 @@ void rdp_recv_server_control_pdu(rdpRdp* rdp, STREAM* s, rdpSettings* settings)
 	{
 		if (rdp->settings->rdp_version >= 5)
 		{
-			//rdp_send_client_persistent_key_list_pdu(rdp);
+			if (rdp->settings->persistent_bitmap_cache)
+				rdp_send_client_persistent_key_list_pdu(rdp);
+
 			rdp_send_client_font_list_pdu(rdp, FONTLIST_FIRST | FONTLIST_LAST);
 		}
 		else
@@ -118,34 +120,105 @@ void rdp_write_persistent_list_entry(STREAM* s, uint32 key1, uint32 key2)
 	stream_write_uint32(s, key2); /* key2 (4 bytes) */
 }
 
-void rdp_write_client_persistent_key_list_pdu(STREAM* s, rdpSettings* settings)
-{
-	stream_write_uint16(s, 0); /* numEntriesCache0 (2 bytes) */
-	stream_write_uint16(s, 0); /* numEntriesCache1 (2 bytes) */
-	stream_write_uint16(s, 0); /* numEntriesCache2 (2 bytes) */
-	stream_write_uint16(s, 0); /* numEntriesCache3 (2 bytes) */
-	stream_write_uint16(s, 0); /* numEntriesCache4 (2 bytes) */
-	stream_write_uint16(s, 0); /* totalEntriesCache0 (2 bytes) */
-	stream_write_uint16(s, 0); /* totalEntriesCache1 (2 bytes) */
-	stream_write_uint16(s, 0); /* totalEntriesCache2 (2 bytes) */
-	stream_write_uint16(s, 0); /* totalEntriesCache3 (2 bytes) */
-	stream_write_uint16(s, 0); /* totalEntriesCache4 (2 bytes) */
-	stream_write_uint8(s, PERSIST_LAST_PDU); /* bBitMask (1 byte) */
+void rdp_write_client_persistent_key_list_pdu(STREAM* s, uint16* numEntries, uint16* totalEntries, uint8 flags)
+{
+	stream_write_uint16(s, numEntries[0]); /* numEntriesCache0 (2 bytes) */
+	stream_write_uint16(s, numEntries[1]); /* numEntriesCache1 (2 bytes) */
+	stream_write_uint16(s, numEntries[2]); /* numEntriesCache2 (2 bytes) */
+	stream_write_uint16(s, numEntries[3]); /* numEntriesCache3 (2 bytes) */
+	stream_write_uint16(s, numEntries[4]); /* numEntriesCache4 (2 bytes) */
+	stream_write_uint16(s, totalEntries[0]); /* totalEntriesCache0 (2 bytes) */
+	stream_write_uint16(s, totalEntries[1]); /* totalEntriesCache1 (2 bytes) */
+	stream_write_uint16(s, totalEntries[2]); /* totalEntriesCache2 (2 bytes) */
+	stream_write_uint16(s, totalEntries[3]); /* totalEntriesCache3 (2 bytes) */
+	stream_write_uint16(s, totalEntries[4]); /* totalEntriesCache4 (2 bytes) */
+	stream_write_uint8(s, flags); /* bBitMask (1 byte) */
 	stream_write_uint8(s, 0); /* pad1 (1 byte) */
 	stream_write_uint16(s, 0); /* pad3 (2 bytes) */
-
-	/* entries */
 }
 
+/**
+ * Send the keys of the bitmaps held in the persistent bitmap cache.\n
+ * The keys are sent in cache order, at most 169 per PDU, and the server
+ * places them at consecutive indices of each cell cache.
+ * @msdn{cc240494}
+ * @param rdp RDP module
+ */
+
 void rdp_send_client_persistent_key_list_pdu(rdpRdp* rdp)
 {
 	STREAM* s;
+	uint8 flags;
+	uint8* bm;
+	uint8* em;
+	int id = 0;
+	int index = 0;
+	int count;
+	uint16 numEntries[PERSISTENT_CACHE_MAX_CELLS];
+	uint16 totalEntries[PERSISTENT_CACHE_MAX_CELLS];
+	PERSISTENT_CACHE_ENTRY* entry;
+	rdpPersistentCache* cache = rdp->persistent;
 
-	s = rdp_data_pdu_init(rdp);
+	if (cache->keys_sent)
+		return;
+
+	persistent_cache_open(cache);
+
+	for (id = 0; id < PERSISTENT_CACHE_MAX_CELLS; id++)
+		totalEntries[id] = persistent_cache_compact(cache, id);
+
+	flags = PERSIST_FIRST_PDU;
+	id = 0;
+
+	do
+	{
+		s = rdp_data_pdu_init(rdp);
 
-	rdp_write_client_persistent_key_list_pdu(s, rdp->settings);
+		stream_get_mark(s, bm);
+		stream_seek(s, 24);
+
+		count = 0;
+		memset(numEntries, 0, sizeof(numEntries));
+
+		while (id < PERSISTENT_CACHE_MAX_CELLS && count < PERSISTENT_KEY_LIST_MAX_ENTRIES)
+		{
+			if (index >= totalEntries[id])
+			{
+				id++;
+				index = 0;
+				continue;
+			}
+
+			entry = persistent_cache_get(cache, id, index);
+			rdp_write_persistent_list_entry(s, entry->key1, entry->key2);
+
+			numEntries[id]++;
+			index++;
+			count++;
+		}
+
+		while (id < PERSISTENT_CACHE_MAX_CELLS && index >= totalEntries[id])
+		{
+			id++;
+			index = 0;
+		}
+
+		if (id >= PERSISTENT_CACHE_MAX_CELLS)
+			flags |= PERSIST_LAST_PDU;
+
+		stream_get_mark(s, em);
+		stream_set_mark(s, bm);
+		rdp_write_client_persistent_key_list_pdu(s, numEntries, totalEntries, flags);
+		stream_set_mark(s, em);
+
+		rdp_send_data_pdu(rdp, s, DATA_PDU_TYPE_BITMAP_CACHE_PERSISTENT_LIST, rdp->mcs->user_id);
+
+		flags = 0;
+	}
+	while (id < PERSISTENT_CACHE_MAX_CELLS);
 
-	rdp_send_data_pdu(rdp, s, DATA_PDU_TYPE_BITMAP_CACHE_PERSISTENT_LIST, rdp->mcs->user_id);
+	cache->keys_sent = True;
+	cache->replay = True;
 }
 
 void rdp_write_client_font_list_pdu(STREAM* s, uint16 flags)
@@ -17,6 +17,9 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
+#include "planar.h"
 #include "bitmap.h"
 
 /*
@@ -30,13 +33,6 @@
    Bitmasks
 */
 static uint8 g_MaskBit0 = 0x01; /* Least significant bit */
-static uint8 g_MaskBit1 = 0x02;
-static uint8 g_MaskBit2 = 0x04;
-static uint8 g_MaskBit3 = 0x08;
-static uint8 g_MaskBit4 = 0x10;
-static uint8 g_MaskBit5 = 0x20;
-static uint8 g_MaskBit6 = 0x40;
-static uint8 g_MaskBit7 = 0x80; /* Most significant bit */
 
 static uint8 g_MaskRegularRunLength = 0x1F;
 static uint8 g_MaskLiteRunLength = 0x0F;
@@ -155,6 +151,208 @@ static uint32 ExtractRunLength(uint32 code, uint8* pbOrderHdr, uint32* advance)
 	return runLength;
 }
 
+/*
+   Destination cursor
+
+   Scanlines are stored bottom-up in the compressed stream. The cursor starts
+   on the last scanline of the destination rectangle and moves up one stride
+   each time a scanline is completed, so the previous (already decoded)
+   scanline is always found at pos + stride.
+
+   When the destination format differs from the compressed format, pixels are
+   decoded into two scanline buffers used in turn, and each scanline is
+   converted into the destination as soon as it is completed. The stride then
+   flips sign on every scanline so that pos + stride still points to the
+   previous scanline.
+*/
+typedef void (*RLE_CONVERT)(uint8* src, uint8* dst, uint32 count, uint32* palette);
+
+struct _RLE_DEST
+{
+	uint8* line;
+	uint8* pos;
+	uint8* end;
+	sint32 stride;
+	uint32 lineSize;
+	uint32 lines;
+	uint32 height;
+	uint32 pixelSize;
+	uint8* out;
+	sint32 outStride;
+	uint32* palette;
+	RLE_CONVERT convert;
+};
+typedef struct _RLE_DEST RLE_DEST;
+
+static void rle_dest_init(RLE_DEST* dest, uint8* buffer, sint32 stride, uint32 width, uint32 height, uint32 pixelSize)
+{
+	dest->pixelSize = pixelSize;
+	dest->lineSize = width * pixelSize;
+	dest->lines = (width > 0) ? height : 0;
+	dest->height = height;
+	dest->stride = stride;
+	dest->line = buffer + ((sint32) height - 1) * stride;
+	dest->pos = dest->line;
+	dest->end = dest->line + dest->lineSize;
+	dest->out = NULL;
+	dest->outStride = 0;
+	dest->palette = NULL;
+	dest->convert = NULL;
+}
+
+static void rle_dest_init_convert(RLE_DEST* dest, uint8* lines, uint8* buffer, sint32 stride,
+		uint32 width, uint32 height, uint32 pixelSize, RLE_CONVERT convert, uint32* palette)
+{
+	rle_dest_init(dest, lines, width * pixelSize, width, 1, pixelSize);
+	dest->lines = (width > 0) ? height : 0;
+	dest->height = height;
+	dest->out = buffer + ((sint32) height - 1) * stride;
+	dest->outStride = stride;
+	dest->palette = palette;
+	dest->convert = convert;
+}
+
+/**
+ * Get the number of pixels of a run that fit on the current scanline.
+ */
+static uint32 rle_dest_span(RLE_DEST* dest, uint32 runLength, uint32 pixelSize)
+{
+	uint32 count;
+
+	count = (uint32) (dest->end - dest->pos) / pixelSize;
+
+	return (runLength < count) ? runLength : count;
+}
+
+/**
+ * Store the updated write position, moving to the next scanline if needed.
+ */
+static void rle_dest_commit(RLE_DEST* dest, uint8* pos)
+{
+	dest->pos = pos;
+
+	if (pos == dest->end)
+	{
+		dest->lines--;
+
+		if (dest->convert != NULL)
+		{
+			dest->convert(dest->line, dest->out, dest->lineSize / dest->pixelSize, dest->palette);
+			dest->out -= dest->outStride;
+			dest->line += dest->stride;
+			dest->stride = -dest->stride;
+		}
+		else
+		{
+			dest->line -= dest->stride;
+		}
+
+		dest->pos = dest->line;
+		dest->end = dest->line + dest->lineSize;
+	}
+}
+
+/**
+ * Convert the part of the current scanline that was written before the end of the stream.
+ */
+static void rle_dest_flush(RLE_DEST* dest)
+{
+	if (dest->convert != NULL && dest->lines > 0 && dest->pos != dest->line)
+		dest->convert(dest->line, dest->out, (dest->pos - dest->line) / dest->pixelSize, dest->palette);
+}
+
+/*
+   Foreground/Background Mask Expansion
+
+   Entry n of the table holds the eight bits of the bitmask n spread to one
+   byte each, 0xFF for a foreground pixel and 0x00 for a background pixel,
+   so that eight pixels of a foreground/background image can be produced
+   without testing the bits one at a time.
+*/
+#define FGBG_BIT(_m, _b) ((((_m) >> (_b)) & 1) ? 0xFF : 0x00)
+#define FGBG_EXPAND(_m) { FGBG_BIT(_m, 0), FGBG_BIT(_m, 1), FGBG_BIT(_m, 2), FGBG_BIT(_m, 3), \
+	FGBG_BIT(_m, 4), FGBG_BIT(_m, 5), FGBG_BIT(_m, 6), FGBG_BIT(_m, 7) }
+#define FGBG_EXPAND4(_m) FGBG_EXPAND(_m), FGBG_EXPAND((_m) + 1), FGBG_EXPAND((_m) + 2), FGBG_EXPAND((_m) + 3)
+#define FGBG_EXPAND16(_m) FGBG_EXPAND4(_m), FGBG_EXPAND4((_m) + 4), FGBG_EXPAND4((_m) + 8), FGBG_EXPAND4((_m) + 12)
+#define FGBG_EXPAND64(_m) FGBG_EXPAND16(_m), FGBG_EXPAND16((_m) + 16), FGBG_EXPAND16((_m) + 32), FGBG_EXPAND16((_m) + 48)
+
+static const uint8 g_MaskFgBgExpand[256][8] =
+{
+	FGBG_EXPAND64(0), FGBG_EXPAND64(64), FGBG_EXPAND64(128), FGBG_EXPAND64(192)
+};
+
+/*
+   Run Primitives
+
+   At 24bpp, pixel runs are written a whole span at a time instead of one
+   pixel at a time: single color runs with memset when all the bytes of the
+   pixel are equal (black and white always are) or by doubling the filled
+   part with memcpy otherwise, and foreground/background images eight
+   pixels at a time from the expanded mask. The previous scanline is NULL
+   on the first line. The 8 and 16bpp decoders write runs pixel by pixel,
+   bulk writes measuring no faster there on the test corpora.
+*/
+#define RLE_FILL_PIXELS(_buf, _pix, _count) do { \
+	uint8* _p = (_buf); \
+	uint32 _n = (_count); \
+	while (_n > 0) { DESTWRITEPIXEL(_p, _pix); DESTNEXTPIXEL(_p); _n--; } } while (0)
+
+static void rle_fill24(uint8* dst, PIXEL pixel, uint32 count)
+{
+	uint32 size;
+	uint32 filled;
+	uint32 length;
+
+	if ((uint8) pixel == (uint8) (pixel >> 8) && (uint8) pixel == (uint8) (pixel >> 16))
+	{
+		memset(dst, (uint8) pixel, count * 3);
+		return;
+	}
+
+	if (count < 1)
+		return;
+
+	dst[0] = (uint8) pixel;
+	dst[1] = (uint8) (pixel >> 8);
+	dst[2] = (uint8) (pixel >> 16);
+
+	/* keep doubling the filled part until the whole run is written */
+	size = count * 3;
+	filled = 3;
+
+	while (filled < size)
+	{
+		length = (filled < size - filled) ? filled : size - filled;
+		memcpy(dst + filled, dst, length);
+		filled += length;
+	}
+}
+
+static void rle_fgbg24(uint8* dst, uint8* prev, const uint8* mask, PIXEL fgPel)
+{
+	int i;
+	PIXEL pixel;
+
+	for (i = 0; i < 8; i++)
+	{
+		pixel = fgPel & (PIXEL) (sint8) mask[i];
+
+		if (prev != NULL)
+		{
+			pixel ^= prev[0] | (prev[1] << 8) | (prev[2] << 16);
+			prev += 3;
+		}
+
+		dst[0] = (uint8) pixel;
+		dst[1] = (uint8) (pixel >> 8);
+		dst[2] = (uint8) (pixel >> 16);
+
+		dst += 3;
+	}
+}
+
+#define RLE_LINE_BUFFER_PIXELS 1024
+
 #define UNROLL_COUNT 4
 #define UNROLL(_exp) do { _exp _exp _exp _exp } while (0)
 
@@ -163,6 +361,9 @@ static uint32 ExtractRunLength(uint32 code, uint8* pbOrderHdr, uint32* advance)
 #undef SRCREADPIXEL
 #undef DESTNEXTPIXEL
 #undef SRCNEXTPIXEL
+#undef DESTPIXELSIZE
+#undef DESTFILLPIXELS
+#undef DESTFGBGPIXELS
 #undef WRITEFGBGIMAGE
 #undef WRITEFIRSTLINEFGBGIMAGE
 #undef RLEDECOMPRESS
@@ -172,9 +373,11 @@ static uint32 ExtractRunLength(uint32 code, uint8* pbOrderHdr, uint32* advance)
 #define SRCREADPIXEL(_pix, _buf) _pix = (_buf)[0]
 #define DESTNEXTPIXEL(_buf) _buf += 1
 #define SRCNEXTPIXEL(_buf) _buf += 1
+#define DESTPIXELSIZE 1
+#define DESTFILLPIXELS(_buf, _pix, _count) RLE_FILL_PIXELS(_buf, _pix, _count)
 #define WRITEFGBGIMAGE WriteFgBgImage8to8
 #define WRITEFIRSTLINEFGBGIMAGE WriteFirstLineFgBgImage8to8
-#define RLEDECOMPRESS RleDecompress8to8
+#define RLEDECOMPRESS RleDecompress8
 #define RLEEXTRA
 #include "bitmap_inc.c"
 
@@ -183,6 +386,9 @@ static uint32 ExtractRunLength(uint32 code, uint8* pbOrderHdr, uint32* advance)
 #undef SRCREADPIXEL
 #undef DESTNEXTPIXEL
 #undef SRCNEXTPIXEL
+#undef DESTPIXELSIZE
+#undef DESTFILLPIXELS
+#undef DESTFGBGPIXELS
 #undef WRITEFGBGIMAGE
 #undef WRITEFIRSTLINEFGBGIMAGE
 #undef RLEDECOMPRESS
@@ -192,9 +398,11 @@ static uint32 ExtractRunLength(uint32 code, uint8* pbOrderHdr, uint32* advance)
 #define SRCREADPIXEL(_pix, _buf) _pix = ((uint16*)(_buf))[0]
 #define DESTNEXTPIXEL(_buf) _buf += 2
 #define SRCNEXTPIXEL(_buf) _buf += 2
+#define DESTPIXELSIZE 2
+#define DESTFILLPIXELS(_buf, _pix, _count) RLE_FILL_PIXELS(_buf, _pix, _count)
 #define WRITEFGBGIMAGE WriteFgBgImage16to16
 #define WRITEFIRSTLINEFGBGIMAGE WriteFirstLineFgBgImage16to16
-#define RLEDECOMPRESS RleDecompress16to16
+#define RLEDECOMPRESS RleDecompress16
 #define RLEEXTRA
 #include "bitmap_inc.c"
 
@@ -203,6 +411,9 @@ static uint32 ExtractRunLength(uint32 code, uint8* pbOrderHdr, uint32* advance)
 #undef SRCREADPIXEL
 #undef DESTNEXTPIXEL
 #undef SRCNEXTPIXEL
+#undef DESTPIXELSIZE
+#undef DESTFILLPIXELS
+#undef DESTFGBGPIXELS
 #undef WRITEFGBGIMAGE
 #undef WRITEFIRSTLINEFGBGIMAGE
 #undef RLEDECOMPRESS
@@ -215,212 +426,250 @@ static uint32 ExtractRunLength(uint32 code, uint8* pbOrderHdr, uint32* advance)
   ((_buf)[2] << 16)
 #define DESTNEXTPIXEL(_buf) _buf += 3
 #define SRCNEXTPIXEL(_buf) _buf += 3
+#define DESTPIXELSIZE 3
+#define DESTFILLPIXELS(_buf, _pix, _count) rle_fill24(_buf, _pix, _count)
+#define DESTFGBGPIXELS(_buf, _prev, _mask, _pix) rle_fgbg24(_buf, _prev, _mask, _pix)
 #define WRITEFGBGIMAGE WriteFgBgImage24to24
 #define WRITEFIRSTLINEFGBGIMAGE WriteFirstLineFgBgImage24to24
-#define RLEDECOMPRESS RleDecompress24to24
+#define RLEDECOMPRESS RleDecompress24
 #define RLEEXTRA
 #include "bitmap_inc.c"
 
-#define IN_UINT8_MV(_p) (*((_p)++))
+/*
+   Scanline Color Conversion
 
-/**
- * decompress a color plane
- */
-static int process_plane(uint8* in, int width, int height, uint8* out, int size)
+   Decompressed scanlines are converted to 16bpp RGB565 or to 32bpp XRGB
+   (0x00RRGGBB). 8bpp bitmaps are converted with a 256 entry lookup table
+   holding colors in the destination format.
+*/
+static void RleConvert8to16(uint8* src, uint8* dst, uint32 count, uint32* palette)
 {
-	int indexw;
-	int indexh;
-	int code;
-	int collen;
-	int replen;
-	int color;
-	int x;
-	int revcode;
-	uint8* last_line;
-	uint8* this_line;
-	uint8* org_in;
-	uint8* org_out;
-
-	org_in = in;
-	org_out = out;
-	last_line = 0;
-	indexh = 0;
-	while (indexh < height)
+	uint16* dst16 = (uint16*) dst;
+
+	while (count > 0)
 	{
-		out = (org_out + width * height * 4) - ((indexh + 1) * width * 4);
-		color = 0;
-		this_line = out;
-		indexw = 0;
-		if (last_line == 0)
-		{
-			while (indexw < width)
-			{
-				code = IN_UINT8_MV(in);
-				replen = code & 0xf;
-				collen = (code >> 4) & 0xf;
-				revcode = (replen << 4) | collen;
-				if ((revcode <= 47) && (revcode >= 16))
-				{
-					replen = revcode;
-					collen = 0;
-				}
-				while (collen > 0)
-				{
-					color = IN_UINT8_MV(in);
-					*out = color;
-					out += 4;
-					indexw++;
-					collen--;
-				}
-				while (replen > 0)
-				{
-					*out = color;
-					out += 4;
-					indexw++;
-					replen--;
-				}
-			}
-		}
-		else
-		{
-			while (indexw < width)
-			{
-				code = IN_UINT8_MV(in);
-				replen = code & 0xf;
-				collen = (code >> 4) & 0xf;
-				revcode = (replen << 4) | collen;
-				if ((revcode <= 47) && (revcode >= 16))
-				{
-					replen = revcode;
-					collen = 0;
-				}
-				while (collen > 0)
-				{
-					x = IN_UINT8_MV(in);
-					if (x & 1)
-					{
-						x = x >> 1;
-						x = x + 1;
-						color = -x;
-					}
-					else
-					{
-						x = x >> 1;
-						color = x;
-					}
-					x = last_line[indexw * 4] + color;
-					*out = x;
-					out += 4;
-					indexw++;
-					collen--;
-				}
-				while (replen > 0)
-				{
-					x = last_line[indexw * 4] + color;
-					*out = x;
-					out += 4;
-					indexw++;
-					replen--;
-				}
-			}
-		}
-		indexh++;
-		last_line = this_line;
+		*dst16++ = (uint16) palette[*src++];
+		count--;
 	}
-	return (int) (in - org_in);
 }
 
-/**
- * 4 byte bitmap decompress
- */
-static boolean bitmap_decompress4(uint8* srcData, uint8* dstData, int width, int height, int size)
+static void RleConvert8to32(uint8* src, uint8* dst, uint32 count, uint32* palette)
 {
-	int code;
-	int bytes_pro;
-	int total_pro;
-
-	code = IN_UINT8_MV(srcData);
-
-	if (code != 0x10)
-		return False;
-
-	total_pro = 1;
-	bytes_pro = process_plane(srcData, width, height, dstData + 3, size - total_pro);
-	total_pro += bytes_pro;
-	srcData += bytes_pro;
-	bytes_pro = process_plane(srcData, width, height, dstData + 2, size - total_pro);
-	total_pro += bytes_pro;
-	srcData += bytes_pro;
-	bytes_pro = process_plane(srcData, width, height, dstData + 1, size - total_pro);
-	total_pro += bytes_pro;
-	srcData += bytes_pro;
-	bytes_pro = process_plane(srcData, width, height, dstData + 0, size - total_pro);
-	total_pro += bytes_pro;
-
-	return (size == total_pro) ? True : False;
+	uint32* dst32 = (uint32*) dst;
+
+	while (count > 0)
+	{
+		*dst32++ = palette[*src++];
+		count--;
+	}
 }
 
-/**
- * bitmap flip
- */
-static int bitmap_flip(uint8* src, uint8* dst, int delta, int height)
+static void RleConvert15to16(uint8* src, uint8* dst, uint32 count, uint32* palette)
 {
-	int index;
+	uint32 pixel;
+	uint16* src16 = (uint16*) src;
+	uint16* dst16 = (uint16*) dst;
 
-	dst = (dst + delta * height) - delta;
-	for (index = 0; index < height; index++)
+	while (count > 0)
 	{
-		memcpy(dst, src, delta);
-		src += delta;
-		dst -= delta;
+		pixel = *src16++;
+		*dst16++ = (uint16) (((pixel & 0x7FE0) << 1) | ((pixel & 0x0200) >> 4) | (pixel & 0x001F));
+		count--;
 	}
-	return 0;
 }
 
-/**
- * bitmap decompression routine
- */
-boolean bitmap_decompress(uint8* srcData, uint8* dstData, int width, int height, int size, int srcBpp, int dstBpp)
+static void RleConvert15to32(uint8* src, uint8* dst, uint32 count, uint32* palette)
 {
-	uint8* data;
+	uint32 pixel;
+	uint32 red, green, blue;
+	uint16* src16 = (uint16*) src;
+	uint32* dst32 = (uint32*) dst;
 
-	if (srcBpp == 16 && dstBpp == 16)
+	while (count > 0)
 	{
-		data = (uint8*) xmalloc(width * height * 2);
-		RleDecompress16to16(srcData, size, data, width * 2, width, height);
-		bitmap_flip(data, dstData, width * 2, height);
-		xfree(data);
+		pixel = *src16++;
+		red = (pixel >> 10) & 0x1F;
+		green = (pixel >> 5) & 0x1F;
+		blue = pixel & 0x1F;
+		red = (red << 3) | (red >> 2);
+		green = (green << 3) | (green >> 2);
+		blue = (blue << 3) | (blue >> 2);
+		*dst32++ = (red << 16) | (green << 8) | blue;
+		count--;
 	}
-	else if (srcBpp == 32 && dstBpp == 32)
+}
+
+static void RleConvert16to32(uint8* src, uint8* dst, uint32 count, uint32* palette)
+{
+	uint32 pixel;
+	uint32 red, green, blue;
+	uint16* src16 = (uint16*) src;
+	uint32* dst32 = (uint32*) dst;
+
+	while (count > 0)
 	{
-		if (bitmap_decompress4(srcData, dstData, width, height, size) != True)
-			return False;
+		pixel = *src16++;
+		red = (pixel >> 11) & 0x1F;
+		green = (pixel >> 5) & 0x3F;
+		blue = pixel & 0x1F;
+		red = (red << 3) | (red >> 2);
+		green = (green << 2) | (green >> 4);
+		blue = (blue << 3) | (blue >> 2);
+		*dst32++ = (red << 16) | (green << 8) | blue;
+		count--;
 	}
-	else if (srcBpp == 15 && dstBpp == 15)
+}
+
+static void RleConvert24to16(uint8* src, uint8* dst, uint32 count, uint32* palette)
+{
+	uint16* dst16 = (uint16*) dst;
+
+	while (count > 0)
 	{
-		data = (uint8*) xmalloc(width * height * 2);
-		RleDecompress16to16(srcData, size, data, width * 2, width, height);
-		bitmap_flip(data, dstData, width * 2, height);
-		xfree(data);
+		/* 24bpp pixels are stored as blue, green, red */
+		*dst16++ = (uint16) (((src[2] >> 3) << 11) | ((src[1] >> 2) << 5) | (src[0] >> 3));
+		src += 3;
+		count--;
 	}
-	else if (srcBpp == 8 && dstBpp == 8)
+}
+
+static void RleConvert24to32(uint8* src, uint8* dst, uint32 count, uint32* palette)
+{
+	uint32* dst32 = (uint32*) dst;
+
+	while (count > 0)
 	{
-		data = (uint8*) xmalloc(width * height);
-		RleDecompress8to8(srcData, size, data, width, width, height);
-		bitmap_flip(data, dstData, width, height);
-		xfree(data);
+		*dst32++ = (src[2] << 16) | (src[1] << 8) | src[0];
+		src += 3;
+		count--;
 	}
-	else if (srcBpp == 24 && dstBpp == 24)
+}
+
+typedef void (*RLE_DECOMPRESS)(uint8* pbSrcBuffer, uint32 cbSrcBuffer, RLE_DEST* dest);
+
+/**
+ * Decompress an interleaved RLE bitmap, converting it to the destination format on the fly.\n
+ * Bitmaps wider than RLE_LINE_BUFFER_PIXELS need a heap allocated pair of scanline buffers.
+ */
+static boolean bitmap_decompress_rle(uint8* srcData, uint8* dstData, int dstStride, int width, int height,
+		int size, int srcBpp, int dstBpp, uint32* palette)
+{
+	RLE_DEST dest;
+	uint32 pixelSize;
+	uint8* lineData;
+	RLE_CONVERT convert;
+	RLE_DECOMPRESS decompress;
+	uint32 lineBuffer[RLE_LINE_BUFFER_PIXELS * 2 * 3 / 4];
+
+	convert = NULL;
+
+	switch (srcBpp)
 	{
-		data = (uint8*) xmalloc(width * height * 3);
-		RleDecompress24to24(srcData, size, data, width * 3, width, height);
-		bitmap_flip(data, dstData, width * 3, height);
-		xfree(data);
+		case 8:
+			decompress = RleDecompress8;
+			pixelSize = 1;
+			if (dstBpp == 16)
+				convert = RleConvert8to16;
+			else if (dstBpp == 32)
+				convert = RleConvert8to32;
+			else if (dstBpp != 8)
+				return False;
+			if (convert != NULL && palette == NULL)
+				return False;
+			break;
+
+		case 15:
+			decompress = RleDecompress16;
+			pixelSize = 2;
+			if (dstBpp == 16)
+				convert = RleConvert15to16;
+			else if (dstBpp == 32)
+				convert = RleConvert15to32;
+			else if (dstBpp != 15)
+				return False;
+			break;
+
+		case 16:
+			decompress = RleDecompress16;
+			pixelSize = 2;
+			if (dstBpp == 32)
+				convert = RleConvert16to32;
+			else if (dstBpp != 16)
+				return False;
+			break;
+
+		case 24:
+			decompress = RleDecompress24;
+			pixelSize = 3;
+			if (dstBpp == 16)
+				convert = RleConvert24to16;
+			else if (dstBpp == 32)
+				convert = RleConvert24to32;
+			else if (dstBpp != 24)
+				return False;
+			break;
+
+		default:
+			return False;
 	}
-	else
+
+	if (convert == NULL)
 	{
-		return False;
+		rle_dest_init(&dest, dstData, dstStride, width, height, pixelSize);
+		decompress(srcData, size, &dest);
+		return True;
 	}
 
+	if (width > RLE_LINE_BUFFER_PIXELS)
+		lineData = (uint8*) xmalloc(width * pixelSize * 2);
+	else
+		lineData = (uint8*) lineBuffer;
+
+	rle_dest_init_convert(&dest, lineData, dstData, dstStride, width, height, pixelSize, convert, palette);
+	decompress(srcData, size, &dest);
+	rle_dest_flush(&dest);
+
+	if (lineData != (uint8*) lineBuffer)
+		xfree(lineData);
+
 	return True;
 }
+
+/**
+ * bitmap decompression routine\n
+ * The bitmap is written top-down, straight into the destination rectangle. Interleaved RLE
+ * bitmaps can be converted to 16bpp RGB565 or 32bpp XRGB while they are decompressed,
+ * 32bpp bitmaps are planar bitmaps decoded to BGRA.
+ * @param srcData compressed bitmap data
+ * @param dstData top-left pixel of the destination rectangle
+ * @param dstStride distance in bytes between two destination scanlines
+ * @param width bitmap width
+ * @param height bitmap height
+ * @param size compressed bitmap data length
+ * @param srcBpp source color depth
+ * @param dstBpp destination color depth
+ * @param palette 256 entry color table in the destination format, for 8bpp bitmaps
+ * @return True on success
+ */
+boolean bitmap_decompress_ex(uint8* srcData, uint8* dstData, int dstStride, int width, int height,
+		int size, int srcBpp, int dstBpp, uint32* palette)
+{
+	if (srcBpp == 32)
+	{
+		if (dstBpp != 32)
+			return False;
+
+		return planar_decompress(srcData, dstData, dstStride, width, height, size);
+	}
+
+	return bitmap_decompress_rle(srcData, dstData, dstStride, width, height, size, srcBpp, dstBpp, palette);
+}
+
+/**
+ * bitmap decompression routine
+ */
+boolean bitmap_decompress(uint8* srcData, uint8* dstData, int width, int height, int size, int srcBpp, int dstBpp)
+{
+	return bitmap_decompress_ex(srcData, dstData, width * ((dstBpp + 7) / 8),
+			width, height, size, srcBpp, dstBpp, NULL);
+}
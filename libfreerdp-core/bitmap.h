@@ -49,6 +49,8 @@
 
 typedef uint32 PIXEL;
 
+boolean bitmap_decompress_ex(uint8* srcData, uint8* dstData, int dstStride, int width, int height,
+		int size, int srcBpp, int dstBpp, uint32* palette);
 boolean bitmap_decompress(uint8* srcData, uint8* dstData, int width, int height, int size, int srcBpp, int dstBpp);
 
 #endif /* __BITMAP_H */
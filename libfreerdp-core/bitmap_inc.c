@@ -20,243 +20,80 @@
 /* do not compile the file directly */
 
 /**
- * Write a foreground/background image to a destination buffer.
+ * Write a foreground/background image to a destination buffer.\n
+ * With DESTFGBGPIXELS, a full bitmask that fits on the current scanline is expanded in one go.
  */
-static uint8* WRITEFGBGIMAGE(uint8* pbDest, uint32 rowDelta,
-	uint8 bitmask, PIXEL fgPel, uint32 cBits)
+static void WRITEFGBGIMAGE(RLE_DEST* dest, uint8 bitmask, PIXEL fgPel, uint32 cBits)
 {
 	PIXEL xorPixel;
+	uint8* pbDest;
 
-	DESTREADPIXEL(xorPixel, pbDest - rowDelta);
-	if (bitmask & g_MaskBit0)
+#ifdef DESTFGBGPIXELS
+	if (cBits == 8 && dest->lines > 0 && rle_dest_span(dest, 8, DESTPIXELSIZE) == 8)
 	{
-		DESTWRITEPIXEL(pbDest, xorPixel ^ fgPel);
+		pbDest = dest->pos;
+		DESTFGBGPIXELS(pbDest, pbDest + dest->stride, g_MaskFgBgExpand[bitmask], fgPel);
+		rle_dest_commit(dest, pbDest + 8 * DESTPIXELSIZE);
+		return;
 	}
-	else
-	{
-		DESTWRITEPIXEL(pbDest, xorPixel);
-	}
-	DESTNEXTPIXEL(pbDest);
-	cBits = cBits - 1;
-	if (cBits > 0)
+#endif
+
+	while (cBits > 0 && dest->lines > 0)
 	{
-		DESTREADPIXEL(xorPixel, pbDest - rowDelta);
-		if (bitmask & g_MaskBit1)
-		{
-			DESTWRITEPIXEL(pbDest, xorPixel ^ fgPel);
-		}
-		else
-		{
-			DESTWRITEPIXEL(pbDest, xorPixel);
-		}
+		pbDest = dest->pos;
+		DESTREADPIXEL(xorPixel, pbDest + dest->stride);
+		DESTWRITEPIXEL(pbDest, xorPixel ^ (fgPel & -(PIXEL) (bitmask & g_MaskBit0)));
 		DESTNEXTPIXEL(pbDest);
+		rle_dest_commit(dest, pbDest);
+		bitmask = bitmask >> 1;
 		cBits = cBits - 1;
-		if (cBits > 0)
-		{
-			DESTREADPIXEL(xorPixel, pbDest - rowDelta);
-			if (bitmask & g_MaskBit2)
-			{
-				DESTWRITEPIXEL(pbDest, xorPixel ^ fgPel);
-			}
-			else
-			{
-				DESTWRITEPIXEL(pbDest, xorPixel);
-			}
-			DESTNEXTPIXEL(pbDest);
-			cBits = cBits - 1;
-			if (cBits > 0)
-			{
-				DESTREADPIXEL(xorPixel, pbDest - rowDelta);
-				if (bitmask & g_MaskBit3)
-				{
-					DESTWRITEPIXEL(pbDest, xorPixel ^ fgPel);
-				}
-				else
-				{
-					DESTWRITEPIXEL(pbDest, xorPixel);
-				}
-				DESTNEXTPIXEL(pbDest);
-				cBits = cBits - 1;
-				if (cBits > 0)
-				{
-					DESTREADPIXEL(xorPixel, pbDest - rowDelta);
-					if (bitmask & g_MaskBit4)
-					{
-						DESTWRITEPIXEL(pbDest, xorPixel ^ fgPel);
-					}
-					else
-					{
-						DESTWRITEPIXEL(pbDest, xorPixel);
-					}
-					DESTNEXTPIXEL(pbDest);
-					cBits = cBits - 1;
-					if (cBits > 0)
-					{
-						DESTREADPIXEL(xorPixel, pbDest - rowDelta);
-						if (bitmask & g_MaskBit5)
-						{
-							DESTWRITEPIXEL(pbDest, xorPixel ^ fgPel);
-						}
-						else
-						{
-							DESTWRITEPIXEL(pbDest, xorPixel);
-						}
-						DESTNEXTPIXEL(pbDest);
-						cBits = cBits - 1;
-						if (cBits > 0)
-						{
-							DESTREADPIXEL(xorPixel, pbDest - rowDelta);
-							if (bitmask & g_MaskBit6)
-							{
-								DESTWRITEPIXEL(pbDest, xorPixel ^ fgPel);
-							}
-							else
-							{
-								DESTWRITEPIXEL(pbDest, xorPixel);
-							}
-							DESTNEXTPIXEL(pbDest);
-							cBits = cBits - 1;
-							if (cBits > 0)
-							{
-								DESTREADPIXEL(xorPixel, pbDest - rowDelta);
-								if (bitmask & g_MaskBit7)
-								{
-									DESTWRITEPIXEL(pbDest, xorPixel ^ fgPel);
-								}
-								else
-								{
-									DESTWRITEPIXEL(pbDest, xorPixel);
-								}
-								DESTNEXTPIXEL(pbDest);
-							}
-						}
-					}
-				}
-			}
-		}
 	}
-	return pbDest;
 }
 
 /**
  * Write a foreground/background image to a destination buffer
  * for the first line of compressed data.
  */
-static uint8* WRITEFIRSTLINEFGBGIMAGE(uint8* pbDest, uint8 bitmask,
-	PIXEL fgPel, uint32 cBits)
+static void WRITEFIRSTLINEFGBGIMAGE(RLE_DEST* dest, uint8 bitmask, PIXEL fgPel, uint32 cBits)
 {
-	if (bitmask & g_MaskBit0)
-	{
-		DESTWRITEPIXEL(pbDest, fgPel);
-	}
-	else
+	uint8* pbDest;
+
+#ifdef DESTFGBGPIXELS
+	if (cBits == 8 && dest->lines > 0 && rle_dest_span(dest, 8, DESTPIXELSIZE) == 8)
 	{
-		DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
+		pbDest = dest->pos;
+		DESTFGBGPIXELS(pbDest, NULL, g_MaskFgBgExpand[bitmask], fgPel);
+		rle_dest_commit(dest, pbDest + 8 * DESTPIXELSIZE);
+		return;
 	}
-	DESTNEXTPIXEL(pbDest);
-	cBits = cBits - 1;
-	if (cBits > 0)
+#endif
+
+	while (cBits > 0 && dest->lines > 0)
 	{
-		if (bitmask & g_MaskBit1)
-		{
-			DESTWRITEPIXEL(pbDest, fgPel);
-		}
-		else
-		{
-			DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
-		}
+		pbDest = dest->pos;
+		DESTWRITEPIXEL(pbDest, fgPel & -(PIXEL) (bitmask & g_MaskBit0));
 		DESTNEXTPIXEL(pbDest);
+		rle_dest_commit(dest, pbDest);
+		bitmask = bitmask >> 1;
 		cBits = cBits - 1;
-		if (cBits > 0)
-		{
-			if (bitmask & g_MaskBit2)
-			{
-				DESTWRITEPIXEL(pbDest, fgPel);
-			}
-			else
-			{
-				DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
-			}
-			DESTNEXTPIXEL(pbDest);
-			cBits = cBits - 1;
-			if (cBits > 0)
-			{
-				if (bitmask & g_MaskBit3)
-				{
-					DESTWRITEPIXEL(pbDest, fgPel);
-				}
-				else
-				{
-					DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
-				}
-				DESTNEXTPIXEL(pbDest);
-				cBits = cBits - 1;
-				if (cBits > 0)
-				{
-					if (bitmask & g_MaskBit4)
-					{
-						DESTWRITEPIXEL(pbDest, fgPel);
-					}
-					else
-					{
-						DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
-					}
-					DESTNEXTPIXEL(pbDest);
-					cBits = cBits - 1;
-					if (cBits > 0)
-					{
-						if (bitmask & g_MaskBit5)
-						{
-							DESTWRITEPIXEL(pbDest, fgPel);
-						}
-						else
-						{
-							DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
-						}
-						DESTNEXTPIXEL(pbDest);
-						cBits = cBits - 1;
-						if (cBits > 0)
-						{
-							if (bitmask & g_MaskBit6)
-							{
-								DESTWRITEPIXEL(pbDest, fgPel);
-							}
-							else
-							{
-								DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
-							}
-							DESTNEXTPIXEL(pbDest);
-							cBits = cBits - 1;
-							if (cBits > 0)
-							{
-								if (bitmask & g_MaskBit7)
-								{
-									DESTWRITEPIXEL(pbDest, fgPel);
-								}
-								else
-								{
-									DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
-								}
-								DESTNEXTPIXEL(pbDest);
-							}
-						}
-					}
-				}
-			}
-		}
 	}
-	return pbDest;
 }
 
 /**
- * Decompress an RLE compressed bitmap.
+ * Decompress an RLE compressed bitmap.\n
+ * Pixels are written through the destination cursor, which hands out one
+ * scanline at a time. Runs are split on scanline boundaries so that they
+ * never write outside of the destination rectangle.
+ * @param pbSrcBuffer compressed bitmap data
+ * @param cbSrcBuffer compressed bitmap data length
+ * @param dest destination cursor
  */
-void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, uint8* pbDestBuffer,
-	uint32 rowDelta, uint32 width, uint32 height)
+static void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, RLE_DEST* dest)
 {
 	uint8* pbSrc = pbSrcBuffer;
 	uint8* pbEnd = pbSrcBuffer + cbSrcBuffer;
-	uint8* pbDest = pbDestBuffer;
+	uint8* pbDest;
+	sint32 rowDelta;
 
 	PIXEL temp;
 	PIXEL fgPel = WHITE_PIXEL;
@@ -267,18 +104,19 @@ void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, uint8* pbDestBuffer,
 	PIXEL pixelA, pixelB;
 
 	uint32 runLength;
+	uint32 count;
 	uint32 code;
 
 	uint32 advance;
 
 	RLEEXTRA
 
-	while (pbSrc < pbEnd)
+	while (pbSrc < pbEnd && dest->lines > 0)
 	{
 		/* Watch out for the end of the first scanline. */
 		if (fFirstLine)
 		{
-			if (pbDest - pbDestBuffer >= rowDelta)
+			if (dest->lines < dest->height)
 			{
 				fFirstLine = False;
 				fInsertFgPel = False;
@@ -300,47 +138,41 @@ void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, uint8* pbDestBuffer,
 			{
 				if (fInsertFgPel)
 				{
+					pbDest = dest->pos;
 					DESTWRITEPIXEL(pbDest, fgPel);
 					DESTNEXTPIXEL(pbDest);
+					rle_dest_commit(dest, pbDest);
 					runLength = runLength - 1;
 				}
-				while (runLength >= UNROLL_COUNT)
-				{
-					UNROLL(
-						DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
-						DESTNEXTPIXEL(pbDest); );
-					runLength = runLength - UNROLL_COUNT;
-				}
-				while (runLength > 0)
+				while (runLength > 0 && dest->lines > 0)
 				{
-					DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
-					DESTNEXTPIXEL(pbDest);
-					runLength = runLength - 1;
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					DESTFILLPIXELS(pbDest, BLACK_PIXEL, count);
+					rle_dest_commit(dest, pbDest + count * DESTPIXELSIZE);
 				}
 			}
 			else
 			{
 				if (fInsertFgPel)
 				{
-					DESTREADPIXEL(temp, pbDest - rowDelta);
+					pbDest = dest->pos;
+					rowDelta = dest->stride;
+					DESTREADPIXEL(temp, pbDest + rowDelta);
 					DESTWRITEPIXEL(pbDest, temp ^ fgPel);
 					DESTNEXTPIXEL(pbDest);
+					rle_dest_commit(dest, pbDest);
 					runLength = runLength - 1;
 				}
-				while (runLength >= UNROLL_COUNT)
-				{
-					UNROLL(
-						DESTREADPIXEL(temp, pbDest - rowDelta);
-						DESTWRITEPIXEL(pbDest, temp);
-						DESTNEXTPIXEL(pbDest); );
-					runLength = runLength - UNROLL_COUNT;
-				}
-				while (runLength > 0)
+				while (runLength > 0 && dest->lines > 0)
 				{
-					DESTREADPIXEL(temp, pbDest - rowDelta);
-					DESTWRITEPIXEL(pbDest, temp);
-					DESTNEXTPIXEL(pbDest);
-					runLength = runLength - 1;
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					/* a background run repeats the previous scanline */
+					memcpy(pbDest, pbDest + dest->stride, count * DESTPIXELSIZE);
+					rle_dest_commit(dest, pbDest + count * DESTPIXELSIZE);
 				}
 			}
 			/* A follow-on background run order will need a foreground pel inserted. */
@@ -366,39 +198,36 @@ void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, uint8* pbDestBuffer,
 					SRCREADPIXEL(fgPel, pbSrc);
 					SRCNEXTPIXEL(pbSrc);
 				}
-				if (fFirstLine)
+				while (runLength > 0 && dest->lines > 0)
 				{
-					while (runLength >= UNROLL_COUNT)
-					{
-						UNROLL(
-							DESTWRITEPIXEL(pbDest, fgPel);
-							DESTNEXTPIXEL(pbDest); );
-						runLength = runLength - UNROLL_COUNT;
-					}
-					while (runLength > 0)
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					rowDelta = dest->stride;
+					if (fFirstLine)
 					{
-						DESTWRITEPIXEL(pbDest, fgPel);
-						DESTNEXTPIXEL(pbDest);
-						runLength = runLength - 1;
+						DESTFILLPIXELS(pbDest, fgPel, count);
+						pbDest = pbDest + count * DESTPIXELSIZE;
 					}
-				}
-				else
-				{
-					while (runLength >= UNROLL_COUNT)
+					else
 					{
-						UNROLL(
-							DESTREADPIXEL(temp, pbDest - rowDelta);
+						while (count >= UNROLL_COUNT)
+						{
+							UNROLL(
+								DESTREADPIXEL(temp, pbDest + rowDelta);
+								DESTWRITEPIXEL(pbDest, temp ^ fgPel);
+								DESTNEXTPIXEL(pbDest); );
+							count = count - UNROLL_COUNT;
+						}
+						while (count > 0)
+						{
+							DESTREADPIXEL(temp, pbDest + rowDelta);
 							DESTWRITEPIXEL(pbDest, temp ^ fgPel);
-							DESTNEXTPIXEL(pbDest); );
-						runLength = runLength - UNROLL_COUNT;
-					}
-					while (runLength > 0)
-					{
-						DESTREADPIXEL(temp, pbDest - rowDelta);
-						DESTWRITEPIXEL(pbDest, temp ^ fgPel);
-						DESTNEXTPIXEL(pbDest);
-						runLength = runLength - 1;
+							DESTNEXTPIXEL(pbDest);
+							count = count - 1;
+						}
 					}
+					rle_dest_commit(dest, pbDest);
 				}
 				break;
 
@@ -411,22 +240,30 @@ void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, uint8* pbDestBuffer,
 				SRCNEXTPIXEL(pbSrc);
 				SRCREADPIXEL(pixelB, pbSrc);
 				SRCNEXTPIXEL(pbSrc);
-				while (runLength >= UNROLL_COUNT)
+				/* the run length is a count of pixel pairs, which may straddle two scanlines */
+				runLength = runLength * 2;
+				while (runLength > 0 && dest->lines > 0)
 				{
-					UNROLL(
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					while (count >= 2)
+					{
 						DESTWRITEPIXEL(pbDest, pixelA);
 						DESTNEXTPIXEL(pbDest);
 						DESTWRITEPIXEL(pbDest, pixelB);
-						DESTNEXTPIXEL(pbDest); );
-					runLength = runLength - UNROLL_COUNT;
-				}
-				while (runLength > 0)
-				{
-					DESTWRITEPIXEL(pbDest, pixelA);
-					DESTNEXTPIXEL(pbDest);
-					DESTWRITEPIXEL(pbDest, pixelB);
-					DESTNEXTPIXEL(pbDest);
-					runLength = runLength - 1;
+						DESTNEXTPIXEL(pbDest);
+						count = count - 2;
+					}
+					if (count > 0)
+					{
+						DESTWRITEPIXEL(pbDest, pixelA);
+						DESTNEXTPIXEL(pbDest);
+						temp = pixelA;
+						pixelA = pixelB;
+						pixelB = temp;
+					}
+					rle_dest_commit(dest, pbDest);
 				}
 				break;
 
@@ -437,18 +274,13 @@ void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, uint8* pbDestBuffer,
 				pbSrc = pbSrc + advance;
 				SRCREADPIXEL(pixelA, pbSrc);
 				SRCNEXTPIXEL(pbSrc);
-				while (runLength >= UNROLL_COUNT)
-				{
-					UNROLL(
-						DESTWRITEPIXEL(pbDest, pixelA);
-						DESTNEXTPIXEL(pbDest); );
-					runLength = runLength - UNROLL_COUNT;
-				}
-				while (runLength > 0)
+				while (runLength > 0 && dest->lines > 0)
 				{
-					DESTWRITEPIXEL(pbDest, pixelA);
-					DESTNEXTPIXEL(pbDest);
-					runLength = runLength - 1;
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					DESTFILLPIXELS(pbDest, pixelA, count);
+					rle_dest_commit(dest, pbDest + count * DESTPIXELSIZE);
 				}
 				break;
 
@@ -464,38 +296,16 @@ void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, uint8* pbDestBuffer,
 					SRCREADPIXEL(fgPel, pbSrc);
 					SRCNEXTPIXEL(pbSrc);
 				}
-				if (fFirstLine)
-				{
-					while (runLength > 8)
-					{
-						bitmask = *pbSrc;
-						pbSrc = pbSrc + 1;
-						pbDest = WRITEFIRSTLINEFGBGIMAGE(pbDest, bitmask, fgPel, 8);
-						runLength = runLength - 8;
-					}
-				}
-				else
-				{
-					while (runLength > 8)
-					{
-						bitmask = *pbSrc;
-						pbSrc = pbSrc + 1;
-						pbDest = WRITEFGBGIMAGE(pbDest, rowDelta, bitmask, fgPel, 8);
-						runLength = runLength - 8;
-					}
-				}
-				if (runLength > 0)
+				while (runLength > 0)
 				{
+					count = (runLength > 8) ? 8 : runLength;
 					bitmask = *pbSrc;
 					pbSrc = pbSrc + 1;
 					if (fFirstLine)
-					{
-						pbDest = WRITEFIRSTLINEFGBGIMAGE(pbDest, bitmask, fgPel, runLength);
-					}
+						WRITEFIRSTLINEFGBGIMAGE(dest, bitmask, fgPel, count);
 					else
-					{
-						pbDest = WRITEFGBGIMAGE(pbDest, rowDelta, bitmask, fgPel, runLength);
-					}
+						WRITEFGBGIMAGE(dest, bitmask, fgPel, count);
+					runLength = runLength - count;
 				}
 				break;
 
@@ -504,22 +314,15 @@ void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, uint8* pbDestBuffer,
 			case MEGA_MEGA_COLOR_IMAGE:
 				runLength = ExtractRunLength(code, pbSrc, &advance);
 				pbSrc = pbSrc + advance;
-				while (runLength >= UNROLL_COUNT)
-				{
-					UNROLL(
-						SRCREADPIXEL(temp, pbSrc);
-						SRCNEXTPIXEL(pbSrc);
-						DESTWRITEPIXEL(pbDest, temp);
-						DESTNEXTPIXEL(pbDest); );
-					runLength = runLength - UNROLL_COUNT;
-				}
-				while (runLength > 0)
+				while (runLength > 0 && dest->lines > 0)
 				{
-					SRCREADPIXEL(temp, pbSrc);
-					SRCNEXTPIXEL(pbSrc);
-					DESTWRITEPIXEL(pbDest, temp);
-					DESTNEXTPIXEL(pbDest);
-					runLength = runLength - 1;
+					count = rle_dest_span(dest, runLength, DESTPIXELSIZE);
+					runLength = runLength - count;
+					pbDest = dest->pos;
+					/* color images are stored in the destination format */
+					memcpy(pbDest, pbSrc, count * DESTPIXELSIZE);
+					pbSrc = pbSrc + count * DESTPIXELSIZE;
+					rle_dest_commit(dest, pbDest + count * DESTPIXELSIZE);
 				}
 				break;
 
@@ -527,41 +330,41 @@ void RLEDECOMPRESS(uint8* pbSrcBuffer, uint32 cbSrcBuffer, uint8* pbDestBuffer,
 			case SPECIAL_FGBG_1:
 				pbSrc = pbSrc + 1;
 				if (fFirstLine)
-				{
-					pbDest = WRITEFIRSTLINEFGBGIMAGE(pbDest, g_MaskSpecialFgBg1, fgPel, 8);
-				}
+					WRITEFIRSTLINEFGBGIMAGE(dest, g_MaskSpecialFgBg1, fgPel, 8);
 				else
-				{
-					pbDest = WRITEFGBGIMAGE(pbDest, rowDelta, g_MaskSpecialFgBg1, fgPel, 8);
-				}
+					WRITEFGBGIMAGE(dest, g_MaskSpecialFgBg1, fgPel, 8);
 				break;
 
 			/* Handle Special Order 2. */
 			case SPECIAL_FGBG_2:
 				pbSrc = pbSrc + 1;
 				if (fFirstLine)
-				{
-					pbDest = WRITEFIRSTLINEFGBGIMAGE(pbDest, g_MaskSpecialFgBg2, fgPel, 8);
-				}
+					WRITEFIRSTLINEFGBGIMAGE(dest, g_MaskSpecialFgBg2, fgPel, 8);
 				else
-				{
-					pbDest = WRITEFGBGIMAGE(pbDest, rowDelta, g_MaskSpecialFgBg2, fgPel, 8);
-				}
+					WRITEFGBGIMAGE(dest, g_MaskSpecialFgBg2, fgPel, 8);
 				break;
 
 				/* Handle White Order. */
 			case SPECIAL_WHITE:
 				pbSrc = pbSrc + 1;
+				pbDest = dest->pos;
 				DESTWRITEPIXEL(pbDest, WHITE_PIXEL);
 				DESTNEXTPIXEL(pbDest);
+				rle_dest_commit(dest, pbDest);
 				break;
 
 			/* Handle Black Order. */
 			case SPECIAL_BLACK:
 				pbSrc = pbSrc + 1;
+				pbDest = dest->pos;
 				DESTWRITEPIXEL(pbDest, BLACK_PIXEL);
 				DESTNEXTPIXEL(pbDest);
+				rle_dest_commit(dest, pbDest);
 				break;
+
+			/* Unknown order, the rest of the stream cannot be decoded. */
+			default:
+				return;
 		}
 	}
 }
@@ -136,7 +136,7 @@ void rdp_write_general_capability_set(STREAM* s, rdpSettings* settings)
 	if (settings->auto_reconnection)
 		extraFlags |= AUTORECONNECT_SUPPORTED;
 
-	if (settings->fast_path_input)
+	if (settings->fast_path_output)
 		extraFlags |= FASTPATH_OUTPUT_SUPPORTED;
 
 	stream_write_uint16(s, 0); /* osMajorType (2 bytes) */
@@ -144,7 +144,7 @@ void rdp_write_general_capability_set(STREAM* s, rdpSettings* settings)
 	stream_write_uint16(s, CAPS_PROTOCOL_VERSION); /* protocolVersion (2 bytes) */
 	stream_write_uint16(s, 0); /* pad2OctetsA (2 bytes) */
 	stream_write_uint16(s, 0); /* generalCompressionTypes (2 bytes) */
-	stream_write_uint16(s, 0); /* extraFlags (2 bytes) */
+	stream_write_uint16(s, extraFlags); /* extraFlags (2 bytes) */
 	stream_write_uint16(s, 0); /* updateCapabilityFlag (2 bytes) */
 	stream_write_uint16(s, 0); /* remoteUnshareFlag (2 bytes) */
 	stream_write_uint16(s, 0); /* generalCompressionLevel (2 bytes) */
@@ -614,10 +614,10 @@ void rdp_read_input_capability_set(STREAM* s, rdpSettings* settings)
 	stream_read_uint32(s, settings->kbd_fn_keys); /* keyboardFunctionKeys (4 bytes) */
 	stream_seek(s, 64); /* imeFileName (64 bytes) */
 
-	if ((inputFlags & INPUT_FLAG_FASTPATH_INPUT) || (inputFlags & INPUT_FLAG_FASTPATH_INPUT2))
+	if (!(inputFlags & INPUT_FLAG_FASTPATH_INPUT) && !(inputFlags & INPUT_FLAG_FASTPATH_INPUT2))
 	{
-		if (settings->fast_path_input != False)
-			settings->fast_path_input = True;
+		/* server does not support fast-path input */
+		settings->fast_path_input = False;
 	}
 }
 
@@ -762,22 +762,21 @@ void rdp_read_glyph_cache_capability_set(STREAM* s, rdpSettings* settings)
 
 void rdp_write_glyph_cache_capability_set(STREAM* s, rdpSettings* settings)
 {
+	int i;
 	uint8* header;
 
 	header = rdp_capability_set_start(s);
 
 	/* glyphCache (40 bytes) */
-	rdp_write_cache_definition(s, 254, 4);
-	rdp_write_cache_definition(s, 254, 4);
-	rdp_write_cache_definition(s, 254, 8);
-	rdp_write_cache_definition(s, 254, 8);
-	rdp_write_cache_definition(s, 254, 16);
-	rdp_write_cache_definition(s, 254, 32);
-	rdp_write_cache_definition(s, 254, 64);
-	rdp_write_cache_definition(s, 254, 256);
-	rdp_write_cache_definition(s, 64, 2048);
-
-	rdp_write_cache_definition(s, 64, 2048); /* fragCache */
+	for (i = 0; i < 10; i++)
+	{
+		rdp_write_cache_definition(s, settings->glyph_cache[i].numEntries,
+				settings->glyph_cache[i].maxCellSize);
+	}
+
+	/* fragCache (4 bytes) */
+	rdp_write_cache_definition(s, settings->fragment_cache.numEntries,
+			settings->fragment_cache.maxCellSize);
 
 	stream_write_uint16(s, GLYPH_SUPPORT_FULL); /* glyphSupportLevel (2 bytes) */
 	stream_write_uint16(s, 0); /* pad2Octets (2 bytes) */
@@ -843,8 +842,9 @@ void rdp_read_bitmap_cache_host_support_capability_set(STREAM* s, rdpSettings* s
 	stream_seek_uint8(s); /* pad1 (1 byte) */
 	stream_seek_uint16(s); /* pad2 (2 bytes) */
 
-	if (cacheVersion & BITMAP_CACHE_V2)
-		settings->persistent_bitmap_cache = True;
+	/* persistent caching requires revision 2 bitmap caches */
+	if (!(cacheVersion & BITMAP_CACHE_V2))
+		settings->persistent_bitmap_cache = False;
 }
 
 /**
@@ -876,7 +876,10 @@ void rdp_write_bitmap_cache_cell_info(STREAM* s, uint16 numEntries, boolean pers
 	 * is used to indicate a persistent bitmap cache.
 	 */
 
-	info = numEntries & persistent;
+	info = numEntries;
+
+	if (persistent)
+		info |= 0x80000000;
 
 	stream_write_uint32(s, info);
 }
@@ -910,6 +913,7 @@ void rdp_read_bitmap_cache_v2_capability_set(STREAM* s, rdpSettings* settings)
 
 void rdp_write_bitmap_cache_v2_capability_set(STREAM* s, rdpSettings* settings)
 {
+	int i;
 	uint8* header;
 	uint16 cacheFlags;
 
@@ -922,12 +926,22 @@ void rdp_write_bitmap_cache_v2_capability_set(STREAM* s, rdpSettings* settings)
 
 	stream_write_uint16(s, cacheFlags); /* cacheFlags (2 bytes) */
 	stream_write_uint8(s, 0); /* pad2 (1 byte) */
-	stream_write_uint8(s, 5); /* numCellCaches (1 byte) */
-	rdp_write_bitmap_cache_cell_info(s, 600, 0); /* bitmapCache0CellInfo (4 bytes) */
-	rdp_write_bitmap_cache_cell_info(s, 600, 0); /* bitmapCache1CellInfo (4 bytes) */
-	rdp_write_bitmap_cache_cell_info(s, 2048, 0); /* bitmapCache2CellInfo (4 bytes) */
-	rdp_write_bitmap_cache_cell_info(s, 4096, 0); /* bitmapCache3CellInfo (4 bytes) */
-	rdp_write_bitmap_cache_cell_info(s, 2048, 0); /* bitmapCache4CellInfo (4 bytes) */
+	stream_write_uint8(s, settings->bitmap_cache_v2_num_cells); /* numCellCaches (1 byte) */
+
+	/* bitmapCache0CellInfo to bitmapCache4CellInfo (4 bytes each) */
+	for (i = 0; i < 5; i++)
+	{
+		if (i < settings->bitmap_cache_v2_num_cells)
+		{
+			rdp_write_bitmap_cache_cell_info(s, settings->bitmap_cache_v2_cell_info[i].numEntries,
+					settings->persistent_bitmap_cache && settings->bitmap_cache_v2_cell_info[i].persistent);
+		}
+		else
+		{
+			rdp_write_bitmap_cache_cell_info(s, 0, False);
+		}
+	}
+
 	stream_write_zero(s, 12); /* pad3 (12 bytes) */
 
 	rdp_capability_set_finish(s, header, CAPSET_TYPE_BITMAP_CACHE_V2);
@@ -1560,6 +1574,10 @@ void rdp_read_demand_active(STREAM* s, rdpSettings* settings)
 		stream_set_mark(s, em);
 		numberCapabilities--;
 	}
+
+	/* servers without revision 2 bitmap caches do not send the host support capability set */
+	if (settings->received_caps[CAPSET_TYPE_BITMAP_CACHE_HOST_SUPPORT] != True)
+		settings->persistent_bitmap_cache = False;
 }
 
 void rdp_recv_demand_active(rdpRdp* rdp, STREAM* s, rdpSettings* settings)
@@ -1595,7 +1613,12 @@ void rdp_write_confirm_active(STREAM* s, rdpSettings* settings)
 	rdp_write_general_capability_set(s, settings);
 	rdp_write_bitmap_capability_set(s, settings);
 	rdp_write_order_capability_set(s, settings);
-	rdp_write_bitmap_cache_capability_set(s, settings);
+
+	if (settings->persistent_bitmap_cache)
+		rdp_write_bitmap_cache_v2_capability_set(s, settings);
+	else
+		rdp_write_bitmap_cache_capability_set(s, settings);
+
 	rdp_write_pointer_capability_set(s, settings);
 	rdp_write_input_capability_set(s, settings);
 	rdp_write_brush_capability_set(s, settings);
@@ -21,6 +21,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <freerdp/utils/stream.h>
+#include <freerdp/utils/memory.h>
+
+#include "orders.h"
+#include "update.h"
 
 #include "fastpath.h"
 
@@ -63,3 +67,291 @@ uint16 fastpath_read_header(STREAM* s, uint8* encryptionFlags)
 
 	return length;
 }
+
+static void fastpath_recv_orders(rdpFastPath* fastpath, STREAM* s)
+{
+	rdpUpdate* update = fastpath->rdp->update;
+	uint16 numberOrders;
+
+	stream_read_uint16(s, numberOrders); /* numberOrders (2 bytes) */
+
+	while (numberOrders > 0)
+	{
+		update_recv_order(update, s);
+		numberOrders--;
+	}
+}
+
+static void fastpath_recv_update_common(rdpFastPath* fastpath, STREAM* s)
+{
+	uint16 updateType;
+	rdpUpdate* update = fastpath->rdp->update;
+
+	stream_read_uint16(s, updateType); /* updateType (2 bytes) */
+
+	switch (updateType)
+	{
+		case UPDATE_TYPE_BITMAP:
+			update_read_bitmap(update, s, &update->bitmap_update);
+			IFCALL(update->Bitmap, update, &update->bitmap_update);
+			break;
+
+		case UPDATE_TYPE_PALETTE:
+			update_read_palette(update, s, &update->palette_update);
+			IFCALL(update->Palette, update, &update->palette_update);
+			break;
+	}
+}
+
+static void fastpath_recv_update(rdpFastPath* fastpath, uint8 updateCode, STREAM* s)
+{
+	rdpUpdate* update = fastpath->rdp->update;
+
+	switch (updateCode)
+	{
+		case FASTPATH_UPDATETYPE_ORDERS:
+			fastpath_recv_orders(fastpath, s);
+			break;
+
+		case FASTPATH_UPDATETYPE_BITMAP:
+		case FASTPATH_UPDATETYPE_PALETTE:
+			fastpath_recv_update_common(fastpath, s);
+			break;
+
+		case FASTPATH_UPDATETYPE_SYNCHRONIZE:
+			IFCALL(update->Synchronize, update);
+			break;
+
+		case FASTPATH_UPDATETYPE_SURFCMDS:
+		case FASTPATH_UPDATETYPE_PTR_NULL:
+		case FASTPATH_UPDATETYPE_PTR_DEFAULT:
+		case FASTPATH_UPDATETYPE_PTR_POSITION:
+		case FASTPATH_UPDATETYPE_COLOR:
+		case FASTPATH_UPDATETYPE_CACHED:
+		case FASTPATH_UPDATETYPE_POINTER:
+			/* no callbacks for surface commands and pointer updates yet */
+			break;
+
+		default:
+			printf("fastpath_recv_update: unknown updateCode 0x%X\n", updateCode);
+			break;
+	}
+}
+
+/**
+ * Read a Fast-Path update (TS_FP_UPDATE) and dispatch it, reassembling fragmented updates.\n
+ * @msdn{cc240622}
+ * @param fastpath fast path module
+ * @param s stream
+ */
+
+static void fastpath_recv_update_data(rdpFastPath* fastpath, STREAM* s)
+{
+	uint8 updateHeader;
+	uint8 updateCode;
+	uint8 fragmentation;
+	uint8 compression;
+	uint8 compressionFlags;
+	uint16 size;
+	int length;
+	uint8* next;
+	uint8* buffer;
+	STREAM* data;
+	STREAM* updateData;
+	STREAM comp_stream;
+
+	stream_read_uint8(s, updateHeader); /* updateHeader (1 byte) */
+	updateCode = updateHeader & 0x0F;
+	fragmentation = (updateHeader >> 4) & 0x03;
+	compression = (updateHeader >> 6) & 0x03;
+
+	if (compression == FASTPATH_OUTPUT_COMPRESSION_USED)
+		stream_read_uint8(s, compressionFlags); /* compressionFlags (1 byte) */
+	else
+		compressionFlags = 0;
+
+	stream_read_uint16(s, size); /* size (2 bytes) */
+	next = stream_get_tail(s) + size;
+	data = s;
+
+	if (compressionFlags & (PACKET_COMPRESSED | PACKET_AT_FRONT | PACKET_FLUSHED))
+	{
+		if (mppc_decompress(fastpath->rdp->mppc, stream_get_tail(s), size,
+				compressionFlags, &buffer, &length) != True)
+		{
+			stream_set_mark(s, next);
+			return;
+		}
+
+		comp_stream.data = buffer;
+		comp_stream.p = buffer;
+		comp_stream.size = length;
+		data = &comp_stream;
+		size = length;
+	}
+
+	updateData = fastpath->updateData;
+
+	if (fragmentation == FASTPATH_FRAGMENT_SINGLE)
+	{
+		fastpath_recv_update(fastpath, updateCode, data);
+	}
+	else
+	{
+		if (fragmentation == FASTPATH_FRAGMENT_FIRST)
+			stream_set_pos(updateData, 0);
+
+		stream_check_size(updateData, size);
+		stream_copy(updateData, data, size);
+
+		if (fragmentation == FASTPATH_FRAGMENT_LAST)
+		{
+			stream_set_pos(updateData, 0);
+			fastpath_recv_update(fastpath, updateCode, updateData);
+			stream_set_pos(updateData, 0);
+		}
+	}
+
+	stream_set_mark(s, next);
+}
+
+/**
+ * Receive a Fast-Path server output PDU (TS_FP_UPDATE_PDU).\n
+ * @msdn{cc240621}
+ * @param fastpath fast path module
+ * @param s stream
+ */
+
+void fastpath_recv_updates(rdpFastPath* fastpath, STREAM* s)
+{
+	uint16 length;
+	uint8* end;
+	rdpUpdate* update = fastpath->rdp->update;
+
+	length = fastpath_read_header(s, &fastpath->encryptionFlags);
+	end = stream_get_head(s) + length;
+
+	if (fastpath->encryptionFlags & FASTPATH_OUTPUT_ENCRYPTED)
+	{
+		DEBUG_FASTPATH("encrypted fast-path PDUs are not supported");
+		return;
+	}
+
+	IFCALL(update->BeginPaint, update);
+
+	while (stream_get_tail(s) < end)
+		fastpath_recv_update_data(fastpath, s);
+
+	IFCALL(update->EndPaint, update);
+	freerdp_arena_reset(update->arena);
+}
+
+static void fastpath_write_input_event_header(STREAM* s, uint8 eventFlags, uint8 eventCode)
+{
+	/* eventHeader (1 byte) */
+	stream_write_uint8(s, (eventCode << 5) | (eventFlags & 0x1F));
+}
+
+void fastpath_write_input_synchronize_event(STREAM* s, uint32 flags)
+{
+	/* the toggle flags are carried in the event header */
+	fastpath_write_input_event_header(s, (uint8) flags, FASTPATH_INPUT_EVENT_SYNC);
+}
+
+void fastpath_write_input_keyboard_event(STREAM* s, uint16 flags, uint16 code)
+{
+	uint8 eventFlags = 0;
+
+	if (flags & KBD_FLAGS_RELEASE)
+		eventFlags |= FASTPATH_INPUT_KBDFLAGS_RELEASE;
+
+	if (flags & KBD_FLAGS_EXTENDED)
+		eventFlags |= FASTPATH_INPUT_KBDFLAGS_EXTENDED;
+
+	fastpath_write_input_event_header(s, eventFlags, FASTPATH_INPUT_EVENT_SCANCODE);
+	stream_write_uint8(s, (uint8) code); /* keyCode (1 byte) */
+}
+
+void fastpath_write_input_unicode_keyboard_event(STREAM* s, uint16 code)
+{
+	fastpath_write_input_event_header(s, 0, FASTPATH_INPUT_EVENT_UNICODE);
+	stream_write_uint16(s, code); /* unicodeCode (2 bytes) */
+}
+
+void fastpath_write_input_mouse_event(STREAM* s, uint16 flags, uint16 x, uint16 y)
+{
+	fastpath_write_input_event_header(s, 0, FASTPATH_INPUT_EVENT_MOUSE);
+	stream_write_uint16(s, flags); /* pointerFlags (2 bytes) */
+	stream_write_uint16(s, x); /* xPos (2 bytes) */
+	stream_write_uint16(s, y); /* yPos (2 bytes) */
+}
+
+void fastpath_write_input_extended_mouse_event(STREAM* s, uint16 flags, uint16 x, uint16 y)
+{
+	fastpath_write_input_event_header(s, 0, FASTPATH_INPUT_EVENT_MOUSEX);
+	stream_write_uint16(s, flags); /* pointerFlags (2 bytes) */
+	stream_write_uint16(s, x); /* xPos (2 bytes) */
+	stream_write_uint16(s, y); /* yPos (2 bytes) */
+}
+
+/**
+ * Send a Fast-Path client input PDU (TS_FP_INPUT_PDU).\n
+ * @msdn{cc240589}
+ * @param fastpath fast path module
+ * @param events encoded input events
+ * @param numberEvents number of events
+ */
+
+void fastpath_send_input_pdu(rdpFastPath* fastpath, STREAM* events, uint8 numberEvents)
+{
+	STREAM* s;
+	uint16 length;
+	uint8 fpInputHeader;
+	uint16 eventsLength;
+
+	eventsLength = stream_get_length(events);
+	length = eventsLength + 3;
+
+	fpInputHeader = FASTPATH_INPUT_ACTION_FASTPATH;
+
+	if (numberEvents < 16)
+		fpInputHeader |= (numberEvents << 2);
+	else
+		length++;
+
+	s = transport_send_stream_init(fastpath->rdp->transport, length);
+
+	stream_write_uint8(s, fpInputHeader); /* fpInputHeader (1 byte) */
+	stream_write_uint16_be(s, length | 0x8000); /* length1 and length2 (2 bytes) */
+
+	if (numberEvents >= 16)
+		stream_write_uint8(s, numberEvents); /* numEvents (1 byte) */
+
+	stream_write(s, stream_get_head(events), eventsLength);
+
+	transport_write(fastpath->rdp->transport, s);
+}
+
+rdpFastPath* fastpath_new(rdpRdp* rdp)
+{
+	rdpFastPath* fastpath;
+
+	fastpath = xnew(rdpFastPath);
+
+	if (fastpath != NULL)
+	{
+		fastpath->rdp = rdp;
+		fastpath->updateData = stream_new(4096);
+	}
+
+	return fastpath;
+}
+
+void fastpath_free(rdpFastPath* fastpath)
+{
+	if (fastpath != NULL)
+	{
+		stream_free(fastpath->updateData);
+		xfree(fastpath);
+	}
+}
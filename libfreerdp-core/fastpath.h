@@ -20,6 +20,11 @@
 #ifndef __FASTPATH_H
 #define __FASTPATH_H
 
+typedef struct rdp_fastpath rdpFastPath;
+
+#include "rdp.h"
+#include <freerdp/types.h>
+#include <freerdp/utils/debug.h>
 #include <freerdp/utils/stream.h>
 
 enum FASTPATH_OUTPUT_ACTION_TYPE
@@ -34,6 +39,82 @@ enum FASTPATH_OUTPUT_ENCRYPTION_FLAGS
 	FASTPATH_OUTPUT_ENCRYPTED = 0x2
 };
 
+enum FASTPATH_UPDATETYPE
+{
+	FASTPATH_UPDATETYPE_ORDERS = 0x0,
+	FASTPATH_UPDATETYPE_BITMAP = 0x1,
+	FASTPATH_UPDATETYPE_PALETTE = 0x2,
+	FASTPATH_UPDATETYPE_SYNCHRONIZE = 0x3,
+	FASTPATH_UPDATETYPE_SURFCMDS = 0x4,
+	FASTPATH_UPDATETYPE_PTR_NULL = 0x5,
+	FASTPATH_UPDATETYPE_PTR_DEFAULT = 0x6,
+	FASTPATH_UPDATETYPE_PTR_POSITION = 0x8,
+	FASTPATH_UPDATETYPE_COLOR = 0x9,
+	FASTPATH_UPDATETYPE_CACHED = 0xA,
+	FASTPATH_UPDATETYPE_POINTER = 0xB
+};
+
+enum FASTPATH_FRAGMENT
+{
+	FASTPATH_FRAGMENT_SINGLE = 0x0,
+	FASTPATH_FRAGMENT_LAST = 0x1,
+	FASTPATH_FRAGMENT_FIRST = 0x2,
+	FASTPATH_FRAGMENT_NEXT = 0x3
+};
+
+enum FASTPATH_OUTPUT_COMPRESSION
+{
+	FASTPATH_OUTPUT_COMPRESSION_USED = 0x2
+};
+
+enum FASTPATH_INPUT_ACTION_TYPE
+{
+	FASTPATH_INPUT_ACTION_FASTPATH = 0x0,
+	FASTPATH_INPUT_ACTION_X224 = 0x3
+};
+
+enum FASTPATH_INPUT_EVENT_CODE
+{
+	FASTPATH_INPUT_EVENT_SCANCODE = 0x0,
+	FASTPATH_INPUT_EVENT_MOUSE = 0x1,
+	FASTPATH_INPUT_EVENT_MOUSEX = 0x2,
+	FASTPATH_INPUT_EVENT_SYNC = 0x3,
+	FASTPATH_INPUT_EVENT_UNICODE = 0x4
+};
+
+enum FASTPATH_INPUT_KBDFLAGS
+{
+	FASTPATH_INPUT_KBDFLAGS_RELEASE = 0x01,
+	FASTPATH_INPUT_KBDFLAGS_EXTENDED = 0x02
+};
+
+/* numEvents is a single byte when it does not fit in fpInputHeader */
+#define FASTPATH_INPUT_MAX_EVENTS	255
+
+struct rdp_fastpath
+{
+	rdpRdp* rdp;
+	uint8 encryptionFlags;
+	STREAM* updateData;
+};
+
 uint16 fastpath_read_header(STREAM* s, uint8* encryptionFlags);
+void fastpath_recv_updates(rdpFastPath* fastpath, STREAM* s);
+
+void fastpath_write_input_synchronize_event(STREAM* s, uint32 flags);
+void fastpath_write_input_keyboard_event(STREAM* s, uint16 flags, uint16 code);
+void fastpath_write_input_unicode_keyboard_event(STREAM* s, uint16 code);
+void fastpath_write_input_mouse_event(STREAM* s, uint16 flags, uint16 x, uint16 y);
+void fastpath_write_input_extended_mouse_event(STREAM* s, uint16 flags, uint16 x, uint16 y);
+void fastpath_send_input_pdu(rdpFastPath* fastpath, STREAM* events, uint8 numberEvents);
+
+rdpFastPath* fastpath_new(rdpRdp* rdp);
+void fastpath_free(rdpFastPath* fastpath);
+
+#ifdef WITH_DEBUG_FASTPATH
+#define DEBUG_FASTPATH(fmt, ...) DEBUG_CLASS(FASTPATH, fmt, ## __VA_ARGS__)
+#else
+#define DEBUG_FASTPATH(fmt, ...) DEBUG_NULL(fmt, ## __VA_ARGS__)
+#endif
 
 #endif
@@ -20,10 +20,12 @@
 #include "rdp.h"
 #include "input.h"
 #include "update.h"
+#include "planar.h"
 #include "transport.h"
 #include "connection.h"
 
 #include <freerdp/freerdp.h>
+#include <freerdp/utils/cpu.h>
 #include <freerdp/utils/memory.h>
 
 boolean freerdp_connect(freerdp* instance)
@@ -37,6 +39,13 @@ boolean freerdp_connect(freerdp* instance)
 	status = rdp_client_connect((rdpRdp*) instance->rdp);
 	IFCALL(instance->PostConnect, instance);
 
+	/* draw the updates on a render thread, with the callbacks registered by the client */
+	if (status && rdp->settings->update_pipeline)
+		rdp->pipeline = pipeline_new(rdp->update, PIPELINE_RING_SIZE);
+
+	/* the update callbacks are now registered, load the bitmaps listed in the persistent key list */
+	persistent_cache_replay(rdp->persistent, rdp->update);
+
 	return status;
 }
 
@@ -78,7 +87,11 @@ freerdp* freerdp_new()
 
 	if (instance != NULL)
 	{
-		rdpRdp* rdp = rdp_new(instance);
+		rdpRdp* rdp;
+
+		planar_init(freerdp_cpu_features());
+
+		rdp = rdp_new(instance);
 		instance->rdp = (void*) rdp;
 		instance->input = rdp->input;
 		instance->update = rdp->update;
@@ -95,5 +108,11 @@ freerdp* freerdp_new()
 
 void freerdp_free(freerdp* freerdp)
 {
+	rdpRdp* rdp = (rdpRdp*) freerdp->rdp;
+
+	/* stop the render thread before the client tears down what it draws to */
+	pipeline_free(rdp->pipeline);
+	rdp->pipeline = NULL;
+
 	xfree(freerdp);
 }
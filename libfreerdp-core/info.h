@@ -49,10 +49,10 @@
 #define RNS_INFO_AUDIOCAPTURE		0x00200000
 #define RNS_INFO_VIDEO_DISABLE		0x00400000
 #define INFO_CompressionTypeMask	0x00001E00
-#define INFO_PACKET_COMPR_TYPE_8K	0x00000100
+#define INFO_PACKET_COMPR_TYPE_8K	0x00000000
 #define INFO_PACKET_COMPR_TYPE_64K	0x00000200
-#define INFO_PACKET_COMPR_TYPE_RDP6	0x00000300
-#define INFO_PACKET_COMPR_TYPE_RDP61	0x00000400
+#define INFO_PACKET_COMPR_TYPE_RDP6	0x00000400
+#define INFO_PACKET_COMPR_TYPE_RDP61	0x00000600
 
 /* Logon Information Types */
 #define INFO_TYPE_LOGON			0x00000000
@@ -21,7 +21,7 @@
 
 void rdp_write_client_input_pdu_header(STREAM* s, uint16 number)
 {
-	stream_write_uint16(s, 1); /* numberEvents (2 bytes) */
+	stream_write_uint16(s, number); /* numberEvents (2 bytes) */
 	stream_write_uint16(s, 0); /* pad2Octets (2 bytes) */
 }
 
@@ -31,18 +31,81 @@ void rdp_write_input_event_header(STREAM* s, uint32 time, uint16 type)
 	stream_write_uint16(s, type); /* messageType (2 bytes) */
 }
 
-STREAM* rdp_client_input_pdu_init(rdpRdp* rdp, uint16 type)
+void rdp_send_client_input_pdu(rdpRdp* rdp, STREAM* events, uint16 number)
 {
 	STREAM* s;
+	int length;
+
+	length = stream_get_length(events);
+
 	s = rdp_data_pdu_init(rdp);
-	rdp_write_client_input_pdu_header(s, 1);
-	rdp_write_input_event_header(s, 0, type);
+	stream_check_size(s, RDP_CLIENT_INPUT_PDU_HEADER_LENGTH + length);
+	rdp_write_client_input_pdu_header(s, number);
+	stream_write(s, stream_get_head(events), length);
+
+	rdp_send_data_pdu(rdp, s, DATA_PDU_TYPE_INPUT, rdp->mcs->user_id);
+}
+
+static boolean input_fastpath(rdpInput* input)
+{
+	rdpRdp* rdp = (rdpRdp*) input->rdp;
+	return rdp->settings->fast_path_input;
+}
+
+/**
+ * Send all queued input events, in a fast-path input PDU when it was negotiated.
+ * @param input input module
+ */
+
+void input_flush_batch(rdpInput* input)
+{
+	rdpRdp* rdp = (rdpRdp*) input->rdp;
+
+	if (input->numberEvents > 0)
+	{
+		if (input_fastpath(input))
+			fastpath_send_input_pdu(rdp->fastpath, input->events, input->numberEvents);
+		else
+			rdp_send_client_input_pdu(rdp, input->events, input->numberEvents);
+	}
+
+	input->numberEvents = 0;
+	input->batching = False;
+	stream_set_pos(input->events, 0);
+}
+
+/**
+ * Start queueing input events until input_flush_batch() is called.
+ * @param input input module
+ */
+
+void input_begin_batch(rdpInput* input)
+{
+	input->batching = True;
+}
+
+static STREAM* input_event_init(rdpInput* input, uint16 type)
+{
+	STREAM* s = input->events;
+
+	stream_check_size(s, 16);
+
+	if (!input_fastpath(input))
+		rdp_write_input_event_header(s, 0, type);
+
 	return s;
 }
 
-void rdp_send_client_input_pdu(rdpRdp* rdp, STREAM* s)
+static void input_event_finish(rdpInput* input)
 {
-	rdp_send_data_pdu(rdp, s, DATA_PDU_TYPE_INPUT, rdp->mcs->user_id);
+	input->numberEvents++;
+
+	if (!input->batching || input->numberEvents >= FASTPATH_INPUT_MAX_EVENTS)
+	{
+		boolean batching = input->batching;
+		input_flush_batch(input);
+		input->batching = batching;
+	}
 }
 
 void input_write_synchronize_event(STREAM* s, uint32 flags)
@@ -54,9 +117,14 @@ void input_write_synchronize_event(STREAM* s, uint32 flags)
 void input_send_synchronize_event(rdpInput* input, uint32 flags)
 {
 	STREAM* s;
-	s = rdp_client_input_pdu_init(input->rdp, INPUT_EVENT_SYNC);
-	input_write_synchronize_event(s, flags);
-	rdp_send_client_input_pdu(input->rdp, s);
+	s = input_event_init(input, INPUT_EVENT_SYNC);
+
+	if (input_fastpath(input))
+		fastpath_write_input_synchronize_event(s, flags);
+	else
+		input_write_synchronize_event(s, flags);
+
+	input_event_finish(input);
 }
 
 void input_write_keyboard_event(STREAM* s, uint16 flags, uint16 code)
@@ -69,9 +137,14 @@ void input_write_keyboard_event(STREAM* s, uint16 flags, uint16 code)
 void input_send_keyboard_event(rdpInput* input, uint16 flags, uint16 code)
 {
 	STREAM* s;
-	s = rdp_client_input_pdu_init(input->rdp, INPUT_EVENT_SCANCODE);
-	input_write_keyboard_event(s, flags, code);
-	rdp_send_client_input_pdu(input->rdp, s);
+	s = input_event_init(input, INPUT_EVENT_SCANCODE);
+
+	if (input_fastpath(input))
+		fastpath_write_input_keyboard_event(s, flags, code);
+	else
+		input_write_keyboard_event(s, flags, code);
+
+	input_event_finish(input);
 }
 
 void input_write_unicode_keyboard_event(STREAM* s, uint16 code)
@@ -84,9 +157,14 @@ void input_write_unicode_keyboard_event(STREAM* s, uint16 code)
 void input_send_unicode_keyboard_event(rdpInput* input, uint16 code)
 {
 	STREAM* s;
-	s = rdp_client_input_pdu_init(input->rdp, INPUT_EVENT_UNICODE);
-	input_write_unicode_keyboard_event(s, code);
-	rdp_send_client_input_pdu(input->rdp, s);
+	s = input_event_init(input, INPUT_EVENT_UNICODE);
+
+	if (input_fastpath(input))
+		fastpath_write_input_unicode_keyboard_event(s, code);
+	else
+		input_write_unicode_keyboard_event(s, code);
+
+	input_event_finish(input);
 }
 
 void input_write_mouse_event(STREAM* s, uint16 flags, uint16 x, uint16 y)
@@ -99,9 +177,14 @@ void input_write_mouse_event(STREAM* s, uint16 flags, uint16 x, uint16 y)
 void input_send_mouse_event(rdpInput* input, uint16 flags, uint16 x, uint16 y)
 {
 	STREAM* s;
-	s = rdp_client_input_pdu_init(input->rdp, INPUT_EVENT_MOUSE);
-	input_write_mouse_event(s, flags, x, y);
-	rdp_send_client_input_pdu(input->rdp, s);
+	s = input_event_init(input, INPUT_EVENT_MOUSE);
+
+	if (input_fastpath(input))
+		fastpath_write_input_mouse_event(s, flags, x, y);
+	else
+		input_write_mouse_event(s, flags, x, y);
+
+	input_event_finish(input);
 }
 
 void input_write_extended_mouse_event(STREAM* s, uint16 flags, uint16 x, uint16 y)
@@ -114,9 +197,14 @@ void input_write_extended_mouse_event(STREAM* s, uint16 flags, uint16 x, uint16
 void input_send_extended_mouse_event(rdpInput* input, uint16 flags, uint16 x, uint16 y)
 {
 	STREAM* s;
-	s = rdp_client_input_pdu_init(input->rdp, INPUT_EVENT_MOUSEX);
-	input_write_extended_mouse_event(s, flags, x, y);
-	rdp_send_client_input_pdu(input->rdp, s);
+	s = input_event_init(input, INPUT_EVENT_MOUSEX);
+
+	if (input_fastpath(input))
+		fastpath_write_input_extended_mouse_event(s, flags, x, y);
+	else
+		input_write_extended_mouse_event(s, flags, x, y);
+
+	input_event_finish(input);
 }
 
 rdpInput* input_new(rdpRdp* rdp)
@@ -128,11 +216,14 @@ rdpInput* input_new(rdpRdp* rdp)
 	if (input != NULL)
 	{
 		input->rdp = rdp;
+		input->events = stream_new(512);
 		input->SynchronizeEvent = input_send_synchronize_event;
 		input->KeyboardEvent = input_send_keyboard_event;
 		input->UnicodeKeyboardEvent = input_send_unicode_keyboard_event;
 		input->MouseEvent = input_send_mouse_event;
 		input->ExtendedMouseEvent = input_send_extended_mouse_event;
+		input->BeginBatch = input_begin_batch;
+		input->FlushBatch = input_flush_batch;
 	}
 
 	return input;
@@ -142,7 +233,7 @@ void input_free(rdpInput* input)
 {
 	if (input != NULL)
 	{
+		stream_free(input->events);
 		xfree(input);
 	}
 }
-
@@ -34,6 +34,8 @@ void input_send_keyboard_event(rdpInput* input, uint16 flags, uint16 code);
 void input_send_unicode_keyboard_event(rdpInput* input, uint16 code);
 void input_send_mouse_event(rdpInput* input, uint16 flags, uint16 x, uint16 y);
 void input_send_extended_mouse_event(rdpInput* input, uint16 flags, uint16 x, uint16 y);
+void input_begin_batch(rdpInput* input);
+void input_flush_batch(rdpInput* input);
 
 rdpInput* input_new(rdpRdp* rdp);
 void input_free(rdpInput* input);
@@ -0,0 +1,324 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * MPPC Bulk Data Decompression
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freerdp/utils/memory.h>
+
+#include "rdp.h"
+#include "mppc.h"
+
+/**
+ * MPPC (RDP 4.0, 8K history) and its RDP 5.0 variant (64K history) are
+ * described in [MS-RDPBCGR] 3.1.8.4 and RFC 2118. The data is a bit stream,
+ * most significant bit first, of literals and (copy-offset, length-of-match)
+ * tuples referring back into the history buffer:
+ *
+ * Literals:
+ *   0xxxxxxx              0x00 - 0x7F
+ *   10xxxxxxx             0x80 - 0xFF
+ *
+ * Copy offsets, RDP 4.0:
+ *   1111 + 6 bits         0 - 63
+ *   1110 + 8 bits         64 - 319
+ *   110 + 13 bits         320 - 8191
+ *
+ * Copy offsets, RDP 5.0:
+ *   11111 + 6 bits        0 - 63
+ *   11110 + 8 bits        64 - 319
+ *   1110 + 11 bits        320 - 2367
+ *   110 + 16 bits         2368 - 65535
+ *
+ * Length of match: 0 encodes 3, otherwise n one bits followed by a
+ * zero bit and n + 1 value bits encode (1 << (n + 1)) + value.
+ *
+ * Decompressed bytes are appended to the history buffer and handed to the
+ * caller from there, so no per-packet buffer is needed.
+ */
+
+struct _MPPC_BITS
+{
+	uint8* p;
+	uint8* end;
+	uint32 acc; /* pending bits, left aligned */
+	int count; /* number of pending bits in acc */
+};
+typedef struct _MPPC_BITS MPPC_BITS;
+
+static int mppc_bits_left(MPPC_BITS* bits)
+{
+	return bits->count + (int) (bits->end - bits->p) * 8;
+}
+
+static void mppc_bits_fill(MPPC_BITS* bits)
+{
+	while (bits->count <= 24 && bits->p < bits->end)
+	{
+		bits->acc |= ((uint32) *bits->p++) << (24 - bits->count);
+		bits->count += 8;
+	}
+}
+
+static uint32 mppc_bits_peek(MPPC_BITS* bits, int n)
+{
+	return bits->acc >> (32 - n);
+}
+
+static void mppc_bits_skip(MPPC_BITS* bits, int n)
+{
+	bits->acc <<= n;
+	bits->count -= n;
+}
+
+static uint32 mppc_bits_read(MPPC_BITS* bits, int n)
+{
+	uint32 value;
+
+	mppc_bits_fill(bits);
+	value = mppc_bits_peek(bits, n);
+	mppc_bits_skip(bits, n);
+
+	return value;
+}
+
+static boolean mppc_decompress_bits(rdpMppc* mppc, MPPC_BITS* bits, uint32 history_size, boolean rdp5)
+{
+	int k;
+	uint32 code;
+	uint32 offset;
+	uint32 length;
+	uint8* src;
+	uint8* dst;
+	uint8* history_end;
+
+	dst = mppc->history_ptr;
+	history_end = mppc->history_buf + history_size;
+
+	/* the shortest token is an 8-bit literal, anything less is padding */
+	while (mppc_bits_left(bits) >= 8)
+	{
+		mppc_bits_fill(bits);
+		code = mppc_bits_peek(bits, 4);
+
+		if ((code & 0x8) == 0)
+		{
+			/* literal 0x00 - 0x7F */
+			code = mppc_bits_read(bits, 8);
+
+			if (dst >= history_end)
+				return False;
+
+			*dst++ = (uint8) code;
+			continue;
+		}
+		else if ((code & 0xC) == 0x8)
+		{
+			/* literal 0x80 - 0xFF */
+			if (mppc_bits_left(bits) < 9)
+				break;
+
+			mppc_bits_skip(bits, 2);
+			code = mppc_bits_read(bits, 7);
+
+			if (dst >= history_end)
+				return False;
+
+			*dst++ = (uint8) (code | 0x80);
+			continue;
+		}
+
+		/* copy offset */
+		if (rdp5)
+		{
+			if (mppc_bits_peek(bits, 5) == 0x1F)
+			{
+				mppc_bits_skip(bits, 5);
+				offset = mppc_bits_read(bits, 6);
+			}
+			else if (mppc_bits_peek(bits, 5) == 0x1E)
+			{
+				mppc_bits_skip(bits, 5);
+				offset = mppc_bits_read(bits, 8) + 64;
+			}
+			else if (code == 0xE)
+			{
+				mppc_bits_skip(bits, 4);
+				offset = mppc_bits_read(bits, 11) + 320;
+			}
+			else
+			{
+				mppc_bits_skip(bits, 3);
+				offset = mppc_bits_read(bits, 16) + 2368;
+			}
+		}
+		else
+		{
+			if (code == 0xF)
+			{
+				mppc_bits_skip(bits, 4);
+				offset = mppc_bits_read(bits, 6);
+			}
+			else if (code == 0xE)
+			{
+				mppc_bits_skip(bits, 4);
+				offset = mppc_bits_read(bits, 8) + 64;
+			}
+			else
+			{
+				mppc_bits_skip(bits, 3);
+				offset = mppc_bits_read(bits, 13) + 320;
+			}
+		}
+
+		/* length of match */
+		k = 0;
+		mppc_bits_fill(bits);
+
+		while (mppc_bits_read(bits, 1))
+		{
+			k++;
+
+			if (k > (rdp5 ? 14 : 11))
+				return False;
+		}
+
+		if (k == 0)
+			length = 3;
+		else
+			length = (1 << (k + 1)) + mppc_bits_read(bits, k + 1);
+
+		if (mppc_bits_left(bits) < 0)
+			return False;
+
+		if (dst + length > history_end || offset >= history_size)
+			return False;
+
+		/* the copy may wrap around the end of the history buffer */
+		if (offset > (uint32) (dst - mppc->history_buf))
+			src = history_end - (offset - (dst - mppc->history_buf));
+		else
+			src = dst - offset;
+
+		/* byte by byte, source and destination may overlap */
+		while (length > 0)
+		{
+			if (src >= history_end)
+				src = mppc->history_buf;
+
+			*dst++ = *src++;
+			length--;
+		}
+	}
+
+	mppc->history_ptr = dst;
+
+	return True;
+}
+
+/**
+ * Decompress MPPC compressed data into the history buffer.\n
+ * @param mppc MPPC decompressor
+ * @param cbuf compressed data
+ * @param len compressed data length
+ * @param ctype compression flags and type (PACKET_COMPRESSED, PACKET_AT_FRONT, PACKET_FLUSHED)
+ * @param rbuf pointer to the decompressed data, or to cbuf if it was not compressed
+ * @param rlen decompressed data length
+ * @return True if successful, False otherwise
+ */
+
+boolean mppc_decompress(rdpMppc* mppc, uint8* cbuf, int len, uint8 ctype, uint8** rbuf, int* rlen)
+{
+	uint8* start;
+	uint32 history_size;
+	MPPC_BITS bits;
+
+	switch (ctype & CompressionTypeMask)
+	{
+		case PACKET_COMPR_TYPE_8K:
+			history_size = MPPC_HISTORY_SIZE_8K;
+			break;
+
+		case PACKET_COMPR_TYPE_64K:
+			history_size = MPPC_HISTORY_SIZE_64K;
+			break;
+
+		default:
+			printf("mppc_decompress: unsupported compression type 0x%X\n", ctype & CompressionTypeMask);
+			return False;
+	}
+
+	if (ctype & PACKET_AT_FRONT)
+		mppc->history_ptr = mppc->history_buf;
+
+	if (ctype & PACKET_FLUSHED)
+	{
+		memset(mppc->history_buf, 0, MPPC_HISTORY_SIZE_64K);
+		mppc->history_ptr = mppc->history_buf;
+	}
+
+	if (!(ctype & PACKET_COMPRESSED))
+	{
+		*rbuf = cbuf;
+		*rlen = len;
+		return True;
+	}
+
+	bits.p = cbuf;
+	bits.end = cbuf + len;
+	bits.acc = 0;
+	bits.count = 0;
+
+	start = mppc->history_ptr;
+
+	if (mppc_decompress_bits(mppc, &bits, history_size, (history_size == MPPC_HISTORY_SIZE_64K)) != True)
+	{
+		printf("mppc_decompress: invalid compressed data\n");
+		return False;
+	}
+
+	*rbuf = start;
+	*rlen = mppc->history_ptr - start;
+
+	return True;
+}
+
+rdpMppc* mppc_new()
+{
+	rdpMppc* mppc;
+
+	mppc = xnew(rdpMppc);
+
+	if (mppc != NULL)
+	{
+		mppc->history_buf = (uint8*) xzalloc(MPPC_HISTORY_SIZE_64K);
+		mppc->history_ptr = mppc->history_buf;
+	}
+
+	return mppc;
+}
+
+void mppc_free(rdpMppc* mppc)
+{
+	if (mppc != NULL)
+	{
+		xfree(mppc->history_buf);
+		xfree(mppc);
+	}
+}
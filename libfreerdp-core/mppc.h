@@ -0,0 +1,40 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * MPPC Bulk Data Decompression
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPPC_H
+#define __MPPC_H
+
+#include <freerdp/types.h>
+
+#define MPPC_HISTORY_SIZE_8K		8192
+#define MPPC_HISTORY_SIZE_64K		65536
+
+struct rdp_mppc
+{
+	uint8* history_buf;
+	uint8* history_ptr;
+};
+typedef struct rdp_mppc rdpMppc;
+
+boolean mppc_decompress(rdpMppc* mppc, uint8* cbuf, int len, uint8 ctype, uint8** rbuf, int* rlen);
+
+rdpMppc* mppc_new();
+void mppc_free(rdpMppc* mppc);
+
+#endif /* __MPPC_H */
@@ -295,7 +295,8 @@ void update_read_delta_rects(STREAM* s, DELTA_RECT* rectangles, int number)
 	stream_get_mark(s, zeroBits);
 	stream_seek(s, zeroBitsSize);
 
-	memset(rectangles, 0, sizeof(DELTA_RECT) * number);
+	/* the rectangles start at index 1, index 0 being the origin of the first delta */
+	memset(rectangles, 0, sizeof(DELTA_RECT) * (number + 1));
 
 	for (i = 1; i < number + 1; i++)
 	{
@@ -524,7 +525,7 @@ void update_read_multi_dstblt_order(STREAM* s, ORDER_INFO* orderInfo, MULTI_DSTB
 	if (orderInfo->fieldFlags & ORDER_FIELD_07)
 	{
 		stream_read_uint16(s, multi_dstblt->cbData);
-		stream_seek(s, multi_dstblt->cbData);
+		update_read_delta_rects(s, multi_dstblt->rectangles, multi_dstblt->nDeltaEntries);
 	}
 }
 
@@ -572,7 +573,7 @@ void update_read_multi_patblt_order(STREAM* s, ORDER_INFO* orderInfo, MULTI_PATB
 	if (orderInfo->fieldFlags & ORDER_FIELD_14)
 	{
 		stream_read_uint16(s, multi_patblt->cbData);
-		stream_seek(s, multi_patblt->cbData);
+		update_read_delta_rects(s, multi_patblt->rectangles, multi_patblt->nDeltaEntries);
 	}
 }
 
@@ -605,7 +606,7 @@ void update_read_multi_scrblt_order(STREAM* s, ORDER_INFO* orderInfo, MULTI_SCRB
 	if (orderInfo->fieldFlags & ORDER_FIELD_09)
 	{
 		stream_read_uint16(s, multi_scrblt->cbData);
-		stream_seek(s, multi_scrblt->cbData);
+		update_read_delta_rects(s, multi_scrblt->rectangles, multi_scrblt->nDeltaEntries);
 	}
 }
 
@@ -916,7 +917,7 @@ void update_read_glyph_index_order(STREAM* s, ORDER_INFO* orderInfo, GLYPH_INDEX
 	if (orderInfo->fieldFlags & ORDER_FIELD_22)
 	{
 		stream_read_uint8(s, glyph_index->cbData);
-		stream_seek(s, glyph_index->cbData);
+		stream_read(s, glyph_index->data, glyph_index->cbData);
 	}
 }
 
@@ -970,7 +971,7 @@ void update_read_fast_index_order(STREAM* s, ORDER_INFO* orderInfo, FAST_INDEX_O
 	if (orderInfo->fieldFlags & ORDER_FIELD_15)
 	{
 		stream_read_uint8(s, fast_index->cbData);
-		stream_seek(s, fast_index->cbData);
+		stream_read(s, fast_index->data, fast_index->cbData);
 	}
 }
 
@@ -1023,8 +1024,43 @@ void update_read_fast_glyph_order(STREAM* s, ORDER_INFO* orderInfo, FAST_GLYPH_O
 
 	if (orderInfo->fieldFlags & ORDER_FIELD_15)
 	{
+		uint8* mark;
+		GLYPH_DATA_V2* glyph;
+
 		stream_read_uint8(s, fast_glyph->cbData);
-		stream_seek(s, fast_glyph->cbData);
+
+		stream_get_mark(s, mark);
+		stream_read(s, fast_glyph->data, fast_glyph->cbData);
+
+		glyph = &fast_glyph->glyph_data;
+		glyph->cacheIndex = fast_glyph->data[0];
+		glyph->aj = NULL;
+
+		if (fast_glyph->cbData > 1)
+		{
+			/* the glyph definition follows the cache index */
+			stream_set_mark(s, mark + 1);
+			update_read_2byte_signed(s, &glyph->x);
+			update_read_2byte_signed(s, &glyph->y);
+			update_read_2byte_unsigned(s, &glyph->cx);
+			update_read_2byte_unsigned(s, &glyph->cy);
+
+			glyph->cb = GLYPH_DATA_SIZE(glyph->cx, glyph->cy);
+			glyph->aj = &fast_glyph->data[stream_get_tail(s) - mark];
+
+			if (stream_get_tail(s) + glyph->cb > mark + fast_glyph->cbData)
+			{
+				glyph->cb = 0;
+				glyph->aj = NULL;
+			}
+
+			stream_set_mark(s, mark + fast_glyph->cbData);
+		}
+	}
+	else
+	{
+		/* the glyph carried by a previous order is already cached */
+		fast_glyph->glyph_data.aj = NULL;
 	}
 }
 
@@ -1178,23 +1214,20 @@ void update_read_cache_bitmap_order(STREAM* s, CACHE_BITMAP_ORDER* cache_bitmap_
 	stream_read_uint16(s, cache_bitmap_order->bitmapLength); /* bitmapLength (2 bytes) */
 	stream_read_uint16(s, cache_bitmap_order->cacheIndex); /* cacheIndex (2 bytes) */
 
-	if (compressed)
-	{
-		if (flags & NO_BITMAP_COMPRESSION_HDR)
-		{
-			stream_seek(s, cache_bitmap_order->bitmapLength); /* bitmapDataStream */
-		}
-		else
-		{
-			uint8* bitmapComprHdr = (uint8*) &(cache_bitmap_order->bitmapComprHdr);
-			stream_read(s, bitmapComprHdr, 8); /* bitmapComprHdr (8 bytes) */
-			stream_seek(s, cache_bitmap_order->bitmapLength); /* bitmapDataStream */
-		}
-	}
-	else
+	cache_bitmap_order->compressed = compressed;
+	memset(cache_bitmap_order->bitmapComprHdr, 0, 8);
+
+	if (compressed && !(flags & NO_BITMAP_COMPRESSION_HDR))
 	{
-		stream_seek(s, cache_bitmap_order->bitmapLength); /* bitmapDataStream */
+		/* bitmapLength includes the compression header */
+		uint8* bitmapComprHdr = (uint8*) &(cache_bitmap_order->bitmapComprHdr);
+		stream_read(s, bitmapComprHdr, 8); /* bitmapComprHdr (8 bytes) */
+		cache_bitmap_order->bitmapLength -= 8;
 	}
+
+	/* the data is only valid for the duration of the CacheBitmap callback */
+	cache_bitmap_order->bitmapDataStream = stream_get_tail(s);
+	stream_seek(s, cache_bitmap_order->bitmapLength); /* bitmapDataStream */
 }
 
 void update_read_cache_bitmap_v2_order(STREAM* s, CACHE_BITMAP_V2_ORDER* cache_bitmap_v2_order, boolean compressed, uint16 flags)
@@ -1227,26 +1260,23 @@ void update_read_cache_bitmap_v2_order(STREAM* s, CACHE_BITMAP_V2_ORDER* cache_b
 	update_read_4byte_unsigned(s, &cache_bitmap_v2_order->bitmapLength); /* bitmapLength */
 	update_read_2byte_unsigned(s, &cache_bitmap_v2_order->cacheIndex); /* cacheIndex */
 
-	if (compressed)
-	{
-		if (cache_bitmap_v2_order->flags & CBR2_NO_BITMAP_COMPRESSION_HDR)
-		{
-			stream_seek(s, cache_bitmap_v2_order->bitmapLength); /* bitmapDataStream */
-		}
-		else
-		{
-			uint8* bitmapComprHdr = (uint8*) &(cache_bitmap_v2_order->bitmapComprHdr);
-			stream_read(s, bitmapComprHdr, 8); /* bitmapComprHdr (8 bytes) */
-			stream_seek(s, cache_bitmap_v2_order->bitmapLength); /* bitmapDataStream */
-		}
-	}
-	else
+	cache_bitmap_v2_order->compressed = compressed;
+	memset(cache_bitmap_v2_order->bitmapComprHdr, 0, 8);
+
+	if (compressed && !(cache_bitmap_v2_order->flags & CBR2_NO_BITMAP_COMPRESSION_HDR))
 	{
-		stream_seek(s, cache_bitmap_v2_order->bitmapLength); /* bitmapDataStream */
+		/* bitmapLength includes the compression header */
+		uint8* bitmapComprHdr = (uint8*) &(cache_bitmap_v2_order->bitmapComprHdr);
+		stream_read(s, bitmapComprHdr, 8); /* bitmapComprHdr (8 bytes) */
+		cache_bitmap_v2_order->bitmapLength -= 8;
 	}
+
+	/* the data is only valid for the duration of the CacheBitmapV2 callback */
+	cache_bitmap_v2_order->bitmapDataStream = stream_get_tail(s);
+	stream_seek(s, cache_bitmap_v2_order->bitmapLength); /* bitmapDataStream */
 }
 
-void update_read_cache_bitmap_v3_order(STREAM* s, CACHE_BITMAP_V3_ORDER* cache_bitmap_v3_order, boolean compressed, uint16 flags)
+void update_read_cache_bitmap_v3_order(STREAM* s, ARENA* arena, CACHE_BITMAP_V3_ORDER* cache_bitmap_v3_order, boolean compressed, uint16 flags)
 {
 	uint32 bitmapLength;
 	uint8 bitsPerPixelId;
@@ -1272,15 +1302,11 @@ void update_read_cache_bitmap_v3_order(STREAM* s, CACHE_BITMAP_V3_ORDER* cache_b
 	stream_read_uint16(s, bitmapData->height); /* height (2 bytes) */
 	stream_read_uint32(s, bitmapData->length); /* length (4 bytes) */
 
-	if (bitmapData->data == NULL)
-		bitmapData->data = (uint8*) xmalloc(bitmapData->length);
-	else
-		bitmapData->data = (uint8*) xrealloc(bitmapData->data, bitmapData->length);
-
+	bitmapData->data = (uint8*) freerdp_arena_alloc(arena, bitmapData->length);
 	stream_read(s, bitmapData->data, bitmapData->length);
 }
 
-void update_read_cache_color_table_order(STREAM* s, CACHE_COLOR_TABLE_ORDER* cache_color_table_order, uint16 flags)
+void update_read_cache_color_table_order(STREAM* s, ARENA* arena, CACHE_COLOR_TABLE_ORDER* cache_color_table_order, uint16 flags)
 {
 	int i;
 	uint32* colorTable;
@@ -1288,12 +1314,7 @@ void update_read_cache_color_table_order(STREAM* s, CACHE_COLOR_TABLE_ORDER* cac
 	stream_read_uint8(s, cache_color_table_order->cacheIndex); /* cacheIndex (1 byte) */
 	stream_read_uint8(s, cache_color_table_order->numberColors); /* numberColors (2 bytes) */
 
-	colorTable = cache_color_table_order->colorTable;
-
-	if (colorTable == NULL)
-		colorTable = (uint32*) xmalloc(cache_color_table_order->numberColors * 4);
-	else
-		colorTable = (uint32*) xrealloc(colorTable, cache_color_table_order->numberColors * 4);
+	colorTable = (uint32*) freerdp_arena_alloc(arena, cache_color_table_order->numberColors * 4);
 
 	for (i = 0; i < cache_color_table_order->numberColors; i++)
 	{
@@ -1303,21 +1324,15 @@ void update_read_cache_color_table_order(STREAM* s, CACHE_COLOR_TABLE_ORDER* cac
 	cache_color_table_order->colorTable = colorTable;
 }
 
-void update_read_cache_glyph_order(STREAM* s, CACHE_GLYPH_ORDER* cache_glyph_order, uint16 flags)
+void update_read_cache_glyph_order(STREAM* s, ARENA* arena, CACHE_GLYPH_ORDER* cache_glyph_order, uint16 flags)
 {
 	int i;
-	int size;
 	GLYPH_DATA* glyph;
 
 	stream_read_uint8(s, cache_glyph_order->cacheId); /* cacheId (1 byte) */
 	stream_read_uint8(s, cache_glyph_order->cGlyphs); /* cGlyphs (1 byte) */
 
-	size = cache_glyph_order->cGlyphs * sizeof(GLYPH_DATA);
-
-	if (cache_glyph_order->glyphData == NULL)
-		cache_glyph_order->glyphData = (GLYPH_DATA*) xmalloc(size);
-	else
-		cache_glyph_order->glyphData = (GLYPH_DATA*) xrealloc(cache_glyph_order->glyphData, size);
+	cache_glyph_order->glyphData = (GLYPH_DATA*) freerdp_arena_alloc(arena, cache_glyph_order->cGlyphs * sizeof(GLYPH_DATA));
 
 	for (i = 0; i < cache_glyph_order->cGlyphs; i++)
 	{
@@ -1329,58 +1344,48 @@ void update_read_cache_glyph_order(STREAM* s, CACHE_GLYPH_ORDER* cache_glyph_ord
 		stream_read_uint16(s, glyph->cx);
 		stream_read_uint16(s, glyph->cy);
 
-		glyph->cb = ((glyph->cx + 7) / 8) * glyph->cy;
-		glyph->cb += glyph->cb % 4;
-
-		if (glyph->aj == NULL)
-			glyph->aj = (uint8*) xmalloc(glyph->cb);
-		else
-			glyph->aj = (uint8*) xrealloc(glyph->aj, glyph->cb);
+		glyph->cb = GLYPH_DATA_SIZE(glyph->cx, glyph->cy);
 
+		glyph->aj = (uint8*) freerdp_arena_alloc(arena, glyph->cb);
 		stream_read(s, glyph->aj, glyph->cb);
 	}
+
+	if (flags & CG_GLYPH_UNICODE_PRESENT)
+		stream_seek(s, cache_glyph_order->cGlyphs * 2); /* unicodeCharacters */
 }
 
-void update_read_cache_glyph_v2_order(STREAM* s, CACHE_GLYPH_V2_ORDER* cache_glyph_v2_order, uint16 flags)
+void update_read_cache_glyph_v2_order(STREAM* s, ARENA* arena, CACHE_GLYPH_V2_ORDER* cache_glyph_v2_order, uint16 flags)
 {
 	int i;
-	int size;
 	GLYPH_DATA_V2* glyph;
 
 	cache_glyph_v2_order->cacheId = (flags & 0x000F);
 	cache_glyph_v2_order->flags = (flags & 0x00F0) >> 4;
 	cache_glyph_v2_order->cGlyphs = (flags & 0xFF00) >> 8;
 
-	size = cache_glyph_v2_order->cGlyphs * sizeof(GLYPH_DATA_V2);
-
-	if (cache_glyph_v2_order->glyphData == NULL)
-		cache_glyph_v2_order->glyphData = (GLYPH_DATA_V2*) xmalloc(size);
-	else
-		cache_glyph_v2_order->glyphData = (GLYPH_DATA_V2*) xrealloc(cache_glyph_v2_order->glyphData, size);
+	cache_glyph_v2_order->glyphData = (GLYPH_DATA_V2*) freerdp_arena_alloc(arena, cache_glyph_v2_order->cGlyphs * sizeof(GLYPH_DATA_V2));
 
 	for (i = 0; i < cache_glyph_v2_order->cGlyphs; i++)
 	{
 		glyph = &cache_glyph_v2_order->glyphData[i];
 
-		stream_read_uint16(s, glyph->cacheIndex);
+		stream_read_uint8(s, glyph->cacheIndex);
 		update_read_2byte_signed(s, &glyph->x);
 		update_read_2byte_signed(s, &glyph->y);
 		update_read_2byte_unsigned(s, &glyph->cx);
 		update_read_2byte_unsigned(s, &glyph->cy);
 
-		glyph->cb = ((glyph->cx + 7) / 8) * glyph->cy;
-		glyph->cb += glyph->cb % 4;
-
-		if (glyph->aj == NULL)
-			glyph->aj = (uint8*) xmalloc(glyph->cb);
-		else
-			glyph->aj = (uint8*) xrealloc(glyph->aj, glyph->cb);
+		glyph->cb = GLYPH_DATA_SIZE(glyph->cx, glyph->cy);
 
+		glyph->aj = (uint8*) freerdp_arena_alloc(arena, glyph->cb);
 		stream_read(s, glyph->aj, glyph->cb);
 	}
+
+	if (cache_glyph_v2_order->flags & (CG_GLYPH_UNICODE_PRESENT >> 4))
+		stream_seek(s, cache_glyph_v2_order->cGlyphs * 2); /* unicodeCharacters */
 }
 
-void update_read_cache_brush_order(STREAM* s, CACHE_BRUSH_ORDER* cache_brush_order, uint16 flags)
+void update_read_cache_brush_order(STREAM* s, ARENA* arena, CACHE_BRUSH_ORDER* cache_brush_order, uint16 flags)
 {
 	uint8 iBitmapFormat;
 
@@ -1394,11 +1399,7 @@ void update_read_cache_brush_order(STREAM* s, CACHE_BRUSH_ORDER* cache_brush_ord
 	stream_read_uint8(s, cache_brush_order->style); /* style (1 byte) */
 	stream_read_uint8(s, cache_brush_order->length); /* iBytes (1 byte) */
 
-	if (cache_brush_order->brushData == NULL)
-		cache_brush_order->brushData = (uint8*) xmalloc(cache_brush_order->length);
-	else
-		cache_brush_order->brushData = (uint8*) xrealloc(cache_brush_order->brushData, cache_brush_order->length);
-
+	cache_brush_order->brushData = (uint8*) freerdp_arena_alloc(arena, cache_brush_order->length);
 	stream_read(s, cache_brush_order->brushData, cache_brush_order->length);
 }
 
@@ -1744,6 +1745,14 @@ void update_recv_primary_order(rdpUpdate* update, STREAM* s, uint8 flags)
 		IFCALL(update->SetBounds, update, NULL);
 }
 
+static void update_cache_bitmap_v2_persistent(rdpUpdate* update, CACHE_BITMAP_V2_ORDER* cache_bitmap_v2_order)
+{
+	rdpRdp* rdp = (rdpRdp*) update->rdp;
+
+	if (cache_bitmap_v2_order->flags & CBR2_PERSISTENT_KEY_PRESENT)
+		persistent_cache_put(rdp->persistent, cache_bitmap_v2_order);
+}
+
 void update_recv_secondary_order(rdpUpdate* update, STREAM* s, uint8 flags)
 {
 	uint8* next;
@@ -1778,39 +1787,41 @@ void update_recv_secondary_order(rdpUpdate* update, STREAM* s, uint8 flags)
 
 		case ORDER_TYPE_BITMAP_UNCOMPRESSED_V2:
 			update_read_cache_bitmap_v2_order(s, &(update->cache_bitmap_v2_order), False, extraFlags);
+			update_cache_bitmap_v2_persistent(update, &(update->cache_bitmap_v2_order));
 			IFCALL(update->CacheBitmapV2, update, &(update->cache_bitmap_v2_order));
 			break;
 
 		case ORDER_TYPE_BITMAP_COMPRESSED_V2:
 			update_read_cache_bitmap_v2_order(s, &(update->cache_bitmap_v2_order), True, extraFlags);
+			update_cache_bitmap_v2_persistent(update, &(update->cache_bitmap_v2_order));
 			IFCALL(update->CacheBitmapV2, update, &(update->cache_bitmap_v2_order));
 			break;
 
 		case ORDER_TYPE_BITMAP_COMPRESSED_V3:
-			update_read_cache_bitmap_v3_order(s, &(update->cache_bitmap_v3_order), True, extraFlags);
+			update_read_cache_bitmap_v3_order(s, update->arena, &(update->cache_bitmap_v3_order), True, extraFlags);
 			IFCALL(update->CacheBitmapV3, update, &(update->cache_bitmap_v3_order));
 			break;
 
 		case ORDER_TYPE_CACHE_COLOR_TABLE:
-			update_read_cache_color_table_order(s, &(update->cache_color_table_order), extraFlags);
+			update_read_cache_color_table_order(s, update->arena, &(update->cache_color_table_order), extraFlags);
 			IFCALL(update->CacheColorTable, update, &(update->cache_color_table_order));
 			break;
 
 		case ORDER_TYPE_CACHE_GLYPH:
 			if (update->glyph_v2)
 			{
-				update_read_cache_glyph_v2_order(s, &(update->cache_glyph_v2_order), extraFlags);
-				IFCALL(update->CacheGlyph, update, &(update->cache_glyph_order));
+				update_read_cache_glyph_v2_order(s, update->arena, &(update->cache_glyph_v2_order), extraFlags);
+				IFCALL(update->CacheGlyphV2, update, &(update->cache_glyph_v2_order));
 			}
 			else
 			{
-				update_read_cache_glyph_order(s, &(update->cache_glyph_order), extraFlags);
-				IFCALL(update->CacheGlyphV2, update, &(update->cache_glyph_v2_order));
+				update_read_cache_glyph_order(s, update->arena, &(update->cache_glyph_order), extraFlags);
+				IFCALL(update->CacheGlyph, update, &(update->cache_glyph_order));
 			}
 			break;
 
 		case ORDER_TYPE_CACHE_BRUSH:
-			update_read_cache_brush_order(s, &(update->cache_brush_order), extraFlags);
+			update_read_cache_brush_order(s, update->arena, &(update->cache_brush_order), extraFlags);
 			IFCALL(update->CacheBrush, update, &(update->cache_brush_order));
 			break;
 
@@ -23,6 +23,7 @@
 #include "rdp.h"
 #include <freerdp/types.h>
 #include <freerdp/update.h>
+#include <freerdp/utils/arena.h>
 #include <freerdp/utils/stream.h>
 
 /* Order Control Flags */
@@ -89,13 +90,10 @@
 #define CBR3_IGNORABLE_FLAG		0x08
 #define CBR3_DO_NOT_CACHE		0x10
 
-#define SO_FLAG_DEFAULT_PLACEMENT	0x01
-#define SO_HORIZONTAL			0x02
-#define SO_VERTICAL			0x04
-#define SO_REVERSED			0x08
-#define SO_ZERO_BEARINGS		0x10
-#define SO_CHAR_INC_EQUAL_BM_BASE	0x20
-#define SO_MAXEXT_EQUAL_BM_SIDE		0x40
+#define CG_GLYPH_UNICODE_PRESENT	0x0010
+
+/* glyph bitmaps are 1bpp, byte-aligned rows, padded to a multiple of 4 bytes */
+#define GLYPH_DATA_SIZE(_cx, _cy)	((((((_cx) + 7) / 8) * (_cy)) + 3) & ~3)
 
 #define SCREEN_BITMAP_SURFACE		0xFFFF
 
@@ -230,11 +228,11 @@ void update_read_ellipse_cb_order(STREAM* s, ORDER_INFO* orderInfo, ELLIPSE_CB_O
 
 void update_read_cache_bitmap_order(STREAM* s, CACHE_BITMAP_ORDER* cache_bitmap_order, boolean compressed, uint16 flags);
 void update_read_cache_bitmap_v2_order(STREAM* s, CACHE_BITMAP_V2_ORDER* cache_bitmap_v2_order, boolean compressed, uint16 flags);
-void update_read_cache_bitmap_v3_order(STREAM* s, CACHE_BITMAP_V3_ORDER* cache_bitmap_v3_order, boolean compressed, uint16 flags);
-void update_read_cache_color_table_order(STREAM* s, CACHE_COLOR_TABLE_ORDER* cache_color_table_order, uint16 flags);
-void update_read_cache_glyph_order(STREAM* s, CACHE_GLYPH_ORDER* cache_glyph_order, uint16 flags);
-void update_read_cache_glyph_v2_order(STREAM* s, CACHE_GLYPH_V2_ORDER* cache_glyph_v2_order, uint16 flags);
-void update_read_cache_brush_order(STREAM* s, CACHE_BRUSH_ORDER* cache_brush_order, uint16 flags);
+void update_read_cache_bitmap_v3_order(STREAM* s, ARENA* arena, CACHE_BITMAP_V3_ORDER* cache_bitmap_v3_order, boolean compressed, uint16 flags);
+void update_read_cache_color_table_order(STREAM* s, ARENA* arena, CACHE_COLOR_TABLE_ORDER* cache_color_table_order, uint16 flags);
+void update_read_cache_glyph_order(STREAM* s, ARENA* arena, CACHE_GLYPH_ORDER* cache_glyph_order, uint16 flags);
+void update_read_cache_glyph_v2_order(STREAM* s, ARENA* arena, CACHE_GLYPH_V2_ORDER* cache_glyph_v2_order, uint16 flags);
+void update_read_cache_brush_order(STREAM* s, ARENA* arena, CACHE_BRUSH_ORDER* cache_brush_order, uint16 flags);
 
 void update_read_create_offscreen_bitmap_order(STREAM* s, CREATE_OFFSCREEN_BITMAP_ORDER* create_offscreen_bitmap);
 void update_read_switch_surface_order(STREAM* s, SWITCH_SURFACE_ORDER* switch_surface);
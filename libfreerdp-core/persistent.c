@@ -0,0 +1,394 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Persistent Bitmap Cache
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <freerdp/utils/memory.h>
+
+#include "orders.h"
+#include "persistent.h"
+
+/**
+ * Bitmaps sent in Cache Bitmap (Revision 2) orders carrying a persistent key
+ * are kept in a memory-mapped file under the registry directory, one file per
+ * color depth. Each cell cache has a fixed number of fixed-size slots, slot n
+ * holding the bitmap the server cached at index n, exactly as received on the
+ * wire so that it can be fed back through the CacheBitmapV2 callback.
+ *
+ * On the next connection the keys are sent in the Persistent Key List PDUs.
+ * The server assigns cache indices in the order the keys are listed, so the
+ * slots are compacted first to make the slot number match the index again.
+ */
+
+static const uint8 PERSISTENT_CACHE_MAGIC[8] = "FRDPBMC2";
+
+static uint32 persistent_cache_slot_size(int id)
+{
+	int shift;
+
+	/* cell caches hold up to 16x16, 32x32 and 64x64 pixel bitmaps */
+	shift = (id < 2) ? id * 2 : 4;
+
+	return sizeof(PERSISTENT_CACHE_ENTRY) + (256 << shift) * 4;
+}
+
+static boolean persistent_cache_check_header(rdpPersistentCache* cache, PERSISTENT_CACHE_HEADER* header)
+{
+	int i;
+
+	if (memcmp(header->magic, PERSISTENT_CACHE_MAGIC, sizeof(header->magic)) != 0)
+		return False;
+
+	if (header->version != PERSISTENT_CACHE_VERSION)
+		return False;
+
+	if (header->colorDepth != cache->settings->color_depth)
+		return False;
+
+	if (header->numCells != cache->numCells)
+		return False;
+
+	for (i = 0; i < PERSISTENT_CACHE_MAX_CELLS; i++)
+	{
+		if (header->numEntries[i] != cache->numEntries[i])
+			return False;
+	}
+
+	return True;
+}
+
+/**
+ * Open the persistent cache file and map it into memory.\n
+ * The file is reset if it was written with a different color depth or cache layout.
+ * @param cache persistent cache
+ * @return True if the cache is usable
+ */
+
+boolean persistent_cache_open(rdpPersistentCache* cache)
+{
+	int i;
+	uint8* p;
+	void* map;
+	struct stat st;
+	rdpSettings* settings;
+	PERSISTENT_CACHE_HEADER header;
+
+	if (cache->map != NULL)
+		return True;
+
+	settings = cache->settings;
+
+	if (settings->persistent_bitmap_cache != True || cache->registry->available != True)
+		return False;
+
+	cache->numCells = settings->bitmap_cache_v2_num_cells;
+	cache->size = sizeof(PERSISTENT_CACHE_HEADER);
+
+	if (cache->numCells > PERSISTENT_CACHE_MAX_CELLS)
+		cache->numCells = PERSISTENT_CACHE_MAX_CELLS;
+
+	for (i = 0; i < PERSISTENT_CACHE_MAX_CELLS; i++)
+	{
+		cache->numEntries[i] = 0;
+		cache->slotSize[i] = persistent_cache_slot_size(i);
+
+		if (i < cache->numCells && settings->bitmap_cache_v2_cell_info[i].persistent)
+			cache->numEntries[i] = settings->bitmap_cache_v2_cell_info[i].numEntries;
+
+		cache->size += cache->numEntries[i] * cache->slotSize[i];
+	}
+
+	xfree(cache->file);
+	cache->file = (char*) xmalloc(strlen(cache->registry->path) + 32);
+	sprintf(cache->file, "%s/bitmap_cache_v2_%d.bin", cache->registry->path, settings->color_depth);
+
+	cache->fd = open(cache->file, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+
+	if (cache->fd < 0)
+	{
+		printf("persistent_cache_open: error opening %s\n", cache->file);
+		return False;
+	}
+
+	if (pread(cache->fd, &header, sizeof(header), 0) != sizeof(header) ||
+		persistent_cache_check_header(cache, &header) != True)
+	{
+		/* start from an empty cache, the file is sparse until slots are written */
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, PERSISTENT_CACHE_MAGIC, sizeof(header.magic));
+		header.version = PERSISTENT_CACHE_VERSION;
+		header.colorDepth = settings->color_depth;
+		header.numCells = cache->numCells;
+		memcpy(header.numEntries, cache->numEntries, sizeof(header.numEntries));
+
+		if (ftruncate(cache->fd, 0) != 0 || ftruncate(cache->fd, cache->size) != 0 ||
+			pwrite(cache->fd, &header, sizeof(header), 0) != sizeof(header))
+		{
+			printf("persistent_cache_open: error initializing %s\n", cache->file);
+			close(cache->fd);
+			cache->fd = -1;
+			return False;
+		}
+	}
+	else if (fstat(cache->fd, &st) != 0 || (st.st_size < cache->size && ftruncate(cache->fd, cache->size) != 0))
+	{
+		/* touching a mapped slot past the end of a truncated file would raise SIGBUS */
+		printf("persistent_cache_open: error resizing %s\n", cache->file);
+		close(cache->fd);
+		cache->fd = -1;
+		return False;
+	}
+
+	map = mmap(NULL, cache->size, PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0);
+
+	if (map == MAP_FAILED)
+	{
+		printf("persistent_cache_open: error mapping %s\n", cache->file);
+		close(cache->fd);
+		cache->fd = -1;
+		return False;
+	}
+
+	cache->map = (uint8*) map;
+	p = cache->map + sizeof(PERSISTENT_CACHE_HEADER);
+
+	for (i = 0; i < PERSISTENT_CACHE_MAX_CELLS; i++)
+	{
+		cache->cells[i] = p;
+		p += cache->numEntries[i] * cache->slotSize[i];
+	}
+
+	return True;
+}
+
+/**
+ * Flush and unmap the persistent cache file.
+ * @param cache persistent cache
+ */
+
+void persistent_cache_close(rdpPersistentCache* cache)
+{
+	if (cache->map != NULL)
+	{
+		msync(cache->map, cache->size, MS_SYNC);
+		munmap(cache->map, cache->size);
+		cache->map = NULL;
+	}
+
+	if (cache->fd >= 0)
+	{
+		close(cache->fd);
+		cache->fd = -1;
+	}
+}
+
+/**
+ * Get a persistent cache entry.\n
+ * The bitmap data immediately follows the entry.
+ * @param cache persistent cache
+ * @param id cell cache id
+ * @param index cache index
+ * @return cache entry, or NULL if out of range
+ */
+
+PERSISTENT_CACHE_ENTRY* persistent_cache_get(rdpPersistentCache* cache, int id, int index)
+{
+	if (cache->map == NULL || id < 0 || id >= PERSISTENT_CACHE_MAX_CELLS)
+		return NULL;
+
+	if (index < 0 || index >= cache->numEntries[id])
+		return NULL;
+
+	return (PERSISTENT_CACHE_ENTRY*) (cache->cells[id] + index * cache->slotSize[id]);
+}
+
+/**
+ * Store a bitmap sent with a persistent key.
+ * @param cache persistent cache
+ * @param cache_bitmap_v2_order cache bitmap order
+ */
+
+void persistent_cache_put(rdpPersistentCache* cache, CACHE_BITMAP_V2_ORDER* cache_bitmap_v2_order)
+{
+	PERSISTENT_CACHE_ENTRY* entry;
+
+	if (cache->map == NULL)
+		return;
+
+	if (cache_bitmap_v2_order->cacheIndex == BITMAP_CACHE_WAITING_LIST_INDEX)
+		return;
+
+	entry = persistent_cache_get(cache, cache_bitmap_v2_order->cacheId, cache_bitmap_v2_order->cacheIndex);
+
+	if (entry == NULL)
+		return;
+
+	if (sizeof(PERSISTENT_CACHE_ENTRY) + cache_bitmap_v2_order->bitmapLength >
+		cache->slotSize[cache_bitmap_v2_order->cacheId])
+	{
+		/* larger than the uncompressed bitmap, not worth keeping */
+		entry->flags = 0;
+		return;
+	}
+
+	entry->key1 = cache_bitmap_v2_order->key1;
+	entry->key2 = cache_bitmap_v2_order->key2;
+	entry->width = cache_bitmap_v2_order->bitmapWidth;
+	entry->height = cache_bitmap_v2_order->bitmapHeight;
+	entry->bpp = cache_bitmap_v2_order->bitmapBpp;
+	entry->length = cache_bitmap_v2_order->bitmapLength;
+	memcpy(entry->bitmapComprHdr, cache_bitmap_v2_order->bitmapComprHdr, 8);
+	memcpy(&entry[1], cache_bitmap_v2_order->bitmapDataStream, entry->length);
+
+	entry->flags = PERSISTENT_ENTRY_VALID;
+
+	if (cache_bitmap_v2_order->compressed)
+		entry->flags |= PERSISTENT_ENTRY_COMPRESSED;
+}
+
+/**
+ * Move the valid entries of a cell cache to the first slots.
+ * @param cache persistent cache
+ * @param id cell cache id
+ * @return number of valid entries
+ */
+
+int persistent_cache_compact(rdpPersistentCache* cache, int id)
+{
+	int index;
+	int count = 0;
+	PERSISTENT_CACHE_ENTRY* src;
+	PERSISTENT_CACHE_ENTRY* dst;
+
+	if (cache->map == NULL || id >= PERSISTENT_CACHE_MAX_CELLS)
+		return 0;
+
+	for (index = 0; index < cache->numEntries[id]; index++)
+	{
+		src = persistent_cache_get(cache, id, index);
+
+		if (!(src->flags & PERSISTENT_ENTRY_VALID))
+			continue;
+
+		if (index != count)
+		{
+			dst = persistent_cache_get(cache, id, count);
+			memcpy(dst, src, sizeof(PERSISTENT_CACHE_ENTRY) + src->length);
+			src->flags = 0;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * Feed the bitmaps listed in the persistent key list to the CacheBitmapV2 callback.\n
+ * This has to happen once the callbacks are registered and before any update is processed.
+ * @param cache persistent cache
+ * @param update update module
+ */
+
+void persistent_cache_replay(rdpPersistentCache* cache, rdpUpdate* update)
+{
+	int id;
+	int index;
+	PERSISTENT_CACHE_ENTRY* entry;
+	CACHE_BITMAP_V2_ORDER cache_bitmap_v2_order;
+
+	if (cache->replay != True)
+		return;
+
+	cache->replay = False;
+
+	if (update->CacheBitmapV2 == NULL)
+		return;
+
+	for (id = 0; id < PERSISTENT_CACHE_MAX_CELLS; id++)
+	{
+		for (index = 0; index < cache->numEntries[id]; index++)
+		{
+			entry = persistent_cache_get(cache, id, index);
+
+			/* entries are compacted, the first invalid slot ends the list */
+			if (!(entry->flags & PERSISTENT_ENTRY_VALID))
+				break;
+
+			memset(&cache_bitmap_v2_order, 0, sizeof(CACHE_BITMAP_V2_ORDER));
+			cache_bitmap_v2_order.cacheId = id;
+			cache_bitmap_v2_order.flags = CBR2_PERSISTENT_KEY_PRESENT;
+			cache_bitmap_v2_order.key1 = entry->key1;
+			cache_bitmap_v2_order.key2 = entry->key2;
+			cache_bitmap_v2_order.bitmapBpp = entry->bpp;
+			cache_bitmap_v2_order.bitmapWidth = entry->width;
+			cache_bitmap_v2_order.bitmapHeight = entry->height;
+			cache_bitmap_v2_order.bitmapLength = entry->length;
+			cache_bitmap_v2_order.cacheIndex = index;
+			cache_bitmap_v2_order.compressed = (entry->flags & PERSISTENT_ENTRY_COMPRESSED) ? True : False;
+			memcpy(cache_bitmap_v2_order.bitmapComprHdr, entry->bitmapComprHdr, 8);
+			cache_bitmap_v2_order.bitmapDataStream = (uint8*) &entry[1];
+
+			IFCALL(update->CacheBitmapV2, update, &cache_bitmap_v2_order);
+		}
+	}
+}
+
+/**
+ * Instantiate new persistent bitmap cache.
+ * @param settings settings
+ * @param registry registry, for the cache directory
+ * @return new persistent cache
+ */
+
+rdpPersistentCache* persistent_cache_new(rdpSettings* settings, rdpRegistry* registry)
+{
+	rdpPersistentCache* cache;
+
+	cache = (rdpPersistentCache*) xzalloc(sizeof(rdpPersistentCache));
+
+	if (cache != NULL)
+	{
+		cache->fd = -1;
+		cache->settings = settings;
+		cache->registry = registry;
+	}
+
+	return cache;
+}
+
+/**
+ * Free persistent bitmap cache.
+ * @param cache persistent cache
+ */
+
+void persistent_cache_free(rdpPersistentCache* cache)
+{
+	if (cache != NULL)
+	{
+		persistent_cache_close(cache);
+		xfree(cache->file);
+		xfree(cache);
+	}
+}
@@ -0,0 +1,94 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Persistent Bitmap Cache
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PERSISTENT_H
+#define __PERSISTENT_H
+
+typedef struct rdp_persistent_cache rdpPersistentCache;
+
+#include "rdp.h"
+
+#include <freerdp/types.h>
+#include <freerdp/update.h>
+#include <freerdp/settings.h>
+
+#define PERSISTENT_CACHE_MAX_CELLS		5
+#define PERSISTENT_CACHE_VERSION		1
+#define PERSISTENT_KEY_LIST_MAX_ENTRIES		169
+
+#define BITMAP_CACHE_WAITING_LIST_INDEX		0x7FFF
+
+/* Persistent Cache Entry Flags */
+#define PERSISTENT_ENTRY_VALID			0x01
+#define PERSISTENT_ENTRY_COMPRESSED		0x02
+
+/* File Header */
+struct _PERSISTENT_CACHE_HEADER
+{
+	uint8 magic[8];
+	uint32 version;
+	uint32 colorDepth;
+	uint32 numCells;
+	uint32 numEntries[PERSISTENT_CACHE_MAX_CELLS];
+};
+typedef struct _PERSISTENT_CACHE_HEADER PERSISTENT_CACHE_HEADER;
+
+/* Cache Slot, followed by the bitmap data */
+struct _PERSISTENT_CACHE_ENTRY
+{
+	uint32 key1;
+	uint32 key2;
+	uint16 width;
+	uint16 height;
+	uint8 bpp;
+	uint8 flags;
+	uint16 reserved;
+	uint32 length;
+	uint8 bitmapComprHdr[8];
+};
+typedef struct _PERSISTENT_CACHE_ENTRY PERSISTENT_CACHE_ENTRY;
+
+struct rdp_persistent_cache
+{
+	int fd;
+	uint8* map;
+	uint32 size;
+	char* file;
+	boolean keys_sent;
+	boolean replay;
+	rdpSettings* settings;
+	rdpRegistry* registry;
+	uint32 numCells;
+	uint32 numEntries[PERSISTENT_CACHE_MAX_CELLS];
+	uint32 slotSize[PERSISTENT_CACHE_MAX_CELLS];
+	uint8* cells[PERSISTENT_CACHE_MAX_CELLS];
+};
+
+boolean persistent_cache_open(rdpPersistentCache* cache);
+void persistent_cache_close(rdpPersistentCache* cache);
+
+void persistent_cache_put(rdpPersistentCache* cache, CACHE_BITMAP_V2_ORDER* cache_bitmap_v2_order);
+PERSISTENT_CACHE_ENTRY* persistent_cache_get(rdpPersistentCache* cache, int id, int index);
+int persistent_cache_compact(rdpPersistentCache* cache, int id);
+void persistent_cache_replay(rdpPersistentCache* cache, rdpUpdate* update);
+
+rdpPersistentCache* persistent_cache_new(rdpSettings* settings, rdpRegistry* registry);
+void persistent_cache_free(rdpPersistentCache* cache);
+
+#endif /* __PERSISTENT_H */
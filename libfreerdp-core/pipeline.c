@@ -0,0 +1,775 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Update Pipeline
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freerdp/utils/memory.h>
+#include <freerdp/utils/thread.h>
+
+#include "pipeline.h"
+
+/**
+ * In pipeline mode the update callbacks registered by the client are replaced
+ * by proxies which copy each update, along with the data it points to, into a
+ * record of a ring buffer. A render thread takes the records out of the ring in
+ * order and calls the client callbacks, so that the network thread can go on
+ * parsing PDUs while the previous ones are being drawn.
+ *
+ * The ring has a single producer, the thread receiving the updates, and a single
+ * consumer, the render thread. Each side only writes its own counter, and only
+ * blocks on a semaphore after raising a flag the other side checks once it has
+ * moved its counter. The network thread waits for room in the ring when it gets
+ * ahead of the render thread by more than the size of the ring.
+ *
+ * Callbacks which cannot be queued are called on the network thread, once every
+ * queued record has been processed.
+ */
+
+#define PIPELINE_ALIGN(_n) (((_n) + 7) & ~7)
+
+#define PIPELINE(_update) (((rdpRdp*) (_update)->rdp)->pipeline)
+
+#define pipeline_atomic_add(_v, _n) __sync_fetch_and_add(&(_v), _n)
+#define pipeline_atomic_get(_v) __sync_fetch_and_add(&(_v), 0)
+#define pipeline_atomic_cas(_v, _o, _n) __sync_bool_compare_and_swap(&(_v), _o, _n)
+
+static void pipeline_wait_space(rdpPipeline* pipeline, uint32 size)
+{
+	uint32 used;
+
+	while (1)
+	{
+		used = pipeline_atomic_get(pipeline->head) - pipeline_atomic_get(pipeline->tail);
+
+		if (pipeline->capacity - used >= size)
+			break;
+
+		pipeline_atomic_cas(pipeline->waiting, 0, 1);
+		used = pipeline_atomic_get(pipeline->head) - pipeline_atomic_get(pipeline->tail);
+
+		/* the render thread may have made room before seeing the flag */
+		if (pipeline->capacity - used >= size && pipeline_atomic_cas(pipeline->waiting, 1, 0))
+			break;
+
+		freerdp_sem_wait(pipeline->space);
+	}
+}
+
+static void pipeline_push(rdpPipeline* pipeline)
+{
+	pipeline_atomic_add(pipeline->head, pipeline->size);
+
+	if (pipeline_atomic_cas(pipeline->sleeping, 1, 0))
+		freerdp_sem_signal(pipeline->ready);
+}
+
+/**
+ * Reserve a record in the ring, waiting for the render thread to make room if needed.\n
+ * The record is handed to the render thread by pipeline_push().
+ * @param pipeline update pipeline
+ * @param type record type
+ * @param length length of the record data
+ * @return record data
+ */
+
+static void* pipeline_reserve(rdpPipeline* pipeline, uint32 type, uint32 length)
+{
+	uint32 size;
+	uint32 offset;
+	PIPELINE_RECORD* record;
+
+	size = PIPELINE_ALIGN(sizeof(PIPELINE_RECORD) + length);
+	offset = pipeline_atomic_get(pipeline->head) & (pipeline->capacity - 1);
+
+	if (offset + size > pipeline->capacity)
+	{
+		/* records are contiguous, skip the end of the ring */
+		pipeline->size = pipeline->capacity - offset;
+		pipeline_wait_space(pipeline, pipeline->size);
+
+		record = (PIPELINE_RECORD*) &pipeline->ring[offset];
+		record->type = PIPELINE_WRAP;
+		record->size = pipeline->size;
+		pipeline_push(pipeline);
+
+		offset = 0;
+	}
+
+	pipeline->size = size;
+	pipeline_wait_space(pipeline, size);
+
+	record = (PIPELINE_RECORD*) &pipeline->ring[offset];
+	record->type = type;
+	record->size = size;
+
+	return (void*) &record[1];
+}
+
+static boolean pipeline_fits(rdpPipeline* pipeline, uint32 length)
+{
+	return (PIPELINE_ALIGN(sizeof(PIPELINE_RECORD) + length) <= PIPELINE_MAX_RECORD(pipeline->capacity));
+}
+
+/**
+ * Wait until every queued update has been processed by the render thread.
+ * @param pipeline update pipeline
+ */
+
+void pipeline_flush(rdpPipeline* pipeline)
+{
+	pipeline_reserve(pipeline, PIPELINE_BARRIER, 0);
+	pipeline_push(pipeline);
+	freerdp_sem_wait(pipeline->flushed);
+}
+
+static void pipeline_begin_paint(rdpUpdate* update)
+{
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	pipeline_reserve(pipeline, PIPELINE_BEGIN_PAINT, 0);
+	pipeline_push(pipeline);
+}
+
+static void pipeline_end_paint(rdpUpdate* update)
+{
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	pipeline_reserve(pipeline, PIPELINE_END_PAINT, 0);
+	pipeline_push(pipeline);
+}
+
+static void pipeline_synchronize(rdpUpdate* update)
+{
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	pipeline_reserve(pipeline, PIPELINE_SYNCHRONIZE, 0);
+	pipeline_push(pipeline);
+}
+
+static void pipeline_set_bounds(rdpUpdate* update, BOUNDS* bounds)
+{
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	/* a record without data resets the bounds */
+	if (bounds != NULL)
+		memcpy(pipeline_reserve(pipeline, PIPELINE_SET_BOUNDS, sizeof(BOUNDS)), bounds, sizeof(BOUNDS));
+	else
+		pipeline_reserve(pipeline, PIPELINE_SET_BOUNDS, 0);
+
+	pipeline_push(pipeline);
+}
+
+/* updates without pointers are copied as they are */
+#define PIPELINE_COPY(_name, _type, _record) \
+static void pipeline_##_name(rdpUpdate* update, _type* order) \
+{ \
+	rdpPipeline* pipeline = PIPELINE(update); \
+	memcpy(pipeline_reserve(pipeline, _record, sizeof(_type)), order, sizeof(_type)); \
+	pipeline_push(pipeline); \
+}
+
+PIPELINE_COPY(palette, PALETTE_UPDATE, PIPELINE_PALETTE)
+PIPELINE_COPY(dstblt, DSTBLT_ORDER, PIPELINE_DSTBLT)
+PIPELINE_COPY(patblt, PATBLT_ORDER, PIPELINE_PATBLT)
+PIPELINE_COPY(scrblt, SCRBLT_ORDER, PIPELINE_SCRBLT)
+PIPELINE_COPY(opaque_rect, OPAQUE_RECT_ORDER, PIPELINE_OPAQUE_RECT)
+PIPELINE_COPY(draw_nine_grid, DRAW_NINE_GRID_ORDER, PIPELINE_DRAW_NINE_GRID)
+PIPELINE_COPY(multi_opaque_rect, MULTI_OPAQUE_RECT_ORDER, PIPELINE_MULTI_OPAQUE_RECT)
+PIPELINE_COPY(line_to, LINE_TO_ORDER, PIPELINE_LINE_TO)
+PIPELINE_COPY(memblt, MEMBLT_ORDER, PIPELINE_MEMBLT)
+PIPELINE_COPY(mem3blt, MEM3BLT_ORDER, PIPELINE_MEM3BLT)
+PIPELINE_COPY(save_bitmap, SAVE_BITMAP_ORDER, PIPELINE_SAVE_BITMAP)
+PIPELINE_COPY(glyph_index, GLYPH_INDEX_ORDER, PIPELINE_GLYPH_INDEX)
+PIPELINE_COPY(fast_index, FAST_INDEX_ORDER, PIPELINE_FAST_INDEX)
+PIPELINE_COPY(ellipse_sc, ELLIPSE_SC_ORDER, PIPELINE_ELLIPSE_SC)
+PIPELINE_COPY(ellipse_cb, ELLIPSE_CB_ORDER, PIPELINE_ELLIPSE_CB)
+
+/* updates which cannot be queued are processed on the network thread, in order */
+#define PIPELINE_SYNC(_name, _callback, _type) \
+static void pipeline_##_name(rdpUpdate* update, _type* order) \
+{ \
+	rdpPipeline* pipeline = PIPELINE(update); \
+	pipeline_flush(pipeline); \
+	IFCALL(pipeline->callbacks._callback, update, order); \
+}
+
+PIPELINE_SYNC(multi_dstblt, MultiDstBlt, MULTI_DSTBLT_ORDER)
+PIPELINE_SYNC(multi_patblt, MultiPatBlt, MULTI_PATBLT_ORDER)
+PIPELINE_SYNC(multi_scrblt, MultiScrBlt, MULTI_SCRBLT_ORDER)
+PIPELINE_SYNC(multi_draw_nine_grid, MultiDrawNineGrid, MULTI_DRAW_NINE_GRID_ORDER)
+PIPELINE_SYNC(polygon_sc, PolygonSC, POLYGON_SC_ORDER)
+PIPELINE_SYNC(polygon_cb, PolygonCB, POLYGON_CB_ORDER)
+PIPELINE_SYNC(create_offscreen_bitmap, CreateOffscreenBitmap, CREATE_OFFSCREEN_BITMAP_ORDER)
+PIPELINE_SYNC(switch_surface, SwitchSurface, SWITCH_SURFACE_ORDER)
+PIPELINE_SYNC(create_nine_grid_bitmap, CreateNineGridBitmap, CREATE_NINE_GRID_BITMAP_ORDER)
+PIPELINE_SYNC(frame_marker, FrameMarker, FRAME_MARKER_ORDER)
+PIPELINE_SYNC(stream_bitmap_first, StreamBitmapFirst, STREAM_BITMAP_FIRST_ORDER)
+PIPELINE_SYNC(stream_bitmap_next, StreamBitmapNext, STREAM_BITMAP_FIRST_ORDER)
+PIPELINE_SYNC(draw_gdiplus_first, DrawGdiPlusFirst, DRAW_GDIPLUS_FIRST_ORDER)
+PIPELINE_SYNC(draw_gdiplus_next, DrawGdiPlusNext, DRAW_GDIPLUS_NEXT_ORDER)
+PIPELINE_SYNC(draw_gdiplus_end, DrawGdiPlusEnd, DRAW_GDIPLUS_END_ORDER)
+PIPELINE_SYNC(draw_gdiplus_cache_first, DrawGdiPlusCacheFirst, DRAW_GDIPLUS_CACHE_FIRST_ORDER)
+PIPELINE_SYNC(draw_gdiplus_cache_next, DrawGdiPlusCacheNext, DRAW_GDIPLUS_CACHE_NEXT_ORDER)
+PIPELINE_SYNC(draw_gdiplus_cache_end, DrawGdiPlusCacheEnd, DRAW_GDIPLUS_CACHE_END_ORDER)
+
+/* updates pointing to data in the received stream or in buffers reused by the parser are deep copied */
+
+static void pipeline_bitmap(rdpUpdate* update, BITMAP_UPDATE* bitmap)
+{
+	int i;
+	uint8* data;
+	uint32 length;
+	BITMAP_UPDATE* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	length = sizeof(BITMAP_UPDATE) + bitmap->number * sizeof(BITMAP_DATA);
+
+	for (i = 0; i < bitmap->number; i++)
+		length += bitmap->bitmaps[i].length;
+
+	if (!pipeline_fits(pipeline, length))
+	{
+		pipeline_flush(pipeline);
+		IFCALL(pipeline->callbacks.Bitmap, update, bitmap);
+		return;
+	}
+
+	copy = (BITMAP_UPDATE*) pipeline_reserve(pipeline, PIPELINE_BITMAP, length);
+	copy->number = bitmap->number;
+	copy->bitmaps = (BITMAP_DATA*) &copy[1];
+	memcpy(copy->bitmaps, bitmap->bitmaps, bitmap->number * sizeof(BITMAP_DATA));
+
+	data = (uint8*) &copy->bitmaps[bitmap->number];
+
+	for (i = 0; i < bitmap->number; i++)
+	{
+		memcpy(data, bitmap->bitmaps[i].data, bitmap->bitmaps[i].length);
+		copy->bitmaps[i].data = data;
+		data += bitmap->bitmaps[i].length;
+	}
+
+	pipeline_push(pipeline);
+}
+
+static void pipeline_polyline(rdpUpdate* update, POLYLINE_ORDER* polyline)
+{
+	uint32 length;
+	POLYLINE_ORDER* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	length = (polyline->points != NULL) ? polyline->numPoints * sizeof(DELTA_POINT) : 0;
+
+	copy = (POLYLINE_ORDER*) pipeline_reserve(pipeline, PIPELINE_POLYLINE, sizeof(POLYLINE_ORDER) + length);
+	memcpy(copy, polyline, sizeof(POLYLINE_ORDER));
+
+	if (polyline->points != NULL)
+	{
+		copy->points = (DELTA_POINT*) &copy[1];
+		memcpy(copy->points, polyline->points, length);
+	}
+
+	pipeline_push(pipeline);
+}
+
+static void pipeline_fast_glyph(rdpUpdate* update, FAST_GLYPH_ORDER* fast_glyph)
+{
+	FAST_GLYPH_ORDER* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	copy = (FAST_GLYPH_ORDER*) pipeline_reserve(pipeline, PIPELINE_FAST_GLYPH, sizeof(FAST_GLYPH_ORDER));
+	memcpy(copy, fast_glyph, sizeof(FAST_GLYPH_ORDER));
+
+	/* the glyph bitmap is part of the order data */
+	if (fast_glyph->glyph_data.aj != NULL)
+		copy->glyph_data.aj = &copy->data[fast_glyph->glyph_data.aj - fast_glyph->data];
+
+	pipeline_push(pipeline);
+}
+
+static void pipeline_cache_bitmap(rdpUpdate* update, CACHE_BITMAP_ORDER* cache_bitmap)
+{
+	CACHE_BITMAP_ORDER* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	copy = (CACHE_BITMAP_ORDER*) pipeline_reserve(pipeline, PIPELINE_CACHE_BITMAP,
+			sizeof(CACHE_BITMAP_ORDER) + cache_bitmap->bitmapLength);
+	memcpy(copy, cache_bitmap, sizeof(CACHE_BITMAP_ORDER));
+
+	copy->bitmapDataStream = (uint8*) &copy[1];
+	memcpy(copy->bitmapDataStream, cache_bitmap->bitmapDataStream, cache_bitmap->bitmapLength);
+
+	pipeline_push(pipeline);
+}
+
+static void pipeline_cache_bitmap_v2(rdpUpdate* update, CACHE_BITMAP_V2_ORDER* cache_bitmap_v2)
+{
+	CACHE_BITMAP_V2_ORDER* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	if (!pipeline_fits(pipeline, sizeof(CACHE_BITMAP_V2_ORDER) + cache_bitmap_v2->bitmapLength))
+	{
+		pipeline_flush(pipeline);
+		IFCALL(pipeline->callbacks.CacheBitmapV2, update, cache_bitmap_v2);
+		return;
+	}
+
+	copy = (CACHE_BITMAP_V2_ORDER*) pipeline_reserve(pipeline, PIPELINE_CACHE_BITMAP_V2,
+			sizeof(CACHE_BITMAP_V2_ORDER) + cache_bitmap_v2->bitmapLength);
+	memcpy(copy, cache_bitmap_v2, sizeof(CACHE_BITMAP_V2_ORDER));
+
+	copy->bitmapDataStream = (uint8*) &copy[1];
+	memcpy(copy->bitmapDataStream, cache_bitmap_v2->bitmapDataStream, cache_bitmap_v2->bitmapLength);
+
+	pipeline_push(pipeline);
+}
+
+static void pipeline_cache_bitmap_v3(rdpUpdate* update, CACHE_BITMAP_V3_ORDER* cache_bitmap_v3)
+{
+	CACHE_BITMAP_V3_ORDER* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	if (!pipeline_fits(pipeline, sizeof(CACHE_BITMAP_V3_ORDER) + cache_bitmap_v3->bitmapData.length))
+	{
+		pipeline_flush(pipeline);
+		IFCALL(pipeline->callbacks.CacheBitmapV3, update, cache_bitmap_v3);
+		return;
+	}
+
+	copy = (CACHE_BITMAP_V3_ORDER*) pipeline_reserve(pipeline, PIPELINE_CACHE_BITMAP_V3,
+			sizeof(CACHE_BITMAP_V3_ORDER) + cache_bitmap_v3->bitmapData.length);
+	memcpy(copy, cache_bitmap_v3, sizeof(CACHE_BITMAP_V3_ORDER));
+
+	copy->bitmapData.data = (uint8*) &copy[1];
+	memcpy(copy->bitmapData.data, cache_bitmap_v3->bitmapData.data, cache_bitmap_v3->bitmapData.length);
+
+	pipeline_push(pipeline);
+}
+
+static void pipeline_cache_color_table(rdpUpdate* update, CACHE_COLOR_TABLE_ORDER* cache_color_table)
+{
+	CACHE_COLOR_TABLE_ORDER* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	copy = (CACHE_COLOR_TABLE_ORDER*) pipeline_reserve(pipeline, PIPELINE_CACHE_COLOR_TABLE,
+			sizeof(CACHE_COLOR_TABLE_ORDER) + cache_color_table->numberColors * 4);
+	memcpy(copy, cache_color_table, sizeof(CACHE_COLOR_TABLE_ORDER));
+
+	copy->colorTable = (uint32*) &copy[1];
+	memcpy(copy->colorTable, cache_color_table->colorTable, cache_color_table->numberColors * 4);
+
+	pipeline_push(pipeline);
+}
+
+static void pipeline_cache_glyph(rdpUpdate* update, CACHE_GLYPH_ORDER* cache_glyph)
+{
+	int i;
+	uint8* data;
+	uint32 length;
+	CACHE_GLYPH_ORDER* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	length = sizeof(CACHE_GLYPH_ORDER) + cache_glyph->cGlyphs * sizeof(GLYPH_DATA);
+
+	for (i = 0; i < cache_glyph->cGlyphs; i++)
+		length += cache_glyph->glyphData[i].cb;
+
+	if (!pipeline_fits(pipeline, length))
+	{
+		pipeline_flush(pipeline);
+		IFCALL(pipeline->callbacks.CacheGlyph, update, cache_glyph);
+		return;
+	}
+
+	copy = (CACHE_GLYPH_ORDER*) pipeline_reserve(pipeline, PIPELINE_CACHE_GLYPH, length);
+	memcpy(copy, cache_glyph, sizeof(CACHE_GLYPH_ORDER));
+
+	copy->glyphData = (GLYPH_DATA*) &copy[1];
+	copy->unicodeCharacters = NULL;
+	memcpy(copy->glyphData, cache_glyph->glyphData, cache_glyph->cGlyphs * sizeof(GLYPH_DATA));
+
+	data = (uint8*) &copy->glyphData[cache_glyph->cGlyphs];
+
+	for (i = 0; i < cache_glyph->cGlyphs; i++)
+	{
+		memcpy(data, cache_glyph->glyphData[i].aj, cache_glyph->glyphData[i].cb);
+		copy->glyphData[i].aj = data;
+		data += cache_glyph->glyphData[i].cb;
+	}
+
+	pipeline_push(pipeline);
+}
+
+static void pipeline_cache_glyph_v2(rdpUpdate* update, CACHE_GLYPH_V2_ORDER* cache_glyph_v2)
+{
+	int i;
+	uint8* data;
+	uint32 length;
+	CACHE_GLYPH_V2_ORDER* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	length = sizeof(CACHE_GLYPH_V2_ORDER) + cache_glyph_v2->cGlyphs * sizeof(GLYPH_DATA_V2);
+
+	for (i = 0; i < cache_glyph_v2->cGlyphs; i++)
+		length += cache_glyph_v2->glyphData[i].cb;
+
+	if (!pipeline_fits(pipeline, length))
+	{
+		pipeline_flush(pipeline);
+		IFCALL(pipeline->callbacks.CacheGlyphV2, update, cache_glyph_v2);
+		return;
+	}
+
+	copy = (CACHE_GLYPH_V2_ORDER*) pipeline_reserve(pipeline, PIPELINE_CACHE_GLYPH_V2, length);
+	memcpy(copy, cache_glyph_v2, sizeof(CACHE_GLYPH_V2_ORDER));
+
+	copy->glyphData = (GLYPH_DATA_V2*) &copy[1];
+	copy->unicodeCharacters = NULL;
+	memcpy(copy->glyphData, cache_glyph_v2->glyphData, cache_glyph_v2->cGlyphs * sizeof(GLYPH_DATA_V2));
+
+	data = (uint8*) &copy->glyphData[cache_glyph_v2->cGlyphs];
+
+	for (i = 0; i < cache_glyph_v2->cGlyphs; i++)
+	{
+		memcpy(data, cache_glyph_v2->glyphData[i].aj, cache_glyph_v2->glyphData[i].cb);
+		copy->glyphData[i].aj = data;
+		data += cache_glyph_v2->glyphData[i].cb;
+	}
+
+	pipeline_push(pipeline);
+}
+
+static void pipeline_cache_brush(rdpUpdate* update, CACHE_BRUSH_ORDER* cache_brush)
+{
+	CACHE_BRUSH_ORDER* copy;
+	rdpPipeline* pipeline = PIPELINE(update);
+
+	copy = (CACHE_BRUSH_ORDER*) pipeline_reserve(pipeline, PIPELINE_CACHE_BRUSH,
+			sizeof(CACHE_BRUSH_ORDER) + cache_brush->length);
+	memcpy(copy, cache_brush, sizeof(CACHE_BRUSH_ORDER));
+
+	copy->brushData = (uint8*) &copy[1];
+	memcpy(copy->brushData, cache_brush->brushData, cache_brush->length);
+
+	pipeline_push(pipeline);
+}
+
+/**
+ * Process a record on the render thread.
+ * @param pipeline update pipeline
+ * @param record record taken out of the ring
+ * @return False when the render thread is to exit
+ */
+
+static boolean pipeline_dispatch(rdpPipeline* pipeline, PIPELINE_RECORD* record)
+{
+	void* data = (void*) &record[1];
+	rdpUpdate* update = pipeline->update;
+	rdpUpdate* callbacks = &pipeline->callbacks;
+
+	switch (record->type)
+	{
+		case PIPELINE_WRAP:
+			break;
+
+		case PIPELINE_BARRIER:
+			freerdp_sem_signal(pipeline->flushed);
+			break;
+
+		case PIPELINE_STOP:
+			freerdp_sem_signal(pipeline->flushed);
+			return False;
+
+		case PIPELINE_BEGIN_PAINT:
+			IFCALL(callbacks->BeginPaint, update);
+			break;
+
+		case PIPELINE_END_PAINT:
+			IFCALL(callbacks->EndPaint, update);
+			break;
+
+		case PIPELINE_SET_BOUNDS:
+			IFCALL(callbacks->SetBounds, update, (record->size > sizeof(PIPELINE_RECORD)) ? (BOUNDS*) data : NULL);
+			break;
+
+		case PIPELINE_SYNCHRONIZE:
+			IFCALL(callbacks->Synchronize, update);
+			break;
+
+		case PIPELINE_BITMAP:
+			IFCALL(callbacks->Bitmap, update, (BITMAP_UPDATE*) data);
+			break;
+
+		case PIPELINE_PALETTE:
+			IFCALL(callbacks->Palette, update, (PALETTE_UPDATE*) data);
+			break;
+
+		case PIPELINE_DSTBLT:
+			IFCALL(callbacks->DstBlt, update, (DSTBLT_ORDER*) data);
+			break;
+
+		case PIPELINE_PATBLT:
+			IFCALL(callbacks->PatBlt, update, (PATBLT_ORDER*) data);
+			break;
+
+		case PIPELINE_SCRBLT:
+			IFCALL(callbacks->ScrBlt, update, (SCRBLT_ORDER*) data);
+			break;
+
+		case PIPELINE_OPAQUE_RECT:
+			IFCALL(callbacks->OpaqueRect, update, (OPAQUE_RECT_ORDER*) data);
+			break;
+
+		case PIPELINE_DRAW_NINE_GRID:
+			IFCALL(callbacks->DrawNineGrid, update, (DRAW_NINE_GRID_ORDER*) data);
+			break;
+
+		case PIPELINE_MULTI_OPAQUE_RECT:
+			IFCALL(callbacks->MultiOpaqueRect, update, (MULTI_OPAQUE_RECT_ORDER*) data);
+			break;
+
+		case PIPELINE_LINE_TO:
+			IFCALL(callbacks->LineTo, update, (LINE_TO_ORDER*) data);
+			break;
+
+		case PIPELINE_POLYLINE:
+			IFCALL(callbacks->Polyline, update, (POLYLINE_ORDER*) data);
+			break;
+
+		case PIPELINE_MEMBLT:
+			IFCALL(callbacks->MemBlt, update, (MEMBLT_ORDER*) data);
+			break;
+
+		case PIPELINE_MEM3BLT:
+			IFCALL(callbacks->Mem3Blt, update, (MEM3BLT_ORDER*) data);
+			break;
+
+		case PIPELINE_SAVE_BITMAP:
+			IFCALL(callbacks->SaveBitmap, update, (SAVE_BITMAP_ORDER*) data);
+			break;
+
+		case PIPELINE_GLYPH_INDEX:
+			IFCALL(callbacks->GlyphIndex, update, (GLYPH_INDEX_ORDER*) data);
+			break;
+
+		case PIPELINE_FAST_INDEX:
+			IFCALL(callbacks->FastIndex, update, (FAST_INDEX_ORDER*) data);
+			break;
+
+		case PIPELINE_FAST_GLYPH:
+			IFCALL(callbacks->FastGlyph, update, (FAST_GLYPH_ORDER*) data);
+			break;
+
+		case PIPELINE_ELLIPSE_SC:
+			IFCALL(callbacks->EllipseSC, update, (ELLIPSE_SC_ORDER*) data);
+			break;
+
+		case PIPELINE_ELLIPSE_CB:
+			IFCALL(callbacks->EllipseCB, update, (ELLIPSE_CB_ORDER*) data);
+			break;
+
+		case PIPELINE_CACHE_BITMAP:
+			IFCALL(callbacks->CacheBitmap, update, (CACHE_BITMAP_ORDER*) data);
+			break;
+
+		case PIPELINE_CACHE_BITMAP_V2:
+			IFCALL(callbacks->CacheBitmapV2, update, (CACHE_BITMAP_V2_ORDER*) data);
+			break;
+
+		case PIPELINE_CACHE_BITMAP_V3:
+			IFCALL(callbacks->CacheBitmapV3, update, (CACHE_BITMAP_V3_ORDER*) data);
+			break;
+
+		case PIPELINE_CACHE_COLOR_TABLE:
+			IFCALL(callbacks->CacheColorTable, update, (CACHE_COLOR_TABLE_ORDER*) data);
+			break;
+
+		case PIPELINE_CACHE_GLYPH:
+			IFCALL(callbacks->CacheGlyph, update, (CACHE_GLYPH_ORDER*) data);
+			break;
+
+		case PIPELINE_CACHE_GLYPH_V2:
+			IFCALL(callbacks->CacheGlyphV2, update, (CACHE_GLYPH_V2_ORDER*) data);
+			break;
+
+		case PIPELINE_CACHE_BRUSH:
+			IFCALL(callbacks->CacheBrush, update, (CACHE_BRUSH_ORDER*) data);
+			break;
+
+		default:
+			printf("pipeline_dispatch: unknown record type %d\n", record->type);
+			break;
+	}
+
+	return True;
+}
+
+static void* pipeline_thread(void* arg)
+{
+	uint32 tail;
+	PIPELINE_RECORD* record;
+	rdpPipeline* pipeline = (rdpPipeline*) arg;
+
+	while (1)
+	{
+		tail = pipeline_atomic_get(pipeline->tail);
+
+		while (pipeline_atomic_get(pipeline->head) == tail)
+		{
+			pipeline_atomic_cas(pipeline->sleeping, 0, 1);
+
+			/* the network thread may have pushed a record before seeing the flag */
+			if (pipeline_atomic_get(pipeline->head) != tail && pipeline_atomic_cas(pipeline->sleeping, 1, 0))
+				break;
+
+			freerdp_sem_wait(pipeline->ready);
+		}
+
+		record = (PIPELINE_RECORD*) &pipeline->ring[tail & (pipeline->capacity - 1)];
+
+		/* the pipeline is being freed once the stop record is processed */
+		if (!pipeline_dispatch(pipeline, record))
+			break;
+
+		pipeline_atomic_add(pipeline->tail, record->size);
+
+		if (pipeline_atomic_cas(pipeline->waiting, 1, 0))
+			freerdp_sem_signal(pipeline->space);
+	}
+
+	return NULL;
+}
+
+/* replace the client callbacks by the pipeline proxies, or put them back */
+#define PIPELINE_HOOK(_callback, _proxy) \
+	if (update->_callback != NULL) \
+		update->_callback = (install) ? _proxy : pipeline->callbacks._callback
+
+static void pipeline_hook(rdpPipeline* pipeline, boolean install)
+{
+	rdpUpdate* update = pipeline->update;
+
+	PIPELINE_HOOK(BeginPaint, pipeline_begin_paint);
+	PIPELINE_HOOK(EndPaint, pipeline_end_paint);
+	PIPELINE_HOOK(SetBounds, pipeline_set_bounds);
+	PIPELINE_HOOK(Synchronize, pipeline_synchronize);
+	PIPELINE_HOOK(Bitmap, pipeline_bitmap);
+	PIPELINE_HOOK(Palette, pipeline_palette);
+
+	PIPELINE_HOOK(DstBlt, pipeline_dstblt);
+	PIPELINE_HOOK(PatBlt, pipeline_patblt);
+	PIPELINE_HOOK(ScrBlt, pipeline_scrblt);
+	PIPELINE_HOOK(OpaqueRect, pipeline_opaque_rect);
+	PIPELINE_HOOK(DrawNineGrid, pipeline_draw_nine_grid);
+	PIPELINE_HOOK(MultiDstBlt, pipeline_multi_dstblt);
+	PIPELINE_HOOK(MultiPatBlt, pipeline_multi_patblt);
+	PIPELINE_HOOK(MultiScrBlt, pipeline_multi_scrblt);
+	PIPELINE_HOOK(MultiOpaqueRect, pipeline_multi_opaque_rect);
+	PIPELINE_HOOK(MultiDrawNineGrid, pipeline_multi_draw_nine_grid);
+	PIPELINE_HOOK(LineTo, pipeline_line_to);
+	PIPELINE_HOOK(Polyline, pipeline_polyline);
+	PIPELINE_HOOK(MemBlt, pipeline_memblt);
+	PIPELINE_HOOK(Mem3Blt, pipeline_mem3blt);
+	PIPELINE_HOOK(SaveBitmap, pipeline_save_bitmap);
+	PIPELINE_HOOK(GlyphIndex, pipeline_glyph_index);
+	PIPELINE_HOOK(FastIndex, pipeline_fast_index);
+	PIPELINE_HOOK(FastGlyph, pipeline_fast_glyph);
+	PIPELINE_HOOK(PolygonSC, pipeline_polygon_sc);
+	PIPELINE_HOOK(PolygonCB, pipeline_polygon_cb);
+	PIPELINE_HOOK(EllipseSC, pipeline_ellipse_sc);
+	PIPELINE_HOOK(EllipseCB, pipeline_ellipse_cb);
+
+	PIPELINE_HOOK(CacheBitmap, pipeline_cache_bitmap);
+	PIPELINE_HOOK(CacheBitmapV2, pipeline_cache_bitmap_v2);
+	PIPELINE_HOOK(CacheBitmapV3, pipeline_cache_bitmap_v3);
+	PIPELINE_HOOK(CacheColorTable, pipeline_cache_color_table);
+	PIPELINE_HOOK(CacheGlyph, pipeline_cache_glyph);
+	PIPELINE_HOOK(CacheGlyphV2, pipeline_cache_glyph_v2);
+	PIPELINE_HOOK(CacheBrush, pipeline_cache_brush);
+
+	PIPELINE_HOOK(CreateOffscreenBitmap, pipeline_create_offscreen_bitmap);
+	PIPELINE_HOOK(SwitchSurface, pipeline_switch_surface);
+	PIPELINE_HOOK(CreateNineGridBitmap, pipeline_create_nine_grid_bitmap);
+	PIPELINE_HOOK(FrameMarker, pipeline_frame_marker);
+	PIPELINE_HOOK(StreamBitmapFirst, pipeline_stream_bitmap_first);
+	PIPELINE_HOOK(StreamBitmapNext, pipeline_stream_bitmap_next);
+	PIPELINE_HOOK(DrawGdiPlusFirst, pipeline_draw_gdiplus_first);
+	PIPELINE_HOOK(DrawGdiPlusNext, pipeline_draw_gdiplus_next);
+	PIPELINE_HOOK(DrawGdiPlusEnd, pipeline_draw_gdiplus_end);
+	PIPELINE_HOOK(DrawGdiPlusCacheFirst, pipeline_draw_gdiplus_cache_first);
+	PIPELINE_HOOK(DrawGdiPlusCacheNext, pipeline_draw_gdiplus_cache_next);
+	PIPELINE_HOOK(DrawGdiPlusCacheEnd, pipeline_draw_gdiplus_cache_end);
+}
+
+/**
+ * Instantiate new update pipeline, moving the update callbacks to a render thread.\n
+ * The client callbacks must have been registered already.
+ * @param update update module
+ * @param capacity size of the ring buffer, a power of two, usually PIPELINE_RING_SIZE
+ * @return new update pipeline
+ */
+
+rdpPipeline* pipeline_new(rdpUpdate* update, uint32 capacity)
+{
+	rdpPipeline* pipeline;
+
+	pipeline = (rdpPipeline*) xzalloc(sizeof(rdpPipeline));
+
+	if (pipeline != NULL)
+	{
+		pipeline->update = update;
+		pipeline->capacity = capacity;
+		pipeline->ring = (uint8*) xmalloc(capacity);
+
+		pipeline->ready = freerdp_sem_new(0);
+		pipeline->space = freerdp_sem_new(0);
+		pipeline->flushed = freerdp_sem_new(0);
+
+		memcpy(&pipeline->callbacks, update, sizeof(rdpUpdate));
+		pipeline_hook(pipeline, True);
+
+		freerdp_thread_create(pipeline_thread, pipeline);
+	}
+
+	return pipeline;
+}
+
+/**
+ * Free update pipeline, once every queued update has been processed.\n
+ * The client callbacks are put back in place.
+ * @param pipeline update pipeline to be freed
+ */
+
+void pipeline_free(rdpPipeline* pipeline)
+{
+	if (pipeline != NULL)
+	{
+		pipeline_reserve(pipeline, PIPELINE_STOP, 0);
+		pipeline_push(pipeline);
+		freerdp_sem_wait(pipeline->flushed);
+
+		pipeline_hook(pipeline, False);
+
+		freerdp_sem_free(pipeline->ready);
+		freerdp_sem_free(pipeline->space);
+		freerdp_sem_free(pipeline->flushed);
+		xfree(pipeline->ring);
+		xfree(pipeline);
+	}
+}
@@ -0,0 +1,106 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Update Pipeline
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PIPELINE_H
+#define __PIPELINE_H
+
+typedef struct rdp_pipeline rdpPipeline;
+
+#include "rdp.h"
+
+#include <freerdp/types.h>
+#include <freerdp/update.h>
+#include <freerdp/utils/semaphore.h>
+
+/* default size of the ring buffer, a power of two */
+#define PIPELINE_RING_SIZE		(4 * 1024 * 1024)
+
+/* larger records are not queued, the update is drawn once the ring is drained */
+#define PIPELINE_MAX_RECORD(_capacity)	((_capacity) / 4)
+
+/* Record Types */
+#define PIPELINE_WRAP			0
+#define PIPELINE_BARRIER		1
+#define PIPELINE_STOP			2
+#define PIPELINE_BEGIN_PAINT		3
+#define PIPELINE_END_PAINT		4
+#define PIPELINE_SET_BOUNDS		5
+#define PIPELINE_SYNCHRONIZE		6
+#define PIPELINE_BITMAP			7
+#define PIPELINE_PALETTE		8
+#define PIPELINE_DSTBLT			9
+#define PIPELINE_PATBLT			10
+#define PIPELINE_SCRBLT			11
+#define PIPELINE_OPAQUE_RECT		12
+#define PIPELINE_DRAW_NINE_GRID		13
+#define PIPELINE_MULTI_OPAQUE_RECT	14
+#define PIPELINE_LINE_TO		15
+#define PIPELINE_POLYLINE		16
+#define PIPELINE_MEMBLT			17
+#define PIPELINE_MEM3BLT		18
+#define PIPELINE_SAVE_BITMAP		19
+#define PIPELINE_GLYPH_INDEX		20
+#define PIPELINE_FAST_INDEX		21
+#define PIPELINE_FAST_GLYPH		22
+#define PIPELINE_ELLIPSE_SC		23
+#define PIPELINE_ELLIPSE_CB		24
+#define PIPELINE_CACHE_BITMAP		25
+#define PIPELINE_CACHE_BITMAP_V2	26
+#define PIPELINE_CACHE_BITMAP_V3	27
+#define PIPELINE_CACHE_COLOR_TABLE	28
+#define PIPELINE_CACHE_GLYPH		29
+#define PIPELINE_CACHE_GLYPH_V2		30
+#define PIPELINE_CACHE_BRUSH		31
+
+/* Record Header, followed by the copied update and the data it points to */
+struct _PIPELINE_RECORD
+{
+	uint32 type;
+	uint32 size;
+};
+typedef struct _PIPELINE_RECORD PIPELINE_RECORD;
+
+struct rdp_pipeline
+{
+	rdpUpdate* update;
+
+	/* callbacks registered by the client, called on the render thread */
+	rdpUpdate callbacks;
+
+	uint8* ring;
+	uint32 capacity; /* size of the ring, a power of two */
+	uint32 head; /* bytes written, owned by the network thread */
+	uint32 tail; /* bytes consumed, owned by the render thread */
+	uint32 size; /* size of the record being written */
+
+	/* set by a thread before sleeping, cleared by the other thread when waking it up */
+	uint32 sleeping;
+	uint32 waiting;
+
+	freerdp_sem ready;
+	freerdp_sem space;
+	freerdp_sem flushed;
+};
+
+void pipeline_flush(rdpPipeline* pipeline);
+
+rdpPipeline* pipeline_new(rdpUpdate* update, uint32 capacity);
+void pipeline_free(rdpPipeline* pipeline);
+
+#endif /* __PIPELINE_H */
@@ -0,0 +1,427 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Planar Bitmap Codec
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <freerdp/utils/cpu.h>
+
+#include "planar.h"
+
+/*
+   Planar Codec (RDP 6.0 Bitmap Compression)
+   http://msdn.microsoft.com/en-us/library/ff655170%28v=prot.10%29.aspx
+
+   The bitmap is made of up to four color planes (alpha, then red, green and
+   blue, or luma, orange chroma and green chroma when color loss is enabled),
+   each stored bottom-up either raw or run-length encoded. In RLE planes all
+   scanlines but the first one hold the difference to the previous scanline.
+
+   Planes are decoded one at a time into a scratch buffer, which stays in the
+   cache for the usual 64x64 tiles, and are then interleaved into BGRA pixels
+   written straight to the destination, one scanline at a time.
+*/
+
+#define PLANAR_BUFFER_PIXELS 4096
+
+/**
+ * Add the previous scanline to a scanline of deltas.
+ */
+static void planar_delta_row_c(uint8* row, uint8* prev, int width)
+{
+	int x;
+
+	for (x = 0; x < width; x++)
+		row[x] += prev[x];
+}
+
+/**
+ * Interleave alpha, red, green and blue planes into BGRA pixels.
+ */
+static void planar_interleave_row_c(uint8* dst, uint8* a, uint8* r, uint8* g, uint8* b, int width)
+{
+	int x;
+
+	for (x = 0; x < width; x++)
+	{
+		*dst++ = b[x];
+		*dst++ = g[x];
+		*dst++ = r[x];
+		*dst++ = a[x];
+	}
+}
+
+#define PLANAR_CLAMP(_v) (((_v) < 0) ? 0 : (((_v) > 255) ? 255 : (_v)))
+
+/**
+ * Convert luma and chroma planes to BGRA pixels.\n
+ * Chroma values were reduced by the color loss level and are restored with the given shift.
+ * Subsampled chroma planes are half as wide, each chroma value covering two pixels.
+ */
+static void planar_ycocg_row_c(uint8* dst, uint8* a, uint8* y, uint8* co, uint8* cg,
+		int width, int shift, int subsample)
+{
+	int x;
+	int t;
+	int red, green, blue;
+	int coValue, cgValue;
+
+	for (x = 0; x < width; x++)
+	{
+		coValue = (sint8) (co[x >> subsample] << shift);
+		cgValue = (sint8) (cg[x >> subsample] << shift);
+
+		t = y[x] - cgValue;
+		red = t + coValue;
+		green = y[x] + cgValue;
+		blue = t - coValue;
+
+		*dst++ = PLANAR_CLAMP(blue);
+		*dst++ = PLANAR_CLAMP(green);
+		*dst++ = PLANAR_CLAMP(red);
+		*dst++ = a[x];
+	}
+}
+
+#ifdef WITH_SSE2
+
+static void planar_delta_row_sse2(uint8* row, uint8* prev, int width)
+{
+	int x;
+	__m128i xmm0, xmm1;
+
+	for (x = 0; x + 16 <= width; x += 16)
+	{
+		xmm0 = _mm_loadu_si128((__m128i*) &row[x]);
+		xmm1 = _mm_loadu_si128((__m128i*) &prev[x]);
+		_mm_storeu_si128((__m128i*) &row[x], _mm_add_epi8(xmm0, xmm1));
+	}
+
+	planar_delta_row_c(&row[x], &prev[x], width - x);
+}
+
+/**
+ * Interleave sixteen blue, green, red and alpha values into BGRA pixels.
+ */
+static void planar_store_bgra_sse2(uint8* dst, __m128i b, __m128i g, __m128i r, __m128i a)
+{
+	__m128i bgLo, bgHi, raLo, raHi;
+
+	bgLo = _mm_unpacklo_epi8(b, g);
+	bgHi = _mm_unpackhi_epi8(b, g);
+	raLo = _mm_unpacklo_epi8(r, a);
+	raHi = _mm_unpackhi_epi8(r, a);
+
+	_mm_storeu_si128((__m128i*) &dst[0], _mm_unpacklo_epi16(bgLo, raLo));
+	_mm_storeu_si128((__m128i*) &dst[16], _mm_unpackhi_epi16(bgLo, raLo));
+	_mm_storeu_si128((__m128i*) &dst[32], _mm_unpacklo_epi16(bgHi, raHi));
+	_mm_storeu_si128((__m128i*) &dst[48], _mm_unpackhi_epi16(bgHi, raHi));
+}
+
+static void planar_interleave_row_sse2(uint8* dst, uint8* a, uint8* r, uint8* g, uint8* b, int width)
+{
+	int x;
+
+	for (x = 0; x + 16 <= width; x += 16)
+	{
+		planar_store_bgra_sse2(&dst[x * 4],
+			_mm_loadu_si128((__m128i*) &b[x]), _mm_loadu_si128((__m128i*) &g[x]),
+			_mm_loadu_si128((__m128i*) &r[x]), _mm_loadu_si128((__m128i*) &a[x]));
+	}
+
+	planar_interleave_row_c(&dst[x * 4], &a[x], &r[x], &g[x], &b[x], width - x);
+}
+
+static void planar_ycocg_row_sse2(uint8* dst, uint8* a, uint8* y, uint8* co, uint8* cg,
+		int width, int shift, int subsample)
+{
+	int x;
+	__m128i zero;
+	__m128i count;
+	__m128i coBytes, cgBytes, yBytes;
+	__m128i yLo, yHi, coLo, coHi, cgLo, cgHi, tLo, tHi;
+	__m128i red, green, blue;
+
+	zero = _mm_setzero_si128();
+	count = _mm_cvtsi32_si128(shift);
+
+	for (x = 0; x + 16 <= width; x += 16)
+	{
+		if (subsample)
+		{
+			coBytes = _mm_loadl_epi64((__m128i*) &co[x >> 1]);
+			cgBytes = _mm_loadl_epi64((__m128i*) &cg[x >> 1]);
+			coBytes = _mm_unpacklo_epi8(coBytes, coBytes);
+			cgBytes = _mm_unpacklo_epi8(cgBytes, cgBytes);
+		}
+		else
+		{
+			coBytes = _mm_loadu_si128((__m128i*) &co[x]);
+			cgBytes = _mm_loadu_si128((__m128i*) &cg[x]);
+		}
+
+		yBytes = _mm_loadu_si128((__m128i*) &y[x]);
+		yLo = _mm_unpacklo_epi8(yBytes, zero);
+		yHi = _mm_unpackhi_epi8(yBytes, zero);
+
+		/* shift the chroma bytes in the upper half of each lane, then sign extend them */
+		coLo = _mm_srai_epi16(_mm_sll_epi16(_mm_unpacklo_epi8(zero, coBytes), count), 8);
+		coHi = _mm_srai_epi16(_mm_sll_epi16(_mm_unpackhi_epi8(zero, coBytes), count), 8);
+		cgLo = _mm_srai_epi16(_mm_sll_epi16(_mm_unpacklo_epi8(zero, cgBytes), count), 8);
+		cgHi = _mm_srai_epi16(_mm_sll_epi16(_mm_unpackhi_epi8(zero, cgBytes), count), 8);
+
+		tLo = _mm_sub_epi16(yLo, cgLo);
+		tHi = _mm_sub_epi16(yHi, cgHi);
+
+		/* saturating packs clamp the components to [0, 255] */
+		red = _mm_packus_epi16(_mm_add_epi16(tLo, coLo), _mm_add_epi16(tHi, coHi));
+		green = _mm_packus_epi16(_mm_add_epi16(yLo, cgLo), _mm_add_epi16(yHi, cgHi));
+		blue = _mm_packus_epi16(_mm_sub_epi16(tLo, coLo), _mm_sub_epi16(tHi, coHi));
+
+		planar_store_bgra_sse2(&dst[x * 4], blue, green, red, _mm_loadu_si128((__m128i*) &a[x]));
+	}
+
+	planar_ycocg_row_c(&dst[x * 4], &a[x], &y[x], &co[x >> subsample], &cg[x >> subsample],
+			width - x, shift, subsample);
+}
+
+#endif
+
+typedef void (*pPlanarDeltaRow)(uint8* row, uint8* prev, int width);
+typedef void (*pPlanarInterleaveRow)(uint8* dst, uint8* a, uint8* r, uint8* g, uint8* b, int width);
+typedef void (*pPlanarYCoCgRow)(uint8* dst, uint8* a, uint8* y, uint8* co, uint8* cg,
+		int width, int shift, int subsample);
+
+/* scanline kernels, the scalar ones until planar_init() selects others */
+static pPlanarDeltaRow planar_delta_row = planar_delta_row_c;
+static pPlanarInterleaveRow planar_interleave_row = planar_interleave_row_c;
+static pPlanarYCoCgRow planar_ycocg_row = planar_ycocg_row_c;
+
+/**
+ * Select the scanline kernels for the instruction sets of the processor.
+ * @param features CPU_* feature flags, zero for the scalar kernels
+ */
+void planar_init(uint32 features)
+{
+	planar_delta_row = planar_delta_row_c;
+	planar_interleave_row = planar_interleave_row_c;
+	planar_ycocg_row = planar_ycocg_row_c;
+
+#ifdef WITH_SSE2
+	if (features & CPU_SSE2)
+	{
+		planar_delta_row = planar_delta_row_sse2;
+		planar_interleave_row = planar_interleave_row_sse2;
+		planar_ycocg_row = planar_ycocg_row_sse2;
+	}
+#endif
+}
+
+/**
+ * Decompress a run-length encoded color plane.
+ * @return number of bytes consumed, or -1 if the plane is malformed
+ */
+static int planar_decompress_plane_rle(uint8* srcData, int size, uint8* plane, int width, int height)
+{
+	int x, y;
+	int code;
+	int collen;
+	int replen;
+	int revcode;
+	uint8 color;
+	uint8 value;
+	uint8* row;
+	uint8* src = srcData;
+	uint8* end = srcData + size;
+
+	for (y = 0; y < height; y++)
+	{
+		row = plane + y * width;
+		color = 0;
+		x = 0;
+
+		while (x < width)
+		{
+			if (src >= end)
+				return -1;
+
+			code = *src++;
+			replen = code & 0x0F;
+			collen = (code >> 4) & 0x0F;
+			revcode = (replen << 4) | collen;
+
+			/* a run length of 1 or 2 extends the run with the raw byte count */
+			if ((revcode <= 47) && (revcode >= 16))
+			{
+				replen = revcode;
+				collen = 0;
+			}
+
+			if (collen > end - src || x + collen + replen > width)
+				return -1;
+
+			if (y == 0)
+			{
+				if (collen > 0)
+				{
+					memcpy(&row[x], src, collen);
+					color = src[collen - 1];
+					src += collen;
+					x += collen;
+				}
+			}
+			else
+			{
+				while (collen > 0)
+				{
+					/* deltas are stored as sign and magnitude, with the sign in the lowest bit */
+					value = *src++;
+					color = (value >> 1) ^ (uint8) -(value & 1);
+					row[x++] = color;
+					collen--;
+				}
+			}
+
+			memset(&row[x], color, replen);
+			x += replen;
+		}
+
+		if (y > 0)
+			planar_delta_row(row, row - width, width);
+	}
+
+	return (int) (src - srcData);
+}
+
+/**
+ * Decompress a planar bitmap to 32bpp BGRA.\n
+ * Bitmaps larger than PLANAR_BUFFER_PIXELS need a heap allocated plane buffer.
+ * @param srcData compressed bitmap data
+ * @param dstData top-left pixel of the destination rectangle
+ * @param dstStride distance in bytes between two destination scanlines
+ * @param width bitmap width
+ * @param height bitmap height
+ * @param size compressed bitmap data length
+ * @return True on success
+ */
+boolean planar_decompress(uint8* srcData, uint8* dstData, int dstStride, int width, int height, int size)
+{
+	int i, y;
+	int status;
+	int length;
+	int planeSize;
+	int colorLoss;
+	int subsample;
+	uint8 header;
+	uint8* src;
+	uint8* end;
+	uint8* dst;
+	uint8* buffer;
+	uint8* planes[4];
+	int widths[4];
+	int heights[4];
+	uint32 planeBuffer[PLANAR_BUFFER_PIXELS];
+
+	if (size < 1 || width < 1 || height < 1)
+		return False;
+
+	header = srcData[0];
+	colorLoss = header & PLANAR_FORMAT_HEADER_CLL_MASK;
+	subsample = (header & PLANAR_FORMAT_HEADER_CS) ? 1 : 0;
+
+	/* chroma subsampling only applies to YCoCg planes */
+	if (subsample && colorLoss == 0)
+		return False;
+
+	planeSize = width * height;
+
+	widths[0] = widths[1] = width;
+	heights[0] = heights[1] = height;
+	widths[2] = widths[3] = (width + subsample) >> subsample;
+	heights[2] = heights[3] = (height + subsample) >> subsample;
+
+	if (planeSize > PLANAR_BUFFER_PIXELS)
+		buffer = (uint8*) xmalloc(planeSize * 4);
+	else
+		buffer = (uint8*) planeBuffer;
+
+	for (i = 0; i < 4; i++)
+		planes[i] = buffer + i * planeSize;
+
+	src = srcData + 1;
+	end = srcData + size;
+	status = True;
+
+	for (i = 0; i < 4 && status; i++)
+	{
+		if (i == 0 && (header & PLANAR_FORMAT_HEADER_NA))
+		{
+			memset(planes[0], 0xFF, planeSize);
+		}
+		else if (header & PLANAR_FORMAT_HEADER_RLE)
+		{
+			length = planar_decompress_plane_rle(src, (int) (end - src), planes[i],
+					widths[i], heights[i]);
+
+			if (length < 0)
+				status = False;
+			else
+				src += length;
+		}
+		else
+		{
+			/* raw planes are used in place */
+			length = widths[i] * heights[i];
+
+			if (length > end - src)
+				status = False;
+
+			planes[i] = src;
+			src += length;
+		}
+	}
+
+	/* RLE planes must use up the whole stream, raw planes may be followed by a pad byte */
+	if ((header & PLANAR_FORMAT_HEADER_RLE) && src != end)
+		status = False;
+
+	if (status)
+	{
+		for (y = 0; y < height; y++)
+		{
+			dst = dstData + (height - y - 1) * dstStride;
+
+			if (colorLoss)
+			{
+				planar_ycocg_row(dst, planes[0] + y * width, planes[1] + y * width,
+					planes[2] + (y >> subsample) * widths[2], planes[3] + (y >> subsample) * widths[3],
+					width, colorLoss - 1, subsample);
+			}
+			else
+			{
+				planar_interleave_row(dst, planes[0] + y * width, planes[1] + y * width,
+					planes[2] + y * width, planes[3] + y * width, width);
+			}
+		}
+	}
+
+	if (buffer != (uint8*) planeBuffer)
+		xfree(buffer);
+
+	return status;
+}
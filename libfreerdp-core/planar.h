@@ -0,0 +1,35 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Planar Bitmap Codec
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PLANAR_H
+#define __PLANAR_H
+
+#include <freerdp/types.h>
+#include <freerdp/utils/memory.h>
+
+/* Format Header */
+#define PLANAR_FORMAT_HEADER_CLL_MASK	0x07
+#define PLANAR_FORMAT_HEADER_CS		0x08
+#define PLANAR_FORMAT_HEADER_RLE	0x10
+#define PLANAR_FORMAT_HEADER_NA		0x20
+
+void planar_init(uint32 features);
+boolean planar_decompress(uint8* srcData, uint8* dstData, int dstStride, int width, int height, int size);
+
+#endif /* __PLANAR_H */
@@ -108,7 +108,8 @@ void rdp_write_share_control_header(STREAM* s, uint16 length, uint16 type, uint1
 	stream_write_uint16(s, channel_id); /* pduSource */
 }
 
-void rdp_read_share_data_header(STREAM* s, uint16* length, uint8* type, uint32* share_id)
+void rdp_read_share_data_header(STREAM* s, uint16* length, uint8* type, uint32* share_id,
+					uint8* compressed_type, uint16* compressed_len)
 {
 	/* Share Data Header */
 	stream_read_uint32(s, *share_id); /* shareId (4 bytes) */
@@ -116,8 +117,8 @@ void rdp_read_share_data_header(STREAM* s, uint16* length, uint8* type, uint32*
 	stream_seek_uint8(s); /* streamId (1 byte) */
 	stream_read_uint16(s, *length); /* uncompressedLength (2 bytes) */
 	stream_read_uint8(s, *type); /* pduType2, Data PDU Type (1 byte) */
-	stream_seek_uint8(s); /* compressedType (1 byte) */
-	stream_seek_uint16(s); /* compressedLength (2 bytes) */
+	stream_read_uint8(s, *compressed_type); /* compressedType (1 byte) */
+	stream_read_uint16(s, *compressed_len); /* compressedLength (2 bytes) */
 }
 
 void rdp_write_share_data_header(STREAM* s, uint16 length, uint8 type, uint32 share_id)
@@ -208,6 +209,36 @@ void rdp_send(rdpRdp* rdp, STREAM* s, uint16 channel_id)
 	transport_write(rdp->transport, s);
 }
 
+/**
+ * Send an RDP packet with a payload that is not copied into the stream.\n
+ * The stream only holds the headers, the payload is written from where it is.
+ * @param rdp RDP module
+ * @param s stream with the headers
+ * @param data payload
+ * @param size payload size
+ * @param channel_id channel id
+ */
+
+void rdp_sendv(rdpRdp* rdp, STREAM* s, uint8* data, int size, uint16 channel_id)
+{
+	int length;
+	struct iovec iov[2];
+
+	length = stream_get_length(s);
+	stream_set_pos(s, 0);
+
+	rdp_write_header(rdp, s, length + size, channel_id);
+
+	stream_set_pos(s, length);
+
+	iov[0].iov_base = stream_get_head(s);
+	iov[0].iov_len = length;
+	iov[1].iov_base = data;
+	iov[1].iov_len = size;
+
+	transport_writev(rdp->transport, iov, 2);
+}
+
 void rdp_send_pdu(rdpRdp* rdp, STREAM* s, uint16 type, uint16 channel_id)
 {
 	int length;
@@ -254,8 +285,36 @@ void rdp_read_data_pdu(rdpRdp* rdp, STREAM* s)
 	uint8 type;
 	uint16 length;
 	uint32 share_id;
+	uint8 compressed_type;
+	uint16 compressed_len;
+	uint8* buffer;
+	int size;
+	STREAM comp_stream;
+
+	rdp_read_share_data_header(s, &length, &type, &share_id, &compressed_type, &compressed_len);
+
+	if (compressed_type & (PACKET_COMPRESSED | PACKET_AT_FRONT | PACKET_FLUSHED))
+	{
+		/* compressedLength includes the share control and share data headers */
+		if (compressed_len < 18 || compressed_len - 18 > stream_get_left(s))
+		{
+			printf("rdp_read_data_pdu: invalid compressed length %d\n", compressed_len);
+			return;
+		}
 
-	rdp_read_share_data_header(s, &length, &type, &share_id);
+		if (mppc_decompress(rdp->mppc, stream_get_tail(s), compressed_len - 18,
+				compressed_type, &buffer, &size) != True)
+			return;
+
+		/* continue parsing the decompressed data in place in the history buffer */
+		if (compressed_type & PACKET_COMPRESSED)
+		{
+			comp_stream.data = buffer;
+			comp_stream.p = buffer;
+			comp_stream.size = size;
+			s = &comp_stream;
+		}
+	}
 
 	if (type != DATA_PDU_TYPE_UPDATE)
 		printf("recv %s Data PDU (0x%02X), length:%d\n", DATA_PDU_TYPE_STRINGS[type], type, length);
@@ -359,9 +418,16 @@ void rdp_process_pdu(rdpRdp* rdp, STREAM* s)
 	uint16 initiator;
 	uint16 channelId;
 	uint16 sec_flags;
+	uint8 header;
 	enum DomainMCSPDU MCSPDU;
 
-	/* TODO: Check Fast Path header */
+	stream_peek_uint8(s, header);
+
+	if (header != 0x03) /* not a TPKT header, Fast Path */
+	{
+		fastpath_recv_updates(rdp->fastpath, s);
+		return;
+	}
 
 	MCSPDU = DomainMCSPDU_SendDataIndication;
 	mcs_read_domain_mcspdu_header(s, &MCSPDU, &length);
@@ -495,6 +561,9 @@ rdpRdp* rdp_new(freerdp* instance)
 		rdp->nego = nego_new(rdp->transport);
 		rdp->mcs = mcs_new(rdp->transport);
 		rdp->vchan = vchan_new(instance);
+		rdp->fastpath = fastpath_new(rdp);
+		rdp->mppc = mppc_new();
+		rdp->persistent = persistent_cache_new(rdp->settings, rdp->registry);
 	}
 
 	return rdp;
@@ -516,6 +585,10 @@ void rdp_free(rdpRdp* rdp)
 		update_free(rdp->update);
 		mcs_free(rdp->mcs);
 		vchan_free(rdp->vchan);
+		fastpath_free(rdp->fastpath);
+		mppc_free(rdp->mppc);
+		persistent_cache_free(rdp->persistent);
+		pipeline_free(rdp->pipeline);
 		xfree(rdp);
 	}
 }
@@ -35,6 +35,10 @@ typedef struct rdp_rdp rdpRdp;
 #include "connection.h"
 #include "capabilities.h"
 #include "vchan.h"
+#include "fastpath.h"
+#include "mppc.h"
+#include "persistent.h"
+#include "pipeline.h"
 
 #include <freerdp/freerdp.h>
 #include <freerdp/settings.h>
@@ -215,6 +219,10 @@ struct rdp_rdp
 	struct rdp_registry* registry;
 	struct rdp_transport* transport;
 	struct rdp_vchan* vchan;
+	struct rdp_fastpath* fastpath;
+	struct rdp_mppc* mppc;
+	struct rdp_persistent_cache* persistent;
+	struct rdp_pipeline* pipeline;
 };
 
 void rdp_read_security_header(STREAM* s, uint16* flags);
@@ -223,7 +231,8 @@ void rdp_write_security_header(STREAM* s, uint16 flags);
 void rdp_read_share_control_header(STREAM* s, uint16* length, uint16* type, uint16* channel_id);
 void rdp_write_share_control_header(STREAM* s, uint16 length, uint16 type, uint16 channel_id);
 
-void rdp_read_share_data_header(STREAM* s, uint16* length, uint8* type, uint32* share_id);
+void rdp_read_share_data_header(STREAM* s, uint16* length, uint8* type, uint32* share_id,
+					uint8* compressed_type, uint16* compressed_len);
 void rdp_write_share_data_header(STREAM* s, uint16 length, uint8 type, uint32 share_id);
 
 STREAM* rdp_send_stream_init(rdpRdp* rdp);
@@ -236,6 +245,7 @@ STREAM* rdp_data_pdu_init(rdpRdp* rdp);
 void rdp_send_data_pdu(rdpRdp* rdp, STREAM* s, uint16 type, uint16 channel_id);
 
 void rdp_send(rdpRdp* rdp, STREAM* s, uint16 channel_id);
+void rdp_sendv(rdpRdp* rdp, STREAM* s, uint8* data, int size, uint16 channel_id);
 void rdp_recv(rdpRdp* rdp);
 
 int rdp_send_channel_data(rdpRdp* rdp, int channel_id, uint8* data, int size);
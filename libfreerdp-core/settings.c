@@ -57,6 +57,10 @@ rdpSettings* settings_new()
 				PERF_DISABLE_WALLPAPER;
 
 		settings->auto_reconnection = True;
+		settings->fast_path_input = True;
+		settings->fast_path_output = True;
+		settings->update_pipeline = False;
+		settings->parallel_orders = False;
 
 		settings->encryption_method = ENCRYPTION_METHOD_NONE;
 		settings->encryption_level = ENCRYPTION_LEVEL_NONE;
@@ -94,6 +98,38 @@ rdpSettings* settings_new()
 		settings->bitmap_cache = True;
 		settings->persistent_bitmap_cache = False;
 
+		settings->bitmap_cache_v2_num_cells = 3;
+		settings->bitmap_cache_v2_cell_info[0].numEntries = 600;
+		settings->bitmap_cache_v2_cell_info[0].persistent = True;
+		settings->bitmap_cache_v2_cell_info[1].numEntries = 600;
+		settings->bitmap_cache_v2_cell_info[1].persistent = True;
+		settings->bitmap_cache_v2_cell_info[2].numEntries = 2048;
+		settings->bitmap_cache_v2_cell_info[2].persistent = True;
+
+		settings->glyph_cache[0].numEntries = 254;
+		settings->glyph_cache[0].maxCellSize = 4;
+		settings->glyph_cache[1].numEntries = 254;
+		settings->glyph_cache[1].maxCellSize = 4;
+		settings->glyph_cache[2].numEntries = 254;
+		settings->glyph_cache[2].maxCellSize = 8;
+		settings->glyph_cache[3].numEntries = 254;
+		settings->glyph_cache[3].maxCellSize = 8;
+		settings->glyph_cache[4].numEntries = 254;
+		settings->glyph_cache[4].maxCellSize = 16;
+		settings->glyph_cache[5].numEntries = 254;
+		settings->glyph_cache[5].maxCellSize = 32;
+		settings->glyph_cache[6].numEntries = 254;
+		settings->glyph_cache[6].maxCellSize = 64;
+		settings->glyph_cache[7].numEntries = 254;
+		settings->glyph_cache[7].maxCellSize = 128;
+		settings->glyph_cache[8].numEntries = 254;
+		settings->glyph_cache[8].maxCellSize = 256;
+		settings->glyph_cache[9].numEntries = 64;
+		settings->glyph_cache[9].maxCellSize = 2048;
+
+		settings->fragment_cache.numEntries = 256;
+		settings->fragment_cache.maxCellSize = 256;
+
 		settings->offscreen_bitmap_cache = True;
 		settings->offscreen_bitmap_cache_size = 7680;
 		settings->offscreen_bitmap_cache_entries = 100;
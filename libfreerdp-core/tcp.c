@@ -158,6 +158,12 @@ int tcp_read(rdpTcp* tcp, uint8* data, int length)
 		return -1;
 	}
 
+	if (status == 0)
+	{
+		/* orderly shutdown by the peer, not a would-block condition */
+		return -1;
+	}
+
 	return status;
 }
 
@@ -178,6 +184,28 @@ int tcp_write(rdpTcp* tcp, uint8* data, int length)
 	return status;
 }
 
+int tcp_writev(rdpTcp* tcp, struct iovec* iov, int iovcnt)
+{
+	int status;
+	struct msghdr msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+
+	status = sendmsg(tcp->sockfd, &msg, MSG_NOSIGNAL);
+
+	if (status < 0)
+	{
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			status = 0;
+		else
+			perror("sendmsg");
+	}
+
+	return status;
+}
+
 boolean tcp_disconnect(rdpTcp * tcp)
 {
 	if (tcp->sockfd != -1)
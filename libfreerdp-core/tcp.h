@@ -21,6 +21,8 @@
 #ifndef __TCP_H
 #define __TCP_H
 
+#include <sys/uio.h>
+
 #include <freerdp/types.h>
 #include <freerdp/settings.h>
 #include <freerdp/utils/stream.h>
@@ -50,6 +52,7 @@ boolean tcp_connect(rdpTcp* tcp, const char* hostname, uint16 port);
 boolean tcp_disconnect(rdpTcp* tcp);
 int tcp_read(rdpTcp* tcp, uint8* data, int length);
 int tcp_write(rdpTcp* tcp, uint8* data, int length);
+int tcp_writev(rdpTcp* tcp, struct iovec* iov, int iovcnt);
 boolean tcp_set_blocking_mode(rdpTcp* tcp, boolean blocking);
 
 rdpTcp* tcp_new(rdpSettings* settings);
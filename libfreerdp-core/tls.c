@@ -119,6 +119,45 @@ int tls_write(rdpTls* tls, uint8* data, int length)
 	return status;
 }
 
+/**
+ * Write a scatter-gather list over TLS.\n
+ * The buffers are coalesced into a single TLS record instead of one record
+ * per buffer, a single buffer is written directly. As with tls_write(), a
+ * return value of 0 means the write must be retried with the same data.
+ * @param tls TLS module
+ * @param iov buffers
+ * @param iovcnt number of buffers
+ * @return number of bytes written from the start of iov
+ */
+
+int tls_writev(rdpTls* tls, struct iovec* iov, int iovcnt)
+{
+	int i;
+	int size;
+	int length = 0;
+
+	if (iovcnt == 1)
+		return tls_write(tls, (uint8*) iov[0].iov_base, iov[0].iov_len);
+
+	for (i = 0; i < iovcnt && length < TLS_COALESCE_SIZE; i++)
+	{
+		size = iov[i].iov_len;
+
+		if (size > TLS_COALESCE_SIZE - length)
+			size = TLS_COALESCE_SIZE - length;
+
+		memcpy(&tls->send_buffer[length], iov[i].iov_base, size);
+		length += size;
+	}
+
+	return tls_write(tls, tls->send_buffer, length);
+}
+
+int tls_pending(rdpTls* tls)
+{
+	return SSL_pending(tls->ssl);
+}
+
 boolean tls_print_error(char *func, SSL *connection, int value)
 {
 	switch (SSL_get_error(connection, value))
@@ -180,6 +219,7 @@ rdpTls* tls_new()
 	{
 		tls->connect = tls_connect;
 		tls->disconnect = tls_disconnect;
+		tls->send_buffer = (uint8*) xmalloc(TLS_COALESCE_SIZE);
 
 		SSL_load_error_strings();
 		SSL_library_init();
@@ -211,6 +251,7 @@ void tls_free(rdpTls* tls)
 {
 	if (tls != NULL)
 	{
+		xfree(tls->send_buffer);
 		xfree(tls);
 	}
 }
@@ -20,6 +20,7 @@
 #ifndef __TLS_H
 #define __TLS_H
 
+#include <sys/uio.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 
@@ -32,9 +33,13 @@ typedef struct rdp_tls rdpTls;
 typedef boolean (*TlsConnect) (rdpTls* tls);
 typedef boolean (*TlsDisconnect) (rdpTls* tls);
 
+/* small writes are coalesced into a single TLS record of up to this size */
+#define TLS_COALESCE_SIZE	16384
+
 struct rdp_tls
 {
 	SSL* ssl;
+	uint8* send_buffer;
 	int sockfd;
 	SSL_CTX* ctx;
 	TlsConnect connect;
@@ -45,6 +50,8 @@ boolean tls_connect(rdpTls* tls);
 boolean tls_disconnect(rdpTls* tls);
 int tls_read(rdpTls* tls, uint8* data, int length);
 int tls_write(rdpTls* tls, uint8* data, int length);
+int tls_writev(rdpTls* tls, struct iovec* iov, int iovcnt);
+int tls_pending(rdpTls* tls);
 CryptoCert tls_get_certificate(rdpTls* tls);
 boolean tls_print_error(char* func, SSL* connection, int value);
 
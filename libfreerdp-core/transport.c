@@ -25,7 +25,7 @@
 #include <freerdp/utils/memory.h>
 #include <freerdp/utils/hexdump.h>
 
-#include <time.h>
+#include <poll.h>
 #include <errno.h>
 #include <sys/socket.h>
 #include <netdb.h>
@@ -56,6 +56,9 @@ STREAM* transport_send_stream_init(rdpTransport* transport, int size)
 
 boolean transport_connect(rdpTransport* transport, const char* hostname, uint16 port)
 {
+	/* the settings are only final once the command line has been parsed */
+	transport_set_timeout(transport, transport->settings->tcp_timeout);
+
 	return transport->tcp->connect(transport->tcp, hostname, port);
 }
 
@@ -119,20 +122,63 @@ boolean transport_connect_nla(rdpTransport* transport)
 	return True;
 }
 
-int transport_read(rdpTransport* transport, STREAM* s)
+/**
+ * Wait for the transport socket to become ready.\n
+ * Data already decrypted and buffered by the TLS layer counts as readable.
+ * @param transport transport
+ * @param events poll events to wait for
+ * @return > 0 when ready, 0 on timeout, -1 on error
+ */
+
+static int transport_wait(rdpTransport* transport, short events)
+{
+	int status;
+	struct pollfd pfd;
+
+	if ((events & POLLIN) && transport->layer == TRANSPORT_LAYER_TLS)
+	{
+		if (tls_pending(transport->tls) > 0)
+			return 1;
+	}
+
+	pfd.fd = transport->tcp->sockfd;
+	pfd.events = events;
+	pfd.revents = 0;
+
+	do
+	{
+		status = poll(&pfd, 1, transport->timeout);
+	}
+	while (status < 0 && errno == EINTR);
+
+	if (status < 0)
+		perror("poll");
+
+	return status;
+}
+
+static int transport_read_layer(rdpTransport* transport, uint8* data, int bytes)
 {
 	int status = -1;
 
 	while (True)
 	{
 		if (transport->layer == TRANSPORT_LAYER_TLS)
-			status = tls_read(transport->tls, s->data, s->size);
+			status = tls_read(transport->tls, data, bytes);
 		else if (transport->layer == TRANSPORT_LAYER_TCP)
-			status = tcp_read(transport->tcp, s->data, s->size);
+			status = tcp_read(transport->tcp, data, bytes);
 
 		if (status == 0 && transport->blocking)
 		{
-			nanosleep(&transport->ts, NULL);
+			/* sleep until the socket is readable */
+			status = transport_wait(transport, POLLIN);
+
+			if (status == 0)
+				printf("transport_read_layer: timed out waiting for the server\n");
+
+			if (status <= 0)
+				return -1;
+
 			continue;
 		}
 
@@ -143,72 +189,185 @@ int transport_read(rdpTransport* transport, STREAM* s)
 	if (status > 0)
 	{
 		printf("Server > Client\n");
-		freerdp_hexdump(s->data, status);
+		freerdp_hexdump(data, status);
 	}
 #endif
 
 	return status;
 }
 
+int transport_read(rdpTransport* transport, STREAM* s)
+{
+	return transport_read_layer(transport, s->data, s->size);
+}
+
+/**
+ * Release the view of the PDU processed by the receive callback, along with
+ * the buffer it was left in if the receive buffer was replaced meanwhile.
+ */
+
+static void transport_release_view(rdpTransport* transport)
+{
+	transport->recv_view->data = NULL;
+
+	if (transport->recv_retired != NULL)
+	{
+		stream_free(transport->recv_retired);
+		transport->recv_retired = NULL;
+	}
+}
+
 static int transport_read_nonblocking(rdpTransport* transport)
 {
 	int status;
+	int pending;
+	STREAM* s = transport->recv_buffer;
 
-	stream_check_size(transport->recv_buffer, 4096);
-	status = transport_read(transport, transport->recv_buffer);
+	if (transport->recv_view->data != NULL && transport->recv_retired == NULL && stream_get_left(s) <= 0)
+	{
+		/*
+		 * A PDU view is still being processed in place and the buffer is full. What follows
+		 * the PDU is moved to a new receive buffer, so that the socket can always be drained,
+		 * and the old one is kept until the view is released.
+		 */
+		pending = stream_get_pos(s) - transport->recv_offset;
+
+		transport->recv_retired = s;
+		s = stream_new(BUFFER_SIZE + pending);
+		memcpy(s->data, transport->recv_retired->data + transport->recv_offset, pending);
+		stream_set_pos(s, pending);
+
+		transport->recv_buffer = s;
+		transport->recv_offset = 0;
+	}
+
+	if (transport->recv_view->data == NULL || transport->recv_retired != NULL)
+	{
+		/*
+		 * Consumed PDUs are only reclaimed once the tail of the buffer runs out,
+		 * by moving the partial PDU left at recv_offset back to the front.
+		 */
+		if (stream_get_left(s) < 4096 && transport->recv_offset > 0)
+		{
+			pending = stream_get_pos(s) - transport->recv_offset;
+			memmove(s->data, s->data + transport->recv_offset, pending);
+			transport->recv_offset = 0;
+			stream_set_pos(s, pending);
+		}
+
+		stream_check_size(s, 4096);
+	}
+
+	status = transport_read_layer(transport, stream_get_tail(s), stream_get_left(s));
 
 	if (status <= 0)
 		return status;
 
-	stream_seek(transport->recv_buffer, status);
+	stream_seek(s, status);
 
 	return status;
 }
 
-int transport_write(rdpTransport* transport, STREAM* s)
+/**
+ * Write a scatter-gather list of buffers to the transport.\n
+ * The iov array is consumed: it is advanced past the data that was written.
+ * @param transport transport
+ * @param iov buffers
+ * @param iovcnt number of buffers
+ * @return number of bytes written, -1 on error
+ */
+
+int transport_writev(rdpTransport* transport, struct iovec* iov, int iovcnt)
 {
+	int i;
 	int status = -1;
-	int length;
+	int length = 0;
 	int sent = 0;
 
-	length = stream_get_length(s);
-	stream_set_pos(s, 0);
+	for (i = 0; i < iovcnt; i++)
+		length += iov[i].iov_len;
 
 #ifdef WITH_DEBUG_TRANSPORT
 	if (length > 0)
 	{
 		printf("Client > Server\n");
-		freerdp_hexdump(s->data, length);
+
+		for (i = 0; i < iovcnt; i++)
+			freerdp_hexdump((uint8*) iov[i].iov_base, iov[i].iov_len);
 	}
 #endif
 
 	while (sent < length)
 	{
 		if (transport->layer == TRANSPORT_LAYER_TLS)
-			status = tls_write(transport->tls, stream_get_tail(s), length);
+			status = tls_writev(transport->tls, iov, iovcnt);
 		else if (transport->layer == TRANSPORT_LAYER_TCP)
-			status = tcp_write(transport->tcp, stream_get_tail(s), length);
+			status = tcp_writev(transport->tcp, iov, iovcnt);
 
 		if (status < 0)
 			break; /* error occurred */
 
 		if (status == 0)
 		{
-			/* blocking while sending */
-			nanosleep(&transport->ts, NULL);
+			/* blocking while sending, sleep until the socket is writable */
+			if (transport->blocking)
+			{
+				status = transport_wait(transport, POLLOUT);
+			}
+			else
+			{
+				/* when sending is blocked in nonblocking mode, the receiving buffer should be checked */
+				status = transport_wait(transport, POLLOUT | POLLIN);
+
+				if (status > 0 && transport_read_nonblocking(transport) < 0)
+					status = -1;
+			}
+
+			if (status == 0)
+				printf("transport_writev: timed out waiting for the server\n");
+
+			if (status <= 0)
+			{
+				status = -1;
+				break;
+			}
 
-			/* when sending is blocked in nonblocking mode, the receiving buffer should be checked */
-			if (!transport->blocking)
-				transport_read_nonblocking(transport);
+			continue;
 		}
 
 		sent += status;
-		stream_seek(s, status);
+
+		/* skip the buffers that were written completely */
+		while (iovcnt > 0 && status >= (int) iov->iov_len)
+		{
+			status -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+
+		if (iovcnt > 0)
+		{
+			iov->iov_base = (uint8*) iov->iov_base + status;
+			iov->iov_len -= status;
+		}
 	}
 
 	if (!transport->blocking)
 		transport_check_fds(transport);
 
+	return (status < 0) ? -1 : sent;
+}
+
+int transport_write(rdpTransport* transport, STREAM* s)
+{
+	int status;
+	struct iovec iov;
+
+	iov.iov_base = stream_get_head(s);
+	iov.iov_len = stream_get_length(s);
+
+	status = transport_writev(transport, &iov, 1);
+
 	return status;
 }
 
@@ -218,61 +377,74 @@ int transport_check_fds(rdpTransport* transport)
 	int status;
 	uint8 header;
 	uint16 length;
-	STREAM* received;
+	STREAM* view;
+	STREAM* buffer;
+
+	view = transport->recv_view;
+
+	/* PDUs are processed in place, a nested call from the receive callback must not touch the buffer */
+	if (view->data != NULL)
+		return 0;
 
+	/* data may already be buffered from a read done while sending */
 	status = transport_read_nonblocking(transport);
-	if (status <= 0)
+	if (status < 0)
 		return status;
 
-	while ((pos = stream_get_pos(transport->recv_buffer)) > 0)
+	while (True)
 	{
+		/* the receive buffer is replaced when it fills up while a PDU is being processed */
+		buffer = transport->recv_buffer;
+		pos = stream_get_pos(buffer) - transport->recv_offset;
+
 		/* Ensure the TPKT or Fast Path header is available. */
 		if (pos <= 4)
-			return 0;
+			break;
 
-		stream_set_pos(transport->recv_buffer, 0);
-		stream_peek_uint8(transport->recv_buffer, header);
+		view->data = buffer->data + transport->recv_offset;
+		view->size = pos;
+		stream_set_pos(view, 0);
+
+		stream_peek_uint8(view, header);
 		if (header == 0x03) /* TPKT */
-			length = tpkt_read_header(transport->recv_buffer);
+			length = tpkt_read_header(view);
 		else /* Fast Path */
-			length = fastpath_read_header(transport->recv_buffer, NULL);
+			length = fastpath_read_header(view, NULL);
 
 		if (length == 0)
 		{
 			printf("transport_check_fds: protocol error, not a TPKT header (%d).\n", header);
+			transport_release_view(transport);
 			return -1;
 		}
 
 		if (pos < length)
-		{
-			stream_set_pos(transport->recv_buffer, pos);
-			return 0; /* Packet is not yet completely received. */
-		}
+			break; /* Packet is not yet completely received. */
 
 		/*
-		 * A complete packet has been received. In case there are trailing data
-		 * for the next packet, we copy it to the new receive buffer.
+		 * A complete packet has been received. The callback gets a view of it
+		 * inside the receive buffer, trailing data for the next packet stays in place.
 		 */
-		received = transport->recv_buffer;
-		transport->recv_buffer = stream_new(BUFFER_SIZE);
+		view->size = length;
+		stream_set_pos(view, 0);
+		transport->recv_offset += length;
 
-		if (pos > length)
-		{
-			stream_set_pos(received, length);
-			stream_check_size(transport->recv_buffer, pos - length);
-			stream_copy(transport->recv_buffer, received, pos - length);
-		}
-
-		stream_set_pos(received, length);
-		stream_seal(received);
-		stream_set_pos(received, 0);
-		status = transport->recv_callback(transport, received, transport->recv_extra);
-		stream_free(received);
+		status = transport->recv_callback(transport, view, transport->recv_extra);
+		transport_release_view(transport);
 
 		if (status < 0)
 			return status;
 	}
 
+	transport_release_view(transport);
+
+	/* rewind the buffer for free once everything received has been consumed */
+	if (transport->recv_offset == stream_get_pos(buffer))
+	{
+		transport->recv_offset = 0;
+		stream_set_pos(buffer, 0);
+	}
+
 	return 0;
 }
 
@@ -282,6 +454,17 @@ void transport_init(rdpTransport* transport)
 	transport->state = TRANSPORT_STATE_NEGO;
 }
 
+/**
+ * Set how long blocking reads and writes wait for the socket.
+ * @param transport transport
+ * @param timeout time limit in milliseconds, 0 waits without a time limit
+ */
+
+void transport_set_timeout(rdpTransport* transport, uint32 timeout)
+{
+	transport->timeout = (timeout > 0) ? (int) timeout : -1;
+}
+
 boolean transport_set_blocking_mode(rdpTransport* transport, boolean blocking)
 {
 	transport->blocking = blocking;
@@ -299,12 +482,12 @@ rdpTransport* transport_new(rdpSettings* settings)
 		transport->tcp = tcp_new(settings);
 		transport->settings = settings;
 
-		/* a small 0.1ms delay when transport is blocking. */
-		transport->ts.tv_sec = 0;
-		transport->ts.tv_nsec = 100000;
+		/* blocking reads and writes wait for the socket without a time limit */
+		transport->timeout = -1;
 
 		/* receive buffer for non-blocking read. */
 		transport->recv_buffer = stream_new(BUFFER_SIZE);
+		transport->recv_view = stream_new(0);
 
 		/* buffers for blocking read/write */
 		transport->recv_stream = stream_new(BUFFER_SIZE);
@@ -321,6 +504,8 @@ void transport_free(rdpTransport* transport)
 	if (transport != NULL)
 	{
 		stream_free(transport->recv_buffer);
+		xfree(transport->recv_view);
+		stream_free(transport->recv_retired);
 		stream_free(transport->recv_stream);
 		stream_free(transport->send_stream);
 		tcp_free(transport->tcp);
@@ -42,7 +42,6 @@ typedef struct rdp_transport rdpTransport;
 #include "tls.h"
 #include "credssp.h"
 
-#include <time.h>
 #include <freerdp/types.h>
 #include <freerdp/settings.h>
 #include <freerdp/utils/stream.h>
@@ -59,9 +58,12 @@ struct rdp_transport
 	struct rdp_tls* tls;
 	struct rdp_settings* settings;
 	struct rdp_credssp* credssp;
-	struct timespec ts;
+	int timeout;
 	void* recv_extra;
 	STREAM* recv_buffer;
+	STREAM* recv_view;
+	STREAM* recv_retired;
+	int recv_offset;
 	TransportRecv recv_callback;
 	boolean blocking;
 };
@@ -75,7 +77,9 @@ boolean transport_connect_tls(rdpTransport* transport);
 boolean transport_connect_nla(rdpTransport* transport);
 int transport_read(rdpTransport* transport, STREAM* s);
 int transport_write(rdpTransport* transport, STREAM* s);
+int transport_writev(rdpTransport* transport, struct iovec* iov, int iovcnt);
 int transport_check_fds(rdpTransport* transport);
+void transport_set_timeout(rdpTransport* transport, uint32 timeout);
 boolean transport_set_blocking_mode(rdpTransport* transport, boolean blocking);
 rdpTransport* transport_new(rdpSettings* settings);
 void transport_free(rdpTransport* transport);
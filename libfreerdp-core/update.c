@@ -45,11 +45,6 @@ void update_recv_orders(rdpUpdate* update, STREAM* s)
 
 void update_read_bitmap_data(STREAM* s, BITMAP_DATA* bitmap_data)
 {
-	uint8* srcData;
-	uint16 dstSize;
-	boolean status;
-	uint16 bytesPerPixel;
-
 	stream_read_uint16(s, bitmap_data->left);
 	stream_read_uint16(s, bitmap_data->top);
 	stream_read_uint16(s, bitmap_data->right);
@@ -60,40 +55,36 @@ void update_read_bitmap_data(STREAM* s, BITMAP_DATA* bitmap_data)
 	stream_read_uint16(s, bitmap_data->flags);
 	stream_read_uint16(s, bitmap_data->length);
 
-	bytesPerPixel = (bitmap_data->bpp + 7) / 8;
-
 	if (bitmap_data->flags & BITMAP_COMPRESSION)
 	{
 		uint16 cbCompMainBodySize;
-		uint16 cbUncompressedSize;
-
-		stream_seek_uint16(s); /* cbCompFirstRowSize (2 bytes) */
-		stream_read_uint16(s, cbCompMainBodySize); /* cbCompMainBodySize (2 bytes) */
-		stream_seek_uint16(s); /* cbScanWidth (2 bytes) */
-		stream_read_uint16(s, cbUncompressedSize); /* cbUncompressedSize (2 bytes) */
 
-		dstSize = cbUncompressedSize;
+		if (!(bitmap_data->flags & NO_BITMAP_COMPRESSION_HDR))
+		{
+			stream_seek_uint16(s); /* cbCompFirstRowSize (2 bytes) */
+			stream_read_uint16(s, cbCompMainBodySize); /* cbCompMainBodySize (2 bytes) */
+			stream_seek_uint16(s); /* cbScanWidth (2 bytes) */
+			stream_seek_uint16(s); /* cbUncompressedSize (2 bytes) */
+		}
+		else
+		{
+			cbCompMainBodySize = bitmap_data->length;
+		}
+
+		bitmap_data->compressed = True;
 		bitmap_data->length = cbCompMainBodySize;
-
-		bitmap_data->data = (uint8*) xzalloc(dstSize);
-
-		stream_get_mark(s, srcData);
-		stream_seek(s, bitmap_data->length);
-
-		status = bitmap_decompress(srcData, bitmap_data->data, bitmap_data->width, bitmap_data->height,
-				bitmap_data->length, bitmap_data->bpp, bitmap_data->bpp);
-
-		if (status != True)
-			printf("bitmap decompression failed, bpp:%d\n", bitmap_data->bpp);
 	}
 	else
 	{
-		stream_get_mark(s, srcData);
-		dstSize = bitmap_data->length;
-		stream_seek(s, bitmap_data->length);
-		bitmap_data->data = (uint8*) xzalloc(dstSize);
-		memcpy(bitmap_data->data, srcData, dstSize);
+		bitmap_data->compressed = False;
 	}
+
+	/*
+	 * The bitmap data is left in the stream, where it stays valid until the Bitmap
+	 * callback returns. It is decoded by the callback, directly into its destination.
+	 */
+	stream_get_mark(s, bitmap_data->data);
+	stream_seek(s, bitmap_data->length);
 }
 
 void update_read_bitmap(rdpUpdate* update, STREAM* s, BITMAP_UPDATE* bitmap_update)
@@ -102,7 +93,7 @@ void update_read_bitmap(rdpUpdate* update, STREAM* s, BITMAP_UPDATE* bitmap_upda
 
 	stream_read_uint16(s, bitmap_update->number); /* numberRectangles (2 bytes) */
 
-	bitmap_update->bitmaps = (BITMAP_DATA*) xzalloc(sizeof(BITMAP_DATA) * bitmap_update->number);
+	bitmap_update->bitmaps = (BITMAP_DATA*) freerdp_arena_alloc(update->arena, sizeof(BITMAP_DATA) * bitmap_update->number);
 
 	/* rectangles */
 	for (i = 0; i < bitmap_update->number; i++)
@@ -118,7 +109,7 @@ void update_read_palette(rdpUpdate* update, STREAM* s, PALETTE_UPDATE* palette_u
 	uint32 color;
 
 	stream_seek_uint16(s); /* pad2Octets (2 bytes) */
-	stream_seek_uint32(palette_update->number); /* numberColors (4 bytes), must be set to 256 */
+	stream_read_uint32(s, palette_update->number); /* numberColors (4 bytes), must be set to 256 */
 
 	if (palette_update->number > 256)
 		palette_update->number = 256;
@@ -180,6 +171,7 @@ void update_recv(rdpUpdate* update, STREAM* s)
 	}
 
 	IFCALL(update->EndPaint, update);
+	freerdp_arena_reset(update->arena);
 }
 
 rdpUpdate* update_new(rdpRdp* rdp)
@@ -191,6 +183,7 @@ rdpUpdate* update_new(rdpRdp* rdp)
 	if (update != NULL)
 	{
 		update->rdp = (void*) rdp;
+		update->arena = freerdp_arena_new(UPDATE_ARENA_SIZE);
 	}
 
 	return update;
@@ -200,6 +193,9 @@ void update_free(rdpUpdate* update)
 {
 	if (update != NULL)
 	{
+		freerdp_arena_free(update->arena);
+		xfree(update->polyline.points);
+		xfree(update->create_offscreen_bitmap.deleteList.indices);
 		xfree(update);
 	}
 }
@@ -25,6 +25,7 @@
 #include <freerdp/types.h>
 #include <freerdp/update.h>
 #include <freerdp/freerdp.h>
+#include <freerdp/utils/arena.h>
 #include <freerdp/utils/stream.h>
 
 #define UPDATE_TYPE_ORDERS		0x0000
@@ -35,6 +36,9 @@
 #define BITMAP_COMPRESSION		0x0001
 #define NO_BITMAP_COMPRESSION_HDR	0x0400
 
+/* initial size of the arena holding the data parsed from an update PDU */
+#define UPDATE_ARENA_SIZE		0x10000
+
 rdpUpdate* update_new(rdpRdp* rdp);
 void update_free(rdpUpdate* update);
 
@@ -71,10 +71,9 @@ boolean vchan_send(rdpVchan* vchan, uint16 channel_id, uint8* data, int size)
 
 		stream_write_uint32(s, chunk_size);
 		stream_write_uint32(s, flags);
-		stream_check_size(s, chunk_size);
-		stream_write(s, data, chunk_size);
 
-		rdp_send(vchan->instance->rdp, s, channel_id);
+		/* the chunk is sent from the caller's buffer, only the headers go through the stream */
+		rdp_sendv(vchan->instance->rdp, s, data, chunk_size, channel_id);
 
 		data += chunk_size;
 		size -= chunk_size;
@@ -89,13 +88,25 @@ void vchan_process(rdpVchan* vchan, STREAM* s, uint16 channel_id)
 	uint32 length;
 	uint32 flags;
 	int chunk_length;
+	uint8* chunk;
 
 	stream_read_uint32(s, length);
 	stream_read_uint32(s, flags);
 	chunk_length = stream_get_left(s);
+	chunk = stream_get_tail(s);
+
+	if (flags & (CHANNEL_PACKET_COMPRESSED | CHANNEL_PACKET_AT_FRONT | CHANNEL_PACKET_FLUSHED))
+	{
+		/* the compression flags have the same layout as the share data header compressedType */
+		if (mppc_decompress(((rdpRdp*) vchan->instance->rdp)->mppc, chunk, chunk_length,
+				(uint8) ((flags >> 16) & 0xFF), &chunk, &chunk_length) != True)
+			return;
+
+		flags &= ~CHANNEL_PACKET_COMPR_MASK;
+	}
 
 	IFCALL(vchan->instance->ReceiveChannelData, vchan->instance,
-		channel_id, stream_get_tail(s), chunk_length, flags, length);
+		channel_id, chunk, chunk_length, flags, length);
 }
 
 rdpVchan* vchan_new(freerdp* instance)
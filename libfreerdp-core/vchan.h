@@ -20,6 +20,12 @@
 #ifndef __VCHAN_H
 #define __VCHAN_H
 
+/* Channel PDU compression flags, the compression type is in bits 16-19 */
+#define CHANNEL_PACKET_COMPRESSED	0x00200000
+#define CHANNEL_PACKET_AT_FRONT		0x00400000
+#define CHANNEL_PACKET_FLUSHED		0x00800000
+#define CHANNEL_PACKET_COMPR_MASK	0x00EF0000
+
 struct rdp_vchan
 {
 	freerdp* instance;
@@ -22,6 +22,8 @@
 #include <stdlib.h>
 #include <freerdp/freerdp.h>
 
+#include <freerdp/utils/cpu.h>
+
 #include "color.h"
 
 uint32 gdi_color_convert_rgb(uint32 srcColor, int srcBpp, int dstBpp, HCLRCONV clrconv)
@@ -194,148 +196,590 @@ uint32 gdi_color_convert_bgr(uint32 srcColor, int srcBpp, int dstBpp, HCLRCONV c
 
 uint32 gdi_color_convert(uint32 srcColor, int srcBpp, int dstBpp, HCLRCONV clrconv)
 {
+	uint32* palette;
+
+	if (srcBpp == 8)
+	{
+		palette = gdi_color_get_palette(clrconv, dstBpp);
+
+		if (palette != NULL)
+			return palette[srcColor & 0xFF];
+	}
+
 	if (clrconv->invert)
 		return gdi_color_convert_bgr(srcColor, srcBpp, dstBpp, clrconv);
 	else
 		return gdi_color_convert_rgb(srcColor, srcBpp, dstBpp, clrconv);
 }
 
-uint8* gdi_image_convert_8bpp(uint8* srcData, uint8* dstData, int width, int height, int srcBpp, int dstBpp, HCLRCONV clrconv)
+/**
+ * Scanline color conversion kernels.\n
+ * Each kernel converts count pixels from src to dst, the options of the color converter
+ * being resolved once per image when the kernel is selected rather than once per pixel.
+ * 8bpp pixels are looked up in the palette table of the destination format.
+ */
+
+typedef void (*p_gdi_convert_row)(uint8* dst, uint8* src, int count, uint32* palette);
+
+static void gdi_convert_row_8_16(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		((uint16*) dst)[i] = (uint16) palette[src[i]];
+}
+
+static void gdi_convert_row_8_32(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		((uint32*) dst)[i] = palette[src[i]];
+}
+
+static void gdi_convert_row_copy16(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	memcpy(dst, src, count * 2);
+}
+
+static void gdi_convert_row_copy32(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	memcpy(dst, src, count * 4);
+}
+
+/**
+ * RGB565 to XRGB32, the alpha byte is cleared.
+ */
+
+static void gdi_convert_row_16_32_c(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	uint16 pixel;
+	uint8 red, green, blue;
+
+	for (i = 0; i < count; i++)
+	{
+		pixel = ((uint16*) src)[i];
+		GetBGR16(red, green, blue, pixel);
+		((uint32*) dst)[i] = BGR32(red, green, blue);
+	}
+}
+
+/**
+ * RGB555 to XRGB32, the alpha byte is cleared.
+ */
+
+static void gdi_convert_row_15_32_c(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	uint16 pixel;
+	uint8 red, green, blue;
+
+	for (i = 0; i < count; i++)
+	{
+		pixel = ((uint16*) src)[i];
+		GetRGB15(red, green, blue, pixel);
+		((uint32*) dst)[i] = RGB32(red, green, blue);
+	}
+}
+
+/**
+ * RGB24 to XRGB32, the bytes of each pixel are kept in order and the alpha byte is cleared.
+ */
+
+static void gdi_convert_row_24_32_c(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	uint8 red, green, blue;
+
+	for (i = 0; i < count; i++)
+	{
+		red = src[i * 3];
+		green = src[i * 3 + 1];
+		blue = src[i * 3 + 2];
+		((uint32*) dst)[i] = BGR24(red, green, blue);
+	}
+}
+
+/**
+ * XRGB32 to RGB565.
+ */
+
+static void gdi_convert_row_32_16_c(uint8* dst, uint8* src, int count, uint32* palette)
 {
 	int i;
-	uint8 red;
-	uint8 green;
-	uint8 blue;
 	uint32 pixel;
-	uint8 *src8;
-	uint16 *dst16;
-	uint32 *dst32;
+	uint8 red, green, blue;
 
-	if (dstBpp == 8)
+	for (i = 0; i < count; i++)
 	{
-		if (dstData == NULL)
-			dstData = (uint8*) malloc(width * height);
+		pixel = ((uint32*) src)[i];
+		GetBGR32(blue, green, red, pixel);
+		((uint16*) dst)[i] = RGB16(red, green, blue);
+	}
+}
 
-		memcpy(dstData, srcData, width * height);
-		return dstData;
+/**
+ * RGB565 to RGB555.
+ */
+
+static void gdi_convert_row_16_15_c(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	uint16 pixel;
+	uint8 red, green, blue;
+
+	for (i = 0; i < count; i++)
+	{
+		pixel = ((uint16*) src)[i];
+		GetRGB_565(red, green, blue, pixel);
+		RGB_565_555(red, green, blue);
+		((uint16*) dst)[i] = RGB555(red, green, blue);
 	}
-	else if (dstBpp == 15 || (dstBpp == 16 && clrconv->rgb555))
+}
+
+/**
+ * RGB555 to RGB565.
+ */
+
+static void gdi_convert_row_15_16_c(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	uint16 pixel;
+	uint8 red, green, blue;
+
+	for (i = 0; i < count; i++)
 	{
-		if (dstData == NULL)
-			dstData = (uint8*) malloc(width * height * 2);
-		
-		dst16 = (uint16 *) dstData;
-		for (i = width * height; i > 0; i--)
-		{
-			pixel = *srcData;
-			srcData++;
-			red = clrconv->palette->entries[pixel].red;
-			green = clrconv->palette->entries[pixel].green;
-			blue = clrconv->palette->entries[pixel].blue;
-			pixel = RGB15(red, green, blue);
-			*dst16 = pixel;
-			dst16++;
-		}
-		return dstData;
+		pixel = ((uint16*) src)[i];
+		GetRGB_555(red, green, blue, pixel);
+		RGB_555_565(red, green, blue);
+		((uint16*) dst)[i] = RGB565(red, green, blue);
 	}
-	else if (dstBpp == 16)
+}
+
+/**
+ * XRGB32 to ARGB32 with an opaque alpha byte.
+ */
+
+static void gdi_convert_row_32_alpha_c(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
 	{
-		if (dstData == NULL)
-			dstData = (uint8*) malloc(width * height * 2);
-		
-		dst16 = (uint16 *) dstData;
-		for (i = width * height; i > 0; i--)
-		{
-			pixel = *srcData;
-			srcData++;
-			red = clrconv->palette->entries[pixel].red;
-			green = clrconv->palette->entries[pixel].green;
-			blue = clrconv->palette->entries[pixel].blue;
-			pixel = RGB16(red, green, blue);
-			*dst16 = pixel;
-			dst16++;
-		}
-		return dstData;
+		dst[i * 4] = src[i * 4];
+		dst[i * 4 + 1] = src[i * 4 + 1];
+		dst[i * 4 + 2] = src[i * 4 + 2];
+		dst[i * 4 + 3] = 0xFF;
 	}
-	else if (dstBpp == 32)
+}
+
+#ifdef WITH_SSE2
+
+static void gdi_convert_row_16_32_sse2(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	__m128i p, r, g, b, lo, hi;
+	const __m128i mask5 = _mm_set1_epi16(0x1F);
+	const __m128i mask6 = _mm_set1_epi16(0x3F);
+
+	for (i = 0; i + 8 <= count; i += 8)
 	{
-		if (dstData == NULL)
-			dstData = (uint8*) malloc(width * height * 4);
-		
-		src8 = (uint8*) srcData;
-		dst32 = (uint32*) dstData;
-		for (i = width * height; i > 0; i--)
+		p = _mm_loadu_si128((__m128i*) &src[i * 2]);
+
+		r = _mm_srli_epi16(p, 11);
+		g = _mm_and_si128(_mm_srli_epi16(p, 5), mask6);
+		b = _mm_and_si128(p, mask5);
+
+		r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+		g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+		b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+		/* green and blue in the low word, red in the high word */
+		lo = _mm_or_si128(_mm_slli_epi16(g, 8), b);
+		hi = r;
+
+		_mm_storeu_si128((__m128i*) &dst[i * 4], _mm_unpacklo_epi16(lo, hi));
+		_mm_storeu_si128((__m128i*) &dst[i * 4 + 16], _mm_unpackhi_epi16(lo, hi));
+	}
+
+	gdi_convert_row_16_32_c(&dst[i * 4], &src[i * 2], count - i, palette);
+}
+
+static void gdi_convert_row_15_32_sse2(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	__m128i p, r, g, b, lo, hi;
+	const __m128i mask5 = _mm_set1_epi16(0x1F);
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		p = _mm_loadu_si128((__m128i*) &src[i * 2]);
+
+		r = _mm_and_si128(_mm_srli_epi16(p, 10), mask5);
+		g = _mm_and_si128(_mm_srli_epi16(p, 5), mask5);
+		b = _mm_and_si128(p, mask5);
+
+		r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+		g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+		b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+		lo = _mm_or_si128(_mm_slli_epi16(g, 8), b);
+		hi = r;
+
+		_mm_storeu_si128((__m128i*) &dst[i * 4], _mm_unpacklo_epi16(lo, hi));
+		_mm_storeu_si128((__m128i*) &dst[i * 4 + 16], _mm_unpackhi_epi16(lo, hi));
+	}
+
+	gdi_convert_row_15_32_c(&dst[i * 4], &src[i * 2], count - i, palette);
+}
+
+static void gdi_convert_row_24_32_sse2(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	__m128i p, q;
+	const __m128i mask0 = _mm_set_epi32(0, 0, 0, 0x00FFFFFF);
+	const __m128i mask1 = _mm_set_epi32(0, 0, 0x00FFFFFF, 0);
+	const __m128i mask2 = _mm_set_epi32(0, 0x00FFFFFF, 0, 0);
+	const __m128i mask3 = _mm_set_epi32(0x00FFFFFF, 0, 0, 0);
+
+	/* each 16 byte load holds four pixels, pixel n being moved up by n bytes into lane n */
+	for (i = 0; i + 6 <= count; i += 4)
+	{
+		p = _mm_loadu_si128((__m128i*) &src[i * 3]);
+
+		q = _mm_and_si128(p, mask0);
+		q = _mm_or_si128(q, _mm_and_si128(_mm_slli_si128(p, 1), mask1));
+		q = _mm_or_si128(q, _mm_and_si128(_mm_slli_si128(p, 2), mask2));
+		q = _mm_or_si128(q, _mm_and_si128(_mm_slli_si128(p, 3), mask3));
+
+		_mm_storeu_si128((__m128i*) &dst[i * 4], q);
+	}
+
+	gdi_convert_row_24_32_c(&dst[i * 4], &src[i * 3], count - i, palette);
+}
+
+static void gdi_convert_row_32_16_sse2(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i, k;
+	__m128i p, q[2];
+	const __m128i maskR = _mm_set1_epi32(0xF800);
+	const __m128i maskG = _mm_set1_epi32(0x07E0);
+	const __m128i maskB = _mm_set1_epi32(0x001F);
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		for (k = 0; k < 2; k++)
 		{
-			pixel = *src8;
-			src8++;
-			red = clrconv->palette->entries[pixel].red;
-			green = clrconv->palette->entries[pixel].green;
-			blue = clrconv->palette->entries[pixel].blue;
-			pixel = BGR32(red, green, blue);
-			*dst32 = pixel;
-			dst32++;
+			p = _mm_loadu_si128((__m128i*) &src[(i + k * 4) * 4]);
+
+			q[k] = _mm_or_si128(_mm_or_si128(
+				_mm_and_si128(_mm_srli_epi32(p, 8), maskR),
+				_mm_and_si128(_mm_srli_epi32(p, 5), maskG)),
+				_mm_and_si128(_mm_srli_epi32(p, 3), maskB));
+
+			/* sign extend the low word so the saturating pack keeps it intact */
+			q[k] = _mm_srai_epi32(_mm_slli_epi32(q[k], 16), 16);
 		}
-		return dstData;
+
+		_mm_storeu_si128((__m128i*) &dst[i * 2], _mm_packs_epi32(q[0], q[1]));
 	}
 
-	return srcData;
+	gdi_convert_row_32_16_c(&dst[i * 2], &src[i * 4], count - i, palette);
 }
 
-uint8* gdi_image_convert_15bpp(uint8* srcData, uint8* dstData, int width, int height, int srcBpp, int dstBpp, HCLRCONV clrconv)
+static void gdi_convert_row_16_15_sse2(uint8* dst, uint8* src, int count, uint32* palette)
 {
 	int i;
-	uint8 red;
-	uint8 green;
-	uint8 blue;
-	uint32 pixel;
-	uint16 *src16;
-	uint16 *dst16;
-	uint32 *dst32;
+	__m128i p;
+	const __m128i maskRG = _mm_set1_epi16(0x7FE0);
+	const __m128i maskB = _mm_set1_epi16(0x001F);
 
-	if (dstBpp == 15 || (dstBpp == 16 && clrconv->rgb555))
+	for (i = 0; i + 8 <= count; i += 8)
 	{
-		if (dstData == NULL)
-			dstData = (uint8*) malloc(width * height * 2);
+		p = _mm_loadu_si128((__m128i*) &src[i * 2]);
+		p = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(p, 1), maskRG), _mm_and_si128(p, maskB));
+		_mm_storeu_si128((__m128i*) &dst[i * 2], p);
+	}
 
-		memcpy(dstData, srcData, width * height * 2);
+	gdi_convert_row_16_15_c(&dst[i * 2], &src[i * 2], count - i, palette);
+}
 
-		return dstData;
+static void gdi_convert_row_15_16_sse2(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	__m128i p, g;
+	const __m128i maskR = _mm_set1_epi16(0x7C00);
+	const __m128i mask5 = _mm_set1_epi16(0x001F);
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		p = _mm_loadu_si128((__m128i*) &src[i * 2]);
+
+		g = _mm_and_si128(_mm_srli_epi16(p, 5), mask5);
+		g = _mm_or_si128(_mm_slli_epi16(g, 1), _mm_srli_epi16(g, 4));
+
+		p = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_and_si128(p, maskR), 1),
+			_mm_slli_epi16(g, 5)), _mm_and_si128(p, mask5));
+
+		_mm_storeu_si128((__m128i*) &dst[i * 2], p);
 	}
-	else if (dstBpp == 32)
+
+	gdi_convert_row_15_16_c(&dst[i * 2], &src[i * 2], count - i, palette);
+}
+
+static void gdi_convert_row_32_alpha_sse2(uint8* dst, uint8* src, int count, uint32* palette)
+{
+	int i;
+	const __m128i alpha = _mm_set1_epi32((int) 0xFF000000);
+
+	for (i = 0; i + 4 <= count; i += 4)
 	{
-		if (dstData == NULL)
-			dstData = (uint8*) malloc(width * height * 4);
-		
-		src16 = (uint16 *) srcData;
-		dst32 = (uint32 *) dstData;
-		for (i = width * height; i > 0; i--)
+		_mm_storeu_si128((__m128i*) &dst[i * 4],
+			_mm_or_si128(_mm_loadu_si128((__m128i*) &src[i * 4]), alpha));
+	}
+
+	gdi_convert_row_32_alpha_c(&dst[i * 4], &src[i * 4], count - i, palette);
+}
+
+#endif
+
+/* conversion kernels with a vector variant, the scalar ones until gdi_color_init() selects others */
+static p_gdi_convert_row convert_row_16_32 = gdi_convert_row_16_32_c;
+static p_gdi_convert_row convert_row_15_32 = gdi_convert_row_15_32_c;
+static p_gdi_convert_row convert_row_24_32 = gdi_convert_row_24_32_c;
+static p_gdi_convert_row convert_row_32_16 = gdi_convert_row_32_16_c;
+static p_gdi_convert_row convert_row_16_15 = gdi_convert_row_16_15_c;
+static p_gdi_convert_row convert_row_15_16 = gdi_convert_row_15_16_c;
+static p_gdi_convert_row convert_row_32_alpha = gdi_convert_row_32_alpha_c;
+
+/**
+ * Select the scanline conversion kernels for the instruction sets of the processor.
+ * @param features CPU_* feature flags, zero for the scalar kernels
+ */
+
+void gdi_color_init(uint32 features)
+{
+	convert_row_16_32 = gdi_convert_row_16_32_c;
+	convert_row_15_32 = gdi_convert_row_15_32_c;
+	convert_row_24_32 = gdi_convert_row_24_32_c;
+	convert_row_32_16 = gdi_convert_row_32_16_c;
+	convert_row_16_15 = gdi_convert_row_16_15_c;
+	convert_row_15_16 = gdi_convert_row_15_16_c;
+	convert_row_32_alpha = gdi_convert_row_32_alpha_c;
+
+#ifdef WITH_SSE2
+	if (features & CPU_SSE2)
+	{
+		convert_row_16_32 = gdi_convert_row_16_32_sse2;
+		convert_row_15_32 = gdi_convert_row_15_32_sse2;
+		convert_row_24_32 = gdi_convert_row_24_32_sse2;
+		convert_row_32_16 = gdi_convert_row_32_16_sse2;
+		convert_row_16_15 = gdi_convert_row_16_15_sse2;
+		convert_row_15_16 = gdi_convert_row_15_16_sse2;
+		convert_row_32_alpha = gdi_convert_row_32_alpha_sse2;
+	}
+#endif
+}
+
+/**
+ * Select the scanline kernel converting between two color depths.
+ * @return scanline kernel, NULL if the conversion has no kernel
+ */
+
+static p_gdi_convert_row gdi_get_convert_row(int srcBpp, int dstBpp, HCLRCONV clrconv)
+{
+	boolean rgb555 = (dstBpp == 15 || (dstBpp == 16 && clrconv->rgb555)) ? True : False;
+
+	if (srcBpp == 8)
+	{
+		if (clrconv->palette == NULL)
+			return NULL;
+		else if (dstBpp == 15 || dstBpp == 16)
+			return gdi_convert_row_8_16;
+		else if (dstBpp == 32)
+			return gdi_convert_row_8_32;
+	}
+	else if (srcBpp == 15)
+	{
+		if (rgb555)
+			return gdi_convert_row_copy16;
+		else if (dstBpp == 16)
+			return convert_row_15_16;
+		else if (dstBpp == 32)
+			return convert_row_15_32;
+	}
+	else if (srcBpp == 16)
+	{
+		if (rgb555)
+			return convert_row_16_15;
+		else if (dstBpp == 16)
+			return gdi_convert_row_copy16;
+		else if (dstBpp == 32)
+			return convert_row_16_32;
+	}
+	else if (srcBpp == 24)
+	{
+		if (dstBpp == 32)
+			return convert_row_24_32;
+	}
+	else if (srcBpp == 32)
+	{
+		if (dstBpp == 16)
+			return convert_row_32_16;
+		else if (dstBpp == 32)
+			return (clrconv->alpha) ? convert_row_32_alpha : gdi_convert_row_copy32;
+	}
+
+	return NULL;
+}
+
+/**
+ * Convert an image between two color depths, scanline by scanline.\n
+ * The destination is written in place, the strides allowing the conversion of
+ * bottom-up images and of images within a larger bitmap.
+ * @param srcData top-left pixel of the source
+ * @param srcStride distance in bytes between two source scanlines, negative for bottom-up images
+ * @param dstData top-left pixel of the destination
+ * @param dstStride distance in bytes between two destination scanlines
+ * @param width image width
+ * @param height image height
+ * @param srcBpp source color depth
+ * @param dstBpp destination color depth
+ * @param clrconv color converter
+ * @return True if the conversion is supported and was done, False otherwise
+ */
+
+boolean gdi_image_convert_ex(uint8* srcData, int srcStride, uint8* dstData, int dstStride,
+		int width, int height, int srcBpp, int dstBpp, HCLRCONV clrconv)
+{
+	int y;
+	uint32* palette;
+	p_gdi_convert_row convert_row;
+
+	convert_row = gdi_get_convert_row(srcBpp, dstBpp, clrconv);
+
+	if (convert_row == NULL)
+		return False;
+
+	palette = gdi_color_get_palette(clrconv, dstBpp);
+
+	for (y = 0; y < height; y++)
+		convert_row(&dstData[y * dstStride], &srcData[y * srcStride], width, palette);
+
+	return True;
+}
+
+/**
+ * Select the palette of a color converter.\n
+ * The palette colors are converted once to each destination format, 8bpp pixels then
+ * converting with a single table lookup. The tables must be rebuilt whenever the palette
+ * entries or the color converter options change.
+ * @param clrconv color converter
+ * @param palette palette, NULL for none
+ */
+
+void gdi_color_set_palette(HCLRCONV clrconv, FRDP_PALETTE* palette)
+{
+	int i;
+
+	clrconv->palette = palette;
+
+	memset(clrconv->palette32, 0, sizeof(clrconv->palette32));
+	memset(clrconv->palette16, 0, sizeof(clrconv->palette16));
+	memset(clrconv->palette15, 0, sizeof(clrconv->palette15));
+
+	if (palette == NULL)
+		return;
+
+	for (i = 0; i < palette->count && i < 256; i++)
+	{
+		if (clrconv->invert)
 		{
-			pixel = *src16;
-			src16++;
-			GetBGR16(red, green, blue, pixel);
-			pixel = BGR32(red, green, blue);
-			*dst32 = pixel;
-			dst32++;
+			clrconv->palette32[i] = gdi_color_convert_bgr(i, 8, 32, clrconv);
+			clrconv->palette16[i] = gdi_color_convert_bgr(i, 8, 16, clrconv);
+			clrconv->palette15[i] = gdi_color_convert_bgr(i, 8, 15, clrconv);
+		}
+		else
+		{
+			clrconv->palette32[i] = gdi_color_convert_rgb(i, 8, 32, clrconv);
+			clrconv->palette16[i] = gdi_color_convert_rgb(i, 8, 16, clrconv);
+			clrconv->palette15[i] = gdi_color_convert_rgb(i, 8, 15, clrconv);
 		}
-		return dstData;
 	}
+}
+
+/**
+ * Get the palette colors converted to a destination format.
+ * @param clrconv color converter
+ * @param dstBpp destination color depth
+ * @return 256 entry color table, NULL if there is no palette or no table for this color depth
+ */
+
+uint32* gdi_color_get_palette(HCLRCONV clrconv, int dstBpp)
+{
+	if (clrconv->palette == NULL)
+		return NULL;
+
+	if (dstBpp == 32)
+		return clrconv->palette32;
 	else if (dstBpp == 16)
+		return clrconv->palette16;
+	else if (dstBpp == 15)
+		return clrconv->palette15;
+
+	return NULL;
+}
+
+uint8* gdi_image_convert_8bpp(uint8* srcData, uint8* dstData, int width, int height, int srcBpp, int dstBpp, HCLRCONV clrconv)
+{
+	uint32* palette;
+
+	if (dstBpp == 8)
+	{
+		if (dstData == NULL)
+			dstData = (uint8*) malloc(width * height);
+
+		memcpy(dstData, srcData, width * height);
+		return dstData;
+	}
+
+	palette = gdi_color_get_palette(clrconv, dstBpp);
+
+	if (palette == NULL)
+		return srcData;
+
+	if (dstBpp == 15 || dstBpp == 16)
 	{
 		if (dstData == NULL)
 			dstData = (uint8*) malloc(width * height * 2);
-	
-		src16 = (uint16 *) srcData;
-		dst16 = (uint16 *) dstData;
-		for (i = width * height; i > 0; i--)
-		{
-			pixel = *src16;
-			src16++;
-			GetRGB_555(red, green, blue, pixel);
-			RGB_555_565(red, green, blue);
-			pixel = RGB565(red, green, blue);
-			*dst16 = pixel;
-			dst16++;
-		}
+
+		gdi_convert_row_8_16(dstData, srcData, width * height, palette);
+	}
+	else
+	{
+		if (dstData == NULL)
+			dstData = (uint8*) malloc(width * height * 4);
+
+		gdi_convert_row_8_32(dstData, srcData, width * height, palette);
+	}
+
+	return dstData;
+}
+
+uint8* gdi_image_convert_15bpp(uint8* srcData, uint8* dstData, int width, int height, int srcBpp, int dstBpp, HCLRCONV clrconv)
+{
+	p_gdi_convert_row convert_row;
+
+	if (dstBpp == 15 || dstBpp == 16 || dstBpp == 32)
+	{
+		convert_row = gdi_get_convert_row(15, dstBpp, clrconv);
+
+		if (dstData == NULL)
+			dstData = (uint8*) malloc(width * height * ((dstBpp + 1) / 8));
+
+		convert_row(dstData, srcData, width * height, NULL);
+
 		return dstData;
 	}
 
@@ -352,26 +796,10 @@ uint8* gdi_image_convert_16bpp(uint8* srcData, uint8* dstData, int width, int he
 		if (dstData == NULL)
 			dstData = (uint8*) malloc(width * height * 2);
 
-		if(clrconv->rgb555)
-		{
-			int i;
-			uint8 red, green, blue;
-			uint16* src16 = (uint16 *) srcData;
-			uint16* dst16 = (uint16 *) dstData;
-
-			for (i = width * height; i > 0; i--)
-			{
-				GetRGB_565(red, green, blue, (*src16));
-				RGB_565_555(red, green, blue);
-				(*dst16) = RGB555(red, green, blue);
-				src16++;
-				dst16++;
-			}
-		}
+		if (clrconv->rgb555)
+			convert_row_16_15(dstData, srcData, width * height, NULL);
 		else
-		{
 			memcpy(dstData, srcData, width * height * 2);
-		}
 
 		return dstData;
 	}
@@ -409,26 +837,11 @@ uint8* gdi_image_convert_16bpp(uint8* srcData, uint8* dstData, int width, int he
 	}
 	else if (dstBpp == 32)
 	{
-		int i;
-		uint32 pixel;
-		uint16 *src16;
-		uint32 *dst32;
-		uint8 red, green, blue;
-
 		if (dstData == NULL)
 			dstData = (uint8*) malloc(width * height * 4);
 
-		src16 = (uint16 *) srcData;
-		dst32 = (uint32 *) dstData;
-		for (i = width * height; i > 0; i--)
-		{
-			pixel = *src16;
-			src16++;
-			GetBGR16(red, green, blue, pixel);
-			pixel = BGR32(red, green, blue);
-			*dst32 = pixel;
-			dst32++;
-		}
+		convert_row_16_32(dstData, srcData, width * height, NULL);
+
 		return dstData;
 	}
 
@@ -437,28 +850,13 @@ uint8* gdi_image_convert_16bpp(uint8* srcData, uint8* dstData, int width, int he
 
 uint8* gdi_image_convert_24bpp(uint8* srcData, uint8* dstData, int width, int height, int srcBpp, int dstBpp, HCLRCONV clrconv)
 {
-	int i;
-	uint8 red;
-	uint8 green;
-	uint8 blue;
-	uint32 pixel;
-	uint32 *dst32;
-
 	if (dstBpp == 32)
 	{
 		if (dstData == NULL)
 			dstData = (uint8*) malloc(width * height * 4);
-		
-		dst32 = (uint32 *) dstData;
-		for (i = width * height; i > 0; i--)
-		{
-			red = *(srcData++);
-			green = *(srcData++);
-			blue = *(srcData++);
-			pixel = BGR24(red, green, blue);
-			*dst32 = pixel;
-			dst32++;
-		}
+
+		convert_row_24_32(dstData, srcData, width * height, NULL);
+
 		return dstData;
 	}
 
@@ -469,24 +867,11 @@ uint8* gdi_image_convert_32bpp(uint8* srcData, uint8* dstData, int width, int he
 {
 	if (dstBpp == 16)
 	{
-		int index;
-		uint16 *dst16;
-		uint32 *src32;
-		uint8 red, green, blue;
-
 		if (dstData == NULL)
 			dstData = (uint8*) malloc(width * height * 2);
 
-		dst16 = (uint16*) dstData;
-		src32 = (uint32*) srcData;
+		convert_row_32_16(dstData, srcData, width * height, NULL);
 
-		for (index = 0; index < width * height; index++)
-		{
-			GetBGR32(blue, green, red, *src32);
-			*dst16 = RGB16(red, green, blue);
-			src32++;
-			dst16++;
-		}
 		return dstData;
 	}
 	else if (dstBpp == 24)
@@ -522,35 +907,14 @@ uint8* gdi_image_convert_32bpp(uint8* srcData, uint8* dstData, int width, int he
 	}
 	else if (dstBpp == 32)
 	{
-		if (clrconv->alpha)
-		{
-			int x, y;
-			uint8 *dstp;
-
-			if (dstData == NULL)
-				dstData = (uint8*) malloc(width * height * 4);
-
-			memcpy(dstData, srcData, width * height * 4);
+		if (dstData == NULL)
+			dstData = (uint8*) malloc(width * height * 4);
 
-			dstp = dstData;
-			for (y = 0; y < height; y++)
-			{
-				for (x = 0; x < width * 4; x += 4)
-				{
-					dstp += 3;
-					*dstp = 0xFF;
-					dstp++;
-				}
-			}
-		}
+		if (clrconv->alpha)
+			convert_row_32_alpha(dstData, srcData, width * height, NULL);
 		else
-		{
-			if (dstData == NULL)
-				dstData = (uint8*) malloc(width * height * 4);
-
 			memcpy(dstData, srcData, width * height * 4);
-		}
-		
+
 		return dstData;
 	}
 
@@ -614,26 +978,39 @@ gdi_glyph_convert(int width, int height, uint8* data)
 	return dstData;
 }
 
-uint8* gdi_mono_image_convert(uint8* srcData, int width, int height, int srcBpp, int dstBpp, uint32 bgcolor, uint32 fgcolor, HCLRCONV clrconv)
+uint8* gdi_mono_image_convert(uint8* srcData, uint8* dstData, int width, int height, int srcBpp, int dstBpp, uint32 bgcolor, uint32 fgcolor, HCLRCONV clrconv)
 {
 	int index;
 	uint16* dst16;
 	uint32* dst32;
-	uint8* dstData;
 	uint8 bitMask;
 	int bitIndex;
+	uint32* palette;
 	uint8 redBg, greenBg, blueBg;
 	uint8 redFg, greenFg, blueFg;
 
+	redBg = greenBg = blueBg = 0;
+	redFg = greenFg = blueFg = 0;
+	palette = (srcBpp == 8) ? gdi_color_get_palette(clrconv, dstBpp) : NULL;
+
 	switch (srcBpp)
 	{
 		case 8:
 			bgcolor &= 0xFF;
+			fgcolor &= 0xFF;
+
+			if (palette != NULL)
+			{
+				/* the colors are already in the destination format */
+				bgcolor = palette[bgcolor];
+				fgcolor = palette[fgcolor];
+				break;
+			}
+
 			redBg = clrconv->palette->entries[bgcolor].red;
 			greenBg = clrconv->palette->entries[bgcolor].green;
 			blueBg = clrconv->palette->entries[bgcolor].blue;
 
-			fgcolor &= 0xFF;
 			redFg = clrconv->palette->entries[fgcolor].red;
 			greenFg = clrconv->palette->entries[fgcolor].green;
 			blueFg = clrconv->palette->entries[fgcolor].blue;
@@ -673,7 +1050,9 @@ uint8* gdi_mono_image_convert(uint8* srcData, int width, int height, int srcBpp,
 			}
 		}
 
-		dstData = (uint8*) malloc(width * height * 2);
+		if (dstData == NULL)
+			dstData = (uint8*) malloc(width * height * 2);
+
 		dst16 = (uint16*) dstData;
 		for(index = height; index > 0; index--)
 		{
@@ -697,7 +1076,15 @@ uint8* gdi_mono_image_convert(uint8* srcData, int width, int height, int srcBpp,
 	}
 	else if(dstBpp == 32)
 	{
-		dstData = (uint8*) malloc(width * height * 4);
+		if (palette == NULL)
+		{
+			bgcolor = RGB32(redBg, greenBg, blueBg);
+			fgcolor = RGB32(redFg, greenFg, blueFg);
+		}
+
+		if (dstData == NULL)
+			dstData = (uint8*) malloc(width * height * 4);
+
 		dst32 = (uint32*) dstData;
 		for(index = height; index > 0; index--)
 		{
@@ -707,11 +1094,11 @@ uint8* gdi_mono_image_convert(uint8* srcData, int width, int height, int srcBpp,
 			{
 				if((bitMask >> bitIndex) & 0x01)
 				{
-					*dst32 = RGB32(redBg, greenBg, blueBg);
+					*dst32 = bgcolor;
 				}
 				else
 				{
-					*dst32 = RGB32(redFg, greenFg, blueFg);
+					*dst32 = fgcolor;
 				}
 				dst32++;
 			}
@@ -221,12 +221,20 @@ extern "C" {
 #define CLRBUF_16BPP		8
 #define	CLRBUF_32BPP		16
 
+/* Drawing orders are recorded and rasterized in parallel by gdi_end_paint() */
+#define GDI_PARALLEL_ORDERS	32
+
 struct _CLRCONV
 {
 	int alpha;
 	int invert;
 	int rgb555;
 	FRDP_PALETTE* palette;
+
+	/* palette colors in the 32, 16 and 15 bpp destination formats, see gdi_color_set_palette */
+	uint32 palette32[256];
+	uint32 palette16[256];
+	uint32 palette15[256];
 };
 typedef struct _CLRCONV CLRCONV;
 typedef CLRCONV* HCLRCONV;
@@ -235,10 +243,15 @@ typedef CLRCONV* HCLRCONV;
 
 typedef uint8* (*p_gdi_image_convert)(uint8* srcData, uint8* dstData, int width, int height, int srcBpp, int dstBpp, HCLRCONV clrconv);
 
+void gdi_color_init(uint32 features);
 uint32 gdi_color_convert(uint32 srcColor, int srcBpp, int dstBpp, HCLRCONV clrconv);
+void gdi_color_set_palette(HCLRCONV clrconv, FRDP_PALETTE* palette);
+uint32* gdi_color_get_palette(HCLRCONV clrconv, int dstBpp);
 uint8* gdi_image_convert(uint8* srcData, uint8 *dstData, int width, int height, int srcBpp, int dstBpp, HCLRCONV clrconv);
+boolean gdi_image_convert_ex(uint8* srcData, int srcStride, uint8* dstData, int dstStride,
+		int width, int height, int srcBpp, int dstBpp, HCLRCONV clrconv);
 uint8* gdi_glyph_convert(int width, int height, uint8* data);
-uint8* gdi_mono_image_convert(uint8* srcData, int width, int height, int srcBpp, int dstBpp, uint32 bgcolor, uint32 fgcolor, HCLRCONV clrconv);
+uint8* gdi_mono_image_convert(uint8* srcData, uint8* dstData, int width, int height, int srcBpp, int dstBpp, uint32 bgcolor, uint32 fgcolor, HCLRCONV clrconv);
 
 #ifdef __cplusplus
 }
@@ -21,16 +21,21 @@
 #include <string.h>
 #include <stdlib.h>
 #include <freerdp/freerdp.h>
+#include <freerdp/utils/cpu.h>
 
 #include "color.h"
 #include "decode.h"
 
 #include "gdi_dc.h"
+#include "gdi_rop.h"
 #include "gdi_pen.h"
 #include "gdi_line.h"
 #include "gdi_shape.h"
 #include "gdi_brush.h"
+#include "gdi_cache.h"
+#include "gdi_decoder.h"
 #include "gdi_region.h"
+#include "gdi_render.h"
 #include "gdi_bitmap.h"
 #include "gdi_palette.h"
 #include "gdi_drawing.h"
@@ -38,6 +43,8 @@
 
 #include "gdi.h"
 
+#include "bitmap.h"
+
 /* Ternary Raster Operation Table */
 const uint32 rop3_code_table[] =
 {
@@ -589,14 +596,15 @@ gdi_ui_line(struct rdp_inst * inst, uint8 opcode, int startx, int starty, int en
 	cy = endy - starty + 1;
 	
 	color = gdi_color_convert(pen->color, gdi->srcBpp, 32, gdi->clrconv);
-	hPen = gdi_CreatePen(pen->style, pen->width, (GDI_COLOR) color);
+	gdi_SetDCPenColor(gdi->drawing->hdc, (GDI_COLOR) color);
+	hPen = gdi->drawing->hdc->dcPen;
+	hPen->style = pen->style;
+	hPen->width = pen->width;
 	gdi_SelectObject(gdi->drawing->hdc, (HGDIOBJECT) hPen);
 	gdi_SetROP2(gdi->drawing->hdc, opcode);
 
 	gdi_MoveToEx(gdi->drawing->hdc, startx, starty, NULL);
 	gdi_LineTo(gdi->drawing->hdc, endx, endy);
-	
-	gdi_DeleteObject((HGDIOBJECT) hPen);
 }
 
 /**
@@ -613,7 +621,6 @@ static void
 gdi_ui_rect(struct rdp_inst * inst, int x, int y, int cx, int cy, uint32 color)
 {
 	GDI_RECT rect;
-	HGDI_BRUSH hBrush;
 	uint32 brush_color;
 	GDI *gdi = GET_GDI(inst);
 
@@ -622,9 +629,8 @@ gdi_ui_rect(struct rdp_inst * inst, int x, int y, int cx, int cy, uint32 color)
 	gdi_CRgnToRect(x, y, cx, cy, &rect);
 	brush_color = gdi_color_convert(color, gdi->srcBpp, 32, gdi->clrconv);
 
-	hBrush = gdi_CreateSolidBrush(brush_color);
-	gdi_FillRect(gdi->drawing->hdc, &rect, hBrush);
-	gdi_DeleteObject((HGDIOBJECT) hBrush);
+	gdi_SetDCBrushColor(gdi->drawing->hdc, brush_color);
+	gdi_FillRect(gdi->drawing->hdc, &rect, gdi->drawing->hdc->dcBrush);
 }
 
 /**
@@ -670,7 +676,10 @@ gdi_ui_polyline(struct rdp_inst * inst, uint8 opcode, FRDP_POINT * points, int n
 
 	color = gdi_color_convert(pen->color, gdi->srcBpp, 32, gdi->clrconv);
 
-	hPen = gdi_CreatePen(pen->style, pen->width, (GDI_COLOR) color);
+	gdi_SetDCPenColor(gdi->drawing->hdc, (GDI_COLOR) color);
+	hPen = gdi->drawing->hdc->dcPen;
+	hPen->style = pen->style;
+	hPen->width = pen->width;
 	gdi_SelectObject(gdi->drawing->hdc, (HGDIOBJECT) hPen);
 	gdi_SetROP2(gdi->drawing->hdc, opcode);
 
@@ -683,8 +692,6 @@ gdi_ui_polyline(struct rdp_inst * inst, uint8 opcode, FRDP_POINT * points, int n
 		cy += points[i].y;
 		gdi_LineTo(gdi->drawing->hdc, cx, cy);
 	}
-
-	gdi_DeleteObject((HGDIOBJECT) hPen);
 }
 
 /**
@@ -811,7 +818,7 @@ gdi_ui_patblt(struct rdp_inst * inst, uint8 opcode, int x, int y, int cx, int cy
 		if (brush->bd->color_code > 1)
 			data = gdi_image_convert(brush->bd->data, NULL, 8, 8, gdi->srcBpp, gdi->dstBpp, gdi->clrconv);
 		else
-			data = gdi_mono_image_convert(brush->bd->data, 8, 8, gdi->srcBpp, gdi->dstBpp, bgcolor, fgcolor, gdi->clrconv);
+			data = gdi_mono_image_convert(brush->bd->data, NULL, 8, 8, gdi->srcBpp, gdi->dstBpp, bgcolor, fgcolor, gdi->clrconv);
 
 		hBmp = gdi_CreateBitmap(8, 8, gdi->drawing->hdc->bitsPerPixel, data);
 
@@ -829,11 +836,11 @@ gdi_ui_patblt(struct rdp_inst * inst, uint8 opcode, int x, int y, int cx, int cy
 		originalBrush = gdi->drawing->hdc->brush;
 
 		color = gdi_color_convert(fgcolor, gdi->srcBpp, 32, gdi->clrconv);
-		gdi->drawing->hdc->brush = gdi_CreateSolidBrush(color);
+		gdi_SetDCBrushColor(gdi->drawing->hdc, color);
+		gdi->drawing->hdc->brush = gdi->drawing->hdc->dcBrush;
 
 		gdi_PatBlt(gdi->drawing->hdc, x, y, cx, cy, gdi_rop3_code(opcode));
 
-		gdi_DeleteObject((HGDIOBJECT) gdi->drawing->hdc->brush);
 		gdi->drawing->hdc->brush = originalBrush;
 	}
 	else
@@ -1065,25 +1072,295 @@ gdi_ui_decode(struct rdp_inst * inst, uint8 * data, int size)
 }
 #endif
 
+/**
+ * Check if compressed bitmap data can be decompressed and converted to the
+ * internal buffer format in a single pass.
+ * @param gdi current GDI
+ * @param bpp bitmap color depth
+ * @return True if the bitmap can be decompressed straight into the internal buffer format
+ */
+
+static boolean gdi_bitmap_direct_decode(GDI* gdi, int bpp)
+{
+	if (bpp == 8)
+		return (gdi_color_get_palette(gdi->clrconv, gdi->dstBpp) != NULL) ? True : False;
+
+	if (bpp == 32)
+		return (gdi->dstBpp == 32 && !gdi->clrconv->alpha) ? True : False;
+
+	if (gdi->dstBpp == 16)
+		return (gdi->clrconv->rgb555) ? False : True;
+
+	return (gdi->clrconv->invert) ? False : True;
+}
+
+/**
+ * Decode bitmap data into a buffer in the internal buffer format.\n
+ * Compressed bitmaps are decompressed and converted in a single pass whenever possible.
+ * Uncompressed bitmap data is stored bottom-up and is flipped while copying.
+ * @param gdi current GDI
+ * @param dstData top-left pixel of the destination
+ * @param dstStride distance in bytes between two destination scanlines
+ * @param width bitmap width
+ * @param height bitmap height
+ * @param bpp bitmap color depth
+ * @param length bitmap data length
+ * @param data bitmap data
+ * @param compressed True if the bitmap data is compressed
+ * @return True on success
+ */
+
+static boolean gdi_decode_bitmap(GDI* gdi, uint8* dstData, int dstStride, int width, int height,
+		int bpp, int length, uint8* data, boolean compressed)
+{
+	int y;
+	int scanline;
+	boolean status;
+	uint8* decoded;
+	uint8* converted;
+
+	if (compressed && gdi_bitmap_direct_decode(gdi, bpp))
+	{
+		return bitmap_decompress_ex(data, dstData, dstStride, width, height,
+				length, bpp, gdi->dstBpp, gdi_color_get_palette(gdi->clrconv, gdi->dstBpp));
+	}
+
+	status = True;
+	scanline = width * ((bpp + 7) / 8);
+
+	if (!compressed && height > 0 && length >= scanline * height)
+	{
+		/* convert straight from the bottom-up scanlines whenever a conversion kernel exists */
+		if (gdi_image_convert_ex(&data[(height - 1) * scanline], -scanline, dstData, dstStride,
+				width, height, bpp, gdi->dstBpp, gdi->clrconv))
+			return True;
+	}
+
+	decoded = (uint8*) malloc(scanline * height);
+
+	if (compressed)
+	{
+		status = bitmap_decompress(data, decoded, width, height, length, bpp, bpp);
+	}
+	else if (length >= scanline * height)
+	{
+		for (y = 0; y < height; y++)
+			memcpy(&decoded[y * scanline], &data[(height - y - 1) * scanline], scanline);
+	}
+	else
+	{
+		status = False;
+	}
+
+	if (status != True)
+		memset(decoded, 0, scanline * height);
+
+	if (gdi_image_convert_ex(decoded, scanline, dstData, dstStride,
+			width, height, bpp, gdi->dstBpp, gdi->clrconv))
+	{
+		free(decoded);
+		return status;
+	}
+
+	converted = gdi_image_convert(decoded, NULL, width, height, bpp, gdi->dstBpp, gdi->clrconv);
+
+	scanline = width * gdi->bytesPerPixel;
+
+	if (converted == decoded && (bpp + 7) / 8 != gdi->bytesPerPixel)
+	{
+		/* unsupported color conversion */
+		for (y = 0; y < height; y++)
+			memset(&dstData[y * dstStride], 0, scanline);
+
+		status = False;
+	}
+	else
+	{
+		for (y = 0; y < height; y++)
+			memcpy(&dstData[y * dstStride], &converted[y * scanline], scanline);
+	}
+
+	if (converted != decoded)
+		free(converted);
+
+	free(decoded);
+
+	return status;
+}
+
+/**
+ * Decode a bitmap to a new bitmap in the internal buffer format.
+ * @param gdi current GDI
+ * @param width bitmap width
+ * @param height bitmap height
+ * @param bpp bitmap color depth
+ * @param length bitmap data length
+ * @param data bitmap data
+ * @param compressed True if the bitmap data is compressed
+ * @return new bitmap in the internal buffer format
+ */
+
+static GDI_IMAGE* gdi_decoded_bitmap_new(GDI* gdi, int width, int height, int bpp, int length, uint8* data, boolean compressed)
+{
+	int scanline;
+	uint8* bmpData;
+	GDI_IMAGE* gdi_bmp;
+
+	scanline = width * gdi->bytesPerPixel;
+	bmpData = (uint8*) malloc(scanline * height);
+
+	if (gdi_decode_bitmap(gdi, bmpData, scanline, width, height, bpp, length, data, compressed) != True)
+		printf("gdi_decoded_bitmap_new: failed to decode %dx%d bitmap at %d bpp\n", width, height, bpp);
+
+	gdi_bmp = (GDI_IMAGE*) malloc(sizeof(GDI_IMAGE));
+	gdi_bmp->hdc = gdi_CreateCompatibleDC(gdi->hdc);
+	gdi_bmp->bitmap = gdi_CreateBitmap(width, height, gdi->dstBpp, bmpData);
+	gdi_SelectObject(gdi_bmp->hdc, (HGDIOBJECT) gdi_bmp->bitmap);
+	gdi_bmp->org_bitmap = NULL;
+
+	return gdi_bmp;
+}
+
+/**
+ * Check if a bitmap update rectangle can be decoded straight into the primary surface.
+ */
+
+static boolean gdi_bitmap_data_direct(GDI* gdi, BITMAP_DATA* bmp)
+{
+	HGDI_BITMAP surface = gdi->primary->bitmap;
+
+	return (bmp->right - bmp->left + 1 == bmp->width && bmp->bottom - bmp->top + 1 == bmp->height &&
+		bmp->right < surface->width && bmp->bottom < surface->height) ? True : False;
+}
+
+/**
+ * Decode a bitmap update rectangle straight into the primary surface.\n
+ * Called from the parallel decoder worker threads, it does not touch any shared GDI state.
+ */
+
+static void gdi_decode_bitmap_data(GDI* gdi, BITMAP_DATA* bmp)
+{
+	uint8* dstData;
+	HGDI_BITMAP surface = gdi->primary->bitmap;
+
+	dstData = surface->data + (bmp->top * surface->scanline) + (bmp->left * gdi->bytesPerPixel);
+
+	if (gdi_decode_bitmap(gdi, dstData, surface->scanline, bmp->width, bmp->height,
+		bmp->bpp, bmp->length, bmp->data, bmp->compressed) != True)
+	{
+		printf("gdi_bitmap_update: failed to decode %dx%d bitmap at %d bpp\n",
+				bmp->width, bmp->height, bmp->bpp);
+	}
+}
+
+/**
+ * Check if the rectangles of a bitmap update can be decoded in parallel.\n
+ * They all have to be decoded straight into the primary surface, without overlapping.
+ */
+
+static boolean gdi_bitmap_update_parallel(GDI* gdi, BITMAP_UPDATE* bitmap)
+{
+	int i, j;
+	BITMAP_DATA* a;
+	BITMAP_DATA* b;
+
+	if (gdi->decoder->threads < 1 || bitmap->number < 2)
+		return False;
+
+	for (i = 0; i < bitmap->number; i++)
+	{
+		a = &bitmap->bitmaps[i];
+
+		if (!gdi_bitmap_data_direct(gdi, a))
+			return False;
+
+		for (j = 0; j < i; j++)
+		{
+			b = &bitmap->bitmaps[j];
+
+			if (a->left <= b->right && b->left <= a->right && a->top <= b->bottom && b->top <= a->bottom)
+				return False;
+		}
+	}
+
+	return True;
+}
+
 void gdi_bitmap_update(rdpUpdate* update, BITMAP_UPDATE* bitmap)
 {
 	int i;
+	int width;
+	int height;
 	BITMAP_DATA* bmp;
 	GDI_IMAGE* gdi_bmp;
 	GDI* gdi = GET_GDI(update);
 
+	gdi_render_flush(gdi->render);
+
+	if (gdi_bitmap_update_parallel(gdi, bitmap))
+	{
+		/* all the rectangles are decoded when this returns */
+		gdi_decoder_run(gdi->decoder, bitmap->bitmaps, bitmap->number);
+
+		for (i = 0; i < bitmap->number; i++)
+		{
+			bmp = &bitmap->bitmaps[i];
+			gdi_InvalidateRegion(gdi->primary->hdc, bmp->left, bmp->top, bmp->width, bmp->height);
+		}
+
+		return;
+	}
+
 	for (i = 0; i < bitmap->number; i++)
 	{
 		bmp = &bitmap->bitmaps[i];
-		gdi_bmp = gdi_bitmap_new(gdi, bmp->width, bmp->height, gdi->dstBpp, bmp->data);
-		gdi_BitBlt(gdi->primary->hdc, bmp->left, bmp->top, bmp->width, bmp->height, gdi_bmp->hdc, 0, 0, GDI_SRCCOPY);
-		gdi_bitmap_free((GDI_IMAGE*) gdi_bmp);
+		width = bmp->right - bmp->left + 1;
+		height = bmp->bottom - bmp->top + 1;
+
+		if (gdi_bitmap_data_direct(gdi, bmp))
+		{
+			/* decode straight into the primary surface */
+			gdi_decode_bitmap_data(gdi, bmp);
+			gdi_InvalidateRegion(gdi->primary->hdc, bmp->left, bmp->top, width, height);
+		}
+		else
+		{
+			gdi_bmp = gdi_decoded_bitmap_new(gdi, bmp->width, bmp->height,
+					bmp->bpp, bmp->length, bmp->data, bmp->compressed);
+			gdi_BitBlt(gdi->primary->hdc, bmp->left, bmp->top, width, height, gdi_bmp->hdc, 0, 0, GDI_SRCCOPY);
+			gdi_bitmap_free(gdi_bmp);
+		}
 	}
 }
 
+/**
+ * Palette Update.\n
+ * The palette entries are replaced and the palette lookup tables rebuilt,
+ * so 8bpp drawing orders and bitmaps use the new colors.
+ * @param update update
+ * @param palette palette update
+ */
+
 void gdi_palette_update(rdpUpdate* update, PALETTE_UPDATE* palette)
 {
+	int i;
+	uint32 color;
+	GDI_PALETTEENTRY* entry;
+	GDI* gdi = GET_GDI(update);
+
+	gdi_render_flush(gdi->render);
+
+	for (i = 0; i < (int) palette->number && i < gdi->palette->count; i++)
+	{
+		/* palette entries are red, green and blue bytes */
+		color = palette->entries[i];
+		entry = &gdi->palette->entries[i];
+		entry->red = color & 0xFF;
+		entry->green = (color >> 8) & 0xFF;
+		entry->blue = (color >> 16) & 0xFF;
+	}
 
+	gdi_color_set_palette(gdi->clrconv, (FRDP_PALETTE*) gdi->palette);
 }
 
 void gdi_set_bounds(rdpUpdate* update, BOUNDS* bounds)
@@ -1099,190 +1376,949 @@ void gdi_set_bounds(rdpUpdate* update, BOUNDS* bounds)
 	{
 		gdi_SetNullClipRgn(gdi->drawing->hdc);
 	}
+
+	if (gdi->render != NULL)
+		gdi_render_set_bounds(gdi->render, bounds);
 }
 
-void gdi_dstblt(rdpUpdate* update, DSTBLT_ORDER* dstblt)
+static void gdi_draw_dstblt(GDI* gdi, HGDI_DC hdc, DSTBLT_ORDER* dstblt)
 {
-	GDI* gdi = GET_GDI(update);
-
-	gdi_BitBlt(gdi->drawing->hdc, dstblt->nLeftRect, dstblt->nTopRect,
+	gdi_BitBlt(hdc, dstblt->nLeftRect, dstblt->nTopRect,
 			dstblt->nWidth, dstblt->nHeight, NULL, 0, 0, gdi_rop3_code(dstblt->bRop));
 }
 
-void gdi_patblt(rdpUpdate* update, PATBLT_ORDER* patblt)
+/**
+ * Convert an 8x8 monochrome brush into the pattern brush of a device context.\n
+ * The pattern bitmap is owned by the device context, created on first use and converted
+ * in place, sparing a bitmap and brush allocation for each pattern drawing order.
+ * @param gdi current GDI
+ * @param hdc device context
+ * @param data brush bits, one byte per row
+ * @param bgcolor background color
+ * @param fgcolor foreground color
+ * @return pattern brush of the device context
+ */
+
+static HGDI_BRUSH gdi_dc_pattern_brush(GDI* gdi, HGDI_DC hdc, uint8* data, uint32 bgcolor, uint32 fgcolor)
 {
-	HGDI_BRUSH originalBrush;
-	GDI* gdi = GET_GDI(update);
+	HGDI_BITMAP hBmp;
+
+	if (hdc->dcPatternBrush == NULL)
+		hdc->dcPatternBrush = gdi_CreatePatternBrush(gdi_CreateBitmap(8, 8, 32, (uint8*) malloc(8 * 8 * 4)));
+
+	hBmp = hdc->dcPatternBrush->pattern;
+
+	/* the color depth of a device context may be set after it was created */
+	hBmp->bitsPerPixel = hdc->bitsPerPixel;
+	hBmp->bytesPerPixel = hdc->bytesPerPixel;
+	hBmp->scanline = hBmp->width * hBmp->bytesPerPixel;
+
+	gdi_mono_image_convert(data, hBmp->data, 8, 8, gdi->srcBpp, gdi->dstBpp, bgcolor, fgcolor, gdi->clrconv);
+
+	return hdc->dcPatternBrush;
+}
+
+/**
+ * Select the brush of a drawing order into a device context.
+ * @param gdi current GDI
+ * @param hdc device context
+ * @param brushStyle brush style
+ * @param brushHatch brush bits, one byte per row
+ * @param backColor background color
+ * @param foreColor foreground color
+ * @return False if the brush style is not supported
+ */
+
+static boolean gdi_select_order_brush(GDI* gdi, HGDI_DC hdc, uint8 brushStyle, uint8* brushHatch,
+		uint32 backColor, uint32 foreColor)
+{
+	uint32 color;
 
-	if (patblt->brushStyle & CACHED_BRUSH)
+	if (brushStyle & CACHED_BRUSH)
 	{
 		/* obtain brush from cache */
 		printf("should obtain brush from cache.\n");
-		return;
+		return False;
 	}
 
-	patblt->brushStyle &= 0x7F;
+	brushStyle = brushStyle & 0x7F;
 
-	if (patblt->brushStyle == BS_SOLID)
+	if (brushStyle == BS_SOLID)
 	{
-		uint32 color;
-		originalBrush = gdi->drawing->hdc->brush;
-
-		color = gdi_color_convert(patblt->foreColor, gdi->srcBpp, 32, gdi->clrconv);
-		gdi->drawing->hdc->brush = gdi_CreateSolidBrush(color);
-
-		gdi_PatBlt(gdi->drawing->hdc, patblt->nLeftRect, patblt->nTopRect,
-				patblt->nWidth, patblt->nHeight, gdi_rop3_code(patblt->bRop));
-
-		gdi_DeleteObject((HGDIOBJECT) gdi->drawing->hdc->brush);
-		gdi->drawing->hdc->brush = originalBrush;
+		color = gdi_color_convert(foreColor, gdi->srcBpp, 32, gdi->clrconv);
+		gdi_SetDCBrushColor(hdc, color);
+		hdc->brush = hdc->dcBrush;
 	}
-	else if (patblt->brushStyle == BS_PATTERN)
+	else if (brushStyle == BS_PATTERN)
 	{
-		uint8* data;
-		HGDI_BITMAP hBmp;
-
-		data = (uint8*) &patblt->brushHatch;
-
-		data = gdi_mono_image_convert(data, 8, 8, gdi->srcBpp, gdi->dstBpp,
-				patblt->backColor, patblt->foreColor, gdi->clrconv);
+		hdc->brush = gdi_dc_pattern_brush(gdi, hdc, brushHatch, backColor, foreColor);
+	}
+	else
+	{
+		printf("unimplemented brush style:%d\n", brushStyle);
+		return False;
+	}
 
-		hBmp = gdi_CreateBitmap(8, 8, gdi->drawing->hdc->bitsPerPixel, data);
+	return True;
+}
 
-		originalBrush = gdi->drawing->hdc->brush;
-		gdi->drawing->hdc->brush = gdi_CreatePatternBrush(hBmp);
+static void gdi_draw_patblt(GDI* gdi, HGDI_DC hdc, PATBLT_ORDER* patblt)
+{
+	HGDI_BRUSH originalBrush;
 
-		gdi_PatBlt(gdi->drawing->hdc, patblt->nLeftRect, patblt->nTopRect,
-				patblt->nWidth, patblt->nHeight, gdi_rop3_code(patblt->bRop));
+	originalBrush = hdc->brush;
 
-		gdi_DeleteObject((HGDIOBJECT) gdi->drawing->hdc->brush);
-		gdi->drawing->hdc->brush = originalBrush;
-	}
-	else
+	if (gdi_select_order_brush(gdi, hdc, patblt->brushStyle, (uint8*) &patblt->brushHatch,
+			patblt->backColor, patblt->foreColor))
 	{
-		printf("unimplemented brush style:%d\n", patblt->brushStyle);
+		gdi_PatBlt(hdc, patblt->nLeftRect, patblt->nTopRect,
+				patblt->nWidth, patblt->nHeight, gdi_rop3_code(patblt->bRop));
 	}
+
+	hdc->brush = originalBrush;
 }
 
-void gdi_scrblt(rdpUpdate* update, SCRBLT_ORDER* scrblt)
+static void gdi_draw_scrblt(GDI* gdi, HGDI_DC hdc, SCRBLT_ORDER* scrblt)
 {
-	GDI* gdi = GET_GDI(update);
-
-	gdi_BitBlt(gdi->drawing->hdc, scrblt->nLeftRect, scrblt->nTopRect,
+	gdi_BitBlt(hdc, scrblt->nLeftRect, scrblt->nTopRect,
 			scrblt->nWidth, scrblt->nHeight, gdi->primary->hdc,
 			scrblt->nXSrc, scrblt->nYSrc, gdi_rop3_code(scrblt->bRop));
 }
 
-void gdi_opaque_rect(rdpUpdate* update, OPAQUE_RECT_ORDER* opaque_rect)
+static void gdi_draw_opaque_rect(GDI* gdi, HGDI_DC hdc, OPAQUE_RECT_ORDER* opaque_rect)
 {
 	GDI_RECT rect;
-	HGDI_BRUSH hBrush;
 	uint32 brush_color;
-	GDI *gdi = GET_GDI(update);
 
 	gdi_CRgnToRect(opaque_rect->nLeftRect, opaque_rect->nTopRect,
 			opaque_rect->nWidth, opaque_rect->nHeight, &rect);
 
 	brush_color = gdi_color_convert(opaque_rect->color, gdi->srcBpp, 32, gdi->clrconv);
 
-	hBrush = gdi_CreateSolidBrush(brush_color);
-	gdi_FillRect(gdi->drawing->hdc, &rect, hBrush);
-
-	gdi_DeleteObject((HGDIOBJECT) hBrush);
+	gdi_SetDCBrushColor(hdc, brush_color);
+	gdi_FillRect(hdc, &rect, hdc->dcBrush);
 }
 
-void gdi_multi_opaque_rect(rdpUpdate* update, MULTI_OPAQUE_RECT_ORDER* multi_opaque_rect)
+/**
+ * Clip a device context to the union of the delta-encoded rectangles of a drawing order,
+ * within its current clipping rectangle and its bitmap. The previous clipping region is restored with
+ * gdi_reset_delta_clip.
+ * @param hdc device context
+ * @param rectangles delta-encoded rectangles, starting at index 1
+ * @param number number of rectangles
+ * @param rect bounding rectangle of the clipping region
+ * @return False if nothing is left to draw
+ */
+
+static boolean gdi_set_delta_clip(HGDI_DC hdc, DELTA_RECT* rectangles, int number, GDI_RECT* rect)
 {
 	int i;
-	GDI_RECT rect;
-	HGDI_BRUSH hBrush;
-	uint32 brush_color;
+	int count;
+	GDI_RGN* clip;
+	GDI_RECT bounds;
+	HGDI_BITMAP hBmp;
 	DELTA_RECT* rectangle;
-	GDI *gdi = GET_GDI(update);
+	GDI_RGN rects[GDI_MAX_CLIP_RECTS];
+
+	clip = hdc->clip;
+	hBmp = (HGDI_BITMAP) hdc->selectedObject;
+
+	if (hBmp == NULL)
+		return False;
 
-	for (i = 0; i < multi_opaque_rect->numRectangles; i++)
+	gdi_CRgnToRect(0, 0, hBmp->width, hBmp->height, &bounds);
+
+	if (!clip->null)
 	{
-		rectangle = &multi_opaque_rect->rectangles[i];
+		gdi_RgnToRect(clip, rect);
 
-		gdi_CRgnToRect(rectangle->left, rectangle->top,
-				rectangle->width, rectangle->height, &rect);
+		if (rect->left > bounds.left)
+			bounds.left = rect->left;
 
-		brush_color = gdi_color_convert(multi_opaque_rect->color, gdi->srcBpp, 32, gdi->clrconv);
+		if (rect->top > bounds.top)
+			bounds.top = rect->top;
 
-		hBrush = gdi_CreateSolidBrush(brush_color);
-		gdi_FillRect(gdi->drawing->hdc, &rect, hBrush);
+		if (rect->right < bounds.right)
+			bounds.right = rect->right;
+
+		if (rect->bottom < bounds.bottom)
+			bounds.bottom = rect->bottom;
 	}
 
-	gdi_DeleteObject((HGDIOBJECT) hBrush);
-}
+	count = 0;
 
-void gdi_line_to(rdpUpdate* update, LINE_TO_ORDER* line_to)
-{
-	int cx, cy;
-	uint32 color;
-	HGDI_PEN hPen;
-	GDI *gdi = GET_GDI(update);
+	for (i = 1; i <= number && i <= 45; i++)
+	{
+		rectangle = &rectangles[i];
 
-	cx = line_to->nXEnd - line_to->nXStart + 1;
-	cy = line_to->nYEnd - line_to->nYStart + 1;
+		gdi_CRgnToRect(rectangle->left, rectangle->top,
+				rectangle->width, rectangle->height, rect);
 
-	color = gdi_color_convert(line_to->penColor, gdi->srcBpp, 32, gdi->clrconv);
-	hPen = gdi_CreatePen(line_to->penStyle, line_to->penWidth, (GDI_COLOR) color);
-	gdi_SelectObject(gdi->drawing->hdc, (HGDIOBJECT) hPen);
-	gdi_SetROP2(gdi->drawing->hdc, line_to->bRop2);
+		if (rect->left < bounds.left)
+			rect->left = bounds.left;
 
-	gdi_MoveToEx(gdi->drawing->hdc, line_to->nXStart, line_to->nYStart, NULL);
-	gdi_LineTo(gdi->drawing->hdc, line_to->nXEnd, line_to->nYEnd);
+		if (rect->top < bounds.top)
+			rect->top = bounds.top;
 
-	gdi_DeleteObject((HGDIOBJECT) hPen);
-}
+		if (rect->right > bounds.right)
+			rect->right = bounds.right;
 
-/**
- * Register GDI callbacks with libfreerdp.
- * @param inst current instance
- * @return
- */
+		if (rect->bottom > bounds.bottom)
+			rect->bottom = bounds.bottom;
 
-void gdi_register_update_callbacks(rdpUpdate* update)
-{
-	update->Bitmap = gdi_bitmap_update;
-	update->Palette = gdi_palette_update;
-	update->SetBounds = gdi_set_bounds;
-	update->DstBlt = gdi_dstblt;
-	update->PatBlt = gdi_patblt;
-	update->ScrBlt = gdi_scrblt;
-	update->OpaqueRect = gdi_opaque_rect;
-	update->DrawNineGrid = NULL;
-	update->MultiDstBlt = NULL;
-	update->MultiPatBlt = NULL;
-	update->MultiScrBlt = NULL;
-	update->MultiOpaqueRect = gdi_multi_opaque_rect;
-	update->MultiDrawNineGrid = NULL;
-	update->LineTo = gdi_line_to;
-	update->Polyline = NULL;
-	update->MemBlt = NULL;
-	update->Mem3Blt = NULL;
-	update->SaveBitmap = NULL;
-	update->GlyphIndex = NULL;
-	update->FastIndex = NULL;
-	update->FastGlyph = NULL;
-	update->PolygonSC = NULL;
-	update->PolygonCB = NULL;
-	update->EllipseSC = NULL;
-	update->EllipseCB = NULL;
+		if (rect->left > rect->right || rect->top > rect->bottom)
+			continue;
+
+		gdi_RectToRgn(rect, &rects[count++]);
+	}
+
+	if (count < 1)
+		return False;
+
+	/* draw the union of the rectangles in a single pass through a complex clipping region */
+	gdi_SetClipRects(hdc, rects, count);
+	gdi_RgnToRect(hdc->clip, rect);
+
+	return True;
 }
 
-/**
- * Initialize GDI
- * @param inst current instance
- * @return
- */
+static void gdi_reset_delta_clip(HGDI_DC hdc, GDI_RGN* clip)
+{
+	hdc->nclip = 0;
+	*hdc->clip = *clip;
+}
 
-int gdi_init(freerdp* instance, uint32 flags)
+static void gdi_draw_multi_opaque_rect(GDI* gdi, HGDI_DC hdc, MULTI_OPAQUE_RECT_ORDER* multi_opaque_rect)
 {
-	GDI *gdi = (GDI*) malloc(sizeof(GDI));
-	memset(gdi, 0, sizeof(GDI));
-	SET_GDI(instance->update, gdi);
+	GDI_RGN clip;
+	GDI_RECT rect;
+	uint32 brush_color;
+
+	clip = *hdc->clip;
+
+	if (!gdi_set_delta_clip(hdc, multi_opaque_rect->rectangles, multi_opaque_rect->numRectangles, &rect))
+		return;
+
+	brush_color = gdi_color_convert(multi_opaque_rect->color, gdi->srcBpp, 32, gdi->clrconv);
+	gdi_SetDCBrushColor(hdc, brush_color);
+	gdi_FillRect(hdc, &rect, hdc->dcBrush);
+
+	gdi_reset_delta_clip(hdc, &clip);
+}
+
+static void gdi_draw_multi_dstblt(GDI* gdi, HGDI_DC hdc, MULTI_DSTBLT_ORDER* multi_dstblt)
+{
+	GDI_RGN clip;
+	GDI_RECT rect;
+
+	clip = *hdc->clip;
+
+	if (!gdi_set_delta_clip(hdc, multi_dstblt->rectangles, multi_dstblt->nDeltaEntries, &rect))
+		return;
+
+	gdi_BitBlt(hdc, multi_dstblt->nLeftRect, multi_dstblt->nTopRect,
+			multi_dstblt->nWidth, multi_dstblt->nHeight, NULL, 0, 0, gdi_rop3_code(multi_dstblt->bRop));
+
+	gdi_reset_delta_clip(hdc, &clip);
+}
+
+static void gdi_draw_multi_patblt(GDI* gdi, HGDI_DC hdc, MULTI_PATBLT_ORDER* multi_patblt)
+{
+	GDI_RGN clip;
+	GDI_RECT rect;
+	HGDI_BRUSH originalBrush;
+
+	clip = *hdc->clip;
+
+	if (!gdi_set_delta_clip(hdc, multi_patblt->rectangles, multi_patblt->nDeltaEntries, &rect))
+		return;
+
+	originalBrush = hdc->brush;
+
+	if (gdi_select_order_brush(gdi, hdc, multi_patblt->brushStyle, (uint8*) &multi_patblt->brushHatch,
+			multi_patblt->backColor, multi_patblt->foreColor))
+	{
+		gdi_PatBlt(hdc, multi_patblt->nLeftRect, multi_patblt->nTopRect,
+				multi_patblt->nWidth, multi_patblt->nHeight, gdi_rop3_code(multi_patblt->bRop));
+	}
+
+	hdc->brush = originalBrush;
+	gdi_reset_delta_clip(hdc, &clip);
+}
+
+static void gdi_draw_multi_scrblt(GDI* gdi, HGDI_DC hdc, MULTI_SCRBLT_ORDER* multi_scrblt)
+{
+	GDI_RGN clip;
+	GDI_RECT rect;
+
+	clip = *hdc->clip;
+
+	if (!gdi_set_delta_clip(hdc, multi_scrblt->rectangles, multi_scrblt->nDeltaEntries, &rect))
+		return;
+
+	gdi_BitBlt(hdc, multi_scrblt->nLeftRect, multi_scrblt->nTopRect,
+			multi_scrblt->nWidth, multi_scrblt->nHeight, gdi->primary->hdc,
+			multi_scrblt->nXSrc, multi_scrblt->nYSrc, gdi_rop3_code(multi_scrblt->bRop));
+
+	gdi_reset_delta_clip(hdc, &clip);
+}
+
+static void gdi_draw_line_to(GDI* gdi, HGDI_DC hdc, LINE_TO_ORDER* line_to)
+{
+	uint32 color;
+	HGDI_PEN hPen;
+
+	color = gdi_color_convert(line_to->penColor, gdi->srcBpp, 32, gdi->clrconv);
+	gdi_SetDCPenColor(hdc, (GDI_COLOR) color);
+	hPen = hdc->dcPen;
+	hPen->style = line_to->penStyle;
+	hPen->width = line_to->penWidth;
+	gdi_SelectObject(hdc, (HGDIOBJECT) hPen);
+	gdi_SetROP2(hdc, line_to->bRop2);
+
+	gdi_MoveToEx(hdc, line_to->nXStart, line_to->nYStart, NULL);
+	gdi_LineTo(hdc, line_to->nXEnd, line_to->nYEnd);
+}
+
+/**
+ * Clip the source rectangle of a MemBlt or Mem3Blt order to the cached bitmap,
+ * moving and shrinking the destination rectangle to match.
+ * @return False if nothing is left to draw
+ */
+
+static boolean gdi_clip_cached_source(GDI_IMAGE* bitmap, GDI_RECT* dst, int* nXSrc, int* nYSrc)
+{
+	int width = dst->right - dst->left + 1;
+	int height = dst->bottom - dst->top + 1;
+
+	if (*nXSrc < 0)
+	{
+		dst->left -= *nXSrc;
+		width += *nXSrc;
+		*nXSrc = 0;
+	}
+
+	if (*nYSrc < 0)
+	{
+		dst->top -= *nYSrc;
+		height += *nYSrc;
+		*nYSrc = 0;
+	}
+
+	if (*nXSrc + width > bitmap->bitmap->width)
+		width = bitmap->bitmap->width - *nXSrc;
+
+	if (*nYSrc + height > bitmap->bitmap->height)
+		height = bitmap->bitmap->height - *nYSrc;
+
+	if (width <= 0 || height <= 0)
+		return False;
+
+	dst->right = dst->left + width - 1;
+	dst->bottom = dst->top + height - 1;
+
+	return True;
+}
+
+static void gdi_draw_memblt(GDI* gdi, HGDI_DC hdc, MEMBLT_ORDER* memblt)
+{
+	GDI_RECT dst;
+	int nXSrc, nYSrc;
+	GDI_IMAGE* bitmap;
+
+	/* the high byte of cacheId is the color table index */
+	bitmap = gdi_bitmap_cache_get(gdi->bitmap_cache, memblt->cacheId & 0xFF, memblt->cacheIndex);
+
+	if (bitmap == NULL)
+		return;
+
+	nXSrc = memblt->nXSrc;
+	nYSrc = memblt->nYSrc;
+	gdi_CRgnToRect(memblt->nLeftRect, memblt->nTopRect, memblt->nWidth, memblt->nHeight, &dst);
+
+	if (!gdi_clip_cached_source(bitmap, &dst, &nXSrc, &nYSrc))
+		return;
+
+	gdi_BitBlt(hdc, dst.left, dst.top, dst.right - dst.left + 1, dst.bottom - dst.top + 1,
+			bitmap->hdc, nXSrc, nYSrc, gdi_rop3_code(memblt->bRop));
+}
+
+static void gdi_draw_mem3blt(GDI* gdi, HGDI_DC hdc, MEM3BLT_ORDER* mem3blt)
+{
+	GDI_RECT dst;
+	int nXSrc, nYSrc;
+	GDI_IMAGE* bitmap;
+	HGDI_BRUSH originalBrush;
+
+	bitmap = gdi_bitmap_cache_get(gdi->bitmap_cache, mem3blt->cacheId & 0xFF, mem3blt->cacheIndex);
+
+	if (bitmap == NULL)
+		return;
+
+	nXSrc = mem3blt->nXSrc;
+	nYSrc = mem3blt->nYSrc;
+	gdi_CRgnToRect(mem3blt->nLeftRect, mem3blt->nTopRect, mem3blt->nWidth, mem3blt->nHeight, &dst);
+
+	if (!gdi_clip_cached_source(bitmap, &dst, &nXSrc, &nYSrc))
+		return;
+
+	originalBrush = hdc->brush;
+
+	if (!gdi_select_order_brush(gdi, hdc, mem3blt->brushStyle, (uint8*) &mem3blt->brushHatch,
+			mem3blt->backColor, mem3blt->foreColor))
+		return;
+
+	gdi_BitBlt(hdc, dst.left, dst.top, dst.right - dst.left + 1, dst.bottom - dst.top + 1,
+			bitmap->hdc, nXSrc, nYSrc, gdi_rop3_code(mem3blt->bRop));
+
+	hdc->brush = originalBrush;
+}
+
+/**
+ * Draw a drawing order recorded by the parallel order rasterizer.
+ * @param gdi current GDI
+ * @param hdc device context to draw to
+ * @param type recorded drawing order type
+ * @param order drawing order
+ */
+
+void gdi_draw_order(GDI* gdi, HGDI_DC hdc, int type, void* order)
+{
+	switch (type)
+	{
+		case GDI_RENDER_DSTBLT:
+			gdi_draw_dstblt(gdi, hdc, (DSTBLT_ORDER*) order);
+			break;
+
+		case GDI_RENDER_PATBLT:
+			gdi_draw_patblt(gdi, hdc, (PATBLT_ORDER*) order);
+			break;
+
+		case GDI_RENDER_SCRBLT:
+			gdi_draw_scrblt(gdi, hdc, (SCRBLT_ORDER*) order);
+			break;
+
+		case GDI_RENDER_OPAQUE_RECT:
+			gdi_draw_opaque_rect(gdi, hdc, (OPAQUE_RECT_ORDER*) order);
+			break;
+
+		case GDI_RENDER_MULTI_OPAQUE_RECT:
+			gdi_draw_multi_opaque_rect(gdi, hdc, (MULTI_OPAQUE_RECT_ORDER*) order);
+			break;
+
+		case GDI_RENDER_LINE_TO:
+			gdi_draw_line_to(gdi, hdc, (LINE_TO_ORDER*) order);
+			break;
+
+		case GDI_RENDER_MEMBLT:
+			gdi_draw_memblt(gdi, hdc, (MEMBLT_ORDER*) order);
+			break;
+
+		case GDI_RENDER_MEM3BLT:
+			gdi_draw_mem3blt(gdi, hdc, (MEM3BLT_ORDER*) order);
+			break;
+
+		case GDI_RENDER_MULTI_DSTBLT:
+			gdi_draw_multi_dstblt(gdi, hdc, (MULTI_DSTBLT_ORDER*) order);
+			break;
+
+		case GDI_RENDER_MULTI_PATBLT:
+			gdi_draw_multi_patblt(gdi, hdc, (MULTI_PATBLT_ORDER*) order);
+			break;
+
+		case GDI_RENDER_MULTI_SCRBLT:
+			gdi_draw_multi_scrblt(gdi, hdc, (MULTI_SCRBLT_ORDER*) order);
+			break;
+	}
+}
+
+/**
+ * Draw an order, or record it when drawing orders are rasterized in parallel.
+ */
+
+static void gdi_order(rdpUpdate* update, int type, void* order)
+{
+	GDI* gdi = GET_GDI(update);
+
+	if (gdi->render != NULL)
+		gdi_render_record(gdi->render, type, order);
+	else
+		gdi_draw_order(gdi, gdi->drawing->hdc, type, order);
+}
+
+void gdi_dstblt(rdpUpdate* update, DSTBLT_ORDER* dstblt)
+{
+	gdi_order(update, GDI_RENDER_DSTBLT, dstblt);
+}
+
+void gdi_patblt(rdpUpdate* update, PATBLT_ORDER* patblt)
+{
+	gdi_order(update, GDI_RENDER_PATBLT, patblt);
+}
+
+void gdi_scrblt(rdpUpdate* update, SCRBLT_ORDER* scrblt)
+{
+	gdi_order(update, GDI_RENDER_SCRBLT, scrblt);
+}
+
+void gdi_multi_dstblt(rdpUpdate* update, MULTI_DSTBLT_ORDER* multi_dstblt)
+{
+	gdi_order(update, GDI_RENDER_MULTI_DSTBLT, multi_dstblt);
+}
+
+void gdi_multi_patblt(rdpUpdate* update, MULTI_PATBLT_ORDER* multi_patblt)
+{
+	gdi_order(update, GDI_RENDER_MULTI_PATBLT, multi_patblt);
+}
+
+void gdi_multi_scrblt(rdpUpdate* update, MULTI_SCRBLT_ORDER* multi_scrblt)
+{
+	gdi_order(update, GDI_RENDER_MULTI_SCRBLT, multi_scrblt);
+}
+
+void gdi_opaque_rect(rdpUpdate* update, OPAQUE_RECT_ORDER* opaque_rect)
+{
+	gdi_order(update, GDI_RENDER_OPAQUE_RECT, opaque_rect);
+}
+
+void gdi_multi_opaque_rect(rdpUpdate* update, MULTI_OPAQUE_RECT_ORDER* multi_opaque_rect)
+{
+	gdi_order(update, GDI_RENDER_MULTI_OPAQUE_RECT, multi_opaque_rect);
+}
+
+void gdi_line_to(rdpUpdate* update, LINE_TO_ORDER* line_to)
+{
+	gdi_order(update, GDI_RENDER_LINE_TO, line_to);
+}
+
+void gdi_memblt(rdpUpdate* update, MEMBLT_ORDER* memblt)
+{
+	gdi_order(update, GDI_RENDER_MEMBLT, memblt);
+}
+
+void gdi_mem3blt(rdpUpdate* update, MEM3BLT_ORDER* mem3blt)
+{
+	gdi_order(update, GDI_RENDER_MEM3BLT, mem3blt);
+}
+
+void gdi_cache_bitmap(rdpUpdate* update, CACHE_BITMAP_ORDER* cache_bitmap)
+{
+	GDI_IMAGE* bitmap;
+	GDI* gdi = GET_GDI(update);
+
+	gdi_render_flush(gdi->render);
+
+	bitmap = gdi_decoded_bitmap_new(gdi, cache_bitmap->bitmapWidth, cache_bitmap->bitmapHeight,
+			cache_bitmap->bitmapBpp, cache_bitmap->bitmapLength,
+			cache_bitmap->bitmapDataStream, cache_bitmap->compressed);
+
+	gdi_bitmap_cache_put(gdi->bitmap_cache, cache_bitmap->cacheId, cache_bitmap->cacheIndex, bitmap);
+}
+
+void gdi_cache_bitmap_v2(rdpUpdate* update, CACHE_BITMAP_V2_ORDER* cache_bitmap_v2)
+{
+	GDI_IMAGE* bitmap;
+	GDI* gdi = GET_GDI(update);
+
+	gdi_render_flush(gdi->render);
+
+	bitmap = gdi_decoded_bitmap_new(gdi, cache_bitmap_v2->bitmapWidth, cache_bitmap_v2->bitmapHeight,
+			cache_bitmap_v2->bitmapBpp, cache_bitmap_v2->bitmapLength,
+			cache_bitmap_v2->bitmapDataStream, cache_bitmap_v2->compressed);
+
+	gdi_bitmap_cache_put(gdi->bitmap_cache, cache_bitmap_v2->cacheId, cache_bitmap_v2->cacheIndex, bitmap);
+}
+
+void gdi_cache_bitmap_v3(rdpUpdate* update, CACHE_BITMAP_V3_ORDER* cache_bitmap_v3)
+{
+	GDI_IMAGE* bitmap;
+	BITMAP_DATA_EX* bitmapData;
+	GDI* gdi = GET_GDI(update);
+
+	gdi_render_flush(gdi->render);
+
+	bitmapData = &cache_bitmap_v3->bitmapData;
+
+	if (bitmapData->codecID != 0)
+	{
+		printf("unsupported bitmap codec: %d\n", bitmapData->codecID);
+		return;
+	}
+
+	bitmap = gdi_decoded_bitmap_new(gdi, bitmapData->width, bitmapData->height,
+			bitmapData->bpp, bitmapData->length, bitmapData->data, False);
+
+	gdi_bitmap_cache_put(gdi->bitmap_cache, cache_bitmap_v3->cacheId, cache_bitmap_v3->cacheIndex, bitmap);
+}
+
+/**
+ * Fill the text background (opaque) rectangle, right and bottom are exclusive.
+ */
+
+static void gdi_fill_text_background(GDI* gdi, int left, int top, int right, int bottom, uint32 color)
+{
+	GDI_RECT rect;
+
+	if (right <= left || bottom <= top)
+		return;
+
+	gdi_CRgnToRect(left, top, right - left, bottom - top, &rect);
+
+	color = gdi_color_convert(color, gdi->srcBpp, 32, gdi->clrconv);
+	gdi_SetDCBrushColor(gdi->drawing->hdc, color);
+	gdi_FillRect(gdi->drawing->hdc, &rect, gdi->drawing->hdc->dcBrush);
+}
+
+/**
+ * Draw a single glyph element of a text order and advance the text origin.\n
+ * A glyph element is the glyph cache index optionally followed by a 1 or 3 byte delta
+ * to the origin of the glyph, present only when there is no fixed character increment.
+ * @param gdi current GDI
+ * @param cacheId glyph cache id
+ * @param data glyph elements
+ * @param index current index in the glyph elements, updated
+ * @param length glyph elements length
+ * @param x text origin x, updated
+ * @param y text origin y, updated
+ * @param flAccel text accelerator flags
+ * @param ulCharInc fixed character increment
+ * @param color text color
+ */
+
+static void gdi_draw_glyph_element(GDI* gdi, uint8 cacheId, uint8* data, int* index, int length,
+		int* x, int* y, uint8 flAccel, uint8 ulCharInc, GDI_COLOR color)
+{
+	int offset;
+	GDI_GLYPH* glyph;
+
+	glyph = gdi_glyph_cache_get(gdi->glyph_cache, cacheId, data[*index]);
+	(*index)++;
+
+	if (ulCharInc == 0 && !(flAccel & SO_CHAR_INC_EQUAL_BM_BASE) && *index < length)
+	{
+		offset = data[*index];
+		(*index)++;
+
+		if (offset & 0x80)
+		{
+			if (*index + 1 >= length)
+				offset = 0;
+			else
+				offset = (sint16) (data[*index] | (data[*index + 1] << 8));
+
+			*index += 2;
+		}
+
+		if (flAccel & SO_VERTICAL)
+			*y += offset;
+		else
+			*x += offset;
+	}
+
+	if (glyph == NULL)
+		return;
+
+	gdi_GlyphBlt(gdi->drawing->hdc, *x + glyph->x, *y + glyph->y, glyph->cx, glyph->cy,
+			glyph->mask, 0, 0, glyph->cx, color);
+
+	if (flAccel & SO_CHAR_INC_EQUAL_BM_BASE)
+	{
+		if (flAccel & SO_VERTICAL)
+			*y += glyph->cy;
+		else
+			*x += glyph->cx;
+	}
+	else if (ulCharInc != 0)
+	{
+		if (flAccel & SO_VERTICAL)
+			*y += ulCharInc;
+		else
+			*x += ulCharInc;
+	}
+}
+
+/**
+ * Draw the glyph elements of a text order, including glyph fragments.\n
+ * GLYPH_FRAGMENT_ADD stores the elements since the previous fragment command in the
+ * fragment cache, GLYPH_FRAGMENT_USE draws a previously stored fragment.
+ */
+
+static void gdi_draw_text(GDI* gdi, uint8 cacheId, uint8* data, int length,
+		int x, int y, uint8 flAccel, uint8 ulCharInc, GDI_COLOR color)
+{
+	int i;
+	int start;
+	int index;
+	uint8* fragment;
+	uint32 size;
+
+	index = 0;
+	start = 0;
+
+	while (index < length)
+	{
+		switch (data[index])
+		{
+			case GLYPH_FRAGMENT_ADD:
+				if (index + 2 >= length)
+					return;
+
+				size = data[index + 2];
+
+				if (start + size <= index)
+					gdi_glyph_cache_fragment_put(gdi->glyph_cache, data[index + 1], size, &data[start]);
+
+				index += 3;
+				start = index;
+				break;
+
+			case GLYPH_FRAGMENT_USE:
+				if (index + 1 >= length)
+					return;
+
+				fragment = gdi_glyph_cache_fragment_get(gdi->glyph_cache, data[index + 1], &size);
+
+				if (fragment != NULL && size > 0)
+				{
+					/* the delta to the first glyph of the fragment follows the fragment index */
+					if (ulCharInc == 0 && !(flAccel & SO_CHAR_INC_EQUAL_BM_BASE) &&
+							(size < 2 || fragment[1] == 0) && index + 2 < length)
+					{
+						if (flAccel & SO_VERTICAL)
+							y += data[index + 2];
+						else
+							x += data[index + 2];
+					}
+
+					i = 0;
+
+					while (i < size)
+						gdi_draw_glyph_element(gdi, cacheId, fragment, &i, size, &x, &y, flAccel, ulCharInc, color);
+				}
+
+				index += (index + 2 < length) ? 3 : 2;
+				start = index;
+				break;
+
+			default:
+				gdi_draw_glyph_element(gdi, cacheId, data, &index, length, &x, &y, flAccel, ulCharInc, color);
+				break;
+		}
+	}
+}
+
+void gdi_glyph_index(rdpUpdate* update, GLYPH_INDEX_ORDER* glyph_index)
+{
+	GDI_COLOR color;
+	GDI* gdi = GET_GDI(update);
+
+	gdi_render_flush(gdi->render);
+
+	/* the opaque rectangle is filled with foreColor, the glyphs are drawn with backColor */
+	if (glyph_index->fOpRedundant)
+	{
+		gdi_fill_text_background(gdi, glyph_index->bkLeft, glyph_index->bkTop,
+				glyph_index->bkRight, glyph_index->bkBottom, glyph_index->foreColor);
+	}
+	else
+	{
+		gdi_fill_text_background(gdi, glyph_index->opLeft, glyph_index->opTop,
+				glyph_index->opRight, glyph_index->opBottom, glyph_index->foreColor);
+	}
+
+	color = gdi_color_convert(glyph_index->backColor, gdi->srcBpp, 32, gdi->clrconv);
+
+	gdi_draw_text(gdi, glyph_index->cacheId, glyph_index->data, glyph_index->cbData,
+			glyph_index->x, glyph_index->y, glyph_index->flAccel, glyph_index->ulCharInc, color);
+}
+
+/**
+ * Fill the opaque rectangle of a FastIndex or FastGlyph order.\n
+ * When opBottom is -32768, opTop holds flags telling which sides are the same as the background rectangle.
+ */
+
+static void gdi_fill_fast_text_background(GDI* gdi, int bkLeft, int bkTop, int bkRight, int bkBottom,
+		int opLeft, int opTop, int opRight, int opBottom, uint32 color)
+{
+	if (opBottom == -32768)
+	{
+		uint8 flags = (uint8) (opTop & 0x0F);
+
+		if (flags & 0x01)
+			opBottom = bkBottom;
+		if (flags & 0x02)
+			opRight = bkRight;
+		if (flags & 0x04)
+			opTop = bkTop;
+		if (flags & 0x08)
+			opLeft = bkLeft;
+	}
+
+	if (opLeft == 0)
+		opLeft = bkLeft;
+
+	if (opRight == 0)
+		opRight = bkRight;
+
+	gdi_fill_text_background(gdi, opLeft, opTop, opRight, opBottom, color);
+}
+
+void gdi_fast_index(rdpUpdate* update, FAST_INDEX_ORDER* fast_index)
+{
+	int x, y;
+	GDI_COLOR color;
+	GDI* gdi = GET_GDI(update);
+
+	gdi_render_flush(gdi->render);
+
+	gdi_fill_fast_text_background(gdi, fast_index->bkLeft, fast_index->bkTop,
+			fast_index->bkRight, fast_index->bkBottom, fast_index->opLeft, fast_index->opTop,
+			fast_index->opRight, fast_index->opBottom, fast_index->foreColor);
+
+	x = (fast_index->x == -32768) ? fast_index->bkLeft : fast_index->x;
+	y = (fast_index->y == -32768) ? fast_index->bkTop : fast_index->y;
+
+	color = gdi_color_convert(fast_index->backColor, gdi->srcBpp, 32, gdi->clrconv);
+
+	gdi_draw_text(gdi, fast_index->cacheId, fast_index->data, fast_index->cbData,
+			x, y, fast_index->flAccel, fast_index->ulCharInc, color);
+}
+
+void gdi_fast_glyph(rdpUpdate* update, FAST_GLYPH_ORDER* fast_glyph)
+{
+	int x, y;
+	GDI_COLOR color;
+	GDI_GLYPH* glyph;
+	GLYPH_DATA_V2* glyph_data;
+	GDI* gdi = GET_GDI(update);
+
+	gdi_render_flush(gdi->render);
+
+	gdi_fill_fast_text_background(gdi, fast_glyph->bkLeft, fast_glyph->bkTop,
+			fast_glyph->bkRight, fast_glyph->bkBottom, fast_glyph->opLeft, fast_glyph->opTop,
+			fast_glyph->opRight, fast_glyph->opBottom, fast_glyph->foreColor);
+
+	x = (fast_glyph->x == -32768) ? fast_glyph->bkLeft : fast_glyph->x;
+	y = (fast_glyph->y == -32768) ? fast_glyph->bkTop : fast_glyph->y;
+
+	glyph_data = &fast_glyph->glyph_data;
+
+	/* the order may carry the glyph definition, which is cached before being drawn */
+	if (glyph_data->aj != NULL)
+	{
+		glyph = gdi_glyph_new(glyph_data->x, glyph_data->y, glyph_data->cx, glyph_data->cy, glyph_data->aj);
+		gdi_glyph_cache_put(gdi->glyph_cache, fast_glyph->cacheId, glyph_data->cacheIndex, glyph);
+	}
+
+	glyph = gdi_glyph_cache_get(gdi->glyph_cache, fast_glyph->cacheId, glyph_data->cacheIndex);
+
+	if (glyph == NULL)
+		return;
+
+	color = gdi_color_convert(fast_glyph->backColor, gdi->srcBpp, 32, gdi->clrconv);
+
+	gdi_GlyphBlt(gdi->drawing->hdc, x + glyph->x, y + glyph->y, glyph->cx, glyph->cy,
+			glyph->mask, 0, 0, glyph->cx, color);
+}
+
+void gdi_cache_glyph(rdpUpdate* update, CACHE_GLYPH_ORDER* cache_glyph)
+{
+	int i;
+	GDI_GLYPH* glyph;
+	GLYPH_DATA* glyph_data;
+	GDI* gdi = GET_GDI(update);
+
+	for (i = 0; i < cache_glyph->cGlyphs; i++)
+	{
+		glyph_data = &cache_glyph->glyphData[i];
+		glyph = gdi_glyph_new(glyph_data->x, glyph_data->y, glyph_data->cx, glyph_data->cy, glyph_data->aj);
+		gdi_glyph_cache_put(gdi->glyph_cache, cache_glyph->cacheId, glyph_data->cacheIndex, glyph);
+	}
+}
+
+void gdi_cache_glyph_v2(rdpUpdate* update, CACHE_GLYPH_V2_ORDER* cache_glyph_v2)
+{
+	int i;
+	GDI_GLYPH* glyph;
+	GLYPH_DATA_V2* glyph_data;
+	GDI* gdi = GET_GDI(update);
+
+	for (i = 0; i < cache_glyph_v2->cGlyphs; i++)
+	{
+		glyph_data = &cache_glyph_v2->glyphData[i];
+		glyph = gdi_glyph_new(glyph_data->x, glyph_data->y, glyph_data->cx, glyph_data->cy, glyph_data->aj);
+		gdi_glyph_cache_put(gdi->glyph_cache, cache_glyph_v2->cacheId, glyph_data->cacheIndex, glyph);
+	}
+}
+
+/**
+ * End Paint.\n
+ * Recorded drawing orders are rasterized to the drawing surface and invalidated.
+ * Clients registering their own EndPaint callback must call it before reading the surface.
+ * @param update update
+ */
+
+void gdi_end_paint(rdpUpdate* update)
+{
+	GDI* gdi = GET_GDI(update);
+
+	gdi_render_flush(gdi->render);
+}
+
+/**
+ * Register GDI callbacks with libfreerdp.
+ * @param inst current instance
+ * @return
+ */
+
+void gdi_register_update_callbacks(rdpUpdate* update)
+{
+	update->Bitmap = gdi_bitmap_update;
+	update->Palette = gdi_palette_update;
+	update->SetBounds = gdi_set_bounds;
+	update->DstBlt = gdi_dstblt;
+	update->PatBlt = gdi_patblt;
+	update->ScrBlt = gdi_scrblt;
+	update->OpaqueRect = gdi_opaque_rect;
+	update->DrawNineGrid = NULL;
+	update->MultiDstBlt = gdi_multi_dstblt;
+	update->MultiPatBlt = gdi_multi_patblt;
+	update->MultiScrBlt = gdi_multi_scrblt;
+	update->MultiOpaqueRect = gdi_multi_opaque_rect;
+	update->MultiDrawNineGrid = NULL;
+	update->LineTo = gdi_line_to;
+	update->Polyline = NULL;
+	update->MemBlt = gdi_memblt;
+	update->Mem3Blt = gdi_mem3blt;
+	update->SaveBitmap = NULL;
+	update->GlyphIndex = gdi_glyph_index;
+	update->FastIndex = gdi_fast_index;
+	update->FastGlyph = gdi_fast_glyph;
+	update->PolygonSC = NULL;
+	update->PolygonCB = NULL;
+	update->EllipseSC = NULL;
+	update->EllipseCB = NULL;
+
+	update->CacheBitmap = gdi_cache_bitmap;
+	update->CacheBitmapV2 = gdi_cache_bitmap_v2;
+	update->CacheBitmapV3 = gdi_cache_bitmap_v3;
+	update->CacheGlyph = gdi_cache_glyph;
+	update->CacheGlyphV2 = gdi_cache_glyph_v2;
+
+	update->EndPaint = gdi_end_paint;
+}
+
+/**
+ * Initialize GDI
+ * @param inst current instance
+ * @return
+ */
+
+int gdi_init(freerdp* instance, uint32 flags)
+{
+	GDI *gdi = (GDI*) malloc(sizeof(GDI));
+	memset(gdi, 0, sizeof(GDI));
+	SET_GDI(instance->update, gdi);
 
 	gdi->width = instance->settings->width;
 	gdi->height = instance->settings->height;
@@ -1319,16 +2355,23 @@ int gdi_init(freerdp* instance, uint32 flags)
 		}
 	}
 	
+	/* scanline kernels for the instruction sets of the processor */
+	gdi_rop_init(freerdp_cpu_features());
+	gdi_color_init(freerdp_cpu_features());
+
 	gdi->hdc = gdi_GetDC();
 	gdi->hdc->bitsPerPixel = gdi->dstBpp;
 	gdi->hdc->bytesPerPixel = gdi->bytesPerPixel;
 
 	gdi->clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
-	gdi->clrconv->palette = NULL;
 	gdi->clrconv->alpha = (flags & CLRCONV_ALPHA) ? 1 : 0;
 	gdi->clrconv->invert = (flags & CLRCONV_INVERT) ? 1 : 0;
 	gdi->clrconv->rgb555 = (flags & CLRCONV_RGB555) ? 1 : 0;
 
+	/* the system palette is used until the server sends one */
+	gdi->palette = gdi_CreatePalette(gdi_GetSystemPalette());
+	gdi_color_set_palette(gdi->clrconv, (FRDP_PALETTE*) gdi->palette);
+
 	gdi->hdc->alpha = gdi->clrconv->alpha;
 	gdi->hdc->invert = gdi->clrconv->invert;
 	gdi->hdc->rgb555 = gdi->clrconv->rgb555;
@@ -1341,8 +2384,19 @@ int gdi_init(freerdp* instance, uint32 flags)
 	gdi->primary->hdc->hwnd->invalid = gdi_CreateRectRgn(0, 0, 0, 0);
 	gdi->primary->hdc->hwnd->invalid->null = 1;
 
+	gdi->primary->hdc->hwnd->count = GDI_MAX_INVALID_RECTS;
+	gdi->primary->hdc->hwnd->cinvalid = (HGDI_RGN) malloc(sizeof(GDI_RGN) * gdi->primary->hdc->hwnd->count);
+	gdi->primary->hdc->hwnd->ninvalid = 0;
+
 	gdi->tile = gdi_bitmap_new(gdi, 64, 64, 32, NULL);
 
+	gdi->bitmap_cache = gdi_bitmap_cache_new(instance->settings);
+	gdi->glyph_cache = gdi_glyph_cache_new(instance->settings);
+	gdi->decoder = gdi_decoder_new(gdi, gdi_decode_bitmap_data, gdi_decoder_cpus() - 1);
+
+	if (flags & GDI_PARALLEL_ORDERS)
+		gdi->render = gdi_render_new(gdi);
+
 	gdi_register_update_callbacks(instance->update);
 
 	return 0;
@@ -1354,9 +2408,15 @@ void gdi_free(freerdp* instance)
 
 	if (gdi)
 	{
+		gdi_render_free(gdi->render);
+		gdi_decoder_free(gdi->decoder);
 		gdi_bitmap_free(gdi->primary);
+		gdi_bitmap_cache_free(gdi->bitmap_cache);
+		gdi_glyph_cache_free(gdi->glyph_cache);
 		gdi_DeleteDC(gdi->hdc);
 		free(gdi->clrconv);
+		free(gdi->palette->entries);
+		free(gdi->palette);
 		free(gdi);
 	}
 	
@@ -188,9 +188,17 @@ struct _GDI_BRUSH
 typedef struct _GDI_BRUSH GDI_BRUSH;
 typedef GDI_BRUSH* HGDI_BRUSH;
 
+/* maximum number of rectangles in the damage region of a window */
+#define GDI_MAX_INVALID_RECTS		32
+
 struct _GDI_WND
 {
-	HGDI_RGN invalid;
+	HGDI_RGN invalid; /* bounding box of the damage region */
+
+	/* damage region, in band order */
+	int count;
+	int ninvalid;
+	HGDI_RGN cinvalid;
 };
 typedef struct _GDI_WND GDI_WND;
 typedef GDI_WND* HGDI_WND;
@@ -205,6 +213,19 @@ struct _GDI_DC
 	HGDI_BRUSH brush;
 	HGDI_RGN clip;
 	HGDI_PEN pen;
+
+	/* stock DC brush and pen, created on first use and recolored in place */
+	HGDI_BRUSH dcBrush;
+	HGDI_PEN dcPen;
+
+	/* scratch 8x8 pattern brush, created on first use and converted in place for each pattern order */
+	HGDI_BRUSH dcPatternBrush;
+
+	/* complex clipping region, y-banded rectangles within clip */
+	int nclip;
+	int maxclip;
+	HGDI_RGN cclip;
+
 	HGDI_WND hwnd;
 	int drawMode;
 	int bkMode;
@@ -224,6 +245,11 @@ struct _GDI_IMAGE
 typedef struct _GDI_IMAGE GDI_IMAGE;
 typedef GDI_IMAGE* HGDI_IMAGE;
 
+typedef struct _GDI_BITMAP_CACHE GDI_BITMAP_CACHE;
+typedef struct _GDI_GLYPH_CACHE GDI_GLYPH_CACHE;
+typedef struct _GDI_DECODER GDI_DECODER;
+typedef struct _GDI_RENDERER GDI_RENDERER;
+
 struct _GDI
 {
 	int width;
@@ -236,12 +262,17 @@ struct _GDI
 
 	HGDI_DC hdc;
 	HCLRCONV clrconv;
+	HGDI_PALETTE palette;
 	GDI_IMAGE *primary;
 	GDI_IMAGE *drawing;
 	uint8* primary_buffer;
 	GDI_COLOR textColor;
 	void * rfx_context;
 	GDI_IMAGE *tile;
+	GDI_BITMAP_CACHE *bitmap_cache;
+	GDI_GLYPH_CACHE *glyph_cache;
+	GDI_DECODER *decoder;
+	GDI_RENDERER *render;
 };
 typedef struct _GDI GDI;
 
@@ -253,6 +284,8 @@ uint8* gdi_get_brush_pointer(HGDI_DC hdcBrush, int x, int y);
 int gdi_is_mono_pixel_set(uint8* data, int x, int y, int width);
 GDI_IMAGE* gdi_bitmap_new(GDI *gdi, int width, int height, int bpp, uint8* data);
 void gdi_bitmap_free(GDI_IMAGE *gdi_bmp);
+void gdi_draw_order(GDI* gdi, HGDI_DC hdc, int type, void* order);
+void gdi_end_paint(rdpUpdate* update);
 int gdi_init(freerdp* instance, uint32 flags);
 void gdi_free(freerdp* instance);
 
@@ -29,9 +29,12 @@
 #include "gdi_region.h"
 #include "gdi_clipping.h"
 #include "gdi_drawing.h"
+#include "gdi_rop.h"
 
 #include "gdi_16bpp.h"
 
+static const uint8 gdi_all_bits[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+
 uint16 gdi_get_color_16bpp(HGDI_DC hdc, GDI_COLOR color)
 {
 	uint8 r, g, b;
@@ -99,6 +102,52 @@ int FillRect_16bpp(HGDI_DC hdc, HGDI_RECT rect, HGDI_BRUSH hbr)
 	return 0;
 }
 
+/**
+ * Fill the pixels selected by a one byte per pixel mask with a solid color.\n
+ * @param hdcDest destination device context
+ * @param nXDest destination x1
+ * @param nYDest destination y1
+ * @param nWidth width
+ * @param nHeight height
+ * @param mask mask, 0xFF where the color is drawn
+ * @param nXSrc mask x1
+ * @param nYSrc mask y1
+ * @param maskWidth mask width
+ * @param color color
+ * @return 1 if successful, 0 otherwise
+ */
+
+int GlyphBlt_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, uint8* mask, int nXSrc, int nYSrc, int maskWidth, GDI_COLOR color)
+{
+	int x, y;
+	uint8* maskp;
+	uint16* dstp;
+	uint16 color16;
+
+	if (gdi_ClipCoords(hdcDest, &nXDest, &nYDest, &nWidth, &nHeight, &nXSrc, &nYSrc) == 0)
+		return 0;
+
+	color16 = gdi_get_color_16bpp(hdcDest, color);
+
+	for (y = 0; y < nHeight; y++)
+	{
+		dstp = (uint16*) gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+		maskp = &mask[(nYSrc + y) * maskWidth + nXSrc];
+
+		if (dstp != 0)
+		{
+			for (x = 0; x < nWidth; x++)
+			{
+				if (maskp[x])
+					dstp[x] = color16;
+			}
+		}
+	}
+
+	gdi_InvalidateRegion(hdcDest, nXDest, nYDest, nWidth, nHeight);
+	return 1;
+}
+
 static int BitBlt_BLACKNESS_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight)
 {
 	int y;
@@ -231,7 +280,7 @@ static int BitBlt_NOTSRCCOPY_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int
 
 static int BitBlt_DSTINVERT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight)
 {
-	int x, y;
+	int y;
 	uint8 *dstp;
 		
 	for (y = 0; y < nHeight; y++)
@@ -239,16 +288,7 @@ static int BitBlt_DSTINVERT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp = ~(*dstp);
-				dstp++;
-					
-				*dstp = ~(*dstp);
-				dstp++;
-			}
-		}
+			gdi_rop_xor_pattern(dstp, gdi_all_bits, nWidth * 2);
 	}
 
 	return 0;
@@ -314,7 +354,7 @@ static int BitBlt_NOTSRCERASE_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int
 
 static int BitBlt_SRCINVERT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
 		
@@ -324,18 +364,7 @@ static int BitBlt_SRCINVERT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp ^= *srcp;
-				srcp++;
-				dstp++;
-					
-				*dstp ^= *srcp;
-				srcp++;
-				dstp++;
-			}
-		}
+			gdi_rop_xor(dstp, srcp, NULL, nWidth * 2);
 	}
 
 	return 0;
@@ -343,7 +372,7 @@ static int BitBlt_SRCINVERT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 
 static int BitBlt_SRCAND_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
 		
@@ -353,18 +382,7 @@ static int BitBlt_SRCAND_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWid
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp &= *srcp;
-				srcp++;
-				dstp++;
-					
-				*dstp &= *srcp;
-				srcp++;
-				dstp++;
-			}
-		}
+			gdi_rop_and(dstp, srcp, NULL, nWidth * 2);
 	}
 
 	return 0;
@@ -372,7 +390,7 @@ static int BitBlt_SRCAND_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWid
 
 static int BitBlt_SRCPAINT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
 		
@@ -382,18 +400,7 @@ static int BitBlt_SRCPAINT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp |= *srcp;
-				srcp++;
-				dstp++;
-					
-				*dstp |= *srcp;
-				srcp++;
-				dstp++;
-			}
-		}
+			gdi_rop_or(dstp, srcp, NULL, nWidth * 2);
 	}
 
 	return 0;
@@ -401,17 +408,17 @@ static int BitBlt_SRCPAINT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 
 static int BitBlt_DSPDxax_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {	
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
-	uint8 *patp;
-	uint16 color16;
+	uint16 color16[2];
 	HGDI_BITMAP hSrcBmp;
 
 	/* D = (S & P) | (~S & D) */
 	/* DSPDxax, used to draw glyphs */
 
-	color16 = gdi_get_color_16bpp(hdcDest, hdcDest->textColor);
+	color16[0] = gdi_get_color_16bpp(hdcDest, hdcDest->textColor);
+	color16[1] = color16[0];
 
 	hSrcBmp = (HGDI_BITMAP) hdcSrc->selectedObject;
 	srcp = hSrcBmp->data;
@@ -428,21 +435,7 @@ static int BitBlt_DSPDxax_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWi
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				patp = (uint8*) &color16;
-
-				*dstp = (*srcp & *patp) | (~(*srcp) & *dstp);
-				dstp++;
-				patp++;
-
-				*dstp = (*srcp & *patp) | (~(*srcp) & *dstp);
-				dstp++;
-				patp++;
-				srcp++;
-			}
-		}
+			gdi_rop_dspdxax(dstp, srcp, (uint8*) color16, NULL, nWidth, 2);
 	}
 
 	return 0;
@@ -580,25 +573,19 @@ static int BitBlt_PATCOPY_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWi
 	int x, y;
 	uint8 *dstp;
 	uint8 *patp;
-	uint16 color16;
-	uint16 *dstp16;
+	uint16 color16[2];
 
 	if(hdcDest->brush->style == GDI_BS_SOLID)
 	{
-		color16 = gdi_get_color_16bpp(hdcDest, hdcDest->brush->color);
+		color16[0] = gdi_get_color_16bpp(hdcDest, hdcDest->brush->color);
+		color16[1] = color16[0];
 
 		for (y = 0; y < nHeight; y++)
 		{
-			dstp16 = (uint16*) gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+			dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
-			if (dstp16 != 0)
-			{
-				for (x = 0; x < nWidth; x++)
-				{
-					*dstp16 = color16;
-					dstp16++;
-				}
-			}
+			if (dstp != 0)
+				gdi_rop_fill(dstp, (uint8*) color16, nWidth * 2);
 		}
 	}
 	else
@@ -633,25 +620,19 @@ static int BitBlt_PATINVERT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 	int x, y;
 	uint8 *dstp;
 	uint8 *patp;
-	uint16 color16;
-	uint16 *dstp16;
+	uint16 color16[2];
 
 	if(hdcDest->brush->style == GDI_BS_SOLID)
 	{
-		color16 = gdi_get_color_16bpp(hdcDest, hdcDest->brush->color);
+		color16[0] = gdi_get_color_16bpp(hdcDest, hdcDest->brush->color);
+		color16[1] = color16[0];
 
 		for (y = 0; y < nHeight; y++)
 		{
-			dstp16 = (uint16*) gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+			dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
-			if (dstp16 != 0)
-			{
-				for (x = 0; x < nWidth; x++)
-				{
-					*dstp16 ^= color16;
-					dstp16++;
-				}
-			}
+			if (dstp != 0)
+				gdi_rop_xor_pattern(dstp, (uint8*) color16, nWidth * 2);
 		}
 	}
 	else
@@ -715,6 +696,20 @@ static int BitBlt_PATPAINT_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 	return 0;
 }
 
+static int BitBlt_ROP3_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop)
+{
+	/* raster operations without a dedicated routine */
+	uint16 color16[2] = { 0, 0 };
+
+	if (hdcDest->brush != NULL && hdcDest->brush->style == GDI_BS_SOLID)
+	{
+		color16[0] = gdi_get_color_16bpp(hdcDest, hdcDest->brush->color);
+		color16[1] = color16[0];
+	}
+
+	return gdi_rop3_blt(hdcDest, nXDest, nYDest, nWidth, nHeight, hdcSrc, nXSrc, nYSrc, rop, (uint8*) color16, NULL);
+}
+
 int BitBlt_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop)
 {
 	if (hdcSrc != NULL)
@@ -805,8 +800,7 @@ int BitBlt_16bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeigh
 			break;
 	}
 	
-	printf("BitBlt: unknown rop: 0x%08X\n", rop);
-	return 1;
+	return BitBlt_ROP3_16bpp(hdcDest, nXDest, nYDest, nWidth, nHeight, hdcSrc, nXSrc, nYSrc, rop);
 }
 
 int PatBlt_16bpp(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, int rop)
@@ -839,8 +833,7 @@ int PatBlt_16bpp(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, i
 			break;
 	}
 	
-	printf("PatBlt: unknown rop: 0x%08X", rop);
-	return 1;
+	return BitBlt_ROP3_16bpp(hdc, nXLeft, nYLeft, nWidth, nHeight, NULL, 0, 0, rop);
 }
 
 void SetPixel_BLACK_16bpp(uint16 *pixel, uint16 *pen)
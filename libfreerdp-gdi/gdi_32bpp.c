@@ -29,9 +29,14 @@
 #include "gdi_region.h"
 #include "gdi_clipping.h"
 #include "gdi_drawing.h"
+#include "gdi_rop.h"
 
 #include "gdi_32bpp.h"
 
+/* raster operations leave the alpha byte of BGRA pixels untouched */
+static const uint8 gdi_rgb_mask[4] = { 0xFF, 0xFF, 0xFF, 0x00 };
+static const uint8 gdi_black_alpha[4] = { 0x00, 0x00, 0x00, 0xFF };
+
 uint32 gdi_get_color_32bpp(HGDI_DC hdc, GDI_COLOR color)
 {
 	uint32 color32;
@@ -85,11 +90,57 @@ int FillRect_32bpp(HGDI_DC hdc, HGDI_RECT rect, HGDI_BRUSH hbr)
 	return 0;
 }
 
+/**
+ * Fill the pixels selected by a one byte per pixel mask with a solid color.\n
+ * @param hdcDest destination device context
+ * @param nXDest destination x1
+ * @param nYDest destination y1
+ * @param nWidth width
+ * @param nHeight height
+ * @param mask mask, 0xFF where the color is drawn
+ * @param nXSrc mask x1
+ * @param nYSrc mask y1
+ * @param maskWidth mask width
+ * @param color color
+ * @return 1 if successful, 0 otherwise
+ */
+
+int GlyphBlt_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, uint8* mask, int nXSrc, int nYSrc, int maskWidth, GDI_COLOR color)
+{
+	int x, y;
+	uint8* maskp;
+	uint32* dstp;
+	uint32 color32;
+
+	if (gdi_ClipCoords(hdcDest, &nXDest, &nYDest, &nWidth, &nHeight, &nXSrc, &nYSrc) == 0)
+		return 0;
+
+	color32 = gdi_get_color_32bpp(hdcDest, color);
+
+	for (y = 0; y < nHeight; y++)
+	{
+		dstp = (uint32*) gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+		maskp = &mask[(nYSrc + y) * maskWidth + nXSrc];
+
+		if (dstp != 0)
+		{
+			for (x = 0; x < nWidth; x++)
+			{
+				if (maskp[x])
+					dstp[x] = color32;
+			}
+		}
+	}
+
+	gdi_InvalidateRegion(hdcDest, nXDest, nYDest, nWidth, nHeight);
+	return 1;
+}
+
 static int BitBlt_BLACKNESS_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight)
 {
 	if (hdcDest->alpha)
 	{
-		int x, y;
+		int y;
 		uint8 *dstp;
 
 		for (y = 0; y < nHeight; y++)
@@ -97,22 +148,7 @@ static int BitBlt_BLACKNESS_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 			dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 			if (dstp != 0)
-			{
-				for (x = 0; x < nWidth; x++)
-				{
-					*dstp = 0;
-					dstp++;
-
-					*dstp = 0;
-					dstp++;
-
-					*dstp = 0;
-					dstp++;
-
-					*dstp = 0xFF;
-					dstp++;
-				}
-			}
+				gdi_rop_fill(dstp, gdi_black_alpha, nWidth * 4);
 		}
 	}
 	else
@@ -252,7 +288,7 @@ static int BitBlt_NOTSRCCOPY_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int
 
 static int BitBlt_DSTINVERT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight)
 {
-	int x, y;
+	int y;
 	uint8 *dstp;
 		
 	for (y = 0; y < nHeight; y++)
@@ -260,19 +296,7 @@ static int BitBlt_DSTINVERT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp = ~(*dstp);
-				dstp++;
-					
-				*dstp = ~(*dstp);
-				dstp++;
-
-				*dstp = ~(*dstp);
-				dstp += 2;
-			}
-		}
+			gdi_rop_xor_pattern(dstp, gdi_rgb_mask, nWidth * 4);
 	}
 
 	return 0;
@@ -346,7 +370,7 @@ static int BitBlt_NOTSRCERASE_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int
 
 static int BitBlt_SRCINVERT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
 		
@@ -356,22 +380,7 @@ static int BitBlt_SRCINVERT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp ^= *srcp;
-				srcp++;
-				dstp++;
-					
-				*dstp ^= *srcp;
-				srcp++;
-				dstp++;
-
-				*dstp ^= *srcp;
-				srcp += 2;
-				dstp += 2;
-			}
-		}
+			gdi_rop_xor(dstp, srcp, gdi_rgb_mask, nWidth * 4);
 	}
 
 	return 0;
@@ -379,7 +388,7 @@ static int BitBlt_SRCINVERT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 
 static int BitBlt_SRCAND_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
 		
@@ -389,22 +398,7 @@ static int BitBlt_SRCAND_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWid
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp &= *srcp;
-				srcp++;
-				dstp++;
-					
-				*dstp &= *srcp;
-				srcp++;
-				dstp++;
-
-				*dstp &= *srcp;
-				srcp += 2;
-				dstp += 2;
-			}
-		}
+			gdi_rop_and(dstp, srcp, gdi_rgb_mask, nWidth * 4);
 	}
 
 	return 0;
@@ -412,7 +406,7 @@ static int BitBlt_SRCAND_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWid
 
 static int BitBlt_SRCPAINT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
 		
@@ -422,22 +416,7 @@ static int BitBlt_SRCPAINT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp |= *srcp;
-				srcp++;
-				dstp++;
-					
-				*dstp |= *srcp;
-				srcp++;
-				dstp++;
-
-				*dstp |= *srcp;
-				srcp += 2;
-				dstp += 2;
-			}
-		}
+			gdi_rop_or(dstp, srcp, gdi_rgb_mask, nWidth * 4);
 	}
 
 	return 0;
@@ -445,10 +424,9 @@ static int BitBlt_SRCPAINT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 
 static int BitBlt_DSPDxax_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {	
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
-	uint8 *patp;
 	uint32 color32;
 	HGDI_BITMAP hSrcBmp;
 
@@ -472,24 +450,7 @@ static int BitBlt_DSPDxax_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWi
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				patp = (uint8*) &color32;
-
-				*dstp = (*srcp & *patp) | (~(*srcp) & *dstp);
-				dstp++;
-				patp++;
-
-				*dstp = (*srcp & *patp) | (~(*srcp) & *dstp);
-				dstp++;
-				patp++;
-
-				*dstp = (*srcp & *patp) | (~(*srcp) & *dstp);
-				dstp += 2;
-				srcp++;
-			}
-		}
+			gdi_rop_dspdxax(dstp, srcp, (uint8*) &color32, gdi_rgb_mask, nWidth, 4);
 	}
 
 	return 0;
@@ -644,7 +605,6 @@ static int BitBlt_PATCOPY_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWi
 	uint8 *dstp;
 	uint8 *patp;
 	uint32 color32;
-	uint32 *dstp32;
 
 	if(hdcDest->brush->style == GDI_BS_SOLID)
 	{
@@ -652,16 +612,10 @@ static int BitBlt_PATCOPY_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWi
 
 		for (y = 0; y < nHeight; y++)
 		{
-			dstp32 = (uint32*) gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+			dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
-			if (dstp32 != 0)
-			{
-				for (x = 0; x < nWidth; x++)
-				{
-					*dstp32 = color32;
-					dstp32++;
-				}
-			}
+			if (dstp != 0)
+				gdi_rop_fill(dstp, (uint8*) &color32, nWidth * 4);
 		}
 	}
 	else
@@ -700,7 +654,6 @@ static int BitBlt_PATINVERT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 	uint8 *dstp;
 	uint8 *patp;
 	uint32 color32;
-	uint32 *dstp32;
 		
 	if(hdcDest->brush->style == GDI_BS_SOLID)
 	{
@@ -708,16 +661,10 @@ static int BitBlt_PATINVERT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 
 		for (y = 0; y < nHeight; y++)
 		{
-			dstp32 = (uint32*) gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+			dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
-			if (dstp32 != 0)
-			{
-				for (x = 0; x < nWidth; x++)
-				{
-					*dstp32 ^= color32;
-					dstp32++;
-				}
-			}
+			if (dstp != 0)
+				gdi_rop_xor_pattern(dstp, (uint8*) &color32, nWidth * 4);
 		}
 	}
 	else
@@ -788,6 +735,17 @@ static int BitBlt_PATPAINT_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 	return 0;
 }
 
+static int BitBlt_ROP3_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop)
+{
+	/* raster operations without a dedicated routine */
+	uint32 color32 = 0;
+
+	if (hdcDest->brush != NULL && hdcDest->brush->style == GDI_BS_SOLID)
+		color32 = gdi_get_color_32bpp(hdcDest, hdcDest->brush->color);
+
+	return gdi_rop3_blt(hdcDest, nXDest, nYDest, nWidth, nHeight, hdcSrc, nXSrc, nYSrc, rop, (uint8*) &color32, gdi_rgb_mask);
+}
+
 int BitBlt_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop)
 {
 	if (hdcSrc != NULL)
@@ -878,8 +836,7 @@ int BitBlt_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeigh
 			break;
 	}
 	
-	printf("BitBlt: unknown rop: 0x%08X\n", rop);
-	return 1;
+	return BitBlt_ROP3_32bpp(hdcDest, nXDest, nYDest, nWidth, nHeight, hdcSrc, nXSrc, nYSrc, rop);
 }
 
 int PatBlt_32bpp(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, int rop)
@@ -912,8 +869,7 @@ int PatBlt_32bpp(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, i
 			break;
 	}
 	
-	printf("PatBlt: unknown rop: 0x%08X", rop);
-	return 1;
+	return BitBlt_ROP3_32bpp(hdc, nXLeft, nYLeft, nWidth, nHeight, NULL, 0, 0, rop);
 }
 
 void SetPixel_BLACK_32bpp(uint32 *pixel, uint32 *pen)
@@ -29,15 +29,65 @@
 #include "gdi_region.h"
 #include "gdi_clipping.h"
 #include "gdi_drawing.h"
+#include "gdi_rop.h"
 
 #include "gdi_8bpp.h"
 
+static const uint8 gdi_all_bits[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+
 int FillRect_8bpp(HGDI_DC hdc, HGDI_RECT rect, HGDI_BRUSH hbr)
 {
 	/* TODO: Implement 8bpp FillRect() */
 	return 0;
 }
 
+/**
+ * Fill the pixels selected by a one byte per pixel mask with a solid color.\n
+ * @param hdcDest destination device context
+ * @param nXDest destination x1
+ * @param nYDest destination y1
+ * @param nWidth width
+ * @param nHeight height
+ * @param mask mask, 0xFF where the color is drawn
+ * @param nXSrc mask x1
+ * @param nYSrc mask y1
+ * @param maskWidth mask width
+ * @param color color
+ * @return 1 if successful, 0 otherwise
+ */
+
+int GlyphBlt_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, uint8* mask, int nXSrc, int nYSrc, int maskWidth, GDI_COLOR color)
+{
+	int x, y;
+	uint8* maskp;
+	uint8* dstp;
+	uint8 palIndex;
+
+	if (gdi_ClipCoords(hdcDest, &nXDest, &nYDest, &nWidth, &nHeight, &nXSrc, &nYSrc) == 0)
+		return 0;
+
+	/* the palette index is carried in the same byte as for solid brushes */
+	palIndex = ((color >> 16) & 0xFF);
+
+	for (y = 0; y < nHeight; y++)
+	{
+		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+		maskp = &mask[(nYSrc + y) * maskWidth + nXSrc];
+
+		if (dstp != 0)
+		{
+			for (x = 0; x < nWidth; x++)
+			{
+				if (maskp[x])
+					dstp[x] = palIndex;
+			}
+		}
+	}
+
+	gdi_InvalidateRegion(hdcDest, nXDest, nYDest, nWidth, nHeight);
+	return 1;
+}
+
 static int BitBlt_BLACKNESS_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight)
 {
 	int y;
@@ -166,7 +216,7 @@ static int BitBlt_NOTSRCCOPY_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int n
 
 static int BitBlt_DSTINVERT_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight)
 {
-	int x, y;
+	int y;
 	uint8 *dstp;
 		
 	for (y = 0; y < nHeight; y++)
@@ -174,13 +224,7 @@ static int BitBlt_DSTINVERT_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp = ~(*dstp);
-				dstp++;
-			}
-		}
+			gdi_rop_xor_pattern(dstp, gdi_all_bits, nWidth);
 	}
 
 	return 0;
@@ -238,7 +282,7 @@ static int BitBlt_NOTSRCERASE_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int
 
 static int BitBlt_SRCINVERT_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
 		
@@ -248,14 +292,7 @@ static int BitBlt_SRCINVERT_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp ^= *srcp;
-				srcp++;
-				dstp++;
-			}
-		}
+			gdi_rop_xor(dstp, srcp, NULL, nWidth);
 	}
 
 	return 0;
@@ -263,7 +300,7 @@ static int BitBlt_SRCINVERT_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 
 static int BitBlt_SRCAND_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
 		
@@ -273,14 +310,7 @@ static int BitBlt_SRCAND_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidt
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp &= *srcp;
-				srcp++;
-				dstp++;
-			}
-		}
+			gdi_rop_and(dstp, srcp, NULL, nWidth);
 	}
 
 	return 0;
@@ -288,7 +318,7 @@ static int BitBlt_SRCAND_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidt
 
 static int BitBlt_SRCPAINT_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc)
 {
-	int x, y;
+	int y;
 	uint8 *srcp;
 	uint8 *dstp;
 		
@@ -298,14 +328,7 @@ static int BitBlt_SRCPAINT_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWi
 		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
 
 		if (dstp != 0)
-		{
-			for (x = 0; x < nWidth; x++)
-			{
-				*dstp |= *srcp;
-				srcp++;
-				dstp++;
-			}
-		}
+			gdi_rop_or(dstp, srcp, NULL, nWidth);
 	}
 
 	return 0;
@@ -438,14 +461,9 @@ static int BitBlt_PATCOPY_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWid
 		for (y = 0; y < nHeight; y++)
 		{
 			dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+
 			if (dstp != 0)
-			{
-				for (x = 0; x < nWidth; x++)
-				{
-					*dstp = palIndex;
-					dstp++;
-				}
-			}
+				memset(dstp, palIndex, nWidth);
 		}
 	}
 	else
@@ -476,22 +494,19 @@ static int BitBlt_PATINVERT_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nW
 	int x, y;
 	uint8 *dstp;
 	uint8 *patp;
-	uint8 palIndex;
+	uint8 palIndex[4];
 
 	if(hdcDest->brush->style == GDI_BS_SOLID)
 	{
-		palIndex = ((hdcDest->brush->color >> 16) & 0xFF);
+		palIndex[0] = ((hdcDest->brush->color >> 16) & 0xFF);
+		palIndex[1] = palIndex[2] = palIndex[3] = palIndex[0];
+
 		for (y = 0; y < nHeight; y++)
 		{
 			dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+
 			if (dstp != 0)
-			{
-				for (x = 0; x < nWidth; x++)
-				{
-					*dstp ^= palIndex;
-					dstp++;
-				}
-			}
+				gdi_rop_xor_pattern(dstp, palIndex, nWidth);
 		}
 	}
 	else
@@ -546,6 +561,20 @@ static int BitBlt_PATPAINT_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWi
 	return 0;
 }
 
+static int BitBlt_ROP3_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop)
+{
+	/* raster operations without a dedicated routine */
+	uint8 palIndex[4] = { 0, 0, 0, 0 };
+
+	if (hdcDest->brush != NULL && hdcDest->brush->style == GDI_BS_SOLID)
+	{
+		palIndex[0] = ((hdcDest->brush->color >> 16) & 0xFF);
+		palIndex[1] = palIndex[2] = palIndex[3] = palIndex[0];
+	}
+
+	return gdi_rop3_blt(hdcDest, nXDest, nYDest, nWidth, nHeight, hdcSrc, nXSrc, nYSrc, rop, palIndex, NULL);
+}
+
 int BitBlt_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop)
 {
 	if (hdcSrc != NULL)
@@ -636,8 +665,7 @@ int BitBlt_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight
 			break;
 	}
 	
-	printf("BitBlt: unknown rop: 0x%08X\n", rop);
-	return 1;
+	return BitBlt_ROP3_8bpp(hdcDest, nXDest, nYDest, nWidth, nHeight, hdcSrc, nXSrc, nYSrc, rop);
 }
 
 int PatBlt_8bpp(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, int rop)
@@ -670,8 +698,7 @@ int PatBlt_8bpp(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, in
 			break;
 	}
 	
-	printf("PatBlt: unknown rop: 0x%08X", rop);
-	return 1;
+	return BitBlt_ROP3_8bpp(hdc, nXLeft, nYLeft, nWidth, nHeight, NULL, 0, 0, rop);
 }
 
 void SetPixel_BLACK_8bpp(uint8 *pixel, uint8 *pen)
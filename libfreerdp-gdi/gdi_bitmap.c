@@ -28,6 +28,7 @@
 #include "gdi_32bpp.h"
 #include "gdi_16bpp.h"
 #include "gdi_8bpp.h"
+#include "gdi_clipping.h"
 
 #include "gdi_bitmap.h"
 
@@ -40,6 +41,15 @@ pBitBlt BitBlt_[5] =
 	BitBlt_32bpp
 };
 
+pGlyphBlt GlyphBlt_[5] =
+{
+	NULL,
+	GlyphBlt_8bpp,
+	GlyphBlt_16bpp,
+	NULL,
+	GlyphBlt_32bpp
+};
+
 /**
  * Get pixel at the given coordinates.\n
  * @msdn{dd144909}
@@ -180,10 +190,117 @@ HGDI_BITMAP gdi_CreateCompatibleBitmap(HGDI_DC hdc, int nWidth, int nHeight)
 
 int gdi_BitBlt(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop)
 {
+	int i, j;
+	int status = 0;
+	int first, last;
+	int start, end;
+	boolean upwards;
+	boolean leftwards;
+	GDI_RGN bounds;
+	HGDI_RGN rect;
+	HGDI_RGN cclip;
 	pBitBlt _BitBlt = BitBlt_[IBPP(hdcDest->bitsPerPixel)];
 
-	if (_BitBlt != NULL)
+	if (_BitBlt == NULL)
+		return 0;
+
+	if (hdcDest->nclip == 0)
 		return _BitBlt(hdcDest, nXDest, nYDest, nWidth, nHeight, hdcSrc, nXSrc, nYSrc, rop);
-	else
+
+	/* blit through each rectangle of the complex clipping region */
+	if (gdi_GetClipBands(hdcDest, nYDest, nHeight, &first, &last) == 0)
+		return 0;
+
+	/* a source within the destination bitmap must be read before being overwritten */
+	upwards = leftwards = False;
+
+	if (hdcSrc != NULL && hdcSrc->selectedObject == hdcDest->selectedObject)
+	{
+		upwards = (nYSrc < nYDest) ? True : False;
+		leftwards = (nXSrc < nXDest) ? True : False;
+	}
+
+	cclip = hdcDest->cclip;
+	bounds = *hdcDest->clip;
+
+	for (i = 0; i < last - first; i += end - start)
+	{
+		if (upwards)
+		{
+			end = last - i;
+			for (start = end - 1; start > first && cclip[start - 1].y == cclip[end - 1].y; start--);
+		}
+		else
+		{
+			start = first + i;
+			for (end = start + 1; end < last && cclip[end].y == cclip[start].y; end++);
+		}
+
+		for (j = 0; j < end - start; j++)
+		{
+			rect = &cclip[leftwards ? end - 1 - j : start + j];
+
+			if (rect->x < nXDest + nWidth && rect->x + rect->w > nXDest)
+			{
+				*hdcDest->clip = *rect;
+				status = _BitBlt(hdcDest, nXDest, nYDest, nWidth, nHeight, hdcSrc, nXSrc, nYSrc, rop);
+			}
+		}
+	}
+
+	*hdcDest->clip = bounds;
+
+	return status;
+}
+
+/**
+ * Draw a glyph mask in a solid color, used for text rendering.\n
+ * @param hdcDest destination device context
+ * @param nXDest destination x1
+ * @param nYDest destination y1
+ * @param nWidth width
+ * @param nHeight height
+ * @param mask glyph mask, one byte per pixel
+ * @param nXSrc mask x1
+ * @param nYSrc mask y1
+ * @param maskWidth mask width
+ * @param color text color
+ * @return 1 if successful, 0 otherwise
+ */
+
+int gdi_GlyphBlt(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, uint8* mask, int nXSrc, int nYSrc, int maskWidth, GDI_COLOR color)
+{
+	int i;
+	int status = 0;
+	int first, last;
+	GDI_RGN bounds;
+	HGDI_RGN rect;
+	pGlyphBlt _GlyphBlt = GlyphBlt_[IBPP(hdcDest->bitsPerPixel)];
+
+	if (_GlyphBlt == NULL)
 		return 0;
+
+	if (hdcDest->nclip == 0)
+		return _GlyphBlt(hdcDest, nXDest, nYDest, nWidth, nHeight, mask, nXSrc, nYSrc, maskWidth, color);
+
+	/* draw through each rectangle of the complex clipping region */
+	if (gdi_GetClipBands(hdcDest, nYDest, nHeight, &first, &last) == 0)
+		return 0;
+
+	bounds = *hdcDest->clip;
+
+	for (i = first; i < last; i++)
+	{
+		rect = &hdcDest->cclip[i];
+
+		if (rect->x < nXDest + nWidth && rect->x + rect->w > nXDest)
+		{
+			*hdcDest->clip = *rect;
+			status = _GlyphBlt(hdcDest, nXDest, nYDest, nWidth, nHeight, mask, nXSrc, nYSrc, maskWidth, color);
+		}
+	}
+
+	*hdcDest->clip = bounds;
+
+	return status;
 }
@@ -24,6 +24,7 @@
 
 HGDI_BRUSH gdi_CreateSolidBrush(GDI_COLOR crColor);
 HGDI_BRUSH gdi_CreatePatternBrush(HGDI_BITMAP hbmp);
+GDI_COLOR gdi_SetDCBrushColor(HGDI_DC hdc, GDI_COLOR crColor);
 int gdi_PatBlt(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, int rop);
 
 typedef int (*pPatBlt)(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, int rop);
@@ -0,0 +1,325 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * GDI Caches
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <freerdp/freerdp.h>
+#include "gdi.h"
+
+#include "gdi_cache.h"
+
+/* entries advertised in the revision 1 bitmap cache capability set */
+static const uint32 bitmap_cache_v1_entries[3] = { 200, 600, 1000 };
+
+/**
+ * Map a cache index to a slot, the waiting list uses the extra slot at the end of the cell.\n
+ * @param cell bitmap cache cell
+ * @param index cache index
+ * @return slot, or -1 if out of range
+ */
+
+static int gdi_bitmap_cache_slot(GDI_BITMAP_CACHE_CELL* cell, uint32 index)
+{
+	if (index == GDI_BITMAP_CACHE_WAITING_LIST_INDEX)
+		return cell->number;
+
+	if (index >= cell->number)
+		return -1;
+
+	return index;
+}
+
+GDI_IMAGE* gdi_bitmap_cache_get(GDI_BITMAP_CACHE* cache, uint32 id, uint32 index)
+{
+	int slot;
+
+	if (id >= cache->maxCells)
+	{
+		printf("invalid bitmap cache id: %d\n", id);
+		return NULL;
+	}
+
+	slot = gdi_bitmap_cache_slot(&cache->cells[id], index);
+
+	if (slot < 0)
+	{
+		printf("invalid bitmap cache index: %d in cell id: %d\n", index, id);
+		return NULL;
+	}
+
+	return cache->cells[id].entries[slot];
+}
+
+void gdi_bitmap_cache_put(GDI_BITMAP_CACHE* cache, uint32 id, uint32 index, GDI_IMAGE* bitmap)
+{
+	int slot;
+
+	if (id >= cache->maxCells)
+	{
+		printf("invalid bitmap cache id: %d\n", id);
+		gdi_bitmap_free(bitmap);
+		return;
+	}
+
+	slot = gdi_bitmap_cache_slot(&cache->cells[id], index);
+
+	if (slot < 0)
+	{
+		printf("invalid bitmap cache index: %d in cell id: %d\n", index, id);
+		gdi_bitmap_free(bitmap);
+		return;
+	}
+
+	if (cache->cells[id].entries[slot] != NULL)
+		gdi_bitmap_free(cache->cells[id].entries[slot]);
+
+	cache->cells[id].entries[slot] = bitmap;
+}
+
+/**
+ * Create a bitmap cache large enough for the bitmap cache capability sets we advertise.\n
+ * Revision 1 and revision 2 orders share the same cells, so each cell is sized for the larger of the two.
+ * @param settings settings
+ * @return new bitmap cache
+ */
+
+GDI_BITMAP_CACHE* gdi_bitmap_cache_new(rdpSettings* settings)
+{
+	int i;
+	uint32 number;
+	GDI_BITMAP_CACHE* cache;
+
+	cache = (GDI_BITMAP_CACHE*) malloc(sizeof(GDI_BITMAP_CACHE));
+	memset(cache, 0, sizeof(GDI_BITMAP_CACHE));
+
+	cache->maxCells = 3;
+
+	if (settings->bitmap_cache_v2_num_cells > cache->maxCells)
+		cache->maxCells = settings->bitmap_cache_v2_num_cells;
+
+	if (cache->maxCells > GDI_BITMAP_CACHE_MAX_CELLS)
+		cache->maxCells = GDI_BITMAP_CACHE_MAX_CELLS;
+
+	for (i = 0; i < cache->maxCells; i++)
+	{
+		number = (i < 3) ? bitmap_cache_v1_entries[i] : 0;
+
+		if (i < settings->bitmap_cache_v2_num_cells &&
+				settings->bitmap_cache_v2_cell_info[i].numEntries > number)
+			number = settings->bitmap_cache_v2_cell_info[i].numEntries;
+
+		/* one more entry for the waiting list */
+		cache->cells[i].number = number;
+		cache->cells[i].entries = (GDI_IMAGE**) malloc(sizeof(GDI_IMAGE*) * (number + 1));
+		memset(cache->cells[i].entries, 0, sizeof(GDI_IMAGE*) * (number + 1));
+	}
+
+	return cache;
+}
+
+void gdi_bitmap_cache_free(GDI_BITMAP_CACHE* cache)
+{
+	int i, j;
+
+	if (cache != NULL)
+	{
+		for (i = 0; i < cache->maxCells; i++)
+		{
+			for (j = 0; j <= cache->cells[i].number; j++)
+			{
+				if (cache->cells[i].entries[j] != NULL)
+					gdi_bitmap_free(cache->cells[i].entries[j]);
+			}
+
+			free(cache->cells[i].entries);
+		}
+
+		free(cache);
+	}
+}
+
+/**
+ * Create a glyph from its 1bpp bitmap.\n
+ * The bitmap is expanded to one byte per pixel so that text can be drawn without bit twiddling.
+ * @param x glyph origin x offset
+ * @param y glyph origin y offset
+ * @param cx glyph width
+ * @param cy glyph height
+ * @param aj 1bpp glyph bitmap, rows padded to a byte boundary
+ * @return new glyph
+ */
+
+GDI_GLYPH* gdi_glyph_new(int x, int y, int cx, int cy, uint8* aj)
+{
+	int i, j;
+	int scanline;
+	uint8* srcp;
+	uint8* maskp;
+	GDI_GLYPH* glyph;
+
+	glyph = (GDI_GLYPH*) malloc(sizeof(GDI_GLYPH));
+	glyph->x = x;
+	glyph->y = y;
+	glyph->cx = cx;
+	glyph->cy = cy;
+	glyph->mask = (uint8*) malloc(cx * cy + 1);
+
+	scanline = (cx + 7) / 8;
+	maskp = glyph->mask;
+
+	for (i = 0; i < cy; i++)
+	{
+		srcp = &aj[i * scanline];
+
+		for (j = 0; j < cx; j++)
+			*maskp++ = (srcp[j >> 3] & (0x80 >> (j & 7))) ? 0xFF : 0x00;
+	}
+
+	return glyph;
+}
+
+void gdi_glyph_free(GDI_GLYPH* glyph)
+{
+	if (glyph != NULL)
+	{
+		free(glyph->mask);
+		free(glyph);
+	}
+}
+
+GDI_GLYPH* gdi_glyph_cache_get(GDI_GLYPH_CACHE* cache, uint32 id, uint32 index)
+{
+	if (id >= GDI_GLYPH_CACHE_MAX_CELLS)
+	{
+		printf("invalid glyph cache id: %d\n", id);
+		return NULL;
+	}
+
+	if (index >= cache->cells[id].number)
+	{
+		printf("invalid glyph cache index: %d in cell id: %d\n", index, id);
+		return NULL;
+	}
+
+	return cache->cells[id].entries[index];
+}
+
+void gdi_glyph_cache_put(GDI_GLYPH_CACHE* cache, uint32 id, uint32 index, GDI_GLYPH* glyph)
+{
+	if (id >= GDI_GLYPH_CACHE_MAX_CELLS)
+	{
+		printf("invalid glyph cache id: %d\n", id);
+		gdi_glyph_free(glyph);
+		return;
+	}
+
+	if (index >= cache->cells[id].number)
+	{
+		printf("invalid glyph cache index: %d in cell id: %d\n", index, id);
+		gdi_glyph_free(glyph);
+		return;
+	}
+
+	if (cache->cells[id].entries[index] != NULL)
+		gdi_glyph_free(cache->cells[id].entries[index]);
+
+	cache->cells[id].entries[index] = glyph;
+}
+
+uint8* gdi_glyph_cache_fragment_get(GDI_GLYPH_CACHE* cache, uint32 index, uint32* size)
+{
+	if (index >= GDI_GLYPH_CACHE_MAX_FRAGMENTS)
+	{
+		printf("invalid glyph cache fragment index: %d\n", index);
+		return NULL;
+	}
+
+	*size = cache->fragments[index].size;
+
+	return cache->fragments[index].data;
+}
+
+void gdi_glyph_cache_fragment_put(GDI_GLYPH_CACHE* cache, uint32 index, uint32 size, uint8* fragment)
+{
+	GDI_GLYPH_FRAGMENT* entry;
+
+	if (index >= GDI_GLYPH_CACHE_MAX_FRAGMENTS)
+	{
+		printf("invalid glyph cache fragment index: %d\n", index);
+		return;
+	}
+
+	entry = &cache->fragments[index];
+
+	if (entry->size < size)
+		entry->data = (uint8*) realloc(entry->data, size);
+
+	memcpy(entry->data, fragment, size);
+	entry->size = size;
+}
+
+/**
+ * Create a glyph cache matching the glyph cache capability set we advertise.\n
+ * @param settings settings
+ * @return new glyph cache
+ */
+
+GDI_GLYPH_CACHE* gdi_glyph_cache_new(rdpSettings* settings)
+{
+	int i;
+	uint32 number;
+	GDI_GLYPH_CACHE* cache;
+
+	cache = (GDI_GLYPH_CACHE*) malloc(sizeof(GDI_GLYPH_CACHE));
+	memset(cache, 0, sizeof(GDI_GLYPH_CACHE));
+
+	for (i = 0; i < GDI_GLYPH_CACHE_MAX_CELLS; i++)
+	{
+		number = settings->glyph_cache[i].numEntries;
+
+		cache->cells[i].number = number;
+		cache->cells[i].entries = (GDI_GLYPH**) malloc(sizeof(GDI_GLYPH*) * (number + 1));
+		memset(cache->cells[i].entries, 0, sizeof(GDI_GLYPH*) * (number + 1));
+	}
+
+	return cache;
+}
+
+void gdi_glyph_cache_free(GDI_GLYPH_CACHE* cache)
+{
+	int i, j;
+
+	if (cache != NULL)
+	{
+		for (i = 0; i < GDI_GLYPH_CACHE_MAX_CELLS; i++)
+		{
+			for (j = 0; j < cache->cells[i].number; j++)
+				gdi_glyph_free(cache->cells[i].entries[j]);
+
+			free(cache->cells[i].entries);
+		}
+
+		for (i = 0; i < GDI_GLYPH_CACHE_MAX_FRAGMENTS; i++)
+			free(cache->fragments[i].data);
+
+		free(cache);
+	}
+}
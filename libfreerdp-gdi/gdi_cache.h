@@ -0,0 +1,96 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * GDI Caches
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GDI_CACHE_H
+#define __GDI_CACHE_H
+
+#include "gdi.h"
+
+#include <freerdp/types.h>
+#include <freerdp/settings.h>
+
+#define GDI_BITMAP_CACHE_MAX_CELLS		5
+#define GDI_BITMAP_CACHE_WAITING_LIST_INDEX	0x7FFF
+
+#define GDI_GLYPH_CACHE_MAX_CELLS		10
+#define GDI_GLYPH_CACHE_MAX_FRAGMENTS		256
+
+struct _GDI_BITMAP_CACHE_CELL
+{
+	uint32 number;
+	GDI_IMAGE** entries;
+};
+typedef struct _GDI_BITMAP_CACHE_CELL GDI_BITMAP_CACHE_CELL;
+
+struct _GDI_BITMAP_CACHE
+{
+	uint32 maxCells;
+	GDI_BITMAP_CACHE_CELL cells[GDI_BITMAP_CACHE_MAX_CELLS];
+};
+
+/* glyph bitmap expanded to one byte per pixel, 0xFF where the glyph is set */
+struct _GDI_GLYPH
+{
+	sint16 x;
+	sint16 y;
+	uint16 cx;
+	uint16 cy;
+	uint8* mask;
+};
+typedef struct _GDI_GLYPH GDI_GLYPH;
+
+struct _GDI_GLYPH_CACHE_CELL
+{
+	uint32 number;
+	GDI_GLYPH** entries;
+};
+typedef struct _GDI_GLYPH_CACHE_CELL GDI_GLYPH_CACHE_CELL;
+
+struct _GDI_GLYPH_FRAGMENT
+{
+	uint32 size;
+	uint8* data;
+};
+typedef struct _GDI_GLYPH_FRAGMENT GDI_GLYPH_FRAGMENT;
+
+struct _GDI_GLYPH_CACHE
+{
+	GDI_GLYPH_CACHE_CELL cells[GDI_GLYPH_CACHE_MAX_CELLS];
+	GDI_GLYPH_FRAGMENT fragments[GDI_GLYPH_CACHE_MAX_FRAGMENTS];
+};
+
+GDI_IMAGE* gdi_bitmap_cache_get(GDI_BITMAP_CACHE* cache, uint32 id, uint32 index);
+void gdi_bitmap_cache_put(GDI_BITMAP_CACHE* cache, uint32 id, uint32 index, GDI_IMAGE* bitmap);
+
+GDI_BITMAP_CACHE* gdi_bitmap_cache_new(rdpSettings* settings);
+void gdi_bitmap_cache_free(GDI_BITMAP_CACHE* cache);
+
+GDI_GLYPH* gdi_glyph_new(int x, int y, int cx, int cy, uint8* aj);
+void gdi_glyph_free(GDI_GLYPH* glyph);
+
+GDI_GLYPH* gdi_glyph_cache_get(GDI_GLYPH_CACHE* cache, uint32 id, uint32 index);
+void gdi_glyph_cache_put(GDI_GLYPH_CACHE* cache, uint32 id, uint32 index, GDI_GLYPH* glyph);
+
+uint8* gdi_glyph_cache_fragment_get(GDI_GLYPH_CACHE* cache, uint32 index, uint32* size);
+void gdi_glyph_cache_fragment_put(GDI_GLYPH_CACHE* cache, uint32 index, uint32 size, uint8* fragment);
+
+GDI_GLYPH_CACHE* gdi_glyph_cache_new(rdpSettings* settings);
+void gdi_glyph_cache_free(GDI_GLYPH_CACHE* cache);
+
+#endif /* __GDI_CACHE_H */
@@ -21,6 +21,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <freerdp/freerdp.h>
+#include <freerdp/utils/memory.h>
 
 #include "gdi.h"
 #include "gdi_region.h"
@@ -29,6 +30,7 @@
 
 int gdi_SetClipRgn(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight)
 {
+	hdc->nclip = 0;
 	return gdi_SetRgn(hdc->clip, nXLeft, nYLeft, nWidth, nHeight);
 }
 
@@ -57,6 +59,218 @@ int gdi_SetNullClipRgn(HGDI_DC hdc)
 	return 0;
 }
 
+static int gdi_compare_int(const void* a, const void* b)
+{
+	return *((int*) a) - *((int*) b);
+}
+
+static int gdi_compare_span(const void* a, const void* b)
+{
+	return ((int*) a)[0] - ((int*) b)[0];
+}
+
+static void gdi_add_clip_rect(HGDI_DC hdc, int x, int y, int w, int h)
+{
+	if (hdc->nclip == hdc->maxclip)
+	{
+		hdc->maxclip = (hdc->maxclip > 0) ? hdc->maxclip * 2 : 16;
+		hdc->cclip = (HGDI_RGN) xrealloc(hdc->cclip, sizeof(GDI_RGN) * hdc->maxclip);
+	}
+
+	gdi_SetRgn(&hdc->cclip[hdc->nclip++], x, y, w, h);
+}
+
+/**
+ * Set a complex clipping region, the union of the given rectangles.\n
+ * The region is stored as y-bands of non-overlapping rectangles, top to bottom and left to right,
+ * with vertically adjacent bands of identical spans coalesced. The bounding box of the region
+ * becomes the clipping rectangle, an empty region clipping everything out.
+ * @param hdc device context
+ * @param rects rectangles, which may overlap
+ * @param count number of rectangles, at most GDI_MAX_CLIP_RECTS
+ * @return
+ */
+
+int gdi_SetClipRects(HGDI_DC hdc, HGDI_RGN rects, int count)
+{
+	int i, j;
+	int y0, y1;
+	int nys, nspans;
+	int band, bandSize;
+	int prevBand, prevSize;
+	int left, top, right, bottom;
+	int ys[GDI_MAX_CLIP_RECTS * 2];
+	int spans[GDI_MAX_CLIP_RECTS * 2];
+
+	hdc->nclip = 0;
+
+	if (count > GDI_MAX_CLIP_RECTS)
+		count = GDI_MAX_CLIP_RECTS;
+
+	nys = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		if (rects[i].w > 0 && rects[i].h > 0)
+		{
+			ys[nys++] = rects[i].y;
+			ys[nys++] = rects[i].y + rects[i].h;
+		}
+	}
+
+	qsort(ys, nys, sizeof(int), gdi_compare_int);
+
+	prevBand = 0;
+	prevSize = 0;
+
+	for (i = 0; i + 1 < nys; i++)
+	{
+		y0 = ys[i];
+		y1 = ys[i + 1];
+
+		if (y0 == y1)
+			continue;
+
+		/* spans of the rectangles crossing the band, merged when they touch */
+		nspans = 0;
+
+		for (j = 0; j < count; j++)
+		{
+			if (rects[j].w > 0 && rects[j].y <= y0 && rects[j].y + rects[j].h >= y1)
+			{
+				spans[nspans * 2] = rects[j].x;
+				spans[nspans * 2 + 1] = rects[j].x + rects[j].w;
+				nspans++;
+			}
+		}
+
+		if (nspans == 0)
+		{
+			prevSize = 0;
+			continue;
+		}
+
+		qsort(spans, nspans, sizeof(int) * 2, gdi_compare_span);
+
+		band = hdc->nclip;
+
+		for (j = 0; j < nspans; j++)
+		{
+			left = spans[j * 2];
+			right = spans[j * 2 + 1];
+
+			while (j + 1 < nspans && spans[(j + 1) * 2] <= right)
+			{
+				j++;
+
+				if (spans[j * 2 + 1] > right)
+					right = spans[j * 2 + 1];
+			}
+
+			gdi_add_clip_rect(hdc, left, y0, right - left, y1 - y0);
+		}
+
+		bandSize = hdc->nclip - band;
+
+		/* extend the previous band instead when it is adjacent with the same spans */
+		if (prevSize == bandSize && hdc->cclip[prevBand].y + hdc->cclip[prevBand].h == y0)
+		{
+			for (j = 0; j < bandSize; j++)
+			{
+				if (hdc->cclip[prevBand + j].x != hdc->cclip[band + j].x ||
+					hdc->cclip[prevBand + j].w != hdc->cclip[band + j].w)
+					break;
+			}
+
+			if (j == bandSize)
+			{
+				for (j = 0; j < bandSize; j++)
+					hdc->cclip[prevBand + j].h += y1 - y0;
+
+				hdc->nclip = band;
+				continue;
+			}
+		}
+
+		prevBand = band;
+		prevSize = bandSize;
+	}
+
+	if (hdc->nclip == 0)
+	{
+		/* nothing is drawn through an empty region */
+		gdi_SetRgn(hdc->clip, 0, 0, 0, 0);
+		return 0;
+	}
+
+	left = hdc->cclip[0].x;
+	right = hdc->cclip[0].x + hdc->cclip[0].w;
+	top = hdc->cclip[0].y;
+	bottom = hdc->cclip[hdc->nclip - 1].y + hdc->cclip[hdc->nclip - 1].h;
+
+	for (i = 1; i < hdc->nclip; i++)
+	{
+		if (hdc->cclip[i].x < left)
+			left = hdc->cclip[i].x;
+
+		if (hdc->cclip[i].x + hdc->cclip[i].w > right)
+			right = hdc->cclip[i].x + hdc->cclip[i].w;
+	}
+
+	gdi_SetRgn(hdc->clip, left, top, right - left, bottom - top);
+
+	return 0;
+}
+
+/**
+ * Find the rectangles of the complex clipping region in the bands crossing rows y to y + h - 1.
+ * @param hdc device context
+ * @param y y1
+ * @param h height
+ * @param first first rectangle
+ * @param last rectangle following the last one
+ * @return number of rectangles
+ */
+
+int gdi_GetClipBands(HGDI_DC hdc, int y, int h, int* first, int* last)
+{
+	int low, high, mid;
+	HGDI_RGN cclip = hdc->cclip;
+
+	/* first rectangle ending below y */
+	low = 0;
+	high = hdc->nclip;
+
+	while (low < high)
+	{
+		mid = (low + high) / 2;
+
+		if (cclip[mid].y + cclip[mid].h <= y)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	*first = low;
+
+	/* first rectangle starting below y + h - 1 */
+	high = hdc->nclip;
+
+	while (low < high)
+	{
+		mid = (low + high) / 2;
+
+		if (cclip[mid].y < y + h)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	*last = low;
+
+	return *last - *first;
+}
+
 /**
  * Clip coordinates according to clipping region
  * @param hdc device context
@@ -22,9 +22,14 @@
 
 #include "gdi.h"
 
+/* the most rectangles a delta-coded order carries */
+#define GDI_MAX_CLIP_RECTS	46
+
 int gdi_SetClipRgn(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight);
 HGDI_RGN gdi_GetClipRgn(HGDI_DC hdc);
 int gdi_SetNullClipRgn(HGDI_DC hdc);
+int gdi_SetClipRects(HGDI_DC hdc, HGDI_RGN rects, int count);
+int gdi_GetClipBands(HGDI_DC hdc, int y, int h, int* first, int* last);
 int gdi_ClipCoords(HGDI_DC hdc, int *x, int *y, int *w, int *h, int *srcx, int *srcy);
 
 #endif /* __GDI_CLIPPING_H */
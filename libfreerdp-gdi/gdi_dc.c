@@ -25,6 +25,9 @@
 #include <freerdp/freerdp.h>
 
 #include "gdi.h"
+#include "gdi_pen.h"
+#include "gdi_brush.h"
+#include "gdi_bitmap.h"
 #include "gdi_region.h"
 
 #include "gdi_dc.h"
@@ -43,6 +46,12 @@ HGDI_DC gdi_GetDC()
 	hDC->drawMode = GDI_R2_BLACK;
 	hDC->clip = gdi_CreateRectRgn(0, 0, 0, 0);
 	hDC->clip->null = 1;
+	hDC->nclip = 0;
+	hDC->maxclip = 0;
+	hDC->cclip = NULL;
+	hDC->dcBrush = NULL;
+	hDC->dcPen = NULL;
+	hDC->dcPatternBrush = NULL;
 	hDC->hwnd = NULL;
 	return hDC;
 }
@@ -62,6 +71,12 @@ HGDI_DC gdi_CreateCompatibleDC(HGDI_DC hdc)
 	hDC->drawMode = hdc->drawMode;
 	hDC->clip = gdi_CreateRectRgn(0, 0, 0, 0);
 	hDC->clip->null = 1;
+	hDC->nclip = 0;
+	hDC->maxclip = 0;
+	hDC->cclip = NULL;
+	hDC->dcBrush = NULL;
+	hDC->dcPen = NULL;
+	hDC->dcPatternBrush = NULL;
 	hDC->hwnd = NULL;
 	hDC->alpha = hdc->alpha;
 	hDC->invert = hdc->invert;
@@ -183,10 +198,17 @@ int gdi_DeleteDC(HGDI_DC hdc)
 	if (hdc->hwnd)
 	{
 		free(hdc->hwnd->invalid);
+		free(hdc->hwnd->cinvalid);
 		free(hdc->hwnd);
 	}
 
 	free(hdc->clip);
+	free(hdc->cclip);
+	free(hdc->dcBrush);
+	free(hdc->dcPen);
+
+	if (hdc->dcPatternBrush != NULL)
+		gdi_DeleteObject((HGDIOBJECT) hdc->dcPatternBrush);
 	free(hdc);
 
 	return 1;
@@ -0,0 +1,189 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * GDI Parallel Bitmap Decoder
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <freerdp/freerdp.h>
+#include <freerdp/utils/memory.h>
+#include <freerdp/utils/thread.h>
+
+#include "gdi_decoder.h"
+
+/**
+ * Get the number of online processors.
+ */
+
+int gdi_decoder_cpus(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+
+	return (int) info.dwNumberOfProcessors;
+#else
+	long cpus;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (cpus > 0) ? (int) cpus : 1;
+#endif
+}
+
+/**
+ * Decode rectangles until none is left in the current bitmap update.
+ */
+
+static void gdi_decoder_work(GDI_DECODER* decoder)
+{
+	int index;
+
+	while (1)
+	{
+		freerdp_mutex_lock(decoder->mutex);
+		index = decoder->next;
+
+		if (index < decoder->number)
+			decoder->next++;
+
+		freerdp_mutex_unlock(decoder->mutex);
+
+		if (index >= decoder->number)
+			break;
+
+		decoder->decode(decoder->gdi, &decoder->bitmaps[index]);
+	}
+}
+
+static void* gdi_decoder_thread(void* arg)
+{
+	GDI_DECODER* decoder = (GDI_DECODER*) arg;
+
+	while (1)
+	{
+		freerdp_sem_wait(decoder->start);
+
+		if (decoder->stop)
+		{
+			freerdp_sem_signal(decoder->done);
+			break;
+		}
+
+		gdi_decoder_work(decoder);
+		freerdp_sem_signal(decoder->done);
+	}
+
+	return NULL;
+}
+
+/**
+ * Decode the rectangles of a bitmap update on the worker threads and the calling thread.\n
+ * Returns once every rectangle has been decoded. The rectangles must not overlap.
+ * @param decoder parallel bitmap decoder
+ * @param bitmaps rectangles of the bitmap update
+ * @param number number of rectangles
+ */
+
+void gdi_decoder_run(GDI_DECODER* decoder, BITMAP_DATA* bitmaps, int number)
+{
+	int i;
+	int wake;
+
+	decoder->bitmaps = bitmaps;
+	decoder->number = number;
+	decoder->next = 0;
+
+	/* the calling thread takes a share of the rectangles as well */
+	wake = (number - 1 < decoder->threads) ? number - 1 : decoder->threads;
+
+	for (i = 0; i < wake; i++)
+		freerdp_sem_signal(decoder->start);
+
+	gdi_decoder_work(decoder);
+
+	for (i = 0; i < wake; i++)
+		freerdp_sem_wait(decoder->done);
+
+	decoder->bitmaps = NULL;
+	decoder->number = 0;
+}
+
+/**
+ * Create a parallel bitmap decoder.\n
+ * Usually there is one worker thread per additional processor, see gdi_decoder_cpus().
+ * @param gdi GDI the rectangles are decoded for
+ * @param decode rectangle decoding function
+ * @param threads number of worker threads, zero to decode on the calling thread only
+ * @return new parallel bitmap decoder
+ */
+
+GDI_DECODER* gdi_decoder_new(GDI* gdi, GDI_DECODE_PROC decode, int threads)
+{
+	int i;
+	GDI_DECODER* decoder;
+
+	decoder = xnew(GDI_DECODER);
+
+	decoder->gdi = gdi;
+	decoder->decode = decode;
+
+	decoder->threads = (threads > 0) ? threads : 0;
+
+	if (decoder->threads > GDI_DECODER_MAX_THREADS)
+		decoder->threads = GDI_DECODER_MAX_THREADS;
+
+	decoder->start = freerdp_sem_new(0);
+	decoder->done = freerdp_sem_new(0);
+	decoder->mutex = freerdp_mutex_new();
+
+	for (i = 0; i < decoder->threads; i++)
+		freerdp_thread_create(gdi_decoder_thread, decoder);
+
+	return decoder;
+}
+
+void gdi_decoder_free(GDI_DECODER* decoder)
+{
+	int i;
+
+	if (decoder == NULL)
+		return;
+
+	decoder->stop = True;
+
+	for (i = 0; i < decoder->threads; i++)
+		freerdp_sem_signal(decoder->start);
+
+	for (i = 0; i < decoder->threads; i++)
+		freerdp_sem_wait(decoder->done);
+
+	freerdp_sem_free(decoder->start);
+	freerdp_sem_free(decoder->done);
+	freerdp_mutex_free(decoder->mutex);
+
+	xfree(decoder);
+}
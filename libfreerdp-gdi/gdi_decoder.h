@@ -0,0 +1,57 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * GDI Parallel Bitmap Decoder
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GDI_DECODER_H
+#define __GDI_DECODER_H
+
+#include "gdi.h"
+
+#include <freerdp/types.h>
+#include <freerdp/update.h>
+#include <freerdp/utils/mutex.h>
+#include <freerdp/utils/semaphore.h>
+
+#define GDI_DECODER_MAX_THREADS		16
+
+typedef void (*GDI_DECODE_PROC)(GDI* gdi, BITMAP_DATA* bitmap);
+
+struct _GDI_DECODER
+{
+	GDI* gdi;
+	GDI_DECODE_PROC decode;
+
+	int threads;
+	boolean stop;
+	freerdp_sem start;
+	freerdp_sem done;
+	freerdp_mutex mutex;
+
+	/* rectangles of the bitmap update being decoded */
+	BITMAP_DATA* bitmaps;
+	int number;
+	int next;
+};
+
+int gdi_decoder_cpus(void);
+void gdi_decoder_run(GDI_DECODER* decoder, BITMAP_DATA* bitmaps, int number);
+
+GDI_DECODER* gdi_decoder_new(GDI* gdi, GDI_DECODE_PROC decode, int threads);
+void gdi_decoder_free(GDI_DECODER* decoder);
+
+#endif /* __GDI_DECODER_H */
@@ -27,6 +27,7 @@
 #include "gdi_32bpp.h"
 #include "gdi_16bpp.h"
 #include "gdi_8bpp.h"
+#include "gdi_clipping.h"
 
 #include "gdi_line.h"
 
@@ -50,12 +51,43 @@ pLineTo LineTo_[5] =
 
 int gdi_LineTo(HGDI_DC hdc, int nXEnd, int nYEnd)
 {
+	int i;
+	int status = 0;
+	int first, last;
+	int left, top, right, bottom;
+	GDI_RGN bounds;
+	HGDI_RGN rect;
 	pLineTo _LineTo = LineTo_[IBPP(hdc->bitsPerPixel)];
 
-	if (_LineTo != NULL)
-		return _LineTo(hdc, nXEnd, nYEnd);
-	else
+	if (_LineTo == NULL)
 		return 0;
+
+	if (hdc->nclip == 0)
+		return _LineTo(hdc, nXEnd, nYEnd);
+
+	/* draw the pixels of the line within each rectangle of the complex clipping region */
+	left = (hdc->pen->posX < nXEnd) ? hdc->pen->posX : nXEnd;
+	right = (hdc->pen->posX > nXEnd) ? hdc->pen->posX : nXEnd;
+	top = (hdc->pen->posY < nYEnd) ? hdc->pen->posY : nYEnd;
+	bottom = (hdc->pen->posY > nYEnd) ? hdc->pen->posY : nYEnd;
+
+	bounds = *hdc->clip;
+	gdi_GetClipBands(hdc, top, bottom - top + 1, &first, &last);
+
+	for (i = first; i < last; i++)
+	{
+		rect = &hdc->cclip[i];
+
+		if (rect->x <= right && rect->x + rect->w > left)
+		{
+			*hdc->clip = *rect;
+			status = _LineTo(hdc, nXEnd, nYEnd);
+		}
+	}
+
+	*hdc->clip = bounds;
+
+	return status;
 }
 
 /**
@@ -47,6 +47,27 @@ HGDI_PEN gdi_CreatePen(int fnPenStyle, int nWidth, int crColor)
 	return hPen;
 }
 
+/**
+ * Set the color of the stock pen of a device context.\n
+ * The DC pen is owned by the device context, created on first use and recolored in place.
+ * @msdn{dd162970}
+ * @param hdc device context
+ * @param crColor pen color
+ * @return previous pen color
+ */
+
+GDI_COLOR gdi_SetDCPenColor(HGDI_DC hdc, GDI_COLOR crColor)
+{
+	GDI_COLOR previousColor;
+
+	if (hdc->dcPen == NULL)
+		hdc->dcPen = gdi_CreatePen(GDI_PS_SOLID, 1, 0);
+
+	previousColor = hdc->dcPen->color;
+	hdc->dcPen->color = crColor;
+	return previousColor;
+}
+
 uint8 gdi_GetPenColor_8bpp(HGDI_PEN pen)
 {
 	/* TODO: implement conversion using palette */
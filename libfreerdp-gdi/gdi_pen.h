@@ -23,6 +23,7 @@
 #include "gdi.h"
 
 HGDI_PEN gdi_CreatePen(int fnPenStyle, int nWidth, int crColor);
+GDI_COLOR gdi_SetDCPenColor(HGDI_DC hdc, GDI_COLOR crColor);
 uint8 gdi_GetPenColor_8bpp(HGDI_PEN pen);
 uint16 gdi_GetPenColor_16bpp(HGDI_PEN pen);
 uint32 gdi_GetPenColor_32bpp(HGDI_PEN pen);
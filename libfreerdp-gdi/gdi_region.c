@@ -358,6 +358,104 @@ int gdi_PtInRect(HGDI_RECT rc, int x, int y)
 	return 0;
 }
 
+/**
+ * Compute the bounding box of a region and a rectangle, and the number
+ * of pixels it covers outside of both of them.
+ */
+
+static int gdi_damage_merge(HGDI_RGN rgn, int left, int top, int right, int bottom, GDI_RECT* merged)
+{
+	int covered;
+	int iw, ih;
+	int rgnRight = rgn->x + rgn->w;
+	int rgnBottom = rgn->y + rgn->h;
+
+	merged->left = (left < rgn->x) ? left : rgn->x;
+	merged->top = (top < rgn->y) ? top : rgn->y;
+	merged->right = (right > rgnRight) ? right : rgnRight;
+	merged->bottom = (bottom > rgnBottom) ? bottom : rgnBottom;
+
+	iw = ((right < rgnRight) ? right : rgnRight) - ((left > rgn->x) ? left : rgn->x);
+	ih = ((bottom < rgnBottom) ? bottom : rgnBottom) - ((top > rgn->y) ? top : rgn->y);
+
+	covered = (right - left) * (bottom - top) + rgn->w * rgn->h;
+
+	if (iw > 0 && ih > 0)
+		covered -= iw * ih;
+
+	return (merged->right - merged->left) * (merged->bottom - merged->top) - covered;
+}
+
+/**
+ * Add a rectangle to the damage region of a window, right and bottom exclusive.\n
+ * Rectangles merge when their bounding box wastes at most a quarter of its area,
+ * which joins adjacent drawing within a band while keeping distant updates apart.
+ * On a full list, the new rectangle merges with the one wasting the least.
+ */
+
+static void gdi_InvalidateDamage(HGDI_WND hwnd, int left, int top, int right, int bottom)
+{
+	int i;
+	int best;
+	int waste;
+	int bestWaste;
+	HGDI_RGN rgn;
+	GDI_RECT merged;
+	GDI_RECT bestMerged;
+	HGDI_RGN cinvalid = hwnd->cinvalid;
+
+	memset(&bestMerged, 0, sizeof(GDI_RECT));
+
+	while (hwnd->ninvalid > 0)
+	{
+		best = -1;
+		bestWaste = 0;
+
+		for (i = 0; i < hwnd->ninvalid; i++)
+		{
+			rgn = &cinvalid[i];
+
+			if (left >= rgn->x && top >= rgn->y && right <= rgn->x + rgn->w && bottom <= rgn->y + rgn->h)
+				return;
+
+			waste = gdi_damage_merge(rgn, left, top, right, bottom, &merged);
+
+			if (best < 0 || waste < bestWaste)
+			{
+				best = i;
+				bestWaste = waste;
+				bestMerged = merged;
+			}
+		}
+
+		if (bestWaste * 4 > (bestMerged.right - bestMerged.left) * (bestMerged.bottom - bestMerged.top)
+				&& hwnd->ninvalid < hwnd->count)
+			break;
+
+		/* replace both rectangles by their bounding box, which may merge further */
+		left = bestMerged.left;
+		top = bestMerged.top;
+		right = bestMerged.right;
+		bottom = bestMerged.bottom;
+
+		hwnd->ninvalid--;
+		memmove(&cinvalid[best], &cinvalid[best + 1], (hwnd->ninvalid - best) * sizeof(GDI_RGN));
+	}
+
+	/* keep the rectangles top to bottom, then left to right */
+	for (i = hwnd->ninvalid; i > 0; i--)
+	{
+		rgn = &cinvalid[i - 1];
+
+		if (rgn->y < top || (rgn->y == top && rgn->x <= left))
+			break;
+	}
+
+	memmove(&cinvalid[i + 1], &cinvalid[i], (hwnd->ninvalid - i) * sizeof(GDI_RGN));
+	gdi_SetRgn(&cinvalid[i], left, top, right - left, bottom - top);
+	hwnd->ninvalid++;
+}
+
 /**
  * Invalidate a given region, such that it is redrawn on the next region update.\n
  * @msdn{dd145003}
@@ -385,6 +483,23 @@ int gdi_InvalidateRegion(HGDI_DC hdc, int x, int y, int w, int h)
 	invalid = hdc->hwnd->invalid;
 	bmp = (HGDI_BITMAP) hdc->selectedObject;
 
+	if (hdc->hwnd->cinvalid != NULL)
+	{
+		gdi_CRgnToRect(x, y, w, h, &rgn);
+
+		if (rgn.left < 0)
+			rgn.left = 0;
+		if (rgn.top < 0)
+			rgn.top = 0;
+		if (rgn.right >= bmp->width)
+			rgn.right = bmp->width - 1;
+		if (rgn.bottom >= bmp->height)
+			rgn.bottom = bmp->height - 1;
+
+		if (rgn.left <= rgn.right && rgn.top <= rgn.bottom)
+			gdi_InvalidateDamage(hdc->hwnd, rgn.left, rgn.top, rgn.right + 1, rgn.bottom + 1);
+	}
+
 	if (invalid->null)
 	{
 		invalid->x = x;
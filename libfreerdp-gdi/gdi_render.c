@@ -0,0 +1,643 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * GDI Parallel Order Rasterizer
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <freerdp/freerdp.h>
+#include <freerdp/utils/memory.h>
+#include <freerdp/utils/thread.h>
+
+#include "gdi_dc.h"
+#include "gdi_region.h"
+#include "gdi_decoder.h"
+#include "gdi_clipping.h"
+
+#include "gdi_render.h"
+
+/**
+ * Intersect two rectangles, returns False if the intersection is empty.
+ */
+
+static boolean gdi_render_intersect(GDI_RECT* a, GDI_RECT* b, GDI_RECT* rect)
+{
+	rect->left = (a->left > b->left) ? a->left : b->left;
+	rect->top = (a->top > b->top) ? a->top : b->top;
+	rect->right = (a->right < b->right) ? a->right : b->right;
+	rect->bottom = (a->bottom < b->bottom) ? a->bottom : b->bottom;
+
+	return (rect->left <= rect->right && rect->top <= rect->bottom) ? True : False;
+}
+
+static boolean gdi_render_touches(GDI_RENDER_COMMAND* command, GDI_RENDER_TILE* tile)
+{
+	GDI_RECT rect;
+
+	if (gdi_render_intersect(&command->dst, &tile->rect, &rect))
+		return True;
+
+	return gdi_render_intersect(&command->src, &tile->rect, &rect);
+}
+
+/**
+ * Get the range of tiles a command may touch, right and bottom are exclusive.
+ */
+
+static void gdi_render_tile_range(GDI_RENDER_COMMAND* command, int* col, int* row, int* cols, int* rows)
+{
+	GDI_RECT rect = command->dst;
+
+	if (command->src.left <= command->src.right)
+	{
+		if (command->src.left < rect.left)
+			rect.left = command->src.left;
+
+		if (command->src.top < rect.top)
+			rect.top = command->src.top;
+
+		if (command->src.right > rect.right)
+			rect.right = command->src.right;
+
+		if (command->src.bottom > rect.bottom)
+			rect.bottom = command->src.bottom;
+	}
+
+	*col = rect.left / GDI_RENDER_TILE_SIZE;
+	*row = rect.top / GDI_RENDER_TILE_SIZE;
+	*cols = rect.right / GDI_RENDER_TILE_SIZE + 1;
+	*rows = rect.bottom / GDI_RENDER_TILE_SIZE + 1;
+}
+
+/**
+ * Set the bounds of the orders recorded next.
+ * @param render parallel order rasterizer
+ * @param bounds order bounds, NULL for the whole surface
+ */
+
+void gdi_render_set_bounds(GDI_RENDERER* render, BOUNDS* bounds)
+{
+	if (bounds == NULL)
+	{
+		render->bounds = render->surface;
+		return;
+	}
+
+	gdi_SetRect(&render->bounds, bounds->left, bounds->top, bounds->right, bounds->bottom);
+
+	/* bounds outside of the surface clip everything away */
+	if (!gdi_render_intersect(&render->bounds, &render->surface, &render->bounds))
+		gdi_SetRect(&render->bounds, 0, 0, -1, -1);
+}
+
+/**
+ * Record a drawing order in the command list.\n
+ * The order is copied, along with the current bounds and the area it may write to and read from.
+ * Orders clipped away entirely are dropped.
+ * @param render parallel order rasterizer
+ * @param type recorded drawing order type
+ * @param order drawing order
+ */
+
+void gdi_render_record(GDI_RENDERER* render, int type, void* order)
+{
+	int i;
+	int size;
+	GDI_RECT dst;
+	GDI_RECT src;
+	GDI_RECT rect;
+	boolean whole;
+	DELTA_RECT* rectangle;
+	GDI_RENDER_COMMAND* command;
+
+	whole = False;
+	gdi_SetRect(&src, 0, 0, -1, -1);
+
+	switch (type)
+	{
+		case GDI_RENDER_DSTBLT:
+			{
+				DSTBLT_ORDER* dstblt = (DSTBLT_ORDER*) order;
+				gdi_CRgnToRect(dstblt->nLeftRect, dstblt->nTopRect, dstblt->nWidth, dstblt->nHeight, &dst);
+				size = sizeof(DSTBLT_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_PATBLT:
+			{
+				PATBLT_ORDER* patblt = (PATBLT_ORDER*) order;
+				gdi_CRgnToRect(patblt->nLeftRect, patblt->nTopRect, patblt->nWidth, patblt->nHeight, &dst);
+				whole = ((patblt->brushStyle & 0x7F) == BS_PATTERN) ? True : False;
+				size = sizeof(PATBLT_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_SCRBLT:
+			{
+				SCRBLT_ORDER* scrblt = (SCRBLT_ORDER*) order;
+				gdi_CRgnToRect(scrblt->nLeftRect, scrblt->nTopRect, scrblt->nWidth, scrblt->nHeight, &dst);
+				gdi_CRgnToRect(scrblt->nXSrc, scrblt->nYSrc, scrblt->nWidth, scrblt->nHeight, &src);
+				whole = True;
+				size = sizeof(SCRBLT_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_OPAQUE_RECT:
+			{
+				OPAQUE_RECT_ORDER* opaque_rect = (OPAQUE_RECT_ORDER*) order;
+				gdi_CRgnToRect(opaque_rect->nLeftRect, opaque_rect->nTopRect,
+						opaque_rect->nWidth, opaque_rect->nHeight, &dst);
+				size = sizeof(OPAQUE_RECT_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_MULTI_OPAQUE_RECT:
+			{
+				MULTI_OPAQUE_RECT_ORDER* multi_opaque_rect = (MULTI_OPAQUE_RECT_ORDER*) order;
+				gdi_SetRect(&dst, 0, 0, -1, -1);
+
+				for (i = 1; i <= multi_opaque_rect->numRectangles && i <= 45; i++)
+				{
+					rectangle = &multi_opaque_rect->rectangles[i];
+					gdi_CRgnToRect(rectangle->left, rectangle->top, rectangle->width, rectangle->height, &rect);
+
+					if (rect.left > rect.right || rect.top > rect.bottom)
+						continue;
+
+					if (dst.left > dst.right)
+					{
+						dst = rect;
+						continue;
+					}
+
+					dst.left = (rect.left < dst.left) ? rect.left : dst.left;
+					dst.top = (rect.top < dst.top) ? rect.top : dst.top;
+					dst.right = (rect.right > dst.right) ? rect.right : dst.right;
+					dst.bottom = (rect.bottom > dst.bottom) ? rect.bottom : dst.bottom;
+				}
+
+				size = sizeof(MULTI_OPAQUE_RECT_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_LINE_TO:
+			{
+				LINE_TO_ORDER* line_to = (LINE_TO_ORDER*) order;
+				gdi_SetRect(&dst,
+						(line_to->nXStart < line_to->nXEnd) ? line_to->nXStart : line_to->nXEnd,
+						(line_to->nYStart < line_to->nYEnd) ? line_to->nYStart : line_to->nYEnd,
+						(line_to->nXStart > line_to->nXEnd) ? line_to->nXStart : line_to->nXEnd,
+						(line_to->nYStart > line_to->nYEnd) ? line_to->nYStart : line_to->nYEnd);
+				size = sizeof(LINE_TO_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_MEMBLT:
+			{
+				MEMBLT_ORDER* memblt = (MEMBLT_ORDER*) order;
+				gdi_CRgnToRect(memblt->nLeftRect, memblt->nTopRect, memblt->nWidth, memblt->nHeight, &dst);
+				size = sizeof(MEMBLT_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_MEM3BLT:
+			{
+				MEM3BLT_ORDER* mem3blt = (MEM3BLT_ORDER*) order;
+				gdi_CRgnToRect(mem3blt->nLeftRect, mem3blt->nTopRect, mem3blt->nWidth, mem3blt->nHeight, &dst);
+				whole = ((mem3blt->brushStyle & 0x7F) == BS_PATTERN) ? True : False;
+				size = sizeof(MEM3BLT_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_MULTI_DSTBLT:
+			{
+				MULTI_DSTBLT_ORDER* multi_dstblt = (MULTI_DSTBLT_ORDER*) order;
+				gdi_CRgnToRect(multi_dstblt->nLeftRect, multi_dstblt->nTopRect,
+						multi_dstblt->nWidth, multi_dstblt->nHeight, &dst);
+				size = sizeof(MULTI_DSTBLT_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_MULTI_PATBLT:
+			{
+				MULTI_PATBLT_ORDER* multi_patblt = (MULTI_PATBLT_ORDER*) order;
+				gdi_CRgnToRect(multi_patblt->nLeftRect, multi_patblt->nTopRect,
+						multi_patblt->nWidth, multi_patblt->nHeight, &dst);
+				whole = ((multi_patblt->brushStyle & 0x7F) == BS_PATTERN) ? True : False;
+				size = sizeof(MULTI_PATBLT_ORDER);
+			}
+			break;
+
+		case GDI_RENDER_MULTI_SCRBLT:
+			{
+				MULTI_SCRBLT_ORDER* multi_scrblt = (MULTI_SCRBLT_ORDER*) order;
+				gdi_CRgnToRect(multi_scrblt->nLeftRect, multi_scrblt->nTopRect,
+						multi_scrblt->nWidth, multi_scrblt->nHeight, &dst);
+				gdi_CRgnToRect(multi_scrblt->nXSrc, multi_scrblt->nYSrc,
+						multi_scrblt->nWidth, multi_scrblt->nHeight, &src);
+				whole = True;
+				size = sizeof(MULTI_SCRBLT_ORDER);
+			}
+			break;
+
+		default:
+			return;
+	}
+
+	if (!gdi_render_intersect(&dst, &render->bounds, &dst))
+		return;
+
+	if (!gdi_render_intersect(&src, &render->surface, &src))
+		gdi_SetRect(&src, 0, 0, -1, -1);
+
+	if (render->count >= render->size)
+	{
+		render->size = (render->size > 0) ? render->size * 2 : 64;
+		render->commands = (GDI_RENDER_COMMAND*) xrealloc(render->commands,
+				sizeof(GDI_RENDER_COMMAND) * render->size);
+	}
+
+	command = &render->commands[render->count++];
+	command->type = type;
+	command->clip = render->bounds;
+	command->dst = dst;
+	command->src = src;
+	command->whole = whole;
+	memcpy(&command->order, order, size);
+}
+
+static void gdi_render_draw_whole(GDI_RENDERER* render, HGDI_DC hdc, GDI_RENDER_COMMAND* command)
+{
+	int x, y, w, h;
+
+	gdi_RectToCRgn(&command->clip, &x, &y, &w, &h);
+	gdi_SetClipRgn(hdc, x, y, w, h);
+	gdi_draw_order(render->gdi, hdc, command->type, &command->order);
+}
+
+static void gdi_render_draw_tile(GDI_RENDERER* render, HGDI_DC hdc, GDI_RENDER_TILE* tile, GDI_RENDER_COMMAND* command)
+{
+	int x, y, w, h;
+	GDI_RECT clip;
+
+	if (!gdi_render_intersect(&command->clip, &tile->rect, &clip))
+		return;
+
+	gdi_RectToCRgn(&clip, &x, &y, &w, &h);
+	gdi_SetClipRgn(hdc, x, y, w, h);
+	gdi_draw_order(render->gdi, hdc, command->type, &command->order);
+}
+
+static void gdi_render_push(GDI_RENDERER* render, int index)
+{
+	freerdp_mutex_lock(render->mutex);
+	render->ready[render->nready++] = index;
+	freerdp_mutex_unlock(render->mutex);
+
+	freerdp_sem_signal(render->work);
+}
+
+/**
+ * Resume the tiles waiting for a command rasterized as a whole, except the current one.
+ */
+
+static void gdi_render_resume(GDI_RENDERER* render, GDI_RENDER_COMMAND* command, GDI_RENDER_TILE* current)
+{
+	int col, row;
+	int first, last, rows;
+	GDI_RENDER_TILE* tile;
+
+	gdi_render_tile_range(command, &first, &row, &last, &rows);
+
+	for (; row < rows; row++)
+	{
+		for (col = first; col < last; col++)
+		{
+			tile = &render->tiles[row * render->cols + col];
+
+			if (tile != current && gdi_render_touches(command, tile))
+				gdi_render_push(render, row * render->cols + col);
+		}
+	}
+}
+
+/**
+ * Rasterize tiles until every tile is done.\n
+ * A tile reaching a command which must be rasterized as a whole is parked until the
+ * last tile the command touches reaches it, so that every earlier command writing
+ * to these tiles is done before, and no later one starts before it is.
+ */
+
+static void gdi_render_work(GDI_RENDERER* render)
+{
+	int i;
+	boolean parked;
+	HGDI_DC hdc;
+	GDI_RENDER_TILE* tile;
+	GDI_RENDER_COMMAND* command;
+
+	freerdp_mutex_lock(render->mutex);
+	hdc = render->hdcs[render->nexthdc++];
+	freerdp_mutex_unlock(render->mutex);
+
+	while (1)
+	{
+		freerdp_sem_wait(render->work);
+
+		freerdp_mutex_lock(render->mutex);
+		tile = (render->nready > 0) ? &render->tiles[render->ready[--render->nready]] : NULL;
+		freerdp_mutex_unlock(render->mutex);
+
+		/* an empty queue after a wake-up means every tile is done */
+		if (tile == NULL)
+			break;
+
+		parked = False;
+
+		while (!parked && tile->next < tile->count)
+		{
+			command = &render->commands[tile->commands[tile->next++]];
+
+			if (!command->whole)
+			{
+				gdi_render_draw_tile(render, hdc, tile, command);
+				continue;
+			}
+
+			freerdp_mutex_lock(render->mutex);
+			command->arrived++;
+			parked = (command->arrived < command->tiles) ? True : False;
+			freerdp_mutex_unlock(render->mutex);
+
+			if (!parked)
+			{
+				gdi_render_draw_whole(render, hdc, command);
+				gdi_render_resume(render, command, tile);
+			}
+		}
+
+		if (parked)
+			continue;
+
+		freerdp_mutex_lock(render->mutex);
+		render->finished++;
+
+		if (render->finished == render->active)
+		{
+			for (i = 0; i < render->participants; i++)
+				freerdp_sem_signal(render->work);
+		}
+
+		freerdp_mutex_unlock(render->mutex);
+	}
+}
+
+static void* gdi_render_thread(void* arg)
+{
+	GDI_RENDERER* render = (GDI_RENDERER*) arg;
+
+	while (1)
+	{
+		freerdp_sem_wait(render->start);
+
+		if (render->stop)
+		{
+			freerdp_sem_signal(render->done);
+			break;
+		}
+
+		gdi_render_work(render);
+		freerdp_sem_signal(render->done);
+	}
+
+	return NULL;
+}
+
+/**
+ * Bin the commands into the tiles they touch and rasterize the tiles
+ * on the worker threads and the calling thread.
+ */
+
+static void gdi_render_run(GDI_RENDERER* render)
+{
+	int i;
+	int wake;
+	int col, row;
+	int first, last, rows;
+	GDI_RENDER_TILE* tile;
+	GDI_RENDER_COMMAND* command;
+
+	for (i = 0; i < render->cols * render->rows; i++)
+	{
+		render->tiles[i].count = 0;
+		render->tiles[i].next = 0;
+	}
+
+	for (i = 0; i < render->count; i++)
+	{
+		command = &render->commands[i];
+		command->tiles = 0;
+		command->arrived = 0;
+
+		gdi_render_tile_range(command, &first, &row, &last, &rows);
+
+		for (; row < rows; row++)
+		{
+			for (col = first; col < last; col++)
+			{
+				tile = &render->tiles[row * render->cols + col];
+
+				if (!gdi_render_touches(command, tile))
+					continue;
+
+				if (tile->count >= tile->size)
+				{
+					tile->size = (tile->size > 0) ? tile->size * 2 : 16;
+					tile->commands = (int*) xrealloc(tile->commands, sizeof(int) * tile->size);
+				}
+
+				tile->commands[tile->count++] = i;
+				command->tiles++;
+			}
+		}
+	}
+
+	render->nready = 0;
+	render->finished = 0;
+	render->nexthdc = 0;
+
+	/* queued in reverse so that the first tiles are taken first */
+	for (i = render->cols * render->rows - 1; i >= 0; i--)
+	{
+		if (render->tiles[i].count > 0)
+			render->ready[render->nready++] = i;
+	}
+
+	render->active = render->nready;
+
+	wake = (render->active - 1 < render->threads) ? render->active - 1 : render->threads;
+	render->participants = wake + 1;
+
+	for (i = 0; i < render->active; i++)
+		freerdp_sem_signal(render->work);
+
+	for (i = 0; i < wake; i++)
+		freerdp_sem_signal(render->start);
+
+	gdi_render_work(render);
+
+	for (i = 0; i < wake; i++)
+		freerdp_sem_wait(render->done);
+}
+
+/**
+ * Rasterize the recorded command list to the drawing surface and empty it.\n
+ * Must be called before anything else reads or writes the drawing surface,
+ * the bitmap cache or the palette. The result is the same as drawing the
+ * orders one after the other.
+ * @param render parallel order rasterizer, may be NULL
+ */
+
+void gdi_render_flush(GDI_RENDERER* render)
+{
+	int i;
+	int x, y, w, h;
+	GDI_RENDER_COMMAND* command;
+
+	if (render == NULL || render->count < 1)
+		return;
+
+	if (render->threads < 1 || render->count < GDI_RENDER_MIN_COMMANDS)
+	{
+		for (i = 0; i < render->count; i++)
+			gdi_render_draw_whole(render, render->hdcs[0], &render->commands[i]);
+	}
+	else
+	{
+		gdi_render_run(render);
+	}
+
+	for (i = 0; i < render->count; i++)
+	{
+		command = &render->commands[i];
+		gdi_RectToCRgn(&command->dst, &x, &y, &w, &h);
+		gdi_InvalidateRegion(render->gdi->drawing->hdc, x, y, w, h);
+	}
+
+	render->count = 0;
+}
+
+/**
+ * Create a parallel order rasterizer for the drawing surface,
+ * with one worker thread per additional processor.
+ * @param gdi current GDI
+ * @return new parallel order rasterizer
+ */
+
+GDI_RENDERER* gdi_render_new(GDI* gdi)
+{
+	int i;
+	int col, row;
+	HGDI_DC hdc;
+	HGDI_BITMAP bitmap;
+	GDI_RENDERER* render;
+
+	render = xnew(GDI_RENDERER);
+
+	render->gdi = gdi;
+	render->threads = gdi_decoder_cpus() - 1;
+
+	if (render->threads > GDI_RENDER_MAX_THREADS)
+		render->threads = GDI_RENDER_MAX_THREADS;
+
+	render->hdcs = (HGDI_DC*) xzalloc(sizeof(HGDI_DC) * (render->threads + 1));
+
+	for (i = 0; i <= render->threads; i++)
+	{
+		hdc = gdi_CreateCompatibleDC(gdi->hdc);
+		gdi_SelectObject(hdc, (HGDIOBJECT) gdi->drawing->bitmap);
+		hdc->brush = NULL;
+		hdc->pen = NULL;
+		render->hdcs[i] = hdc;
+	}
+
+	/* the client may change gdi->width and gdi->height later, the surface keeps its size */
+	bitmap = gdi->primary->bitmap;
+	gdi_SetRect(&render->surface, 0, 0, bitmap->width - 1, bitmap->height - 1);
+
+	render->cols = (bitmap->width + GDI_RENDER_TILE_SIZE - 1) / GDI_RENDER_TILE_SIZE;
+	render->rows = (bitmap->height + GDI_RENDER_TILE_SIZE - 1) / GDI_RENDER_TILE_SIZE;
+	render->tiles = (GDI_RENDER_TILE*) xzalloc(sizeof(GDI_RENDER_TILE) * render->cols * render->rows);
+	render->ready = (int*) xzalloc(sizeof(int) * render->cols * render->rows);
+
+	for (row = 0; row < render->rows; row++)
+	{
+		for (col = 0; col < render->cols; col++)
+		{
+			gdi_SetRect(&render->tiles[row * render->cols + col].rect,
+					col * GDI_RENDER_TILE_SIZE, row * GDI_RENDER_TILE_SIZE,
+					(col + 1) * GDI_RENDER_TILE_SIZE - 1, (row + 1) * GDI_RENDER_TILE_SIZE - 1);
+		}
+	}
+
+	gdi_render_set_bounds(render, NULL);
+
+	render->start = freerdp_sem_new(0);
+	render->done = freerdp_sem_new(0);
+	render->work = freerdp_sem_new(0);
+	render->mutex = freerdp_mutex_new();
+
+	for (i = 0; i < render->threads; i++)
+		freerdp_thread_create(gdi_render_thread, render);
+
+	return render;
+}
+
+void gdi_render_free(GDI_RENDERER* render)
+{
+	int i;
+
+	if (render == NULL)
+		return;
+
+	render->stop = True;
+
+	for (i = 0; i < render->threads; i++)
+		freerdp_sem_signal(render->start);
+
+	for (i = 0; i < render->threads; i++)
+		freerdp_sem_wait(render->done);
+
+	freerdp_sem_free(render->start);
+	freerdp_sem_free(render->done);
+	freerdp_sem_free(render->work);
+	freerdp_mutex_free(render->mutex);
+
+	for (i = 0; i <= render->threads; i++)
+		gdi_DeleteDC(render->hdcs[i]);
+
+	for (i = 0; i < render->cols * render->rows; i++)
+		xfree(render->tiles[i].commands);
+
+	xfree(render->hdcs);
+	xfree(render->tiles);
+	xfree(render->ready);
+	xfree(render->commands);
+	xfree(render);
+}
@@ -0,0 +1,137 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * GDI Parallel Order Rasterizer
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GDI_RENDER_H
+#define __GDI_RENDER_H
+
+#include "gdi.h"
+
+#include <freerdp/types.h>
+#include <freerdp/update.h>
+#include <freerdp/utils/mutex.h>
+#include <freerdp/utils/semaphore.h>
+
+#define GDI_RENDER_MAX_THREADS		16
+#define GDI_RENDER_TILE_SIZE		64
+
+/* below this number of commands the list is rasterized by the calling thread */
+#define GDI_RENDER_MIN_COMMANDS		4
+
+/* recorded drawing orders */
+#define GDI_RENDER_DSTBLT		0
+#define GDI_RENDER_PATBLT		1
+#define GDI_RENDER_SCRBLT		2
+#define GDI_RENDER_OPAQUE_RECT		3
+#define GDI_RENDER_MULTI_OPAQUE_RECT	4
+#define GDI_RENDER_LINE_TO		5
+#define GDI_RENDER_MEMBLT		6
+#define GDI_RENDER_MEM3BLT		7
+#define GDI_RENDER_MULTI_DSTBLT		8
+#define GDI_RENDER_MULTI_PATBLT		9
+#define GDI_RENDER_MULTI_SCRBLT		10
+
+struct _GDI_RENDER_COMMAND
+{
+	int type;
+	GDI_RECT clip; /* bounds of the order, or the whole surface */
+	GDI_RECT dst; /* pixels the order may write, within the clip */
+	GDI_RECT src; /* surface pixels the order reads, empty if none */
+
+	/*
+	 * Orders reading the surface outside of the pixel they write, or using a pattern
+	 * aligned on the destination rectangle, cannot be split across tiles. They are
+	 * rasterized as a whole once every tile they touch has reached them.
+	 */
+	boolean whole;
+	int tiles;
+	int arrived;
+
+	union
+	{
+		DSTBLT_ORDER dstblt;
+		PATBLT_ORDER patblt;
+		SCRBLT_ORDER scrblt;
+		OPAQUE_RECT_ORDER opaque_rect;
+		MULTI_OPAQUE_RECT_ORDER multi_opaque_rect;
+		LINE_TO_ORDER line_to;
+		MEMBLT_ORDER memblt;
+		MEM3BLT_ORDER mem3blt;
+		MULTI_DSTBLT_ORDER multi_dstblt;
+		MULTI_PATBLT_ORDER multi_patblt;
+		MULTI_SCRBLT_ORDER multi_scrblt;
+	} order;
+};
+typedef struct _GDI_RENDER_COMMAND GDI_RENDER_COMMAND;
+
+struct _GDI_RENDER_TILE
+{
+	GDI_RECT rect;
+
+	/* indices of the commands touching the tile, in order */
+	int* commands;
+	int count;
+	int size;
+	int next;
+};
+typedef struct _GDI_RENDER_TILE GDI_RENDER_TILE;
+
+struct _GDI_RENDERER
+{
+	GDI* gdi;
+
+	int threads;
+	boolean stop;
+	freerdp_sem start;
+	freerdp_sem done;
+	freerdp_sem work;
+	freerdp_mutex mutex;
+
+	/* one device context per rasterizing thread, sharing the drawing surface */
+	HGDI_DC* hdcs;
+	int nexthdc;
+
+	/* command list of the update being recorded */
+	GDI_RENDER_COMMAND* commands;
+	int count;
+	int size;
+	GDI_RECT bounds;
+
+	/* drawing surface covered by the tile grid, orders are clipped to it */
+	GDI_RECT surface;
+
+	int cols;
+	int rows;
+	GDI_RENDER_TILE* tiles;
+
+	/* tiles ready to be rasterized */
+	int* ready;
+	int nready;
+	int active;
+	int finished;
+	int participants;
+};
+
+void gdi_render_set_bounds(GDI_RENDERER* render, BOUNDS* bounds);
+void gdi_render_record(GDI_RENDERER* render, int type, void* order);
+void gdi_render_flush(GDI_RENDERER* render);
+
+GDI_RENDERER* gdi_render_new(GDI* gdi);
+void gdi_render_free(GDI_RENDERER* render);
+
+#endif /* __GDI_RENDER_H */
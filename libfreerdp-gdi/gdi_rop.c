@@ -0,0 +1,504 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * GDI Raster Operation Scanline Kernels
+ *
+ * Copyright 2010-2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <freerdp/utils/cpu.h>
+#include <freerdp/utils/memory.h>
+
+#include "gdi_rop.h"
+
+static const uint8 gdi_rop_all[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+/* source and pattern rows of up to 2048 pixels at 32bpp fit on the stack */
+#define GDI_ROP3_STACK_SIZE	(2 * 2048 * 4)
+
+typedef void (*pRopPattern)(uint8* dst, const uint8* pattern, int length);
+typedef void (*pRopSource)(uint8* dst, uint8* src, const uint8* mask, int length);
+typedef void (*pRopGlyph)(uint8* dst, uint8* src, const uint8* pattern, const uint8* mask, int width, int bytesPerPixel);
+
+static void gdi_rop_fill_c(uint8* dst, const uint8* pattern, int length)
+{
+	int i;
+
+	for (i = 0; i < length; i++)
+		dst[i] = pattern[i & 3];
+}
+
+static void gdi_rop_xor_pattern_c(uint8* dst, const uint8* pattern, int length)
+{
+	int i;
+
+	for (i = 0; i < length; i++)
+		dst[i] ^= pattern[i & 3];
+}
+
+static void gdi_rop_xor_c(uint8* dst, uint8* src, const uint8* mask, int length)
+{
+	int i;
+
+	for (i = 0; i < length; i++)
+		dst[i] ^= src[i] & mask[i & 3];
+}
+
+static void gdi_rop_and_c(uint8* dst, uint8* src, const uint8* mask, int length)
+{
+	int i;
+
+	for (i = 0; i < length; i++)
+		dst[i] &= src[i] | ~mask[i & 3];
+}
+
+static void gdi_rop_or_c(uint8* dst, uint8* src, const uint8* mask, int length)
+{
+	int i;
+
+	for (i = 0; i < length; i++)
+		dst[i] |= src[i] & mask[i & 3];
+}
+
+static void gdi_rop_dspdxax_c(uint8* dst, uint8* src, const uint8* pattern, const uint8* mask, int width, int bytesPerPixel)
+{
+	int i, x;
+	uint8 s;
+
+	for (x = 0; x < width; x++)
+	{
+		for (i = 0; i < bytesPerPixel; i++)
+		{
+			s = src[x] & mask[i];
+			*dst = (s & pattern[i]) | (~s & *dst);
+			dst++;
+		}
+	}
+}
+
+#ifdef WITH_SSE2
+
+/*
+ * The vector loops handle 16 bytes at a time and leave the remaining bytes to the
+ * scalar kernels, the four byte patterns and masks keeping their phase in between.
+ */
+
+/**
+ * Broadcast a four byte pattern to all lanes of a vector.
+ */
+static __m128i gdi_rop_load4_sse2(const uint8* pattern)
+{
+	uint32 value;
+
+	memcpy(&value, pattern, 4);
+
+	return _mm_set1_epi32((int) value);
+}
+
+static void gdi_rop_fill_sse2(uint8* dst, const uint8* pattern, int length)
+{
+	int i;
+	__m128i pat = gdi_rop_load4_sse2(pattern);
+
+	for (i = 0; i + 16 <= length; i += 16)
+		_mm_storeu_si128((__m128i*) &dst[i], pat);
+
+	gdi_rop_fill_c(&dst[i], pattern, length - i);
+}
+
+static void gdi_rop_xor_pattern_sse2(uint8* dst, const uint8* pattern, int length)
+{
+	int i;
+	__m128i pat = gdi_rop_load4_sse2(pattern);
+
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		_mm_storeu_si128((__m128i*) &dst[i],
+			_mm_xor_si128(_mm_loadu_si128((__m128i*) &dst[i]), pat));
+	}
+
+	gdi_rop_xor_pattern_c(&dst[i], pattern, length - i);
+}
+
+static void gdi_rop_xor_sse2(uint8* dst, uint8* src, const uint8* mask, int length)
+{
+	int i;
+	__m128i msk = gdi_rop_load4_sse2(mask);
+
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		_mm_storeu_si128((__m128i*) &dst[i], _mm_xor_si128(_mm_loadu_si128((__m128i*) &dst[i]),
+			_mm_and_si128(_mm_loadu_si128((__m128i*) &src[i]), msk)));
+	}
+
+	gdi_rop_xor_c(&dst[i], &src[i], mask, length - i);
+}
+
+static void gdi_rop_and_sse2(uint8* dst, uint8* src, const uint8* mask, int length)
+{
+	int i;
+	__m128i msk = gdi_rop_load4_sse2(mask);
+
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		/* bytes outside of the mask are and'ed with all ones */
+		_mm_storeu_si128((__m128i*) &dst[i], _mm_and_si128(_mm_loadu_si128((__m128i*) &dst[i]),
+			_mm_or_si128(_mm_loadu_si128((__m128i*) &src[i]), _mm_andnot_si128(msk, _mm_set1_epi8(-1)))));
+	}
+
+	gdi_rop_and_c(&dst[i], &src[i], mask, length - i);
+}
+
+static void gdi_rop_or_sse2(uint8* dst, uint8* src, const uint8* mask, int length)
+{
+	int i;
+	__m128i msk = gdi_rop_load4_sse2(mask);
+
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		_mm_storeu_si128((__m128i*) &dst[i], _mm_or_si128(_mm_loadu_si128((__m128i*) &dst[i]),
+			_mm_and_si128(_mm_loadu_si128((__m128i*) &src[i]), msk)));
+	}
+
+	gdi_rop_or_c(&dst[i], &src[i], mask, length - i);
+}
+
+static void gdi_rop_dspdxax_sse2(uint8* dst, uint8* src, const uint8* pattern, const uint8* mask, int width, int bytesPerPixel)
+{
+	int x;
+	uint32 value;
+	int step = 16 / bytesPerPixel;
+	__m128i sv, dv;
+	__m128i pat = gdi_rop_load4_sse2(pattern);
+	__m128i msk = gdi_rop_load4_sse2(mask);
+
+	for (x = 0; x + step <= width; x += step)
+	{
+		/* widen the source bytes to the destination pixel size */
+		if (bytesPerPixel == 4)
+		{
+			memcpy(&value, &src[x], 4);
+			sv = _mm_cvtsi32_si128((int) value);
+			sv = _mm_unpacklo_epi8(sv, sv);
+			sv = _mm_unpacklo_epi16(sv, sv);
+		}
+		else if (bytesPerPixel == 2)
+		{
+			sv = _mm_loadl_epi64((__m128i*) &src[x]);
+			sv = _mm_unpacklo_epi8(sv, sv);
+		}
+		else
+		{
+			sv = _mm_loadu_si128((__m128i*) &src[x]);
+		}
+
+		sv = _mm_and_si128(sv, msk);
+		dv = _mm_loadu_si128((__m128i*) &dst[x * bytesPerPixel]);
+
+		_mm_storeu_si128((__m128i*) &dst[x * bytesPerPixel],
+			_mm_or_si128(_mm_and_si128(sv, pat), _mm_andnot_si128(sv, dv)));
+	}
+
+	gdi_rop_dspdxax_c(&dst[x * bytesPerPixel], &src[x], pattern, mask, width - x, bytesPerPixel);
+}
+
+#endif
+
+/* scanline kernels, the scalar ones until gdi_rop_init() selects others */
+static pRopPattern rop_fill = gdi_rop_fill_c;
+static pRopPattern rop_xor_pattern = gdi_rop_xor_pattern_c;
+static pRopSource rop_xor = gdi_rop_xor_c;
+static pRopSource rop_and = gdi_rop_and_c;
+static pRopSource rop_or = gdi_rop_or_c;
+static pRopGlyph rop_dspdxax = gdi_rop_dspdxax_c;
+
+/**
+ * Select the scanline kernels for the instruction sets of the processor.
+ * @param features CPU_* feature flags, zero for the scalar kernels
+ */
+
+void gdi_rop_init(uint32 features)
+{
+	rop_fill = gdi_rop_fill_c;
+	rop_xor_pattern = gdi_rop_xor_pattern_c;
+	rop_xor = gdi_rop_xor_c;
+	rop_and = gdi_rop_and_c;
+	rop_or = gdi_rop_or_c;
+	rop_dspdxax = gdi_rop_dspdxax_c;
+
+#ifdef WITH_SSE2
+	if (features & CPU_SSE2)
+	{
+		rop_fill = gdi_rop_fill_sse2;
+		rop_xor_pattern = gdi_rop_xor_pattern_sse2;
+		rop_xor = gdi_rop_xor_sse2;
+		rop_and = gdi_rop_and_sse2;
+		rop_or = gdi_rop_or_sse2;
+		rop_dspdxax = gdi_rop_dspdxax_sse2;
+	}
+#endif
+}
+
+/**
+ * Fill a scanline with a repeated pattern.\n
+ * D = P
+ */
+
+void gdi_rop_fill(uint8* dst, const uint8* pattern, int length)
+{
+	rop_fill(dst, pattern, length);
+}
+
+/**
+ * Invert a scanline with a repeated pattern.\n
+ * D = P ^ D
+ */
+
+void gdi_rop_xor_pattern(uint8* dst, const uint8* pattern, int length)
+{
+	rop_xor_pattern(dst, pattern, length);
+}
+
+/**
+ * Combine a source scanline into a destination scanline.\n
+ * D = S ^ D
+ */
+
+void gdi_rop_xor(uint8* dst, uint8* src, const uint8* mask, int length)
+{
+	rop_xor(dst, src, (mask != NULL) ? mask : gdi_rop_all, length);
+}
+
+/**
+ * D = S & D
+ */
+
+void gdi_rop_and(uint8* dst, uint8* src, const uint8* mask, int length)
+{
+	rop_and(dst, src, (mask != NULL) ? mask : gdi_rop_all, length);
+}
+
+/**
+ * D = S | D
+ */
+
+void gdi_rop_or(uint8* dst, uint8* src, const uint8* mask, int length)
+{
+	rop_or(dst, src, (mask != NULL) ? mask : gdi_rop_all, length);
+}
+
+/**
+ * Draw a glyph scanline, the source holding one byte per destination pixel.\n
+ * D = (S & P) | (~S & D)
+ * @param width number of pixels
+ * @param bytesPerPixel destination pixel size, 1, 2 or 4
+ */
+
+void gdi_rop_dspdxax(uint8* dst, uint8* src, const uint8* pattern, const uint8* mask, int width, int bytesPerPixel)
+{
+	rop_dspdxax(dst, src, pattern, (mask != NULL) ? mask : gdi_rop_all, width, bytesPerPixel);
+}
+
+/**
+ * Ternary raster operations\n
+ * Bit i of a rop3 index holds the result for P = bit 2, S = bit 1 and D = bit 0 of i,
+ * each kernel below is the sum of the minterms set in its index. The index being a
+ * constant, the compiler folds every kernel down to its own boolean expression.
+ */
+
+#define ROP3_EXPR(_t, _d, _s, _p) ( \
+	(((_t) & 0x01) ? (~(_p) & ~(_s) & ~(_d)) : 0) | \
+	(((_t) & 0x02) ? (~(_p) & ~(_s) & (_d)) : 0) | \
+	(((_t) & 0x04) ? (~(_p) & (_s) & ~(_d)) : 0) | \
+	(((_t) & 0x08) ? (~(_p) & (_s) & (_d)) : 0) | \
+	(((_t) & 0x10) ? ((_p) & ~(_s) & ~(_d)) : 0) | \
+	(((_t) & 0x20) ? ((_p) & ~(_s) & (_d)) : 0) | \
+	(((_t) & 0x40) ? ((_p) & (_s) & ~(_d)) : 0) | \
+	(((_t) & 0x80) ? ((_p) & (_s) & (_d)) : 0))
+
+typedef void (*pRop3)(uint8* dst, uint8* src, uint8* pat, uint32 mask, int length);
+
+#define ROP3_KERNEL(_t) \
+static void gdi_rop3_##_t(uint8* dst, uint8* src, uint8* pat, uint32 mask, int length) \
+{ \
+	int i = 0; \
+	uint32 d, s, p; \
+	uint8 m; \
+	for (; i + 4 <= length; i += 4) \
+	{ \
+		memcpy(&d, &dst[i], 4); \
+		memcpy(&s, &src[i], 4); \
+		memcpy(&p, &pat[i], 4); \
+		d = ((uint32) ROP3_EXPR(_t, d, s, p) & mask) | (d & ~mask); \
+		memcpy(&dst[i], &d, 4); \
+	} \
+	for (; i < length; i++) \
+	{ \
+		m = ((uint8*) &mask)[i & 3]; \
+		dst[i] = ((uint8) ROP3_EXPR(_t, dst[i], src[i], pat[i]) & m) | (dst[i] & ~m); \
+	} \
+}
+
+#define ROP3_KERNELS(_h) \
+	ROP3_KERNEL(0x##_h##0) ROP3_KERNEL(0x##_h##1) ROP3_KERNEL(0x##_h##2) ROP3_KERNEL(0x##_h##3) \
+	ROP3_KERNEL(0x##_h##4) ROP3_KERNEL(0x##_h##5) ROP3_KERNEL(0x##_h##6) ROP3_KERNEL(0x##_h##7) \
+	ROP3_KERNEL(0x##_h##8) ROP3_KERNEL(0x##_h##9) ROP3_KERNEL(0x##_h##A) ROP3_KERNEL(0x##_h##B) \
+	ROP3_KERNEL(0x##_h##C) ROP3_KERNEL(0x##_h##D) ROP3_KERNEL(0x##_h##E) ROP3_KERNEL(0x##_h##F)
+
+#define ROP3_ENTRIES(_h) \
+	gdi_rop3_0x##_h##0, gdi_rop3_0x##_h##1, gdi_rop3_0x##_h##2, gdi_rop3_0x##_h##3, \
+	gdi_rop3_0x##_h##4, gdi_rop3_0x##_h##5, gdi_rop3_0x##_h##6, gdi_rop3_0x##_h##7, \
+	gdi_rop3_0x##_h##8, gdi_rop3_0x##_h##9, gdi_rop3_0x##_h##A, gdi_rop3_0x##_h##B, \
+	gdi_rop3_0x##_h##C, gdi_rop3_0x##_h##D, gdi_rop3_0x##_h##E, gdi_rop3_0x##_h##F
+
+ROP3_KERNELS(0) ROP3_KERNELS(1) ROP3_KERNELS(2) ROP3_KERNELS(3)
+ROP3_KERNELS(4) ROP3_KERNELS(5) ROP3_KERNELS(6) ROP3_KERNELS(7)
+ROP3_KERNELS(8) ROP3_KERNELS(9) ROP3_KERNELS(A) ROP3_KERNELS(B)
+ROP3_KERNELS(C) ROP3_KERNELS(D) ROP3_KERNELS(E) ROP3_KERNELS(F)
+
+static const pRop3 rop3_kernels[256] =
+{
+	ROP3_ENTRIES(0), ROP3_ENTRIES(1), ROP3_ENTRIES(2), ROP3_ENTRIES(3),
+	ROP3_ENTRIES(4), ROP3_ENTRIES(5), ROP3_ENTRIES(6), ROP3_ENTRIES(7),
+	ROP3_ENTRIES(8), ROP3_ENTRIES(9), ROP3_ENTRIES(A), ROP3_ENTRIES(B),
+	ROP3_ENTRIES(C), ROP3_ENTRIES(D), ROP3_ENTRIES(E), ROP3_ENTRIES(F)
+};
+
+/**
+ * Perform a bit block transfer with any of the 256 ternary raster operations.\n
+ * Used for the raster operations without a dedicated routine, on clipped coordinates.
+ * @param rop raster operation code, as returned by gdi_rop3_code
+ * @param color solid brush color, repeated over four bytes
+ * @param mask bytes of each pixel written to, NULL for all of them
+ * @return 0 on success, 1 if the operands of the raster operation are missing
+ */
+
+int gdi_rop3_blt(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight,
+		HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop, const uint8* color, const uint8* mask)
+{
+	int x, y;
+	int index;
+	int length;
+	int yStart, yEnd, yStep;
+	uint32 mask32;
+	uint8* dstp;
+	uint8* srcp;
+	uint8* patp;
+	uint8* buffer;
+	uint8 stackBuffer[GDI_ROP3_STACK_SIZE];
+	uint8* srcRow;
+	uint8* patRow;
+	boolean useSrc;
+	boolean usePat;
+	boolean overlap;
+	pRop3 kernel;
+
+	index = (rop >> 16) & 0xFF;
+	kernel = rop3_kernels[index];
+
+	/* an operand is used when flipping it changes the result */
+	useSrc = (((index >> 2) ^ index) & 0x33) ? True : False;
+	usePat = (((index >> 4) ^ index) & 0x0F) ? True : False;
+
+	if (useSrc && (hdcSrc == NULL || hdcSrc->bytesPerPixel != hdcDest->bytesPerPixel))
+	{
+		printf("BitBlt: rop 0x%08X requires a source of the destination depth\n", rop);
+		return 1;
+	}
+
+	if (usePat && hdcDest->brush == NULL)
+	{
+		printf("BitBlt: rop 0x%08X requires a brush\n", rop);
+		return 1;
+	}
+
+	if (nWidth <= 0 || nHeight <= 0)
+		return 0;
+
+	memcpy(&mask32, (mask != NULL) ? mask : gdi_rop_all, 4);
+
+	length = nWidth * hdcDest->bytesPerPixel;
+	buffer = (length * 2 <= GDI_ROP3_STACK_SIZE) ? stackBuffer : (uint8*) xmalloc(length * 2);
+	srcRow = buffer;
+	patRow = &buffer[length];
+
+	if (usePat && hdcDest->brush->style == GDI_BS_SOLID)
+		gdi_rop_fill(patRow, color, length);
+
+	overlap = (useSrc && hdcSrc->selectedObject == hdcDest->selectedObject) ? True : False;
+
+	/* walk the rows upwards when the source lies above an overlapping destination */
+	if (overlap && nYSrc < nYDest)
+	{
+		yStart = nHeight - 1;
+		yEnd = -1;
+		yStep = -1;
+	}
+	else
+	{
+		yStart = 0;
+		yEnd = nHeight;
+		yStep = 1;
+	}
+
+	for (y = yStart; y != yEnd; y += yStep)
+	{
+		dstp = gdi_get_bitmap_pointer(hdcDest, nXDest, nYDest + y);
+
+		if (dstp == 0)
+			continue;
+
+		srcp = dstp;
+		patp = dstp;
+
+		if (useSrc)
+		{
+			srcp = gdi_get_bitmap_pointer(hdcSrc, nXSrc, nYSrc + y);
+
+			if (srcp == 0)
+				continue;
+
+			if (overlap)
+			{
+				memcpy(srcRow, srcp, length);
+				srcp = srcRow;
+			}
+		}
+
+		if (usePat)
+		{
+			if (hdcDest->brush->style != GDI_BS_SOLID)
+			{
+				for (x = 0; x < nWidth; x++)
+				{
+					memcpy(&patRow[x * hdcDest->bytesPerPixel],
+						gdi_get_brush_pointer(hdcDest, x, y), hdcDest->bytesPerPixel);
+				}
+			}
+
+			patp = patRow;
+		}
+
+		kernel(dstp, srcp, patp, mask32, length);
+	}
+
+	if (buffer != stackBuffer)
+		xfree(buffer);
+
+	return 0;
+}
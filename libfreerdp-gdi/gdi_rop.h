@@ -0,0 +1,45 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * GDI Raster Operation Scanline Kernels
+ *
+ * Copyright 2010-2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __GDI_ROP_H
+#define __GDI_ROP_H
+
+#include "gdi.h"
+
+#include <freerdp/types.h>
+
+/*
+ * Patterns and masks are four bytes repeated over the whole scanline, starting
+ * on its first byte. A NULL mask selects every byte, the 32bpp routines pass
+ * a mask selecting the blue, green and red bytes to leave the alpha untouched.
+ */
+
+void gdi_rop_init(uint32 features);
+
+void gdi_rop_fill(uint8* dst, const uint8* pattern, int length);
+void gdi_rop_xor_pattern(uint8* dst, const uint8* pattern, int length);
+void gdi_rop_xor(uint8* dst, uint8* src, const uint8* mask, int length);
+void gdi_rop_and(uint8* dst, uint8* src, const uint8* mask, int length);
+void gdi_rop_or(uint8* dst, uint8* src, const uint8* mask, int length);
+void gdi_rop_dspdxax(uint8* dst, uint8* src, const uint8* pattern, const uint8* mask, int width, int bytesPerPixel);
+
+int gdi_rop3_blt(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight,
+		HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop, const uint8* color, const uint8* mask);
+
+#endif /* __GDI_ROP_H */
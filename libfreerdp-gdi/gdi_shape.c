@@ -27,6 +27,7 @@
 #include "gdi_16bpp.h"
 #include "gdi_32bpp.h"
 #include "gdi_bitmap.h"
+#include "gdi_clipping.h"
 
 #include "gdi_shape.h"
 
@@ -192,12 +193,37 @@ int gdi_Ellipse(HGDI_DC hdc, int nLeftRect, int nTopRect, int nRightRect, int nB
 
 int gdi_FillRect(HGDI_DC hdc, HGDI_RECT rect, HGDI_BRUSH hbr)
 {
+	int i;
+	int status = 0;
+	int first, last;
+	GDI_RGN bounds;
+	HGDI_RGN clip;
 	pFillRect _FillRect = FillRect_[IBPP(hdc->bitsPerPixel)];
 
-	if (_FillRect != NULL)
-		return _FillRect(hdc, rect, hbr);
-	else
+	if (_FillRect == NULL)
 		return 0;
+
+	if (hdc->nclip == 0)
+		return _FillRect(hdc, rect, hbr);
+
+	/* fill through each rectangle of the complex clipping region */
+	bounds = *hdc->clip;
+	gdi_GetClipBands(hdc, rect->top, rect->bottom - rect->top + 1, &first, &last);
+
+	for (i = first; i < last; i++)
+	{
+		clip = &hdc->cclip[i];
+
+		if (clip->x <= rect->right && clip->x + clip->w > rect->left)
+		{
+			*hdc->clip = *clip;
+			status = _FillRect(hdc, rect, hbr);
+		}
+	}
+
+	*hdc->clip = bounds;
+
+	return status;
 }
 
 /**
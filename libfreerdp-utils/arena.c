@@ -0,0 +1,148 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Arena Allocator Utils
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/utils/memory.h>
+
+#include <freerdp/utils/arena.h>
+
+#define ARENA_ALIGN(_n) (((_n) + 7) & ~7)
+
+/* the block header is followed by its data */
+#define ARENA_BLOCK_HEADER ARENA_ALIGN(sizeof(struct rdp_arena_block))
+
+static struct rdp_arena_block* freerdp_arena_block_new(uint32 size, struct rdp_arena_block* next)
+{
+	struct rdp_arena_block* block;
+
+	block = (struct rdp_arena_block*) xmalloc(ARENA_BLOCK_HEADER + size);
+	block->next = next;
+	block->size = size;
+	block->used = 0;
+
+	return block;
+}
+
+/**
+ * Allocate memory from an arena.\n
+ * The memory is not initialized, and stays valid until the arena is reset.
+ * @param arena arena
+ * @param length memory length
+ * @return allocated memory, aligned on 8 bytes
+ */
+
+void* freerdp_arena_alloc(ARENA* arena, uint32 length)
+{
+	uint8* data;
+	struct rdp_arena_block* block;
+
+	length = ARENA_ALIGN(length);
+	block = arena->block;
+
+	if (block->size - block->used < length)
+	{
+		block = freerdp_arena_block_new((length > arena->size) ? length : arena->size, block);
+		arena->block = block;
+	}
+
+	data = (uint8*) block + ARENA_BLOCK_HEADER + block->used;
+	block->used += length;
+
+	return (void*) data;
+}
+
+/**
+ * Release all memory allocated from an arena at once.\n
+ * When the arena had to grow, its blocks are merged into a single block large enough
+ * for everything that was allocated since the last reset.
+ * @param arena arena
+ */
+
+void freerdp_arena_reset(ARENA* arena)
+{
+	uint32 size;
+	struct rdp_arena_block* next;
+	struct rdp_arena_block* block;
+
+	block = arena->block;
+
+	if (block->next == NULL)
+	{
+		block->used = 0;
+		return;
+	}
+
+	size = 0;
+
+	while (block != NULL)
+	{
+		next = block->next;
+		size += block->size;
+		xfree(block);
+		block = next;
+	}
+
+	arena->size = size;
+	arena->block = freerdp_arena_block_new(size, NULL);
+}
+
+/**
+ * Instantiate new arena.
+ * @param size initial size of the arena
+ * @return new arena
+ */
+
+ARENA* freerdp_arena_new(uint32 size)
+{
+	ARENA* arena;
+
+	arena = xnew(ARENA);
+
+	if (arena != NULL)
+	{
+		arena->size = ARENA_ALIGN(size);
+		arena->block = freerdp_arena_block_new(arena->size, NULL);
+	}
+
+	return arena;
+}
+
+/**
+ * Free arena, along with all memory allocated from it.
+ * @param arena arena to be freed
+ */
+
+void freerdp_arena_free(ARENA* arena)
+{
+	struct rdp_arena_block* next;
+	struct rdp_arena_block* block;
+
+	if (arena != NULL)
+	{
+		block = arena->block;
+
+		while (block != NULL)
+		{
+			next = block->next;
+			xfree(block);
+			block = next;
+		}
+
+		xfree(arena);
+	}
+}
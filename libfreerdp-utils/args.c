@@ -148,6 +148,16 @@ int freerdp_parse_args(rdpSettings* settings, int argc, char** argv,
 			}
 			settings->port = atoi(argv[index]);
 		}
+		else if (strcmp("--timeout", argv[index]) == 0)
+		{
+			index++;
+			if (index == argc)
+			{
+				printf("missing timeout value\n");
+				return 0;
+			}
+			settings->tcp_timeout = atoi(argv[index]);
+		}
 		else if (strcmp("-n", argv[index]) == 0)
 		{
 			index++;
@@ -175,6 +185,18 @@ int freerdp_parse_args(rdpSettings* settings, int argc, char** argv,
 		{
 			settings->offscreen_bitmap_cache = 0;
 		}
+		else if (strcmp("--persistent-cache", argv[index]) == 0)
+		{
+			settings->persistent_bitmap_cache = True;
+		}
+		else if (strcmp("--pipeline", argv[index]) == 0)
+		{
+			settings->update_pipeline = True;
+		}
+		else if (strcmp("--parallel-orders", argv[index]) == 0)
+		{
+			settings->parallel_orders = True;
+		}
 		else if (strcmp("--rfx", argv[index]) == 0)
 		{
 			settings->rfx_flags = 1;
@@ -0,0 +1,55 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * CPU Feature Utils
+ *
+ * Copyright 2011 Marc-Andre Moreau <marcandre.moreau@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#endif
+
+#include <freerdp/utils/cpu.h>
+
+/**
+ * Get the SIMD instruction sets supported by the processor.\n
+ * Only the instruction sets the SIMD kernels were built for are reported.
+ * @return CPU_* feature flags
+ */
+
+uint32 freerdp_cpu_features(void)
+{
+	uint32 features = 0;
+
+#ifdef WITH_SSE2
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	int info[4];
+
+	__cpuid(info, 1);
+
+	if (info[3] & (1 << 26))
+		features |= CPU_SSE2;
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	unsigned int eax, ebx, ecx, edx;
+
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & (1 << 26)))
+		features |= CPU_SSE2;
+#endif
+#endif
+
+	return features;
+}
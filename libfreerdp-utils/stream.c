@@ -24,6 +24,10 @@
 #include <freerdp/utils/memory.h>
 #include <freerdp/utils/stream.h>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 STREAM* stream_new(int size)
 {
 	STREAM* stream;
@@ -38,6 +42,7 @@ STREAM* stream_new(int size)
 			stream->data = (uint8*)xmalloc(size);
 			stream->p = stream->data;
 			stream->size = size;
+			stream->capacity = size;
 		}
 	}
 
@@ -59,6 +64,234 @@ void stream_extend(STREAM* stream)
 
 	pos = stream_get_pos(stream);
 	stream->size <<= 1;
-	stream->data = (uint8*)xrealloc(stream->data, stream->size);
+
+	if (stream->size > stream->capacity)
+	{
+		stream->data = (uint8*)xrealloc(stream->data, stream->size);
+		stream->capacity = stream->size;
+	}
+
 	stream_set_pos(stream, pos);
 }
+
+/**
+ * Stream pool.\n
+ * Streams are recycled in power of two size classes from 256 bytes to 128 KB.
+ * Each thread keeps a small cache per class so that get/put do not take a lock,
+ * the cache exchanges half of its streams with a shared depot when it runs empty or full.
+ * Streams returned to the pool may come from stream_new or from another thread.
+ */
+
+#define STREAM_POOL_MIN_SHIFT		8
+#define STREAM_POOL_CLASSES		10
+#define STREAM_POOL_CACHE_DEPTH		16
+#define STREAM_POOL_DEPOT_DEPTH		64
+
+static STREAM_POOL_STATS stream_pool_stats;
+
+#ifndef _WIN32
+
+struct stream_pool_cache
+{
+	int count[STREAM_POOL_CLASSES];
+	STREAM* streams[STREAM_POOL_CLASSES][STREAM_POOL_CACHE_DEPTH];
+};
+
+struct stream_pool_depot
+{
+	int count[STREAM_POOL_CLASSES];
+	STREAM* streams[STREAM_POOL_CLASSES][STREAM_POOL_DEPOT_DEPTH];
+};
+
+static struct stream_pool_depot stream_pool_depot;
+static pthread_mutex_t stream_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t stream_pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stream_pool_key;
+
+#define stream_pool_count(_n) __sync_fetch_and_add(&stream_pool_stats._n, 1)
+
+/* move up to count streams of a class from the cache to the depot, freeing what does not fit */
+static void stream_pool_spill(struct stream_pool_cache* cache, int index, int count)
+{
+	STREAM* stream;
+	struct stream_pool_depot* depot = &stream_pool_depot;
+
+	pthread_mutex_lock(&stream_pool_mutex);
+
+	while (count-- > 0 && cache->count[index] > 0)
+	{
+		stream = cache->streams[index][--cache->count[index]];
+
+		if (depot->count[index] < STREAM_POOL_DEPOT_DEPTH)
+		{
+			depot->streams[index][depot->count[index]++] = stream;
+		}
+		else
+		{
+			stream_pool_count(frees);
+			stream_free(stream);
+		}
+	}
+
+	pthread_mutex_unlock(&stream_pool_mutex);
+}
+
+static void stream_pool_refill(struct stream_pool_cache* cache, int index)
+{
+	int count = STREAM_POOL_CACHE_DEPTH / 2;
+	struct stream_pool_depot* depot = &stream_pool_depot;
+
+	pthread_mutex_lock(&stream_pool_mutex);
+
+	while (count-- > 0 && depot->count[index] > 0)
+		cache->streams[index][cache->count[index]++] = depot->streams[index][--depot->count[index]];
+
+	pthread_mutex_unlock(&stream_pool_mutex);
+}
+
+static void stream_pool_cache_free(void* arg)
+{
+	int index;
+	struct stream_pool_cache* cache = (struct stream_pool_cache*) arg;
+
+	for (index = 0; index < STREAM_POOL_CLASSES; index++)
+		stream_pool_spill(cache, index, cache->count[index]);
+
+	xfree(cache);
+}
+
+static void stream_pool_init(void)
+{
+	pthread_key_create(&stream_pool_key, stream_pool_cache_free);
+}
+
+static struct stream_pool_cache* stream_pool_get_cache(void)
+{
+	struct stream_pool_cache* cache;
+
+	pthread_once(&stream_pool_once, stream_pool_init);
+	cache = (struct stream_pool_cache*) pthread_getspecific(stream_pool_key);
+
+	if (cache == NULL)
+	{
+		cache = xnew(struct stream_pool_cache);
+		pthread_setspecific(stream_pool_key, cache);
+	}
+
+	return cache;
+}
+
+#else
+
+#define stream_pool_count(_n) stream_pool_stats._n++
+
+#endif
+
+/**
+ * Get a stream from the pool.\n
+ * The stream has at least size bytes of storage, and stream_get_size returns size.
+ * Streams larger than the biggest size class are allocated with stream_new.
+ * @param size requested size
+ * @return stream positioned at 0
+ */
+
+STREAM* stream_pool_get(int size)
+{
+	int index;
+	STREAM* stream = NULL;
+#ifndef _WIN32
+	struct stream_pool_cache* cache;
+#endif
+
+	stream_pool_count(gets);
+
+	if (size <= 0)
+		size = 0x400;
+
+	for (index = 0; index < STREAM_POOL_CLASSES; index++)
+	{
+		if (size <= (1 << (index + STREAM_POOL_MIN_SHIFT)))
+			break;
+	}
+
+	if (index >= STREAM_POOL_CLASSES)
+	{
+		stream_pool_count(allocs);
+		return stream_new(size);
+	}
+
+#ifndef _WIN32
+	cache = stream_pool_get_cache();
+
+	if (cache->count[index] < 1)
+		stream_pool_refill(cache, index);
+
+	if (cache->count[index] > 0)
+		stream = cache->streams[index][--cache->count[index]];
+#endif
+
+	if (stream == NULL)
+	{
+		stream_pool_count(allocs);
+		stream = stream_new(1 << (index + STREAM_POOL_MIN_SHIFT));
+	}
+
+	stream->p = stream->data;
+	stream->size = size;
+
+	return stream;
+}
+
+/**
+ * Return a stream to the pool.\n
+ * The stream is filed under the largest size class that fits in its capacity,
+ * streams that are too small or too large for the pool are freed.
+ * @param stream stream
+ */
+
+void stream_pool_put(STREAM* stream)
+{
+	int index;
+#ifndef _WIN32
+	struct stream_pool_cache* cache;
+#endif
+
+	if (stream == NULL)
+		return;
+
+	stream_pool_count(puts);
+
+	for (index = STREAM_POOL_CLASSES - 1; index >= 0; index--)
+	{
+		if (stream->capacity >= (1 << (index + STREAM_POOL_MIN_SHIFT)))
+			break;
+	}
+
+#ifndef _WIN32
+	if (stream->data != NULL && index >= 0 &&
+		stream->capacity < (1 << (STREAM_POOL_CLASSES + STREAM_POOL_MIN_SHIFT)))
+	{
+		cache = stream_pool_get_cache();
+
+		if (cache->count[index] >= STREAM_POOL_CACHE_DEPTH)
+			stream_pool_spill(cache, index, STREAM_POOL_CACHE_DEPTH / 2);
+
+		cache->streams[index][cache->count[index]++] = stream;
+		return;
+	}
+#endif
+
+	stream_pool_count(frees);
+	stream_free(stream);
+}
+
+/**
+ * Get stream pool statistics.\n
+ * In steady state allocs and frees should stay close to zero while gets and puts grow.
+ * @param stats statistics
+ */
+
+void stream_pool_get_stats(STREAM_POOL_STATS* stats)
+{
+	memcpy(stats, &stream_pool_stats, sizeof(STREAM_POOL_STATS));
+}
@@ -60,7 +60,7 @@ void svc_data_in_item_free(struct svc_data_in_item* item)
 {
 	if (item->data_in)
 	{
-		stream_free(item->data_in);
+		stream_pool_put(item->data_in);
 		item->data_in = NULL;
 	}
 	if (item->event_in)
@@ -155,8 +155,8 @@ static void svc_plugin_process_received(rdpSvcPlugin* plugin, void* pData, uint3
 	if (dataFlags & CHANNEL_FLAG_FIRST)
 	{
 		if (plugin->priv->data_in != NULL)
-			stream_free(plugin->priv->data_in);
-		plugin->priv->data_in = stream_new(totalLength);
+			stream_pool_put(plugin->priv->data_in);
+		plugin->priv->data_in = stream_pool_get(totalLength);
 	}
 
 	data_in = plugin->priv->data_in;
@@ -218,7 +218,7 @@ static void svc_plugin_open_event(uint32 openHandle, uint32 event, void* pData,
 			svc_plugin_process_received(plugin, pData, dataLength, totalLength, dataFlags);
 			break;
 		case CHANNEL_EVENT_WRITE_COMPLETE:
-			stream_free((STREAM*)pData);
+			stream_pool_put((STREAM*)pData);
 			break;
 		case CHANNEL_EVENT_USER:
 			svc_plugin_process_event(plugin, (FRDP_EVENT*)pData);
@@ -339,7 +339,7 @@ static void svc_plugin_process_terminated(rdpSvcPlugin* plugin)
 
 	if (plugin->priv->data_in != NULL)
 	{
-		stream_free(plugin->priv->data_in);
+		stream_pool_put(plugin->priv->data_in);
 		plugin->priv->data_in = NULL;
 	}
 	xfree(plugin->priv);
@@ -411,7 +411,7 @@ int svc_plugin_send(rdpSvcPlugin* plugin, STREAM* data_out)
 		stream_get_data(data_out), stream_get_length(data_out), data_out);
 	if (error != CHANNEL_RC_OK)
 	{
-		stream_free(data_out);
+		stream_pool_put(data_out);
 		printf("svc_plugin_send: VirtualChannelWrite failed %d\n", error);
 	}
 